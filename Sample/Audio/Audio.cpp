@@ -6,6 +6,7 @@
 #include <Windows.h>
 #include <NuiApi.h>
 #include <opencv2/opencv.hpp>
+#include "NuiFrameSource.h"
 
 // Audio֘Ãwb_[ƃCu
 #include <dmo.h>
@@ -184,6 +185,19 @@ int _tmain(int argc, _TCHAR* argv[])
 	pDMO->SetOutputType( 0, &mediaType, 0 ); 
 	MoFreeMediaType( &mediaType );
 
+	// "-record <file>"w肵Ƃ́A擾L^t@Cɏ
+	RecordingWriter recordingWriter;
+	for( int i = 1; i + 1 < argc; i++ ){
+		if( _tcscmp( argv[i], _T( "-record" ) ) == 0 ){
+			if( !recordingWriter.open( toMultiByteString( argv[i + 1] ).c_str(), RECORD_STREAM_FLAG_AUDIO ) ){
+				std::cerr << "Error : RecordingWriter::open" << std::endl;
+				return -1;
+			}
+		}
+	}
+	const double recordingStart = getTimeInSeconds();
+	uint32_t recordedSamples = 0;
+
 	// Audioobt@̊m
 	CStaticMediaBuffer mediaBuffer;
 	DMO_OUTPUT_DATA_BUFFER OutputBufferStruct = { 0 };
@@ -202,6 +216,16 @@ int _tmain(int argc, _TCHAR* argv[])
 
 			hResult = pDMO->ProcessOutput( 0, 1, &OutputBufferStruct, &dwStatus );
 			if( SUCCEEDED(hResult) ){
+				// ̋L^(^CX^v͋L^n߂Ă̎[ms])
+				BYTE* pAudioData = nullptr;
+				DWORD audioLength = 0;
+				mediaBuffer.GetBufferAndLength( &pAudioData, &audioLength );
+				if( recordingWriter.isOpen() && audioLength > 0 ){
+					const uint32_t sampleCount = audioLength / AudioBlockAlign;
+					recordingWriter.writeAudio( static_cast<int64_t>( ( getTimeInSeconds() - recordingStart ) * 1000.0 ), recordedSamples, reinterpret_cast<int16_t*>( pAudioData ), sampleCount );
+					recordedSamples += sampleCount;
+				}
+
 				// ̎擾
 				double beam = 0.0f;
 				double angle = 0.0f;
@@ -227,6 +251,9 @@ int _tmain(int argc, _TCHAR* argv[])
 		}
 	}
 
+	// L^t@C(c̉ƃCfbNX)
+	recordingWriter.close();
+
 	// Kinect̏I
 	pDMO->Release();
 	pPS->Release();
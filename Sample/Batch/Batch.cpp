@@ -0,0 +1,505 @@
+// Batch.cpp : L^t@CClippingAPlayerƓEBhEg킸ɓKpAʂt@Cɏo
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Platform.h"
+#include "KinectTypes.h"
+#include "Registration.h"
+#include "Recording.h"
+#include "ReplayFrameSource.h"
+#include "FrameProcessor.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+
+static const int WIDTH  = KINECT_IMAGE_WIDTH;
+static const int HEIGHT = KINECT_IMAGE_HEIGHT;
+static const int PIXELS = WIDTH * HEIGHT;
+
+// ̎
+static const int BATCH_MODE_CLIP   = 1 << 0; // Clipping̏(mask/Aclip/)
+static const int BATCH_MODE_PLAYER = 1 << 1; // Playeȑ(depth/Aplayer/)
+
+// 1t[̓v
+struct FrameStatistics
+{
+	int index;                 // L^t@C̐擪̃t[̑g̔ԍ
+	int64_t timestamp;         // Depth̃^CX^v[ms]
+	uint32_t depthFrameNumber;
+	uint32_t colorFrameNumber;
+	int playerPixels[KINECT_PLAYER_COUNT + 1]; // ʒu킹Depth&PlayerPlayer̃CfbNX̉f(0͐lȊO)
+	int maskPixels;            // openingAclosinǧ̃}XN̉f(Clipping̏ȂƂ0)
+};
+
+// L^t@C̎Ԃ͈̔͂ŕ̒P
+struct Shard
+{
+	int begin; // 擪̃t[̑g̔ԍ
+	int end;   // Ō̃t[̑g̎̔ԍ
+	int64_t beginTimestamp;
+	std::vector<FrameStatistics> statistics;
+	bool done;
+	bool failed;
+};
+
+// SẴ[J[ŋLݒƏ
+struct BatchContext
+{
+	const char* replayPath;
+	std::string outputPath;
+	const RegistrationTable* table;
+	int mode;
+	bool writeImages;
+	int iterationErode;
+	int iterationDilate;
+	MorphologyShape shape;
+	bool incremental;
+
+	std::vector<Shard> shards;
+	volatile long nextShard;
+
+	// IShardC̃Xbh֒m点
+	Mutex mutex;
+	ConditionVariable shardDone;
+};
+
+// [J[̏
+struct BatchWorker
+{
+	BatchContext* context;
+	Thread thread;
+	int frames;
+	double busySeconds;
+	bool failed;
+};
+
+// 8rbg̃O[XP[(channels = 1)܂BGR/BGRX(channels = 3A4)̉摜PGM/PPMŏo
+static bool writeImage( const std::string& path, const uint8_t* data, int channels, std::vector<uint8_t>& row )
+{
+	FILE* file = std::fopen( path.c_str(), "wb" );
+	if( !file ){
+		return false;
+	}
+	const bool gray = ( channels == 1 );
+	std::fprintf( file, "%s\n%d %d\n255\n", gray ? "P5" : "P6", WIDTH, HEIGHT );
+	bool result = true;
+	if( gray ){
+		result = std::fwrite( data, PIXELS, 1, file ) == 1;
+	}
+	else{
+		// PPM̉f̕тRGB
+		row.resize( WIDTH * 3 );
+		for( int y = 0; y < HEIGHT && result; y++ ){
+			const uint8_t* src = data + y * WIDTH * channels;
+			for( int x = 0; x < WIDTH; x++ ){
+				row[x * 3 + 0] = src[x * channels + 2];
+				row[x * 3 + 1] = src[x * channels + 1];
+				row[x * 3 + 2] = src[x * channels + 0];
+			}
+			result = std::fwrite( &row[0], row.size(), 1, file ) == 1;
+		}
+	}
+	return std::fclose( file ) == 0 && result;
+}
+
+static std::string makeImagePath( const std::string& outputPath, const char* directory, int index, const char* extension )
+{
+	char name[32];
+	std::sprintf( name, "%06d.%s", index, extension );
+	return outputPath + "/" + directory + "/" + name;
+}
+
+// [J[̃Xbh
+// Shard1oAReplayFrameSourceł͈̔͂ֈړď
+// ClippingAPlayerƓFrameProcessorĂяoXbhōs(񉻂Shard̒Pʂōs)
+static void workerEntry( void* argument )
+{
+	BatchWorker* worker = static_cast<BatchWorker*>( argument );
+	BatchContext* context = worker->context;
+	setTraceThreadName( "worker" );
+
+	const int streams = ( context->mode & BATCH_MODE_CLIP ) ? FRAME_STREAM_FLAG_COLOR | FRAME_STREAM_FLAG_DEPTH : FRAME_STREAM_FLAG_DEPTH;
+	ReplayFrameSource source;
+	if( !source.open( context->replayPath, streams ) ){
+		worker->failed = true;
+	}
+
+	ClippingProcessor clippingProcessor( *context->table );
+	clippingProcessor.setIterations( context->iterationErode, context->iterationDilate );
+	clippingProcessor.setShape( context->shape );
+	clippingProcessor.setIncremental( context->incremental );
+	PlayerProcessor playerProcessor( *context->table );
+
+	// Player̉f́AŌɃfR[h鏈œvƂċ߂
+	clippingProcessor.setPlayerStats( !( context->mode & BATCH_MODE_PLAYER ) );
+	playerProcessor.setPlayerStats( ( context->mode & BATCH_MODE_PLAYER ) != 0 );
+
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint8_t> mask( PIXELS );
+	std::vector<uint8_t> clip( PIXELS * 4 );
+	std::vector<uint8_t> depth8( PIXELS );
+	std::vector<uint8_t> player( PIXELS * 3 );
+	std::vector<uint8_t> row;
+
+	for( ;; ){
+		const long shardIndex = atomicAdd( &context->nextShard, 1 ) - 1;
+		if( shardIndex >= static_cast<long>( context->shards.size() ) ){
+			break;
+		}
+		Shard& shard = context->shards[shardIndex];
+		shard.failed = worker->failed;
+
+		const double start = getTimeInSeconds();
+		if( !shard.failed ){
+			source.seek( shard.begin );
+		}
+		for( int index = shard.begin; index < shard.end && !shard.failed; index++ ){
+			// g[X̃Cxgɂ͋L^t@C̑g̔ԍ(o͂摜̖O)t
+			setTraceFrame( index );
+			FrameSet frames;
+			bool read;
+			{
+				TraceScope trace( "read" );
+				read = source.read( frames );
+			}
+			if( !read ){
+				shard.failed = true;
+				break;
+			}
+			const uint16_t* depth = reinterpret_cast<const uint16_t*>( frames.depth.data );
+
+			FrameStatistics statistics;
+			std::memset( &statistics, 0, sizeof( statistics ) );
+			statistics.index = index;
+			statistics.timestamp = frames.depth.info.timestamp;
+			statistics.depthFrameNumber = frames.depth.info.frameNumber;
+			statistics.colorFrameNumber = frames.color.data ? frames.color.info.frameNumber : 0;
+
+			if( context->mode & BATCH_MODE_CLIP ){
+				clippingProcessor.process( depth, frames.color.data, &mask[0], &clip[0], &registered[0] );
+				for( int i = 0; i < PIXELS; i++ ){
+					statistics.maskPixels += mask[i] ? 1 : 0;
+				}
+			}
+			if( context->mode & BATCH_MODE_PLAYER ){
+				playerProcessor.process( depth, &depth8[0], &player[0], &registered[0] );
+			}
+
+			// fR[ĥƂɋ߂vĝŁAʒu킹Depth&PlayerǂݒȂ
+			const PlayerStats* playerStats = ( context->mode & BATCH_MODE_PLAYER ) ? playerProcessor.getPlayerStats() : clippingProcessor.getPlayerStats();
+			for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+				statistics.playerPixels[i] = playerStats[i].pixels;
+			}
+
+			if( context->writeImages ){
+				TraceScope trace( "write" );
+				bool written = true;
+				if( context->mode & BATCH_MODE_CLIP ){
+					written = written && writeImage( makeImagePath( context->outputPath, "mask", index, "pgm" ), &mask[0], 1, row );
+					written = written && writeImage( makeImagePath( context->outputPath, "clip", index, "ppm" ), &clip[0], 4, row );
+				}
+				if( context->mode & BATCH_MODE_PLAYER ){
+					written = written && writeImage( makeImagePath( context->outputPath, "depth", index, "pgm" ), &depth8[0], 1, row );
+					written = written && writeImage( makeImagePath( context->outputPath, "player", index, "ppm" ), &player[0], 3, row );
+				}
+				if( !written ){
+					shard.failed = true;
+					break;
+				}
+			}
+
+			shard.statistics.push_back( statistics );
+			worker->frames++;
+		}
+		worker->busySeconds += getTimeInSeconds() - start;
+
+		ScopedLock lock( context->mutex );
+		shard.done = true;
+		context->shardDone.notifyAll();
+	}
+}
+
+static void printUsage()
+{
+	std::cout << "Usage : Batch -replay <file.kbr> [-output <directory>] [-mode clip|player|both] [-threads <N>] [-shards <N>]" << std::endl;
+	std::cout << "              [-erode <N>] [-dilate <N>] [-octagon] [-incremental] [-table <table.bin>] [-no-images] [-metrics <file>|-] [-trace <file>]" << std::endl;
+}
+
+int main( int argc, char* argv[] )
+{
+	// ̉
+	const char* replayPath = nullptr;
+	const char* tablePath = nullptr;
+	const char* metricsPath = nullptr;
+	const char* tracePath = nullptr;
+	std::string outputPath = "BatchOutput";
+	std::string modeName = "both";
+	int threadCount = 0;
+	int shardCount = 0;
+	int iterationErode = 2;
+	int iterationDilate = 2;
+	MorphologyShape shape = MORPHOLOGY_RECT;
+	bool incremental = false;
+	bool writeImages = true;
+	for( int i = 1; i < argc; i++ ){
+		const std::string arg = argv[i];
+		if( arg == "-replay" && i + 1 < argc ){
+			replayPath = argv[++i];
+		}
+		else if( arg == "-output" && i + 1 < argc ){
+			outputPath = argv[++i];
+		}
+		else if( arg == "-mode" && i + 1 < argc ){
+			modeName = argv[++i];
+		}
+		else if( arg == "-threads" && i + 1 < argc ){
+			threadCount = std::atoi( argv[++i] );
+		}
+		else if( arg == "-shards" && i + 1 < argc ){
+			shardCount = std::atoi( argv[++i] );
+		}
+		else if( arg == "-erode" && i + 1 < argc ){
+			iterationErode = std::atoi( argv[++i] );
+		}
+		else if( arg == "-dilate" && i + 1 < argc ){
+			iterationDilate = std::atoi( argv[++i] );
+		}
+		else if( arg == "-octagon" ){
+			shape = MORPHOLOGY_OCTAGON;
+		}
+		else if( arg == "-incremental" ){
+			incremental = true;
+		}
+		else if( arg == "-table" && i + 1 < argc ){
+			tablePath = argv[++i];
+		}
+		else if( arg == "-metrics" && i + 1 < argc ){
+			metricsPath = argv[++i];
+		}
+		else if( arg == "-trace" && i + 1 < argc ){
+			tracePath = argv[++i];
+		}
+		else if( arg == "-no-images" ){
+			writeImages = false;
+		}
+		else{
+			printUsage();
+			return -1;
+		}
+	}
+
+	int mode = 0;
+	if( modeName == "clip" ){
+		mode = BATCH_MODE_CLIP;
+	}
+	else if( modeName == "player" ){
+		mode = BATCH_MODE_PLAYER;
+	}
+	else if( modeName == "both" ){
+		mode = BATCH_MODE_CLIP | BATCH_MODE_PLAYER;
+	}
+	if( !replayPath || !mode ){
+		printUsage();
+		return -1;
+	}
+	if( threadCount <= 0 ){
+		threadCount = getProcessorCount();
+	}
+
+	// ȉԂ̃qXgO([J[ɋL^A1bɏWvďo)
+	if( metricsPath && !startMetricsReporter( metricsPath ) ){
+		std::cerr << "Error : startMetricsReporter( " << metricsPath << " )" << std::endl;
+		return -1;
+	}
+
+	// [J[̏̊JnƏI(IChromẽg[X`ŏo)
+	if( tracePath ){
+		if( !startTrace( tracePath ) ){
+			std::cerr << "Error : startTrace( " << tracePath << " )" << std::endl;
+			return -1;
+		}
+		setTraceThreadName( "main" );
+	}
+
+	// L^t@C̃t[̑g̐ƃ^CX^v
+	// Shard͈̔͂͂ReplayFrameSourceŌ߁A̓[J[ɊJReplayFrameSourceōs
+	const int streams = ( mode & BATCH_MODE_CLIP ) ? FRAME_STREAM_FLAG_COLOR | FRAME_STREAM_FLAG_DEPTH : FRAME_STREAM_FLAG_DEPTH;
+	ReplayFrameSource source;
+	if( !source.open( replayPath, streams ) ){
+		std::cerr << "Error : ReplayFrameSource::open( " << replayPath << " )" << std::endl;
+		return -1;
+	}
+	const RecordingReader& reader = source.getReader();
+	const int frameCount = source.getFrameCount();
+
+	// ʒu킹e[u("-table <file>"Ƃ̓Jf̌̒l)
+	RegistrationTable table;
+	if( tablePath ){
+		if( !table.load( tablePath ) ){
+			std::cerr << "Error : RegistrationTable::load( " << tablePath << " )" << std::endl;
+			return -1;
+		}
+	}
+	else{
+		CameraModel model;
+		model.setDefault();
+		table.build( model );
+	}
+
+	// o͐̃fBNg
+	if( !createDirectory( outputPath.c_str() ) ){
+		std::cerr << "Error : createDirectory( " << outputPath << " )" << std::endl;
+		return -1;
+	}
+	if( writeImages ){
+		const char* directories[] = { "mask", "clip", "depth", "player" };
+		for( int i = 0; i < 4; i++ ){
+			if( !( mode & ( i < 2 ? BATCH_MODE_CLIP : BATCH_MODE_PLAYER ) ) ){
+				continue;
+			}
+			const std::string directory = outputPath + "/" + directories[i];
+			if( !createDirectory( directory.c_str() ) ){
+				std::cerr << "Error : createDirectory( " << directory << " )" << std::endl;
+				return -1;
+			}
+		}
+	}
+
+	// L^̎Ԃ𓙂Shardɕ
+	// Ẽ^CX^vȍ~ōłÂt[̑g玟̋ȆO܂ł1ShardƂ
+	// ([J[葽ĂAI[J[玟Shard̂ŁAl̑Ԃ΂Ă҂Ȃ)
+	if( shardCount <= 0 ){
+		shardCount = threadCount * 4;
+	}
+	if( shardCount > frameCount ){
+		shardCount = frameCount;
+	}
+	const int64_t firstTimestamp = reader.getIndexEntry( FRAME_STREAM_DEPTH, 0 ).timestamp;
+	const int64_t lastTimestamp = reader.getIndexEntry( FRAME_STREAM_DEPTH, frameCount - 1 ).timestamp;
+	const int64_t duration = lastTimestamp - firstTimestamp + 1;
+
+	BatchContext context;
+	context.replayPath = replayPath;
+	context.outputPath = outputPath;
+	context.table = &table;
+	context.mode = mode;
+	context.writeImages = writeImages;
+	context.iterationErode = iterationErode;
+	context.iterationDilate = iterationDilate;
+	context.shape = shape;
+	context.incremental = incremental;
+	context.nextShard = 0;
+
+	std::vector<int> boundaries( shardCount + 1 );
+	boundaries[0] = 0;
+	boundaries[shardCount] = frameCount;
+	for( int i = 1; i < shardCount; i++ ){
+		const int64_t timestamp = firstTimestamp + duration * i / shardCount;
+		int index = reader.findByTime( FRAME_STREAM_DEPTH, timestamp );
+		if( reader.getIndexEntry( FRAME_STREAM_DEPTH, index ).timestamp < timestamp ){
+			index++;
+		}
+		boundaries[i] = ( std::max )( boundaries[i - 1], ( std::min )( index, frameCount ) );
+	}
+	for( int i = 0; i < shardCount; i++ ){
+		if( boundaries[i] == boundaries[i + 1] ){
+			// t[̖(L^r؂Ă)
+			continue;
+		}
+		Shard shard;
+		shard.begin = boundaries[i];
+		shard.end = boundaries[i + 1];
+		shard.beginTimestamp = reader.getIndexEntry( FRAME_STREAM_DEPTH, shard.begin ).timestamp;
+		shard.statistics.reserve( shard.end - shard.begin );
+		shard.done = false;
+		shard.failed = false;
+		context.shards.push_back( shard );
+	}
+	if( threadCount > static_cast<int>( context.shards.size() ) ){
+		threadCount = static_cast<int>( context.shards.size() );
+	}
+	std::cout << "replay : " << replayPath << " (" << frameCount << " frames, " << duration / 1000.0 << " s)" << std::endl;
+	std::cout << "mode : " << modeName << ", threads : " << threadCount << ", shards : " << context.shards.size() << ", output : " << outputPath << ( writeImages ? "" : " (statistics only)" ) << std::endl;
+
+	// t[̓v(C̃XbhL^̏ɏo)
+	const std::string statisticsPath = outputPath + "/frames.csv";
+	std::ofstream statisticsFile( statisticsPath.c_str() );
+	if( !statisticsFile ){
+		std::cerr << "Error : std::ofstream( " << statisticsPath << " )" << std::endl;
+		return -1;
+	}
+	statisticsFile << "index,timestamp,depthFrameNumber,colorFrameNumber,maskPixels";
+	for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+		statisticsFile << ",player" << i;
+	}
+	statisticsFile << std::endl;
+
+	// [J[̊Jn
+	const double start = getTimeInSeconds();
+	std::vector<BatchWorker> workers( threadCount );
+	for( int i = 0; i < threadCount; i++ ){
+		workers[i].context = &context;
+		workers[i].frames = 0;
+		workers[i].busySeconds = 0.0;
+		workers[i].failed = false;
+		if( !workers[i].thread.start( workerEntry, &workers[i] ) ){
+			std::cerr << "Error : Thread::start" << std::endl;
+			return -1;
+		}
+	}
+
+	// IShard̓v擪珇ɏo(ShardIĂĂAOShardI܂ő҂)
+	bool failed = false;
+	int written = 0;
+	for( size_t i = 0; i < context.shards.size(); i++ ){
+		Shard& shard = context.shards[i];
+		{
+			ScopedLock lock( context.mutex );
+			while( !shard.done ){
+				context.shardDone.wait( context.mutex );
+			}
+		}
+		if( shard.failed ){
+			std::cerr << "Error : frames " << shard.begin << "-" << shard.end - 1 << " (" << shard.beginTimestamp << " ms)" << std::endl;
+			failed = true;
+		}
+		for( size_t j = 0; j < shard.statistics.size(); j++ ){
+			const FrameStatistics& statistics = shard.statistics[j];
+			statisticsFile << statistics.index << "," << statistics.timestamp << "," << statistics.depthFrameNumber << "," << statistics.colorFrameNumber << "," << statistics.maskPixels;
+			for( int k = 0; k <= KINECT_PLAYER_COUNT; k++ ){
+				statisticsFile << "," << statistics.playerPixels[k];
+			}
+			statisticsFile << "\n";
+		}
+		written += static_cast<int>( shard.statistics.size() );
+		std::vector<FrameStatistics>().swap( shard.statistics );
+	}
+	for( int i = 0; i < threadCount; i++ ){
+		workers[i].thread.join();
+	}
+	const double elapsed = getTimeInSeconds() - start;
+	statisticsFile.close();
+	stopMetricsReporter();
+	stopTrace();
+
+	// Ŝƃ[J[̃t[[g
+	std::cout << std::fixed << std::setprecision( 1 );
+	for( int i = 0; i < threadCount; i++ ){
+		const BatchWorker& worker = workers[i];
+		std::cout << "worker " << i << " : " << worker.frames << " frames, " << ( worker.busySeconds > 0.0 ? worker.frames / worker.busySeconds : 0.0 ) << " fps" << std::endl;
+	}
+	std::cout << "total : " << written << " / " << frameCount << " frames in " << elapsed << " s, " << ( elapsed > 0.0 ? written / elapsed : 0.0 ) << " fps" << std::endl;
+	std::cout << "statistics : " << statisticsPath << std::endl;
+
+	return failed ? -1 : 0;
+}
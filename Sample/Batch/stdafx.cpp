@@ -0,0 +1,8 @@
+// stdafx.cpp : WCN[h Batch.pch ݂̂
+// ܂ރ\[X t@ĆAvRpCς݃wb_[ɂȂ܂B
+// stdafx.obj ɂ̓vRpCς݌^񂪊܂܂܂B
+
+#include "stdafx.h"
+
+// TODO: ̃t@Cł͂ȂASTDAFX.H ŕKv
+// ǉwb_[QƂĂB
@@ -0,0 +1,18 @@
+// stdafx.h : W̃VXe CN[h t@C̃CN[h t@CA܂
+// QƉ񐔂A܂ύXȂAvWFNgp̃CN[h t@C
+// Lq܂B
+//
+
+#pragma once
+
+// Linuxłrhł悤ɁAWindowsŗL̃wb_[_WIN32̂ƂQƂ
+#ifdef _WIN32
+#include "targetver.h"
+#include <tchar.h>
+#endif
+
+#include <stdio.h>
+
+
+
+// TODO: vOɕKvȒǉwb_[ŎQƂĂB
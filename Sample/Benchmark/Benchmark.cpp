@@ -0,0 +1,3209 @@
+// Benchmark.cpp : t[̏̏Ԃv
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Platform.h"
+#include "KinectTypes.h"
+#include "Registration.h"
+#include "ThreadPool.h"
+#include "DepthDecoder.h"
+#include "DepthColorizer.h"
+#include "DepthPipeline.h"
+#include "FrameBufferPool.h"
+#include "FrameRing.h"
+#include "SkeletonFrame.h"
+#include "Recording.h"
+#include "ReplayFrameSource.h"
+#include "DepthCodec.h"
+#include "SyntheticFrameSource.h"
+#include "FrameSynchronizer.h"
+#include "StagePipeline.h"
+#include "Morphology.h"
+#include "BitMask.h"
+#include "FrameProcessor.h"
+#include "PlayerLabeler.h"
+#include "Compositor.h"
+#include "BoneTransform.h"
+#include "LatencyHistogram.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "FrameTiming.h"
+#include "BenchmarkSuite.h"
+
+#ifdef _WIN32
+#include "NuiRegistration.h"
+#endif
+
+
+// q[v̊mۂ̉(ԂŃt[̊mۂƂmF邽߂ɐ)
+static volatile long g_heapAllocations = 0;
+
+// mۂƉ͑Smalloc()/free()ōs(złƃTCYt̉uāAmۂƉ̑g𑵂)
+static void* countedAllocate( size_t size )
+{
+	atomicAdd( &g_heapAllocations, 1 );
+	void* pointer = std::malloc( size ? size : 1 );
+	if( !pointer ){
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new( size_t size )
+{
+	return countedAllocate( size );
+}
+
+void* operator new[]( size_t size )
+{
+	return countedAllocate( size );
+}
+
+void operator delete( void* pointer ) throw()
+{
+	std::free( pointer );
+}
+
+void operator delete[]( void* pointer ) throw()
+{
+	std::free( pointer );
+}
+
+void operator delete( void* pointer, size_t ) throw()
+{
+	std::free( pointer );
+}
+
+void operator delete[]( void* pointer, size_t ) throw()
+{
+	std::free( pointer );
+}
+
+static const int WIDTH  = KINECT_IMAGE_WIDTH;
+static const int HEIGHT = KINECT_IMAGE_HEIGHT;
+static const int PIXELS = WIDTH * HEIGHT;
+
+// vɎgDepth&Playert[
+static std::vector< std::vector<uint16_t> > g_depthFrames;
+
+// vʂL^ĊlƔׂ(printResult()ŕ\ʂL^)
+static BenchmarkSuite* g_suite = nullptr;
+
+// Player̐F(BGȐ8F)depth8̕ϊ(Depth&Player̃fR[ȟvŎg)
+static const uint8_t PLAYER_COLORS[8][3] = { { 0, 0, 0 }, { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 255, 255, 0 }, { 255, 0, 255 }, { 0, 255, 255 }, { 0, 0, 0 } };
+static const float DEPTH8_ALPHA = -255.0f / ( ( KINECT_DEPTH_MAXIMUM_MM << KINECT_PLAYER_INDEX_SHIFT ) | KINECT_PLAYER_INDEX_MASK );
+static const float DEPTH8_BETA = 255.0f;
+
+// Depth&Playert[쐬
+// ̕ǂƏAEɓl(Player 1)͂ȉ~`(playerRadius͑ȉ~̏c̔aA0̂Ƃ͐l`Ȃ)
+static void makeSyntheticDepth( std::vector<uint16_t>& frame, int index, int playerRadius = 180 )
+{
+	frame.resize( PIXELS );
+	const int centerX = WIDTH / 2 + static_cast<int>( 150.0 * std::sin( index * 0.1 ) );
+	const int centerY = HEIGHT / 2;
+	for( int y = 0; y < HEIGHT; y++ ){
+		for( int x = 0; x < WIDTH; x++ ){
+			int depthMm = 3500;
+			if( y > HEIGHT * 2 / 3 ){
+				depthMm = 3500 - ( y - HEIGHT * 2 / 3 ) * 8;
+			}
+			int player = 0;
+			const int dx = ( x - centerX ) * 2;
+			const int dy = y - centerY;
+			if( dx * dx + dy * dy < playerRadius * playerRadius ){
+				depthMm = 1800 + ( dx * dx + dy * dy ) / 400;
+				player = 1;
+			}
+			// ̗̂֊st߂͌vłȂ
+			if( ( x + y * 7 + index ) % 97 == 0 ){
+				depthMm = 0;
+				player = 0;
+			}
+			frame[y * WIDTH + x] = static_cast<uint16_t>( ( depthMm << KINECT_PLAYER_INDEX_SHIFT ) | player );
+		}
+	}
+}
+
+// raw`(640x48016rbgfA)Depth&Playert[ǂݍ
+static bool loadRawDepth( const char* path, int maxFrames )
+{
+	std::ifstream ifs( path, std::ios::binary );
+	if( !ifs ){
+		return false;
+	}
+	std::vector<uint16_t> frame( PIXELS );
+	while( static_cast<int>( g_depthFrames.size() ) < maxFrames ){
+		ifs.read( reinterpret_cast<char*>( &frame[0] ), sizeof( uint16_t ) * PIXELS );
+		if( !ifs ){
+			break;
+		}
+		g_depthFrames.push_back( frame );
+	}
+	return !g_depthFrames.empty();
+}
+
+// func( frameIndex )iterationssāA1t[̕Ϗ[ms]߂
+template<class Func>
+static double measure( int iterations, Func func )
+{
+	// EH[Abv
+	func( 0 );
+
+	const double start = getTimeInSeconds();
+	for( int i = 0; i < iterations; i++ ){
+		func( i );
+	}
+	return ( getTimeInSeconds() - start ) * 1000.0 / iterations;
+}
+
+// measure()ƓfuncvÅԂMETRIC_MORPH֋L^1t[̎Ԃ̒l[ms]stageMsɋ߂
+template<class Func>
+static double measureWithMorphStage( int iterations, Func func, double& stageMs )
+{
+	LatencyHistogram before;
+	getMetricSnapshot( METRIC_MORPH, before );
+	setMetricsEnabled( true );
+	const double ms = measure( iterations, func );
+	setMetricsEnabled( false );
+	LatencyHistogram after;
+	getMetricSnapshot( METRIC_MORPH, after );
+	after.subtract( before );
+	stageMs = after.getPercentile( 50.0 ) / 1000.0;
+	return ms;
+}
+
+static void printResult( const char* name, double msPerFrame )
+{
+	if( g_suite ){
+		g_suite->record( name, msPerFrame );
+	}
+	std::cout << std::left << std::setw( 40 ) << name << " : "
+		<< std::right << std::fixed << std::setprecision( 3 ) << std::setw( 9 ) << msPerFrame << " ms/frame ("
+		<< std::setprecision( 1 ) << std::setw( 7 ) << 1000.0 / msPerFrame << " fps)" << std::endl;
+}
+
+// fɕϊ֐ĂяoA]ǂ̈ʒu킹
+// (NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()𖈉fĂяôƓ`̏)
+static void registerPerPixel( const CameraModel& model, const uint16_t* src, uint16_t* dst )
+{
+	std::memset( dst, 0, sizeof( uint16_t ) * PIXELS );
+	for( int y = 0; y < HEIGHT; y++ ){
+		for( int x = 0; x < WIDTH; x++ ){
+			float colorX = 0.0f;
+			float colorY = 0.0f;
+			const int depthMm = *src >> KINECT_PLAYER_INDEX_SHIFT;
+			if( model.projectToColor( static_cast<float>( x ), static_cast<float>( y ), static_cast<float>( depthMm ), &colorX, &colorY ) ){
+				const int registX = static_cast<int>( std::floor( colorX + 0.5f ) );
+				const int registY = static_cast<int>( std::floor( colorY + 0.5f ) );
+				if( ( registX >= 0 ) && ( registX < WIDTH ) && ( registY >= 0 ) && ( registY < HEIGHT ) ){
+					dst[registY * WIDTH + registX] = *src;
+				}
+			}
+			src++;
+		}
+	}
+}
+
+// ]ǂ̃fR[h(Player.cpp̉f̃[vcv::Mat::convertTo()2̑)
+static void decodeMultiPass( const uint16_t* src, uint16_t* depth, uint8_t* player, uint8_t* depth8, const uint8_t* colors, float alpha, float beta )
+{
+	for( int i = 0; i < PIXELS; i++ ){
+		depth[i] = src[i] & KINECT_DEPTH_MASK;
+		const uint8_t* color = colors + ( src[i] & KINECT_PLAYER_INDEX_MASK ) * 3;
+		player[i * 3 + 0] = color[0];
+		player[i * 3 + 1] = color[1];
+		player[i * 3 + 2] = color[2];
+	}
+	for( int i = 0; i < PIXELS; i++ ){
+		const int value = static_cast<int>( std::floor( depth[i] * alpha + beta + 0.5f ) );
+		depth8[i] = static_cast<uint8_t>( ( value < 0 ) ? 0 : ( ( value > 255 ) ? 255 : value ) );
+	}
+}
+
+// 8rbgDepth3`lɍL(cv::cvtColor( CV_GRAY2BGR )Ɠ)
+static void expandGrayToBgr( const uint8_t* gray, uint8_t* bgr )
+{
+	for( int i = 0; i < PIXELS; i++ ){
+		bgr[i * 3 + 0] = gray[i];
+		bgr[i * 3 + 1] = gray[i];
+		bgr[i * 3 + 2] = gray[i];
+	}
+}
+
+// fR[hƂ͕ʂɑĐAPlayer̓v(DepthDecodeOutput::stats̊)
+static void countPlayerStats( const uint16_t* src, PlayerStats* stats )
+{
+	for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+		stats[i].reset();
+	}
+	for( int i = 0; i < PIXELS; i++ ){
+		const int index = src[i] & KINECT_PLAYER_INDEX_MASK;
+		if( index > KINECT_PLAYER_COUNT ){
+			continue;
+		}
+		PlayerStats& playerStats = stats[index];
+		const int depth = src[i] >> KINECT_PLAYER_INDEX_SHIFT;
+		playerStats.pixels++;
+		playerStats.sumX += i % WIDTH;
+		playerStats.sumY += i / WIDTH;
+		playerStats.histogram[depth >> PLAYER_STATS_BIN_SHIFT]++;
+		if( depth ){
+			playerStats.nearest = static_cast<uint16_t>( ( playerStats.depthPixels == 0 || depth < playerStats.nearest ) ? depth : playerStats.nearest );
+			playerStats.farthest = static_cast<uint16_t>( ( std::max )( static_cast<int>( playerStats.farthest ), depth ) );
+			playerStats.depthPixels++;
+			playerStats.depthSum += depth;
+		}
+	}
+}
+
+static bool isSamePlayerStats( const PlayerStats* a, const PlayerStats* b )
+{
+	return std::memcmp( a, b, sizeof( PlayerStats ) * ( KINECT_PLAYER_COUNT + 1 ) ) == 0;
+}
+
+// 3~3̍\vfiterationsJԂA]ǂ̎k/c(cv::erode()/cv::dilate()iterationsnƂƓ)
+// octagon̂Ƃ͋`Ə\`݂ɎgA摜̊Ỏf͎gȂ
+static void morphologyIterated( uint8_t* image, int width, int height, int iterations, bool octagon, bool minimum )
+{
+	std::vector<uint8_t> src( image, image + width * height );
+	for( int n = 0; n < iterations; n++ ){
+		const bool cross = octagon && ( n % 2 == 1 );
+		src.assign( image, image + width * height );
+		for( int y = 0; y < height; y++ ){
+			for( int x = 0; x < width; x++ ){
+				uint8_t value = src[y * width + x];
+				for( int dy = -1; dy <= 1; dy++ ){
+					for( int dx = -1; dx <= 1; dx++ ){
+						if( ( cross && dx != 0 && dy != 0 ) || x + dx < 0 || x + dx >= width || y + dy < 0 || y + dy >= height ){
+							continue;
+						}
+						const uint8_t neighbor = src[( y + dy ) * width + x + dx];
+						value = minimum ? ( std::min )( value, neighbor ) : ( std::max )( value, neighbor );
+					}
+				}
+				image[y * width + x] = value;
+			}
+		}
+	}
+}
+
+// fɓhԂĘA(8ߖT)߂APlayerLabeler̊mFp̏
+// ͍ォf𑖍ČɕׁAlabelsɂ͉f̐̃CfbNX(PlayerłȂ-1)
+static void labelComponentsByFlooding( const uint16_t* registered, std::vector<int>& labels, std::vector<PlayerComponent>& components )
+{
+	labels.assign( PIXELS, -1 );
+	components.clear();
+	std::vector<int> stack;
+	for( int start = 0; start < PIXELS; start++ ){
+		const int player = registered[start] & KINECT_PLAYER_INDEX_MASK;
+		if( player == 0 || player > KINECT_PLAYER_COUNT || labels[start] >= 0 ){
+			continue;
+		}
+		PlayerComponent component;
+		component.player = player;
+		component.area = 0;
+		component.bounds.left = WIDTH;
+		component.bounds.top = HEIGHT;
+		component.bounds.right = 0;
+		component.bounds.bottom = 0;
+		double sumX = 0.0, sumY = 0.0, sumDepth = 0.0;
+		int depthCount = 0;
+		const int id = static_cast<int>( components.size() );
+		labels[start] = id;
+		stack.push_back( start );
+		while( !stack.empty() ){
+			const int index = stack.back();
+			stack.pop_back();
+			const int x = index % WIDTH;
+			const int y = index / WIDTH;
+			component.area++;
+			component.bounds.left = ( std::min )( component.bounds.left, x );
+			component.bounds.top = ( std::min )( component.bounds.top, y );
+			component.bounds.right = ( std::max )( component.bounds.right, x + 1 );
+			component.bounds.bottom = ( std::max )( component.bounds.bottom, y + 1 );
+			sumX += x;
+			sumY += y;
+			const int depth = registered[index] >> KINECT_PLAYER_INDEX_SHIFT;
+			sumDepth += depth;
+			depthCount += ( depth != 0 ) ? 1 : 0;
+			for( int dy = -1; dy <= 1; dy++ ){
+				for( int dx = -1; dx <= 1; dx++ ){
+					const int nx = x + dx;
+					const int ny = y + dy;
+					if( nx < 0 || nx >= WIDTH || ny < 0 || ny >= HEIGHT ){
+						continue;
+					}
+					const int neighbor = ny * WIDTH + nx;
+					if( labels[neighbor] < 0 && ( registered[neighbor] & KINECT_PLAYER_INDEX_MASK ) == player ){
+						labels[neighbor] = id;
+						stack.push_back( neighbor );
+					}
+				}
+			}
+		}
+		component.centroidX = static_cast<float>( sumX / component.area );
+		component.centroidY = static_cast<float>( sumY / component.area );
+		component.meanDepth = depthCount ? static_cast<float>( sumDepth / depthCount ) : 0.0f;
+		component.removed = false;
+		components.push_back( component );
+	}
+}
+
+// fɔ̒̃}XN̉f𐔂čABackgroundCompositor̊mFp̏(摜̊O͒[̉f̂Ƃ)
+static void compositeByBoxFilter( const uint8_t* foreground, const uint8_t* mask, const uint8_t* background, uint8_t* dst, int radius )
+{
+	const int area = ( 2 * radius + 1 ) * ( 2 * radius + 1 );
+	for( int y = 0; y < HEIGHT; y++ ){
+		for( int x = 0; x < WIDTH; x++ ){
+			int count = 0;
+			for( int dy = -radius; dy <= radius; dy++ ){
+				const int sy = ( std::min )( ( std::max )( y + dy, 0 ), HEIGHT - 1 );
+				for( int dx = -radius; dx <= radius; dx++ ){
+					const int sx = ( std::min )( ( std::max )( x + dx, 0 ), WIDTH - 1 );
+					count += mask[sy * WIDTH + sx] ? 1 : 0;
+				}
+			}
+			const double alpha = std::floor( 255.0 * count / area + 0.5 );
+			const int index = ( y * WIDTH + x ) * 4;
+			for( int c = 0; c < 4; c++ ){
+				dst[index + c] = static_cast<uint8_t>( std::floor( ( foreground[index + c] * alpha + background[index + c] * ( 255.0 - alpha ) ) / 255.0 + 0.5 ) );
+			}
+		}
+	}
+}
+
+// 2̈ʒu킹ʂŒlvf̊[%]
+static double matchRate( const std::vector<uint16_t>& a, const std::vector<uint16_t>& b )
+{
+	int match = 0;
+	for( int i = 0; i < PIXELS; i++ ){
+		if( a[i] == b[i] ){
+			match++;
+		}
+	}
+	return 100.0 * match / PIXELS;
+}
+
+// hCõL[͂āAAvP[V󂯎t[̔ԍ𐔂
+// t[30fpsœ͂AL[(NuiImageStreamOpen()dwFrameLimit)ƃAvP[VێĂt[̍v
+// queueDepthɒBĂƂ͗Ƃ
+// holdMs[i]iԖڂɎ󂯎t[hCo֕Ԃ܂ł̎ԁAworkMs[i]͕Ԃɑ̎
+static void simulateDriverQueue( int queueDepth, const std::vector<double>& holdMs, const std::vector<double>& workMs, FrameDropCounter& dropCounter )
+{
+	const double interval = 1000.0 / 30.0;
+	std::deque<uint32_t> queue;
+	uint32_t nextFrame = 0;
+	int held = 0;
+	double now = 0.0;
+
+	// now܂łɓ͂t[L[֓
+	auto arrive = [&]( double until ){
+		while( nextFrame * interval <= until ){
+			if( static_cast<int>( queue.size() ) + held < queueDepth ){
+				queue.push_back( nextFrame );
+			}
+			nextFrame++;
+		}
+	};
+
+	dropCounter.reset();
+	for( size_t i = 0; i < holdMs.size(); i++ ){
+		// t[̍XV҂
+		arrive( now );
+		if( queue.empty() ){
+			now = nextFrame * interval;
+			arrive( now );
+		}
+		dropCounter.update( queue.front() );
+		queue.pop_front();
+
+		held = 1;
+		now += holdMs[i];
+		arrive( now );
+		held = 0;
+		now += workMs[i];
+	}
+}
+
+// Colort[Skeletont[쐬(makeSyntheticDepth()̐lɍ킹)
+static void makeSyntheticColorAndSkeleton( std::vector<uint8_t>& color, SkeletonFrame& skeleton, int index )
+{
+	color.resize( PIXELS * 4 );
+	for( int y = 0; y < HEIGHT; y++ ){
+		for( int x = 0; x < WIDTH; x++ ){
+			uint8_t* pixel = &color[( y * WIDTH + x ) * 4];
+			pixel[0] = static_cast<uint8_t>( x + index );
+			pixel[1] = static_cast<uint8_t>( y );
+			pixel[2] = static_cast<uint8_t>( x ^ y );
+			pixel[3] = 0;
+		}
+	}
+
+	std::memset( &skeleton, 0, sizeof( skeleton ) );
+	skeleton.timestamp = index * 33;
+	skeleton.frameNumber = index;
+	skeleton.floorClipPlane.y = 1.0f;
+	skeleton.floorClipPlane.w = 0.8f;
+	SkeletonData& data = skeleton.skeletons[0];
+	data.trackingState = SKELETON_TRACKED;
+	data.trackingId = 1;
+	data.position.x = static_cast<float>( 150.0 * std::sin( index * 0.1 ) / 285.63 * 1.8 );
+	data.position.z = 1.8f;
+	for( int i = 0; i < KINECT_SKELETON_POSITION_COUNT; i++ ){
+		data.positions[i] = data.position;
+		data.positions[i].y = 0.6f - i * 0.06f;
+		data.positionTrackingStates[i] = SKELETON_POSITION_TRACKED;
+	}
+}
+
+// ۂ̃ZT[ɋ߂Av̗h炬̂Depth&Playert[쐬
+// (̂̂fɁ}mm̃mCYAvłȂfU΂点)
+static void addDepthNoise( std::vector<uint16_t>& frame, int index )
+{
+	uint32_t seed = 2463534242u + index * 7919u;
+	for( int i = 0; i < PIXELS; i++ ){
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		const int depthMm = frame[i] >> KINECT_PLAYER_INDEX_SHIFT;
+		if( depthMm == 0 ){
+			continue;
+		}
+		if( ( seed & 0xff ) < 3 ){
+			frame[i] = 0;
+			continue;
+		}
+		const int noisy = depthMm + static_cast<int>( ( seed >> 8 ) % 7 ) - 3;
+		frame[i] = static_cast<uint16_t>( ( noisy << KINECT_PLAYER_INDEX_SHIFT ) | ( frame[i] & KINECT_PLAYER_INDEX_MASK ) );
+	}
+}
+
+// Depth̉tk̈kƑxvĕ\(WJt[̃t[ƈv邱Ƃm߂)
+static void measureDepthCodec( const char* name, const std::vector< std::vector<uint16_t> >& frames, bool temporal, int iterations )
+{
+	const int frameCount = static_cast<int>( frames.size() );
+	DepthCompressor compressor( WIDTH, HEIGHT );
+	compressor.setTemporal( temporal );
+	std::vector< std::vector<uint8_t> > compressed( frameCount );
+	std::vector<uint8_t> buffer( compressor.getMaxCompressedSize() );
+	uint64_t compressedBytes = 0;
+	for( int i = 0; i < frameCount; i++ ){
+		const size_t size = compressor.compress( &frames[i][0], &buffer[0] );
+		compressed[i].assign( buffer.begin(), buffer.begin() + size );
+		compressedBytes += size;
+	}
+
+	// kƓWJ̓t[̏ɌJԂ(Õt[Ƃ̍ĝŁA擪ɖ߂Ƃ̓L[t[)
+	compressor.reset();
+	const double compressMs = measure( iterations, [&]( int i ){
+		if( i % frameCount == 0 ){
+			compressor.reset();
+		}
+		compressor.compress( &frames[i % frameCount][0], &buffer[0] );
+	} );
+
+	DepthDecompressor decompressor;
+	std::vector<uint16_t> decoded( PIXELS );
+	bool lossless = true;
+	for( int i = 0; i < frameCount; i++ ){
+		lossless = lossless && decompressor.decompress( &compressed[i][0], compressed[i].size(), &decoded[0], WIDTH, HEIGHT ) && std::memcmp( &decoded[0], &frames[i][0], sizeof( uint16_t ) * PIXELS ) == 0;
+	}
+	decompressor.reset();
+	const double decompressMs = measure( iterations, [&]( int i ){
+		const std::vector<uint8_t>& frame = compressed[i % frameCount];
+		decompressor.decompress( &frame[0], frame.size(), &decoded[0], WIDTH, HEIGHT );
+	} );
+
+	const double rawMB = sizeof( uint16_t ) * PIXELS / ( 1024.0 * 1024.0 );
+	std::cout << "  " << std::left << std::setw( 30 ) << name << std::right << std::fixed << " : ratio " << std::setprecision( 2 ) << std::setw( 5 ) << static_cast<double>( sizeof( uint16_t ) * PIXELS ) * frameCount / compressedBytes
+		<< ", compress " << std::setprecision( 3 ) << compressMs << " ms (" << std::setprecision( 0 ) << rawMB * 1000.0 / compressMs << " MB/s)"
+		<< ", decompress " << std::setprecision( 3 ) << decompressMs << " ms (" << std::setprecision( 0 ) << rawMB * 1000.0 / decompressMs << " MB/s)"
+		<< ", lossless : " << ( lossless ? "yes" : "NO" ) << std::endl;
+}
+
+// L^t@CǂݏoXg[̃t[Ah炬ē͂Cxg
+struct StreamEvent
+{
+	double arrival;    // ͂[s]
+	int stream;
+	int record;        // L^t@C̃R[h̔ԍ
+	int cycle;         // L^t@CJԂ
+	int64_t timestamp; // h炬^CX^v[ms]
+
+	bool operator<( const StreamEvent& other ) const { return arrival < other.arrival; }
+};
+
+// L^t@C̑SẴXg[̃R[hcyclesJԂAZT[̂悤ɗh炢^CX^vƓ͂t
+// Color͘I̕^CX^vxA͂܂ł̎ԂXg[ɈقȂ
+// dropPercent[%]̊Ńt[𗎂Ƃ(Skeleton͗ƂȂ)
+static void makeJitteredEvents( const RecordingReader& reader, int cycles, int jitterMs, int dropPercent, std::vector<StreamEvent>& events )
+{
+	static const int timestampOffsetMs[FRAME_STREAM_COUNT] = { 2, 0, 0 };
+	static const int deliveryMs[FRAME_STREAM_COUNT] = { 12, 8, 20 };
+
+	events.clear();
+	uint32_t seed = 88675123u;
+	for( int stream = 0; stream < FRAME_STREAM_COUNT; stream++ ){
+		const int count = reader.getFrameCount( stream );
+		const int64_t duration = ( count > 0 ) ? reader.getIndexEntry( stream, count - 1 ).timestamp + 33 : 0;
+		for( int cycle = 0; cycle < cycles; cycle++ ){
+			for( int i = 0; i < count; i++ ){
+				seed ^= seed << 13;
+				seed ^= seed >> 17;
+				seed ^= seed << 5;
+				if( stream != FRAME_STREAM_SKELETON && static_cast<int>( seed % 100 ) < dropPercent ){
+					continue;
+				}
+				const int64_t timestamp = cycle * duration + reader.getIndexEntry( stream, i ).timestamp;
+				StreamEvent event;
+				event.stream = stream;
+				event.record = i;
+				event.cycle = cycle;
+				event.timestamp = timestamp + timestampOffsetMs[stream] + static_cast<int>( ( seed >> 8 ) % ( 2 * jitterMs + 1 ) ) - jitterMs;
+				event.arrival = ( timestamp + deliveryMs[stream] + static_cast<int>( ( seed >> 16 ) % ( 2 * jitterMs + 1 ) ) ) / 1000.0;
+				events.push_back( event );
+			}
+		}
+	}
+	std::stable_sort( events.begin(), events.end() );
+}
+
+// Cxg̏Ƀt[FrameSynchronizer֓nAogSĎoēv\
+// checkFrameNumberstruêƂ́Ag̒Ńt[ԍvȂg(1t[ꂽg)𐔂
+static void measureSynchronizer( const char* name, const RecordingReader& reader, const std::vector<StreamEvent>& events,
+	SyncPolicy policy, int toleranceMs, bool checkFrameNumbers )
+{
+	FrameSynchronizer synchronizer( FRAME_STREAM_FLAG_ALL, policy, toleranceMs );
+	FrameSet frames;
+	SkeletonFrame skeleton;
+	uint64_t mismatched = 0;
+	uint64_t depthOutOfOrder = 0;
+	int64_t lastDepthTimestamp = -1;
+	for( size_t e = 0; e < events.size(); e++ ){
+		const StreamEvent& event = events[e];
+		const RecordIndexEntry& entry = reader.getIndexEntry( event.stream, event.record );
+		const uint32_t frameNumber = event.cycle * reader.getFrameCount( event.stream ) + entry.frameNumber;
+		if( event.stream == FRAME_STREAM_SKELETON ){
+			std::memcpy( &skeleton, reader.getRecordData( FRAME_STREAM_SKELETON, event.record ), sizeof( skeleton ) );
+			skeleton.timestamp = event.timestamp;
+			skeleton.frameNumber = frameNumber;
+			synchronizer.pushSkeleton( skeleton, event.arrival );
+		}
+		else{
+			const RecordHeader* header = reader.getRecord( event.stream, event.record );
+			ImageFrame image;
+			image.data = reader.getRecordData( event.stream, event.record );
+			image.info.frameNumber = frameNumber;
+			image.info.timestamp = event.timestamp;
+			image.info.format = static_cast<PixelFormat>( header->format );
+			image.info.width = header->width;
+			image.info.height = header->height;
+			synchronizer.push( static_cast<FrameStream>( event.stream ), image, event.arrival );
+		}
+
+		while( synchronizer.pop( frames, event.arrival ) ){
+			const uint32_t depthNumber = frames.depth.info.frameNumber;
+			if( frames.color.info.frameNumber != depthNumber || frames.skeleton->frameNumber != depthNumber ){
+				mismatched++;
+			}
+			if( frames.depth.info.timestamp < lastDepthTimestamp ){
+				depthOutOfOrder++;
+			}
+			lastDepthTimestamp = frames.depth.info.timestamp;
+		}
+	}
+
+	const FrameSynchronizer::Statistics statistics = synchronizer.getStatistics();
+	std::cout << "  " << std::left << std::setw( 16 ) << name << std::right << std::fixed << std::setprecision( 1 )
+		<< " : sets " << std::setw( 4 ) << statistics.sets << " / depth " << statistics.received[FRAME_STREAM_DEPTH]
+		<< ", skew mean " << statistics.getMeanSkewMs() << " max " << statistics.skewMaxMs << " ms"
+		<< ", latency mean " << statistics.getMeanLatencyMs() << " max " << statistics.latencyMaxMs << " ms"
+		<< ", over tolerance " << statistics.outOfTolerance
+		<< ", discarded " << statistics.discarded[FRAME_STREAM_COLOR] << "/" << statistics.discarded[FRAME_STREAM_DEPTH] << "/" << statistics.discarded[FRAME_STREAM_SKELETON];
+	if( checkFrameNumbers ){
+		std::cout << ", mismatched " << mismatched;
+	}
+	if( depthOutOfOrder ){
+		std::cout << ", depth out of order " << depthOutOfOrder;
+	}
+	std::cout << std::endl;
+}
+
+// ]ǂɑSẴXg[̃Cxĝ҂(WaitForMultipleObjects( ..., true, ... ))ꍇ̑g𐔂
+// eXg[̓hCõL[(2t[)̌ÂɎ擾̂ŁAǂꂩ̃Xg[Ƒg
+static void measureWaitAll( const RecordingReader& reader, const std::vector<StreamEvent>& events, bool checkFrameNumbers )
+{
+	std::deque<const StreamEvent*> queues[FRAME_STREAM_COUNT];
+	uint64_t sets = 0;
+	uint64_t mismatched = 0;
+	int64_t skewSum = 0;
+	int64_t skewMax = 0;
+	for( size_t e = 0; e < events.size(); e++ ){
+		std::deque<const StreamEvent*>& queue = queues[events[e].stream];
+		if( queue.size() == 2 ){
+			queue.pop_front();
+		}
+		queue.push_back( &events[e] );
+		if( queues[FRAME_STREAM_COLOR].empty() || queues[FRAME_STREAM_DEPTH].empty() || queues[FRAME_STREAM_SKELETON].empty() ){
+			continue;
+		}
+
+		uint32_t frameNumbers[FRAME_STREAM_COUNT];
+		int64_t timestamps[FRAME_STREAM_COUNT];
+		for( int s = 0; s < FRAME_STREAM_COUNT; s++ ){
+			const StreamEvent* event = queues[s].front();
+			queues[s].pop_front();
+			frameNumbers[s] = event->cycle * reader.getFrameCount( s ) + reader.getIndexEntry( s, event->record ).frameNumber;
+			timestamps[s] = event->timestamp;
+		}
+
+		// DepthƂ̃^CX^v̍̍ől
+		int64_t skew = 0;
+		for( int s = 0; s < FRAME_STREAM_COUNT; s++ ){
+			const int64_t difference = timestamps[s] - timestamps[FRAME_STREAM_DEPTH];
+			skew = ( std::max )( skew, ( difference < 0 ) ? -difference : difference );
+		}
+		sets++;
+		skewSum += skew;
+		skewMax = ( std::max )( skewMax, skew );
+		if( frameNumbers[FRAME_STREAM_COLOR] != frameNumbers[FRAME_STREAM_DEPTH] || frameNumbers[FRAME_STREAM_SKELETON] != frameNumbers[FRAME_STREAM_DEPTH] ){
+			mismatched++;
+		}
+	}
+	std::cout << "  " << std::left << std::setw( 16 ) << "wait all" << std::right << std::fixed << std::setprecision( 1 )
+		<< " : sets " << std::setw( 4 ) << sets
+		<< ", skew mean " << ( sets ? static_cast<double>( skewSum ) / sets : 0.0 ) << " max " << skewMax << " ms";
+	if( checkFrameNumbers ){
+		std::cout << ", mismatched " << mismatched;
+	}
+	std::cout << std::endl;
+}
+
+// }CNx`}[NŎgt[
+struct SuiteFrames
+{
+	std::vector< std::vector<uint16_t> > depth;
+	std::vector< std::vector<uint8_t> > color;
+	std::vector<SkeletonFrame> skeleton;
+	std::vector< std::vector<BoneOrientation> > orientations; // skeleton̑S(KINECT_SKELETON_COUNT ~ ֐߂̐)
+};
+
+// MotionCaptureBone̐eq֌W(NuiSkeletonCalculateBoneOrientations()startJoint)
+static const int BONE_PARENT[KINECT_SKELETON_POSITION_COUNT] = { 0, 0, 1, 2, 2, 4, 5, 6, 2, 8, 9, 10, 0, 12, 13, 14, 0, 16, 17, 18 };
+
+// MotionCaptureBone̒[cm]
+static const float BONE_LENGTH[KINECT_SKELETON_POSITION_COUNT] = {
+	0.0f, 5.1f, 28.3f, 21.5f, 19.8f, 24.3f, 26.5f, 8.2f, 19.8f, 24.3f, 26.5f, 8.2f, 10.0f, 35.8f, 35.2f, 11.5f, 10.0f, 35.8f, 35.2f, 11.5f
+};
+
+// ֐߂̈ʒuBoně(Kinect SDKNuiSkeletonCalculateBoneOrientations()̑)
+// e̊֐߂q̊֐߂ւ̌YƂ]sAsxNgɉE|`(D3DXƓ)œ
+static void makeBoneOrientations( const SkeletonData& skeleton, BoneOrientation* orient )
+{
+	std::memset( orient, 0, sizeof( BoneOrientation ) * KINECT_SKELETON_POSITION_COUNT );
+	for( int i = 0; i < KINECT_SKELETON_POSITION_COUNT; i++ ){
+		orient[i].startJoint = BONE_PARENT[i];
+		orient[i].endJoint = i;
+		const SkeletonVector& from = skeleton.positions[BONE_PARENT[i]];
+		const SkeletonVector& to = skeleton.positions[i];
+		float y[3] = { to.x - from.x, to.y - from.y, to.z - from.z };
+		float length = std::sqrt( y[0] * y[0] + y[1] * y[1] + y[2] * y[2] );
+		if( length < 1e-6f ){
+			y[0] = 0.0f; y[1] = 1.0f; y[2] = 0.0f;
+			length = 1.0f;
+		}
+		for( int k = 0; k < 3; k++ ){
+			y[k] /= length;
+		}
+		// YƕsłȂƂ̊OςXAZ߂
+		const float axis[3] = { std::fabs( y[2] ) < 0.9f ? 0.0f : 1.0f, 0.0f, std::fabs( y[2] ) < 0.9f ? 1.0f : 0.0f };
+		float x[3] = { y[1] * axis[2] - y[2] * axis[1], y[2] * axis[0] - y[0] * axis[2], y[0] * axis[1] - y[1] * axis[0] };
+		const float xLength = std::sqrt( x[0] * x[0] + x[1] * x[1] + x[2] * x[2] );
+		for( int k = 0; k < 3; k++ ){
+			x[k] /= xLength;
+		}
+		const float z[3] = { x[1] * y[2] - x[2] * y[1], x[2] * y[0] - x[0] * y[2], x[0] * y[1] - x[1] * y[0] };
+		BoneMatrix& rotation = orient[i].absoluteRotation.rotationMatrix;
+		setBoneMatrixIdentity( rotation );
+		for( int k = 0; k < 3; k++ ){
+			rotation.m[0][k] = x[k];
+			rotation.m[1][k] = y[k];
+			rotation.m[2][k] = z[k];
+		}
+		orient[i].hierarchicalRotation = orient[i].absoluteRotation;
+	}
+}
+
+// }CNx`}[Ñt[
+// -replayŎw肵L^t@C΋L^t[A΍V[g
+// (-depthŎw肵Depth&Playert[΁ADepth&Player͂g)
+static bool prepareSuiteFrames( const char* replayPath, bool useLoadedDepth, int maxFrames, SuiteFrames& frames )
+{
+	SyntheticScene scene;
+	SyntheticFrameSource synthetic( scene, FRAME_STREAM_FLAG_ALL );
+	ReplayFrameSource replay;
+	if( replayPath && !replay.open( replayPath ) ){
+		std::cerr << "Error : ReplayFrameSource::open( " << replayPath << " )" << std::endl;
+		return false;
+	}
+	const int frameCount = ( std::min )( maxFrames, replayPath ? replay.getFrameCount() : static_cast<int>( g_depthFrames.size() ) );
+
+	frames.depth.resize( frameCount );
+	frames.color.resize( frameCount );
+	frames.skeleton.resize( frameCount );
+	frames.orientations.resize( frameCount );
+	for( int i = 0; i < frameCount; i++ ){
+		frames.depth[i].resize( PIXELS );
+		frames.color[i].resize( PIXELS * 4 );
+		synthetic.render( i, &frames.depth[i][0], &frames.color[i][0], &frames.skeleton[i] );
+
+		FrameSet replayed;
+		if( replayPath && replay.read( replayed ) ){
+			if( replayed.depth.data ){
+				std::memcpy( &frames.depth[i][0], replayed.depth.data, sizeof( uint16_t ) * PIXELS );
+			}
+			if( replayed.color.data ){
+				std::memcpy( &frames.color[i][0], replayed.color.data, PIXELS * 4 );
+			}
+			if( replayed.skeleton ){
+				frames.skeleton[i] = *replayed.skeleton;
+			}
+		}
+		else if( useLoadedDepth ){
+			frames.depth[i] = g_depthFrames[i];
+		}
+
+		frames.orientations[i].resize( KINECT_SKELETON_COUNT * KINECT_SKELETON_POSITION_COUNT );
+		for( int j = 0; j < KINECT_SKELETON_COUNT; j++ ){
+			makeBoneOrientations( frames.skeleton[i].skeletons[j], &frames.orientations[i][j * KINECT_SKELETON_POSITION_COUNT] );
+		}
+	}
+	return frameCount > 0;
+}
+
+// eTvvÕt[̏J[lɌv
+static void runKernelSuite( BenchmarkSuite& suite, const CameraModel& model, const RegistrationTable& table, const SuiteFrames& frames )
+{
+	const int frameCount = static_cast<int>( frames.depth.size() );
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint16_t> depth( PIXELS );
+	std::vector<uint8_t> depth8( PIXELS );
+	std::vector<uint8_t> player( PIXELS * 3 );
+	std::vector<uint8_t> clip( PIXELS * 4 );
+	std::vector<uint8_t> work( PIXELS );
+
+	// ʒu킹(f̕ϊ֐̌ĂяoAe[uAe[uSIMD)
+	const size_t registrationBytes = sizeof( uint16_t ) * PIXELS * 2;
+	suite.run( "registration per-pixel projection", registrationBytes, [&]( int i ){
+		registerPerPixel( model, &frames.depth[i % frameCount][0], &registered[0] );
+	} );
+	for( int level = SIMD_SCALAR; level <= getSimdLevel(); level++ ){
+		const SimdLevel simdLevel = static_cast<SimdLevel>( level );
+		suite.run( std::string( "registration lookup table (" ) + getSimdLevelName( simdLevel ) + ")", registrationBytes, [&]( int i ){
+			table.registerFrame( &frames.depth[i % frameCount][0], &registered[0], simdLevel );
+		} );
+	}
+
+	// Player̃CfbNX̃fR[h(DepthA8rbgDepthAPlayer̐F)
+	const uint8_t colors[8][3] = { { 0, 0, 0 }, { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 255, 255, 0 }, { 255, 0, 255 }, { 0, 255, 255 }, { 0, 0, 0 } };
+	const float alpha = -255.0f / KINECT_DEPTH_MAXIMUM_VALUE;
+	const float beta = 255.0f;
+	const size_t decodeBytes = ( sizeof( uint16_t ) * 2 + 1 + 3 ) * PIXELS;
+	suite.run( "decode multi-pass (loop + convertTo)", decodeBytes, [&]( int i ){
+		decodeMultiPass( &frames.depth[i % frameCount][0], &depth[0], &player[0], &depth8[0], colors[0], alpha, beta );
+	} );
+	DepthDecoder decoder;
+	decoder.setDepthScale( alpha, beta );
+	decoder.setPlayerColors( colors[0] );
+	DepthDecodeOutput decoded;
+	decoded.depth = &depth[0];
+	decoded.depth8 = &depth8[0];
+	decoded.player = &player[0];
+	DepthDecodeOutput depth8Only;
+	depth8Only.depth8 = &depth8[0];
+	for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+		decoder.setSimdLevel( static_cast<SimdLevel>( level ) );
+		suite.run( std::string( "decode fused (" ) + getSimdLevelName( static_cast<SimdLevel>( level ) ) + ")", decodeBytes, [&]( int i ){
+			decoder.decode( &frames.depth[i % frameCount][0], decoded, 0, PIXELS );
+		} );
+	}
+
+	// \p8rbgDepth(cv::Mat::convertTo()̕_̐ϘaƁADepthDecoder̕ϊe[u)
+	const size_t convertBytes = ( sizeof( uint16_t ) + 1 ) * PIXELS;
+	suite.run( "depth8 convertTo (float multiply-add)", convertBytes, [&]( int i ){
+		const uint16_t* src = &frames.depth[i % frameCount][0];
+		for( int j = 0; j < PIXELS; j++ ){
+			const int value = static_cast<int>( std::floor( ( src[j] & KINECT_DEPTH_MASK ) * alpha + beta + 0.5f ) );
+			depth8[j] = static_cast<uint8_t>( ( value < 0 ) ? 0 : ( ( value > 255 ) ? 255 : value ) );
+		}
+	} );
+	for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+		decoder.setSimdLevel( static_cast<SimdLevel>( level ) );
+		suite.run( std::string( "depth8 lookup table (" ) + getSimdLevelName( static_cast<SimdLevel>( level ) ) + ")", convertBytes, [&]( int i ){
+			decoder.decode( &frames.depth[i % frameCount][0], depth8Only, 0, PIXELS );
+		} );
+	}
+
+	// Clipping̃}XN(ʒu킹Player̗̈)St[Ă
+	std::vector< std::vector<uint8_t> > masks( frameCount, std::vector<uint8_t>( PIXELS ) );
+	{
+		DepthPipeline pipeline( table );
+		DepthPipelineOutput output;
+		output.registered = &registered[0];
+		for( int i = 0; i < frameCount; i++ ){
+			output.mask = &masks[i][0];
+			pipeline.process( &frames.depth[i][0], output );
+		}
+	}
+
+	// ClippingopeningAclosing(gbNo[̊l2񂸂)
+	MorphologyFilter morphology;
+	suite.run( "morphology opening + closing (2, 2)", PIXELS * 2, [&]( int i ){
+		std::memcpy( &work[0], &masks[i % frameCount][0], PIXELS );
+		morphology.erode( &work[0], WIDTH, HEIGHT, 2 );
+		morphology.dilate( &work[0], WIDTH, HEIGHT, 2 );
+		morphology.dilate( &work[0], WIDTH, HEIGHT, 2 );
+		morphology.erode( &work[0], WIDTH, HEIGHT, 2 );
+	} );
+
+	// Clipping̐؂蔲(colorMat.copyTo( clipMat, maskMat ))
+	suite.run( "copyTo with mask", ( 4 + 1 + 4 ) * PIXELS, [&]( int i ){
+		copyWithMask( reinterpret_cast<const uint32_t*>( &frames.color[i % frameCount][0] ), &masks[i % frameCount][0], reinterpret_cast<uint32_t*>( &clip[0] ), PIXELS );
+	} );
+
+	// 1rbg̃}XNł̓(ClippingProcessorgA8rbg̃}XNƂ̕ϊ܂)
+	BitMask bitMask( WIDTH, HEIGHT );
+	suite.run( "bit mask opening + closing (2, 2)", PIXELS * 2, [&]( int i ){
+		bitMask.pack( &masks[i % frameCount][0], WIDTH );
+		bitMask.erode( 2 );
+		bitMask.dilate( 2 );
+		bitMask.dilate( 2 );
+		bitMask.erode( 2 );
+		bitMask.unpack( &work[0], WIDTH );
+	} );
+	suite.run( "copy with bit mask", ( 4 + 4 ) * PIXELS + PIXELS / 8, [&]( int i ){
+		bitMask.copyPixels( reinterpret_cast<const uint32_t*>( &frames.color[i % frameCount][0] ), reinterpret_cast<uint32_t*>( &clip[0] ) );
+	} );
+
+	// SkeletonDepth摜ւ̓e(S̑SĂ̊֐)
+	volatile float projectedSum = 0.0f;
+	suite.run( "skeleton projection (6 x 20 joints)", sizeof( SkeletonData ) * KINECT_SKELETON_COUNT, [&]( int i ){
+		const SkeletonFrame& skeleton = frames.skeleton[i % frameCount];
+		float sum = 0.0f;
+		for( int j = 0; j < KINECT_SKELETON_COUNT; j++ ){
+			if( skeleton.skeletons[j].trackingState == SKELETON_NOT_TRACKED ){
+				continue;
+			}
+			for( int k = 0; k < KINECT_SKELETON_POSITION_COUNT; k++ ){
+				float x, y;
+				projectSkeletonToDepth( skeleton.skeletons[j].positions[k], WIDTH, HEIGHT, &x, &y );
+				sum += x + y;
+			}
+		}
+		projectedSum = projectedSum + sum;
+	} );
+
+	// MotionCaptureBone̕ϊs(ǐՂĂSsetSkeleStateFromOrient())
+	SkeleState skeleStates[KINECT_SKELETON_COUNT];
+	suite.run( "bone transforms (setSkeleStateFromOrient)", ( sizeof( BoneOrientation ) + sizeof( BoneMatrix ) + sizeof( BoneVector ) ) * KINECT_SKELETON_POSITION_COUNT * 2, [&]( int i ){
+		const SkeletonFrame& skeleton = frames.skeleton[i % frameCount];
+		for( int j = 0; j < KINECT_SKELETON_COUNT; j++ ){
+			skeleStates[j].reset();
+			if( skeleton.skeletons[j].trackingState == SKELETON_TRACKED ){
+				setSkeleStateFromOrient( skeleton.skeletons[j], &frames.orientations[i % frameCount][j * KINECT_SKELETON_POSITION_COUNT], BONE_LENGTH, &skeleStates[j] );
+				skeleStates[j].isValid = true;
+			}
+		}
+	} );
+}
+
+// ZNVŋLv̏
+struct BenchmarkContext
+{
+	int iterations;
+	int repetitions;
+	int frameCount;
+	const char* depthPath;
+	const char* replayPath;
+	CameraModel model;
+	RegistrationTable table;
+	bool tableLoaded;      // tablet@Cǂݍ(Jf̂ł͂Ȃ)
+#ifdef _WIN32
+	bool saveSensorTable;  // ZT[e[utableɒu(-save-tablêƂ)
+#endif
+};
+
+// }CNx`}[N(t[̏vĊlƔׂ)
+static bool benchKernelSuite( BenchmarkContext& context )
+{
+	SuiteFrames suiteFrames;
+	if( !prepareSuiteFrames( context.replayPath, context.depthPath != nullptr, context.frameCount, suiteFrames ) ){
+		return false;
+	}
+	std::cout << "kernel suite : " << suiteFrames.depth.size() << " frames (" << ( context.replayPath ? context.replayPath : ( context.depthPath ? context.depthPath : "synthetic" ) ) << "), "
+		<< context.iterations << " frames x " << context.repetitions << " repetitions, fastest repetition" << std::endl;
+	runKernelSuite( *g_suite, context.model, context.table, suiteFrames );
+	return true;
+}
+
+// ʒu킹
+static bool benchRegistration( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint16_t> reference( PIXELS );
+
+	// fϊ֐Ăяoꍇ
+	const double perPixelMs = measure( iterations, [&]( int i ){
+		registerPerPixel( context.model, &g_depthFrames[i % frameCount][0], &reference[0] );
+	} );
+	printResult( "registration per-pixel projection", perPixelMs );
+
+	// e[uꍇ(߃Zbg)
+	double tableMs = perPixelMs;
+	for( int level = SIMD_SCALAR; level <= getSimdLevel(); level++ ){
+		const SimdLevel simdLevel = static_cast<SimdLevel>( level );
+		tableMs = measure( iterations, [&]( int i ){
+			table.registerFrame( &g_depthFrames[i % frameCount][0], &registered[0], simdLevel );
+		} );
+		const std::string name = std::string( "registration lookup table (" ) + getSimdLevelName( simdLevel ) + ")";
+		printResult( name.c_str(), tableMs );
+	}
+	std::cout << "  speed-up : " << std::setprecision( 2 ) << perPixelMs / tableMs << "x" << std::endl;
+
+	// SIMDł̌ʂXJ[ł̌()ƑSt[ňv邱ƂmF
+	for( int i = 0; i < frameCount; i++ ){
+		table.registerFrame( &g_depthFrames[i][0], &reference[0], SIMD_SCALAR );
+		for( int level = SIMD_SSE41; level <= getSimdLevel(); level++ ){
+			table.registerFrame( &g_depthFrames[i][0], &registered[0], static_cast<SimdLevel>( level ) );
+			if( registered != reference ){
+				std::cerr << "Error : registration " << getSimdLevelName( static_cast<SimdLevel>( level ) ) << " output differs from scalar output at frame " << i << std::endl;
+				return false;
+			}
+		}
+	}
+	std::cout << "  SIMD output matches scalar output : " << frameCount << " frames" << std::endl;
+	if( !context.tableLoaded ){
+		registerPerPixel( context.model, &g_depthFrames[0][0], &reference[0] );
+		table.registerFrame( &g_depthFrames[0][0], &registered[0] );
+		std::cout << "  match with per-pixel projection : " << std::setprecision( 2 ) << matchRate( registered, reference ) << "%" << std::endl;
+	}
+	return true;
+}
+
+// Ō̃t[DepthPipelineŏƂ̃}XN(Mathematical MorphologyBitMask̓)
+static void makeLastFrameMask( const BenchmarkContext& context, std::vector<uint8_t>& mask )
+{
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint8_t> depth8( PIXELS );
+	std::vector<uint8_t> player( PIXELS * 3 );
+	mask.resize( PIXELS );
+	DepthPipelineOutput output;
+	output.registered = &registered[0];
+	output.depth8 = &depth8[0];
+	output.player = &player[0];
+	output.mask = &mask[0];
+	DepthPipeline pipeline( context.table );
+	pipeline.process( &g_depthFrames[context.frameCount - 1][0], output );
+}
+
+// Depth&Player̃fR[h
+static bool benchDecode( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+
+	{
+		std::vector<uint16_t> depth( PIXELS );
+		std::vector<uint8_t> depth8( PIXELS );
+		std::vector<uint8_t> player( PIXELS * 3 );
+		std::vector<uint8_t> mask( PIXELS );
+		std::vector<uint8_t> playerMask( PIXELS );
+
+		const double multiPassMs = measure( iterations, [&]( int i ){
+			decodeMultiPass( &g_depthFrames[i % frameCount][0], &depth[0], &player[0], &depth8[0], PLAYER_COLORS[0], DEPTH8_ALPHA, DEPTH8_BETA );
+		} );
+		printResult( "decode multi-pass (loop + convertTo)", multiPassMs );
+
+		DepthDecoder decoder;
+		decoder.setDepthScale( DEPTH8_ALPHA, DEPTH8_BETA );
+		decoder.setPlayerColors( PLAYER_COLORS[0] );
+		DepthDecodeOutput decoded;
+		decoded.depth = &depth[0];
+		decoded.depth8 = &depth8[0];
+		decoded.player = &player[0];
+		for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+			decoder.setSimdLevel( static_cast<SimdLevel>( level ) );
+			const double ms = measure( iterations, [&]( int i ){
+				decoder.decode( &g_depthFrames[i % frameCount][0], decoded, 0, PIXELS );
+			} );
+			const std::string name = std::string( "decode fused (" ) + getSimdLevelName( static_cast<SimdLevel>( level ) ) + ")";
+			printResult( name.c_str(), ms );
+			std::cout << "  speed-up : " << std::setprecision( 2 ) << multiPassMs / ms << "x" << std::endl;
+		}
+
+		// ͂ǂޗʂ2̑(Depth&PlayerƒԂDepth)1ɂȂ
+		const double frameMB = sizeof( uint16_t ) * PIXELS / ( 1024.0 * 1024.0 );
+		std::cout << "  input read per frame : multi-pass " << std::setprecision( 2 ) << frameMB * 2 << " MB, fused " << frameMB << " MB" << std::endl;
+
+		// SIMDłƏ]̏AXJ[ł̌ʂv邱ƂmF
+		std::vector<uint16_t> depthRef( PIXELS );
+		std::vector<uint8_t> depth8Ref( PIXELS );
+		std::vector<uint8_t> playerRef( PIXELS * 3 );
+		std::vector<uint8_t> maskRef( PIXELS );
+		std::vector<uint8_t> playerMaskRef( PIXELS );
+		DepthDecodeOutput reference;
+		reference.depth = &depthRef[0];
+		reference.depth8 = &depth8Ref[0];
+		reference.player = &playerRef[0];
+		reference.mask = &maskRef[0];
+		reference.playerMask[1] = &playerMaskRef[0];
+		DepthDecoder scalarDecoder;
+		scalarDecoder.setDepthScale( DEPTH8_ALPHA, DEPTH8_BETA );
+		scalarDecoder.setPlayerColors( PLAYER_COLORS[0] );
+		scalarDecoder.setSimdLevel( SIMD_SCALAR );
+		decoded.mask = &mask[0];
+		decoded.playerMask[1] = &playerMask[0];
+		decoder.setSimdLevel( getSimdLevel() );
+		for( int i = 0; i < frameCount; i++ ){
+			decodeMultiPass( &g_depthFrames[i][0], &depthRef[0], &playerRef[0], &depth8Ref[0], PLAYER_COLORS[0], DEPTH8_ALPHA, DEPTH8_BETA );
+			decoder.decode( &g_depthFrames[i][0], decoded, 0, PIXELS );
+			if( depth != depthRef || player != playerRef ){
+				std::cerr << "Error : fused decode output differs from multi-pass output at frame " << i << std::endl;
+				return false;
+			}
+			scalarDecoder.decode( &g_depthFrames[i][0], reference, 0, PIXELS );
+			if( depth8 != depth8Ref || mask != maskRef || playerMask != playerMaskRef ){
+				std::cerr << "Error : fused decode SIMD output differs from scalar output at frame " << i << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Player̓v(fR[hƈꏏɋ߂)
+static bool benchPlayerStats( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+
+	std::vector<uint8_t> depth8( PIXELS );
+	std::vector<uint8_t> player( PIXELS * 3 );
+	PlayerStats stats[KINECT_PLAYER_COUNT + 1];
+	PlayerStats expected[KINECT_PLAYER_COUNT + 1];
+	DepthDecoder decoder;
+	decoder.setDepthScale( DEPTH8_ALPHA, DEPTH8_BETA );
+	decoder.setPlayerColors( PLAYER_COLORS[0] );
+	DepthDecodeOutput decoded;
+	decoded.depth8 = &depth8[0];
+	decoded.player = &player[0];
+
+	// fR[ȟɂ1xĐꍇƁAfR[hƈꏏɐꍇׂ
+	const double separateMs = measure( iterations, [&]( int i ){
+		decoder.decode( &g_depthFrames[i % frameCount][0], decoded, 0, PIXELS );
+		countPlayerStats( &g_depthFrames[i % frameCount][0], stats );
+	} );
+	printResult( "decode + player stats (2 passes)", separateMs );
+	for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+		decoder.setSimdLevel( static_cast<SimdLevel>( level ) );
+		decoded.stats = nullptr;
+		const double decodeMs = measure( iterations, [&]( int i ){
+			decoder.decode( &g_depthFrames[i % frameCount][0], decoded, 0, PIXELS );
+		} );
+		decoded.stats = stats;
+		const double ms = measure( iterations, [&]( int i ){
+			for( int j = 0; j <= KINECT_PLAYER_COUNT; j++ ){
+				stats[j].reset();
+			}
+			decoder.decode( &g_depthFrames[i % frameCount][0], decoded, 0, PIXELS );
+		} );
+		const std::string name = std::string( "decode with player stats (" ) + getSimdLevelName( static_cast<SimdLevel>( level ) ) + ")";
+		printResult( name.c_str(), ms );
+		std::cout << "  speed-up : " << std::setprecision( 2 ) << separateMs / ms << "x, stats cost : " << std::setprecision( 3 ) << ms - decodeMs << " ms/frame" << std::endl;
+	}
+	decoder.setSimdLevel( getSimdLevel() );
+
+	// ʂɐvƈv邱ƂmF(߃ZbgAs̓rŋ؂͈͖Aʒu킹ƈꏏɕ̃Xbhŋ߂Ƃ)
+	ThreadPool threadPool( 4 );
+	DepthPipeline pipeline( table, &threadPool );
+	DepthPipelineOutput pipelineOutput;
+	pipelineOutput.registered = &registered[0];
+	pipelineOutput.stats = stats;
+	const int splits[] = { 0, 1001, 150003, PIXELS };
+	for( int i = 0; i < frameCount; i++ ){
+		const uint16_t* frame = &g_depthFrames[i][0];
+		countPlayerStats( frame, expected );
+		for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+			decoder.setSimdLevel( static_cast<SimdLevel>( level ) );
+			for( int j = 0; j <= KINECT_PLAYER_COUNT; j++ ){
+				stats[j].reset();
+			}
+			decoder.decode( frame, decoded, 0, PIXELS );
+			bool same = isSamePlayerStats( stats, expected );
+			for( int j = 0; j <= KINECT_PLAYER_COUNT; j++ ){
+				stats[j].reset();
+			}
+			for( int j = 0; j < 3; j++ ){
+				decoder.decode( frame, decoded, splits[j], splits[j + 1] );
+			}
+			if( !same || !isSamePlayerStats( stats, expected ) ){
+				std::cerr << "Error : player stats differ from counted stats (" << getSimdLevelName( static_cast<SimdLevel>( level ) ) << ", frame " << i << ")" << std::endl;
+				return false;
+			}
+		}
+		pipeline.process( frame, pipelineOutput );
+		countPlayerStats( &registered[0], expected );
+		if( !isSamePlayerStats( stats, expected ) ){
+			std::cerr << "Error : depth pipeline player stats differ from counted stats at frame " << i << std::endl;
+			return false;
+		}
+	}
+	decoder.setSimdLevel( getSimdLevel() );
+
+	// ŋ߂vL^t@Cɏ݁ADepthǂ܂Ɏ擾ł邱ƂmF(kDepthƈꏏɏ)
+	// V[L^ȂAʒu킹ƈꏏɋ߂v1t[ɓn(nȂt[ɂ͓v)
+	const char* statsPath = "BenchmarkStats.kbr";
+	const int STATS_COUNT = KINECT_PLAYER_COUNT + 1;
+	std::vector<PlayerStats> written( frameCount * STATS_COUNT );
+	std::vector<uint32_t> frameNumbers( frameCount );
+	{
+		SyntheticScene scene;
+		scene.players = KINECT_PLAYER_COUNT;
+		RecordingFrameSource recording( new SyntheticFrameSource( scene, FRAME_STREAM_FLAG_DEPTH ) );
+		recording.setDepthCompression( true );
+		recording.setPlayerStats( true );
+		if( !recording.open( statsPath ) ){
+			std::cerr << "Error : RecordingFrameSource::open( " << statsPath << " )" << std::endl;
+			return false;
+		}
+		for( int i = 0; i < frameCount; i++ ){
+			FrameSet frames;
+			if( !recording.read( frames ) ){
+				std::cerr << "Error : RecordingFrameSource::read" << std::endl;
+				return false;
+			}
+			pipeline.process( reinterpret_cast<const uint16_t*>( frames.depth.data ), pipelineOutput );
+			frameNumbers[i] = frames.depth.info.frameNumber;
+			if( i % 2 == 0 ){
+				recording.writePlayerStats( frames.depth.info, stats );
+				std::copy( stats, stats + STATS_COUNT, &written[i * STATS_COUNT] );
+			}
+		}
+		if( !recording.close() ){
+			std::cerr << "Error : RecordingFrameSource::close" << std::endl;
+			return false;
+		}
+	}
+	RecordingReader reader;
+	if( !reader.open( statsPath ) ){
+		std::cerr << "Error : RecordingReader::open( " << statsPath << " )" << std::endl;
+		return false;
+	}
+	bool recorded = ( reader.getStreams() & RECORD_STREAM_FLAG_PLAYER_STATS ) && reader.getFrameCount( RECORD_STREAM_PLAYER_STATS ) == ( frameCount + 1 ) / 2;
+	for( int i = 0; i < frameCount && recorded; i++ ){
+		const PlayerStats* recordedStats = reader.findPlayerStats( frameNumbers[i] );
+		recorded = ( i % 2 == 0 ) ? ( recordedStats && isSamePlayerStats( recordedStats, &written[i * STATS_COUNT] ) ) : !recordedStats;
+	}
+	reader.close();
+	std::remove( statsPath );
+	if( !recorded ){
+		std::cerr << "Error : recorded player stats differ from counted stats" << std::endl;
+		return false;
+	}
+	std::cout << "  recorded player stats : " << sizeof( PlayerStats ) * ( KINECT_PLAYER_COUNT + 1 ) << " bytes/frame" << std::endl;
+	return true;
+}
+
+// Depth̐Ft(DepthColorizer)
+static bool benchColorizer( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	std::vector<uint16_t> reference( PIXELS );
+
+	// ]ǂcv::Mat::convertTo()8rbgɂĂcv::cvtColor( CV_GRAY2BGR )ōL鏈(2̑)
+	const float grayAlpha = -255.0f / KINECT_DEPTH_MAXIMUM_VALUE;
+	std::vector<uint8_t> depth8( PIXELS );
+	std::vector<uint8_t> bgr( PIXELS * 3 );
+	std::vector<uint8_t> bgrx( PIXELS * 4 );
+	const double chainMs = measure( iterations, [&]( int i ){
+		const uint16_t* src = &g_depthFrames[i % frameCount][0];
+		for( int j = 0; j < PIXELS; j++ ){
+			const int value = static_cast<int>( std::floor( ( src[j] & KINECT_DEPTH_MASK ) * grayAlpha + 255.0f + 0.5f ) );
+			depth8[j] = static_cast<uint8_t>( ( value < 0 ) ? 0 : ( ( value > 255 ) ? 255 : value ) );
+		}
+		expandGrayToBgr( &depth8[0], &bgr[0] );
+	} );
+	printResult( "depth view convertTo + cvtColor", chainMs );
+
+	// DepthDecoder̃e[u8rbgɂĂL鏈(FaceTrackingSDK̏]̏)
+	DepthDecoder decoder;
+	decoder.setDepthScale( -255.0 / KINECT_DEPTH_MAXIMUM_VALUE, 255.0 );
+	DepthDecodeOutput decoded;
+	decoded.depth8 = &depth8[0];
+	const double decodeChainMs = measure( iterations, [&]( int i ){
+		decoder.decode( &g_depthFrames[i % frameCount][0], decoded, 0, PIXELS );
+		expandGrayToBgr( &depth8[0], &bgr[0] );
+	} );
+	printResult( "depth view decode depth8 + cvtColor", decodeChainMs );
+
+	const char* const colorMapNames[DEPTH_COLOR_MAP_COUNT] = { "gray", "jet", "turbo", "equalized" };
+	DepthColorizer colorizer;
+	for( int level = SIMD_SCALAR; level <= getSimdLevel(); level++ ){
+		colorizer.setSimdLevel( static_cast<SimdLevel>( level ) );
+		for( int channels = 3; channels <= 4; channels++ ){
+			uint8_t* dst = ( channels == 3 ) ? &bgr[0] : &bgrx[0];
+			const double ms = measure( iterations, [&]( int i ){
+				colorizer.colorize( &g_depthFrames[i % frameCount][0], dst, PIXELS, channels );
+			} );
+			const std::string name = std::string( "depth colorizer gray " ) + ( ( channels == 3 ) ? "BGR (" : "BGRX (" ) + getSimdLevelName( static_cast<SimdLevel>( level ) ) + ")";
+			printResult( name.c_str(), ms );
+			std::cout << "  speed-up : " << std::setprecision( 2 ) << chainMs / ms << "x" << std::endl;
+		}
+	}
+	colorizer.setSimdLevel( getSimdLevel() );
+	for( int colorMap = DEPTH_COLOR_MAP_JET; colorMap < DEPTH_COLOR_MAP_COUNT; colorMap++ ){
+		colorizer.setColorMap( static_cast<DepthColorMap>( colorMap ) );
+		const double ms = measure( iterations, [&]( int i ){
+			colorizer.colorize( &g_depthFrames[i % frameCount][0], &bgr[0], PIXELS, 3 );
+		} );
+		const std::string name = std::string( "depth colorizer " ) + colorMapNames[colorMap] + " BGR";
+		printResult( name.c_str(), ms );
+	}
+
+	// e[u͐F̕t͈͂ςƂ蒼
+	const double rebuildMs = measure( iterations, [&]( int i ){
+		colorizer.setColorMap( ( i % 2 ) ? DEPTH_COLOR_MAP_JET : DEPTH_COLOR_MAP_TURBO );
+	} );
+	printResult( "depth colorizer table rebuild", rebuildMs );
+
+	// O[XP[e[u8rbgɂčLʂƈvABGRBGRXvASIMDłXJ[łƈv邱ƂmF
+	// (͈͖AF̕tAo̖͂̒[m߂邽߂ɉfς)
+	std::vector<uint8_t> expected( PIXELS * 3 );
+	std::vector<uint8_t> scalarBgr( PIXELS * 3 );
+	std::vector<uint8_t> scalarBgrx( PIXELS * 4 );
+	DepthColorizer scalarColorizer;
+	scalarColorizer.setSimdLevel( SIMD_SCALAR );
+	for( int r = 0; r < 2; r++ ){
+		const DepthRange range = static_cast<DepthRange>( r );
+		decoder.setDepthScale( -255.0 / ( ( range == DEPTH_RANGE_NEAR ) ? KINECT_DEPTH_MAXIMUM_NEAR_MODE_VALUE : KINECT_DEPTH_MAXIMUM_VALUE ), 255.0 );
+		colorizer.setRange( range );
+		scalarColorizer.setRange( range );
+		for( int colorMap = 0; colorMap < DEPTH_COLOR_MAP_COUNT; colorMap++ ){
+			colorizer.setColorMap( static_cast<DepthColorMap>( colorMap ) );
+			scalarColorizer.setColorMap( static_cast<DepthColorMap>( colorMap ) );
+			for( int i = 0; i < frameCount; i++ ){
+				const uint16_t* src = &g_depthFrames[i][0];
+				const int pixels = PIXELS - i % 11;
+				colorizer.colorize( src, &bgr[0], PIXELS, 3 );
+				colorizer.colorize( src, &bgrx[0], PIXELS, 4 );
+				bool same = true;
+				for( int level = SIMD_SSE41; level <= getSimdLevel() && same; level++ ){
+					std::fill( scalarBgr.begin(), scalarBgr.end(), static_cast<uint8_t>( 1 ) );
+					std::fill( expected.begin(), expected.end(), static_cast<uint8_t>( 1 ) );
+					colorizer.setSimdLevel( static_cast<SimdLevel>( level ) );
+					scalarColorizer.colorize( src, &scalarBgr[0], pixels, 3 );
+					colorizer.colorize( src, &expected[0], pixels, 3 );
+					scalarColorizer.colorize( src, &scalarBgrx[0], pixels, 4 );
+					colorizer.colorize( src, &bgrx[0], pixels, 4 );
+					same = scalarBgr == expected && std::equal( scalarBgrx.begin(), scalarBgrx.begin() + pixels * 4, bgrx.begin() );
+				}
+				colorizer.setSimdLevel( getSimdLevel() );
+				colorizer.colorize( src, &bgrx[0], PIXELS, 4 );
+				for( int j = 0; j < PIXELS && same; j++ ){
+					same = bgr[j * 3 + 0] == bgrx[j * 4 + 0] && bgr[j * 3 + 1] == bgrx[j * 4 + 1] && bgr[j * 3 + 2] == bgrx[j * 4 + 2] && bgrx[j * 4 + 3] == 255;
+					if( colorMap != DEPTH_COLOR_MAP_GRAY && ( src[j] >> KINECT_PLAYER_INDEX_SHIFT ) == 0 ){
+						same = same && bgr[j * 3 + 0] == 0 && bgr[j * 3 + 1] == 0 && bgr[j * 3 + 2] == 0;
+					}
+				}
+				if( same && colorMap == DEPTH_COLOR_MAP_GRAY ){
+					decoder.decode( src, decoded, 0, PIXELS );
+					expandGrayToBgr( &depth8[0], &expected[0] );
+					same = bgr == expected;
+				}
+				if( !same ){
+					std::cerr << "Error : depth colorizer output differs from reference (" << colorMapNames[colorMap] << ", range " << r << ", frame " << i << ")" << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// XbhDepth̏(ʒu킹AfR[h)
+static bool benchThreads( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint16_t> reference( PIXELS );
+
+	std::vector<uint8_t> depth8( PIXELS );
+	std::vector<uint8_t> player( PIXELS * 3 );
+	std::vector<uint8_t> mask( PIXELS );
+	DepthPipelineOutput output;
+	output.registered = &registered[0];
+	output.depth8 = &depth8[0];
+	output.player = &player[0];
+	output.mask = &mask[0];
+
+	std::cout << "processors : " << getProcessorCount() << std::endl;
+	const int threadCounts[] = { 1, 2, 4, 8, 16 };
+	const int threadCountsSize = sizeof( threadCounts ) / sizeof( threadCounts[0] );
+	double singleThreadMs = 0.0;
+	for( int t = 0; t < threadCountsSize; t++ ){
+		ThreadPool threadPool( threadCounts[t] );
+		DepthPipeline pipeline( table, &threadPool );
+		const double ms = measure( iterations, [&]( int i ){
+			pipeline.process( &g_depthFrames[i % frameCount][0], output );
+		} );
+		if( t == 0 ){
+			singleThreadMs = ms;
+		}
+		std::ostringstream name;
+		name << "depth pipeline (" << threadPool.getThreadCount() << " threads)";
+		printResult( name.str().c_str(), ms );
+		std::cout << "  scaling : " << std::setprecision( 2 ) << singleThreadMs / ms << "x" << std::endl;
+
+		// Xbhɂ炸1Xbḧʒu킹ƓʂɂȂ邱ƂmF
+		for( int i = 0; i < frameCount; i++ ){
+			pipeline.process( &g_depthFrames[i][0], output );
+			table.registerFrame( &g_depthFrames[i][0], &reference[0] );
+			if( registered != reference ){
+				std::cerr << "Error : depth pipeline output differs from single-thread output at frame " << i << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Mathematical Morphology(\vf̑傫openingAclosing)
+static bool benchMorphology( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	std::vector<uint8_t> mask;
+	makeLastFrameMask( context, mask );
+
+	// Ō̃t[̃}XNɂ܉̃mCYāA摜̒[܂߂ĎkƖc悤ɂ
+	std::vector<uint8_t> noisy( mask );
+	uint32_t random = 12345;
+	for( int i = 0; i < PIXELS / 50; i++ ){
+		random = random * 1664525 + 1013904223;
+		const int index = ( random >> 8 ) % PIXELS;
+		noisy[index] = ( random & 0x80 ) ? 255 : 0;
+	}
+
+	// MorphologyFilterɂSSE4.1ł܂ł̂ŁA̖߃ZbggĂSSE4.1ƕ\
+	std::cout << "morphology opening + closing (ms/frame, iterated 3x3 / van Herk, " << getSimdLevelName( ( std::min )( getSimdLevel(), SIMD_SSE41 ) ) << ")" << std::endl;
+	std::cout << "  radius :           rect           octagon" << std::endl;
+	std::vector<uint8_t> work( PIXELS );
+	std::vector<uint8_t> expected( PIXELS );
+	MorphologyFilter morphology;
+	for( int radius = 1; radius <= 15; radius++ ){
+		std::cout << "  " << std::setw( 6 ) << radius << " :";
+		for( int octagon = 0; octagon <= 1; octagon++ ){
+			morphology.setShape( octagon ? MORPHOLOGY_OCTAGON : MORPHOLOGY_RECT );
+
+			// JԂ͔aɔႵĒx̂ŁAȂ񐔂Ōv
+			const double iteratedMs = measure( 2, [&]( int ){
+				expected = noisy;
+				morphologyIterated( &expected[0], WIDTH, HEIGHT, radius, octagon != 0, true );
+				morphologyIterated( &expected[0], WIDTH, HEIGHT, radius, octagon != 0, false );
+				morphologyIterated( &expected[0], WIDTH, HEIGHT, radius, octagon != 0, false );
+				morphologyIterated( &expected[0], WIDTH, HEIGHT, radius, octagon != 0, true );
+			} );
+			const double filterMs = measure( iterations, [&]( int ){
+				work = noisy;
+				morphology.erode( &work[0], WIDTH, HEIGHT, radius );
+				morphology.dilate( &work[0], WIDTH, HEIGHT, radius );
+				morphology.dilate( &work[0], WIDTH, HEIGHT, radius );
+				morphology.erode( &work[0], WIDTH, HEIGHT, radius );
+			} );
+			std::cout << std::right << std::setprecision( 3 ) << std::setw( 8 ) << iteratedMs << " / " << std::setw( 5 ) << filterMs;
+
+			// SIMDłƃXJ[ł̂ǂAJԂƓʂɂȂ邱ƂmF
+			for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+				morphology.setSimdLevel( static_cast<SimdLevel>( level ) );
+				work = noisy;
+				morphology.erode( &work[0], WIDTH, HEIGHT, radius );
+				morphology.dilate( &work[0], WIDTH, HEIGHT, radius );
+				morphology.dilate( &work[0], WIDTH, HEIGHT, radius );
+				morphology.erode( &work[0], WIDTH, HEIGHT, radius );
+				std::vector<uint8_t> dilated( noisy );
+				morphology.dilate( &dilated[0], WIDTH, HEIGHT, radius );
+				std::vector<uint8_t> dilatedExpected( noisy );
+				morphologyIterated( &dilatedExpected[0], WIDTH, HEIGHT, radius, octagon != 0, false );
+				if( work != expected || dilated != dilatedExpected ){
+					std::cerr << std::endl << "Error : morphology output differs from iterated 3x3 output (radius " << radius
+						<< ", " << ( octagon ? "octagon" : "rect" ) << ", " << getSimdLevelName( static_cast<SimdLevel>( level ) ) << ")" << std::endl;
+					return false;
+				}
+			}
+			morphology.setSimdLevel( getSimdLevel() );
+		}
+		std::cout << std::endl;
+	}
+	return true;
+}
+
+// 1rbg̃}XN(BitMask)
+static bool benchBitMask( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	std::vector<uint8_t> mask;
+	makeLastFrameMask( context, mask );
+
+	// Clipping̃}XN̏(openingAclosingA}XNgRs[)8rbg̃}XN1rbg̃}XNŔׂ
+	std::vector<uint32_t> color( PIXELS );
+	uint32_t random = 67890;
+	for( int i = 0; i < PIXELS; i++ ){
+		random = random * 1664525 + 1013904223;
+		color[i] = random;
+	}
+	std::vector<uint8_t> noisy( mask );
+	for( int i = 0; i < PIXELS / 50; i++ ){
+		random = random * 1664525 + 1013904223;
+		noisy[( random >> 8 ) % PIXELS] = ( random & 0x80 ) ? 255 : 0;
+	}
+
+	std::vector<uint8_t> byteMask( PIXELS );
+	std::vector<uint32_t> byteClip( PIXELS );
+	MorphologyFilter morphology;
+	const double byteMs = measure( iterations, [&]( int ){
+		byteMask = noisy;
+		morphology.erode( &byteMask[0], WIDTH, HEIGHT, 2 );
+		morphology.dilate( &byteMask[0], WIDTH, HEIGHT, 2 );
+		morphology.dilate( &byteMask[0], WIDTH, HEIGHT, 2 );
+		morphology.erode( &byteMask[0], WIDTH, HEIGHT, 2 );
+		copyWithMask( &color[0], &byteMask[0], &byteClip[0], PIXELS );
+	} );
+	printResult( "byte mask opening + closing + copy", byteMs );
+
+	BitMask bitMask( WIDTH, HEIGHT );
+	std::vector<uint8_t> unpacked( PIXELS );
+	std::vector<uint32_t> bitClip( PIXELS );
+	const double bitMs = measure( iterations, [&]( int ){
+		bitMask.pack( &noisy[0], WIDTH );
+		bitMask.erode( 2 );
+		bitMask.dilate( 2 );
+		bitMask.dilate( 2 );
+		bitMask.erode( 2 );
+		bitMask.copyPixels( &color[0], &bitClip[0] );
+		bitMask.unpack( &unpacked[0], WIDTH );
+	} );
+	printResult( "bit mask opening + closing + copy", bitMs );
+	std::cout << "  speed-up : " << std::setprecision( 2 ) << byteMs / bitMs << "x (including pack and unpack)" << std::endl;
+	std::cout << "  mask size : byte " << PIXELS << " bytes, bit " << bitMask.getWordsPerRow() * sizeof( uint64_t ) * HEIGHT << " bytes" << std::endl;
+
+	// kƖcAʐρÁ͈ARs[8rbg̃}XN̏ƓʂɂȂ邱ƂmF
+	for( int level = SIMD_SCALAR; level <= ( std::min )( getSimdLevel(), SIMD_SSE41 ); level++ ){
+		bitMask.setSimdLevel( static_cast<SimdLevel>( level ) );
+		for( int radius = 1; radius <= 15; radius++ ){
+			for( int octagon = 0; octagon <= 1; octagon++ ){
+				const MorphologyShape shape = octagon ? MORPHOLOGY_OCTAGON : MORPHOLOGY_RECT;
+				morphology.setShape( shape );
+				byteMask = noisy;
+				morphology.erode( &byteMask[0], WIDTH, HEIGHT, radius );
+				morphology.dilate( &byteMask[0], WIDTH, HEIGHT, radius + 1 );
+				copyWithMask( &color[0], &byteMask[0], &byteClip[0], PIXELS );
+				bitMask.pack( &noisy[0], WIDTH );
+				bitMask.erode( radius, shape );
+				bitMask.dilate( radius + 1, shape );
+				bitMask.unpack( &unpacked[0], WIDTH );
+				bitMask.copyPixels( &color[0], &bitClip[0] );
+
+				int area = 0;
+				MaskRect rect;
+				rect.left = WIDTH;
+				rect.top = HEIGHT;
+				for( int y = 0; y < HEIGHT; y++ ){
+					for( int x = 0; x < WIDTH; x++ ){
+						if( byteMask[y * WIDTH + x] ){
+							area++;
+							rect.left = ( std::min )( rect.left, x );
+							rect.top = ( std::min )( rect.top, y );
+							rect.right = ( std::max )( rect.right, x + 1 );
+							rect.bottom = ( std::max )( rect.bottom, y + 1 );
+						}
+					}
+				}
+				const MaskRect bounds = bitMask.getBoundingBox();
+				const bool sameBounds = ( area == 0 ) ? bounds.isEmpty()
+					: ( bounds.left == rect.left && bounds.top == rect.top && bounds.right == rect.right && bounds.bottom == rect.bottom );
+				if( unpacked != byteMask || bitClip != byteClip || bitMask.getArea() != area || !sameBounds ){
+					std::cerr << "Error : bit mask output differs from byte mask output (radius " << radius
+						<< ", " << ( octagon ? "octagon" : "rect" ) << ", " << getSimdLevelName( static_cast<SimdLevel>( level ) ) << ")" << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Player͈̔͂ɍi(Region of Interest)
+static bool benchRegionOfInterest( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint16_t> reference( PIXELS );
+
+	// ʂ̑啔߂߂̐lȀȐlAl̂Ȃt[Ŕׂ
+	const int radii[] = { 180, 30, 0 };
+	const char* radiusNames[] = { "large player", "small player", "no player" };
+	const int radiiSize = sizeof( radii ) / sizeof( radii[0] );
+
+	std::vector<uint8_t> color( PIXELS * 4 );
+	uint32_t random = 24680;
+	for( int i = 0; i < PIXELS * 4; i++ ){
+		random = random * 1664525 + 1013904223;
+		color[i] = static_cast<uint8_t>( random >> 24 );
+	}
+
+	std::vector<uint8_t> roiMask( PIXELS ), fullMask( PIXELS );
+	std::vector<uint8_t> roiClip( PIXELS * 4 ), fullClip( PIXELS * 4 );
+	std::vector<uint8_t> roiDepth8( PIXELS ), fullDepth8( PIXELS );
+	std::vector<uint8_t> roiPlayer( PIXELS * 3 ), fullPlayer( PIXELS * 3 );
+	ClippingProcessor clipping( table );
+	PlayerProcessor playerProcessor( table );
+	PlayerProcessor fullPlayerProcessor( table );
+	fullPlayerProcessor.setRegionOfInterest( false );
+	for( int r = 0; r < radiiSize; r++ ){
+		std::vector< std::vector<uint16_t> > frames( 8 );
+		for( size_t i = 0; i < frames.size(); i++ ){
+			makeSyntheticDepth( frames[i], static_cast<int>( i ) * 8, radii[r] );
+		}
+		const int count = static_cast<int>( frames.size() );
+
+		// Ԗڂ̃t[ɂ́APlayer痣ꂽɃCfbNX7(gȂl)̉f̉
+		// (fR[hłPlayer͈̔͂ɂ̈ɂ܂߂AwiƂĈ)
+		for( int i = 1; i < count; i += 2 ){
+			for( int y = 8; y < 24; y++ ){
+				for( int x = 8 + i; x < 24 + i; x++ ){
+					frames[i][y * WIDTH + x] |= KINECT_PLAYER_INDEX_MASK;
+				}
+			}
+		}
+
+		std::cout << radiusNames[r] << std::endl;
+		clipping.setIterations( 2, 2 );
+		clipping.setShape( MORPHOLOGY_RECT );
+		clipping.setRegionOfInterest( false );
+		const double clipFullMs = measure( iterations, [&]( int i ){
+			clipping.process( &frames[i % count][0], &color[0], &fullMask[0], &fullClip[0] );
+		} );
+		clipping.setRegionOfInterest( true );
+		const double clipRoiMs = measure( iterations, [&]( int i ){
+			clipping.process( &frames[i % count][0], &color[0], &roiMask[0], &roiClip[0] );
+		} );
+		printResult( "  clipping (full frame)", clipFullMs );
+		printResult( "  clipping (region of interest)", clipRoiMs );
+		std::cout << "    speed-up : " << std::setprecision( 2 ) << clipFullMs / clipRoiMs << "x" << std::endl;
+
+		playerProcessor.setRegionOfInterest( false );
+		const double playerFullMs = measure( iterations, [&]( int i ){
+			playerProcessor.process( &frames[i % count][0], &fullDepth8[0], &fullPlayer[0] );
+		} );
+		playerProcessor.setRegionOfInterest( true );
+		const double playerRoiMs = measure( iterations, [&]( int i ){
+			playerProcessor.process( &frames[i % count][0], &roiDepth8[0], &roiPlayer[0] );
+		} );
+		printResult( "  player (full frame)", playerFullMs );
+		printResult( "  player (region of interest)", playerRoiMs );
+		std::cout << "    speed-up : " << std::setprecision( 2 ) << playerFullMs / playerRoiMs << "x" << std::endl;
+
+		// ͈͂iĂt[ŜƂƓʂɂȂ邱ƂmF(kƖc̉񐔂ƌ`ς)
+		const int erodes[] = { 2, 0, 3, 6 };
+		const int dilates[] = { 2, 3, 0, 5 };
+		for( int i = 0; i < count; i++ ){
+			for( int k = 0; k < 8; k++ ){
+				clipping.setIterations( erodes[k % 4], dilates[k % 4] );
+				clipping.setShape( ( k < 4 ) ? MORPHOLOGY_RECT : MORPHOLOGY_OCTAGON );
+				clipping.setRegionOfInterest( false );
+				clipping.process( &frames[i][0], &color[0], &fullMask[0], &fullClip[0] );
+				clipping.setRegionOfInterest( true );
+				clipping.process( &frames[i][0], &color[0], &roiMask[0], &roiClip[0] );
+				if( roiMask != fullMask || roiClip != fullClip ){
+					std::cerr << "Error : clipping output with region of interest differs from full frame output ("
+						<< radiusNames[r] << ", frame " << i << ", erode " << erodes[k % 4] << ", dilate " << dilates[k % 4] << ")" << std::endl;
+					return false;
+				}
+			}
+
+			// ͈͂i͑ďāAÕt[͈̔͂0Ŗ߂ꍇmF
+			fullPlayerProcessor.process( &frames[i][0], &fullDepth8[0], &fullPlayer[0] );
+			playerProcessor.process( &frames[i][0], &roiDepth8[0], &roiPlayer[0], &registered[0] );
+			if( roiDepth8 != fullDepth8 || roiPlayer != fullPlayer ){
+				std::cerr << "Error : player output with region of interest differs from full frame output (" << radiusNames[r] << ", frame " << i << ")" << std::endl;
+				return false;
+			}
+
+			// fR[hŋ߂Player̉fƔ͈͂Aʒu킹Depth&Player琔̂ƈv邱ƂmF
+			PlayerRegions expected;
+			for( int y = 0; y < HEIGHT; y++ ){
+				for( int x = 0; x < WIDTH; x++ ){
+					const int index = registered[y * WIDTH + x] & KINECT_PLAYER_INDEX_MASK;
+					if( index == 0 || index > KINECT_PLAYER_COUNT ){
+						continue;
+					}
+					MaskRect& rect = expected.bounds[index];
+					if( expected.pixels[index]++ == 0 ){
+						rect.left = x;
+						rect.top = y;
+						rect.right = x + 1;
+						rect.bottom = y + 1;
+					}
+					rect.left = ( std::min )( rect.left, x );
+					rect.top = ( std::min )( rect.top, y );
+					rect.right = ( std::max )( rect.right, x + 1 );
+					rect.bottom = ( std::max )( rect.bottom, y + 1 );
+				}
+			}
+			const PlayerRegions& regions = playerProcessor.getRegions();
+			for( int index = 1; index <= KINECT_PLAYER_COUNT; index++ ){
+				const MaskRect& a = regions.bounds[index];
+				const MaskRect& b = expected.bounds[index];
+				if( regions.pixels[index] != expected.pixels[index]
+					|| a.left != b.left || a.top != b.top || a.right != b.right || a.bottom != b.bottom ){
+					std::cerr << "Error : player regions differ from counted regions (" << radiusNames[r] << ", frame " << i << ", player " << index << ")" << std::endl;
+					return false;
+				}
+			}
+
+			// ̃XbhőіɐĂ܂Ƃ߂ĂɂȂ邱ƂmF
+			ThreadPool threadPool( 4 );
+			DepthPipeline pipeline( table, &threadPool );
+			PlayerRegions bandRegions;
+			DepthPipelineOutput regionOutput;
+			regionOutput.registered = &reference[0];
+			regionOutput.regions = &bandRegions;
+			pipeline.process( &frames[i][0], regionOutput );
+			for( int index = 1; index <= KINECT_PLAYER_COUNT; index++ ){
+				const MaskRect& a = bandRegions.bounds[index];
+				const MaskRect& b = expected.bounds[index];
+				if( bandRegions.pixels[index] != expected.pixels[index]
+					|| a.left != b.left || a.top != b.top || a.right != b.right || a.bottom != b.bottom ){
+					std::cerr << "Error : multi-thread player regions differ from counted regions (" << radiusNames[r] << ", frame " << i << ", player " << index << ")" << std::endl;
+					return false;
+				}
+			}
+		}
+
+		clipping.setIterations( 2, 2 );
+		clipping.setShape( MORPHOLOGY_RECT );
+		clipping.process( &frames[count - 1][0], &color[0], &roiMask[0], &roiClip[0] );
+		const MaskRect rect = clipping.getProcessedRect();
+		std::cout << "    processed : " << rect.getWidth() << "x" << rect.getHeight() << " of " << WIDTH << "x" << HEIGHT << " (last frame)" << std::endl;
+	}
+	return true;
+}
+
+// ς^C̏(ClippingProcessorsetIncremental())
+static bool benchIncremental( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const RegistrationTable& table = context.table;
+
+	// l̃t[̒́A16~16f̃^C̊percent͈̔͂Player̉f̉t[Ãt[ƌ݂ɏ
+	// (lr𓮂Ƃ̂悤ɕς͈͂܂Ƃ܂ĂāAwiColor͓ȂʁAColoȓSẲfh炮ʂ͍ŌɌv)
+	std::vector<uint16_t> base;
+	makeSyntheticDepth( base, 0 );
+	std::vector<uint8_t> color( PIXELS * 4 );
+	uint32_t random = 13579;
+	for( int i = 0; i < PIXELS * 4; i++ ){
+		random = random * 1664525 + 1013904223;
+		color[i] = static_cast<uint8_t>( random >> 24 );
+	}
+	const int tilesX = WIDTH / 16;
+	const int tileCount = tilesX * ( HEIGHT / 16 );
+	const int tilesY = HEIGHT / 16;
+	auto makeChangedFrame = [&]( std::vector<uint16_t>& frame, int percent, int shift ){
+		frame = base;
+		const int count = tileCount * percent / 100;
+		const int blockWidth = ( std::min )( tilesX, static_cast<int>( std::ceil( std::sqrt( count * 4.0 / 3.0 ) ) ) );
+		const int blockHeight = blockWidth ? ( count + blockWidth - 1 ) / blockWidth : 0;
+		const int blockLeft = ( std::max )( ( tilesX - blockWidth ) / 2 + shift, 0 );
+		const int blockTop = ( std::max )( ( tilesY - blockHeight ) / 2, 0 );
+		for( int i = 0; i < count; i++ ){
+			const int left = ( std::min )( blockLeft + i % blockWidth, tilesX - 1 ) * 16 + 4;
+			const int top = ( std::min )( blockTop + i / blockWidth, tilesY - 1 ) * 16 + 4;
+			for( int y = top; y < top + 8; y++ ){
+				for( int x = left; x < left + 8; x++ ){
+					uint16_t& value = frame[y * WIDTH + x];
+					value = static_cast<uint16_t>( ( value & ~KINECT_PLAYER_INDEX_MASK ) | ( ( value & KINECT_PLAYER_INDEX_MASK ) ? 0 : 2 ) );
+				}
+			}
+		}
+	};
+
+	// ς^Ć̕AClippingƓ悤ɕ̃obt@ԂɎg(StagePipelinẽWũobt@)
+	const int bufferCount = 5;
+	std::vector<uint8_t> fullMask( PIXELS );
+	std::vector<uint8_t> fullClip( PIXELS * 4 );
+	std::vector< std::vector<uint8_t> > tileMasks( bufferCount, std::vector<uint8_t>( PIXELS ) );
+	std::vector< std::vector<uint8_t> > tileClips( bufferCount, std::vector<uint8_t>( PIXELS * 4 ) );
+	ClippingProcessor full( table );
+	ClippingProcessor incremental( table );
+	incremental.setIncremental( true );
+
+	// }XN𐮂Đ؂蔲i(METRIC_MORPH)ƁAʒu킹ƃfR[h܂ޏŜׂ
+	auto printTimes = [&]( const std::string& label, double fullStageMs, double tileStageMs, double fullMs, double tileMs ){
+		std::cout << "  " << std::setw( 11 ) << label << " : " << std::setprecision( 3 ) << std::setw( 6 ) << fullStageMs << " / " << std::setw( 6 ) << tileStageMs
+			<< " (" << std::setprecision( 2 ) << std::setw( 5 ) << fullStageMs / tileStageMs << "x) | "
+			<< std::setprecision( 3 ) << std::setw( 6 ) << fullMs << " / " << std::setw( 6 ) << tileMs
+			<< " (" << std::setprecision( 2 ) << std::setw( 5 ) << fullMs / tileMs << "x)" << std::endl;
+	};
+	std::cout << "incremental clipping (ms/frame, full frame / changed tiles only, " << bufferCount << " output buffers in turn)" << std::endl;
+	std::cout << "      changed :  mask + morphology + copy  |      whole process" << std::endl;
+	const int percents[] = { 0, 1, 5, 10, 25, 50, 100 };
+	const int percentsSize = sizeof( percents ) / sizeof( percents[0] );
+	for( int p = 0; p < percentsSize; p++ ){
+		std::vector< std::vector<uint16_t> > frames( 2 );
+		frames[0] = base;
+		makeChangedFrame( frames[1], percents[p], 0 );
+		double fullStageMs = 0.0;
+		const double fullMs = measureWithMorphStage( iterations, [&]( int i ){
+			full.process( &frames[i % 2][0], &color[0], &fullMask[0], &fullClip[0] );
+		}, fullStageMs );
+		int changed = 0;
+		int calls = 0;
+		double tileStageMs = 0.0;
+		const double tileMs = measureWithMorphStage( iterations, [&]( int i ){
+			incremental.process( &frames[i % 2][0], &color[0], &tileMasks[i % bufferCount][0], &tileClips[i % bufferCount][0] );
+			if( calls++ > 0 ){ // EH[Abv(Ǒv̑̃t[)͐Ȃ
+				changed += incremental.getChangedTileCount();
+			}
+		}, tileStageMs );
+		std::ostringstream label;
+		label << std::fixed << std::setprecision( 1 ) << 100.0 * changed / ( iterations * incremental.getTileCount() ) << "%";
+		printTimes( label.str(), fullStageMs, tileStageMs, fullMs, tileMs );
+	}
+
+	// ColoȓSẲfh炮Ƃ(l̃^C͖t[؂蔲)
+	std::vector< std::vector<uint8_t> > colors( 2, color );
+	for( int i = 0; i < PIXELS * 4; i += 4 ){
+		colors[1][i] ^= 1;
+	}
+	double fullStageMs = 0.0;
+	const double fullMs = measureWithMorphStage( iterations, [&]( int i ){
+		full.process( &base[0], &colors[i % 2][0], &fullMask[0], &fullClip[0] );
+	}, fullStageMs );
+	double tileStageMs = 0.0;
+	const double tileMs = measureWithMorphStage( iterations, [&]( int i ){
+		incremental.process( &base[0], &colors[i % 2][0], &tileMasks[i % bufferCount][0], &tileClips[i % bufferCount][0] );
+	}, tileStageMs );
+	printTimes( "noisy color", fullStageMs, tileStageMs, fullMs, tileMs );
+	std::cout << "    " << incremental.getCopiedTileCount() << " tiles copied" << std::endl;
+
+	// Õt[Ƃ̈ႢAkƖc̉񐔂ƌ`AColorςȂAt[ŜƂƓʂɂȂ邱ƂmF
+	std::vector<uint16_t> frame;
+	for( int i = 0; i < 64; i++ ){
+		if( i % 4 == 0 ){
+			frame.resize( PIXELS );
+			makeSyntheticDepth( frame, i, 40 + i * 2 );
+		}
+		else{
+			makeChangedFrame( frame, ( i * 7 ) % 30, i % 5 - 2 );
+		}
+		if( i % 3 == 0 ){
+			for( int j = 0; j < 500; j++ ){
+				random = random * 1664525 + 1013904223;
+				color[( random >> 8 ) % ( PIXELS * 4 )]++;
+			}
+		}
+		const int erode = ( i / 16 ) % 2 ? 3 : 2;
+		const int dilate = ( i / 16 ) % 2 ? 1 : 4;
+		const MorphologyShape shape = ( i / 8 ) % 2 ? MORPHOLOGY_OCTAGON : MORPHOLOGY_RECT;
+		full.setIterations( erode, dilate );
+		full.setShape( shape );
+		incremental.setIterations( erode, dilate );
+		incremental.setShape( shape );
+		full.process( &frame[0], &color[0], &fullMask[0], &fullClip[0] );
+		incremental.process( &frame[0], &color[0], &tileMasks[i % bufferCount][0], &tileClips[i % bufferCount][0] );
+		if( tileMasks[i % bufferCount] != fullMask || tileClips[i % bufferCount] != fullClip ){
+			std::cerr << "Error : incremental clipping output differs from full frame output (frame " << i << ")" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Player̘A(PlayerLabeler)
+static bool benchLabeler( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const RegistrationTable& table = context.table;
+
+	// 6l̍V[ʒu킹APlayer̉f̏ȉ(ܗ)U΂点
+	// 81̓CfbNX7(gȂlŁAwiƂĈ)̉ɂ
+	SyntheticScene scene;
+	scene.players = KINECT_PLAYER_COUNT;
+	SyntheticFrameSource synthetic( scene, FRAME_STREAM_FLAG_DEPTH | FRAME_STREAM_FLAG_COLOR );
+	const int count = 8;
+	std::vector< std::vector<uint16_t> > frames( count, std::vector<uint16_t>( PIXELS ) );
+	std::vector< std::vector<uint8_t> > colors( count, std::vector<uint8_t>( PIXELS * 4 ) );
+	std::vector<uint16_t> depth( PIXELS );
+	uint32_t random = 314159;
+	for( int i = 0; i < count; i++ ){
+		synthetic.render( i * 10, &depth[0], &colors[i][0], nullptr );
+		table.registerFrame( &depth[0], &frames[i][0] );
+		for( int j = 0; j < 400; j++ ){
+			random = random * 1664525 + 1013904223;
+			const int x = ( random >> 8 ) % ( WIDTH - 2 );
+			const int y = ( random >> 4 ) % ( HEIGHT - 2 );
+			const int size = ( j % 4 ) ? 1 : 3;
+			for( int dy = 0; dy < size; dy++ ){
+				for( int dx = 0; dx < size; dx++ ){
+					uint16_t& value = frames[i][( y + dy ) * WIDTH + x + dx];
+					const int index = ( j % 8 == 7 ) ? KINECT_PLAYER_INDEX_MASK : 1 + ( random >> 24 ) % KINECT_PLAYER_COUNT;
+					value = static_cast<uint16_t>( ( value & ~KINECT_PLAYER_INDEX_MASK ) | index );
+				}
+			}
+		}
+	}
+
+	// ]ǂPlayerɃt[Ŝ𑖍ă}XNA؂蔲(6̑AA͕Ȃ)
+	std::vector< std::vector<uint8_t> > masks( KINECT_PLAYER_COUNT + 1, std::vector<uint8_t>( PIXELS ) );
+	std::vector< std::vector<uint8_t> > clips( KINECT_PLAYER_COUNT + 1, std::vector<uint8_t>( PIXELS * 4 ) );
+	const double perPlayerMs = measure( iterations, [&]( int i ){
+		const uint16_t* registeredFrame = &frames[i % count][0];
+		for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+			uint8_t* playerMask = &masks[player][0];
+			for( int j = 0; j < PIXELS; j++ ){
+				playerMask[j] = ( ( registeredFrame[j] & KINECT_PLAYER_INDEX_MASK ) == player ) ? 255 : 0;
+			}
+			copyWithMask( reinterpret_cast<const uint32_t*>( &colors[i % count][0] ), playerMask, reinterpret_cast<uint32_t*>( &clips[player][0] ), PIXELS );
+		}
+	} );
+	printResult( "player masks + clips (6 passes)", perPlayerMs );
+
+	PlayerLabelOutput labelOutput;
+	std::vector<uint8_t> labels( PIXELS );
+	labelOutput.labels = &labels[0];
+	for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+		labelOutput.playerMask[player] = &masks[player][0];
+		labelOutput.clip[player] = &clips[player][0];
+	}
+	double singleThreadMs = 0.0;
+	const int threadCounts[] = { 1, 2, 4, 8 };
+	for( int t = 0; t < 4; t++ ){
+		ThreadPool threadPool( threadCounts[t] );
+		PlayerLabeler labeler( WIDTH, HEIGHT, &threadPool );
+		const double ms = measure( iterations, [&]( int i ){
+			labelOutput.color = &colors[i % count][0];
+			labeler.process( &frames[i % count][0], labelOutput );
+		} );
+		if( t == 0 ){
+			singleThreadMs = ms;
+		}
+		std::ostringstream name;
+		name << "player labeler (" << threadPool.getThreadCount() << " threads)";
+		printResult( name.str().c_str(), ms );
+		std::cout << "  speed-up : " << std::setprecision( 2 ) << perPlayerMs / ms << "x, scaling : " << singleThreadMs / ms << "x" << std::endl;
+	}
+
+	// hԂŋ߂AƁAAPlayeřʁA}XNA؂蔲Colorv邱ƂmF(XbhƏʐςς)
+	std::vector<int> reference;
+	std::vector<PlayerComponent> expected;
+	std::vector<uint8_t> expectedClip( PIXELS * 4 );
+	for( int t = 0; t < 4; t++ ){
+		ThreadPool threadPool( threadCounts[t] );
+		PlayerLabeler labeler( WIDTH, HEIGHT, &threadPool );
+		for( int i = 0; i < count; i++ ){
+			labeler.setMinimumArea( ( i % 2 ) ? PlayerLabeler::DEFAULT_MINIMUM_AREA : 5 );
+			labelOutput.color = &colors[i][0];
+			labeler.process( &frames[i][0], labelOutput );
+			labelComponentsByFlooding( &frames[i][0], reference, expected );
+
+			const std::vector<PlayerComponent>& components = labeler.getComponents();
+			bool same = components.size() == expected.size();
+			for( size_t c = 0; c < expected.size() && same; c++ ){
+				const PlayerComponent& a = components[c];
+				const PlayerComponent& b = expected[c];
+				same = a.player == b.player && a.area == b.area
+					&& a.bounds.left == b.bounds.left && a.bounds.top == b.bounds.top && a.bounds.right == b.bounds.right && a.bounds.bottom == b.bounds.bottom
+					&& std::fabs( a.centroidX - b.centroidX ) < 1e-3f && std::fabs( a.centroidY - b.centroidY ) < 1e-3f && std::fabs( a.meanDepth - b.meanDepth ) < 1e-2f
+					&& a.removed == ( b.area < labeler.getMinimumArea() );
+			}
+			for( int player = 1; player <= KINECT_PLAYER_COUNT && same; player++ ){
+				int area = 0;
+				for( size_t c = 0; c < expected.size(); c++ ){
+					area += ( expected[c].player == player && expected[c].area >= labeler.getMinimumArea() ) ? expected[c].area : 0;
+				}
+				same = labeler.getSegment( player ).area == area;
+			}
+			for( int j = 0; j < PIXELS && same; j++ ){
+				const int player = ( reference[j] >= 0 && !components[reference[j]].removed ) ? expected[reference[j]].player : 0;
+				same = labels[j] == player;
+				for( int p = 1; p <= KINECT_PLAYER_COUNT && same; p++ ){
+					const uint32_t pixel = ( p == player ) ? reinterpret_cast<const uint32_t*>( &colors[i][0] )[j] : 0;
+					same = masks[p][j] == ( ( p == player ) ? 255 : 0 ) && reinterpret_cast<const uint32_t*>( &clips[p][0] )[j] == pixel;
+				}
+			}
+			if( !same ){
+				std::cerr << "Error : player labeler output differs from flood fill output (" << threadPool.getThreadCount() << " threads, frame " << i << ")" << std::endl;
+				return false;
+			}
+		}
+		if( t == 0 ){
+			int removed = 0;
+			for( size_t c = 0; c < labeler.getComponents().size(); c++ ){
+				removed += labeler.getComponents()[c].removed ? 1 : 0;
+			}
+			std::cout << "  components : " << labeler.getComponents().size() << " (" << removed << " specks removed, last frame)" << std::endl;
+		}
+	}
+	return true;
+}
+
+// wi̒u(BackgroundCompositor)
+static bool benchCompositor( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const RegistrationTable& table = context.table;
+
+	// V[ColorPlayer̃}XNAOf[V̔wi
+	SyntheticScene scene;
+	scene.players = 2;
+	SyntheticFrameSource synthetic( scene, FRAME_STREAM_FLAG_DEPTH | FRAME_STREAM_FLAG_COLOR );
+	const int count = 8;
+	std::vector< std::vector<uint8_t> > colors( count, std::vector<uint8_t>( PIXELS * 4 ) );
+	std::vector< std::vector<uint8_t> > masks( count, std::vector<uint8_t>( PIXELS ) );
+	std::vector<uint16_t> depth( PIXELS );
+	std::vector<uint16_t> registeredFrame( PIXELS );
+	for( int i = 0; i < count; i++ ){
+		synthetic.render( i * 10, &depth[0], &colors[i][0], nullptr );
+		table.registerFrame( &depth[0], &registeredFrame[0] );
+		for( int j = 0; j < PIXELS; j++ ){
+			masks[i][j] = ( registeredFrame[j] & KINECT_PLAYER_INDEX_MASK ) ? 255 : 0;
+		}
+	}
+	std::vector<uint8_t> background( PIXELS * 4 );
+	for( int j = 0; j < PIXELS; j++ ){
+		background[j * 4 + 0] = static_cast<uint8_t>( j % WIDTH * 255 / WIDTH );
+		background[j * 4 + 1] = static_cast<uint8_t>( j / WIDTH * 255 / HEIGHT );
+		background[j * 4 + 2] = 128;
+		background[j * 4 + 3] = 255;
+	}
+	std::vector<uint8_t> composite( PIXELS * 4 );
+	std::vector<uint8_t> expected( PIXELS * 4 );
+
+	// ]ǂɃt[ŜŁAڂ}XN𕂓_̃ɂč鏈
+	std::vector<float> blurred( PIXELS );
+	std::vector<float> horizontal( PIXELS );
+	const int radius = BackgroundCompositor::DEFAULT_FEATHER_RADIUS;
+	const double floatMs = measure( iterations, [&]( int i ){
+		const uint8_t* mask = &masks[i % count][0];
+		const uint8_t* color = &colors[i % count][0];
+		for( int y = 0; y < HEIGHT; y++ ){
+			for( int x = 0; x < WIDTH; x++ ){
+				float sum = 0.0f;
+				for( int k = -radius; k <= radius; k++ ){
+					sum += mask[y * WIDTH + ( std::min )( ( std::max )( x + k, 0 ), WIDTH - 1 )];
+				}
+				horizontal[y * WIDTH + x] = sum;
+			}
+		}
+		for( int y = 0; y < HEIGHT; y++ ){
+			for( int x = 0; x < WIDTH; x++ ){
+				float sum = 0.0f;
+				for( int k = -radius; k <= radius; k++ ){
+					sum += horizontal[( std::min )( ( std::max )( y + k, 0 ), HEIGHT - 1 ) * WIDTH + x];
+				}
+				blurred[y * WIDTH + x] = sum / ( 255.0f * ( 2 * radius + 1 ) * ( 2 * radius + 1 ) );
+			}
+		}
+		for( int j = 0; j < PIXELS * 4; j++ ){
+			const float alpha = blurred[j / 4];
+			composite[j] = static_cast<uint8_t>( color[j] * alpha + background[j] * ( 1.0f - alpha ) + 0.5f );
+		}
+	} );
+	printResult( "composite (float, full frame)", floatMs );
+
+	BackgroundCompositor compositor( WIDTH, HEIGHT );
+	for( int level = SIMD_SCALAR; level <= getSimdLevel(); level++ ){
+		compositor.setSimdLevel( static_cast<SimdLevel>( level ) );
+		const double ms = measure( iterations, [&]( int i ){
+			compositor.process( &colors[i % count][0], &masks[i % count][0], &background[0], &composite[0] );
+		} );
+		const std::string name = std::string( "background compositor (" ) + getSimdLevelName( static_cast<SimdLevel>( level ) ) + ")";
+		printResult( name.c_str(), ms );
+		std::cout << "  speed-up : " << std::setprecision( 2 ) << floatMs / ms << "x" << std::endl;
+	}
+
+	// ԂaɂȂ
+	compositor.setSimdLevel( getSimdLevel() );
+	const int radii[] = { 1, 4, 15 };
+	for( int r = 0; r < 3; r++ ){
+		compositor.setFeatherRadius( radii[r] );
+		const double ms = measure( iterations, [&]( int i ){
+			compositor.process( &colors[i % count][0], &masks[i % count][0], &background[0], &composite[0] );
+		} );
+		std::ostringstream name;
+		name << "background compositor (radius " << radii[r] << ")";
+		printResult( name.str().c_str(), ms );
+	}
+	const MaskRect& blendRect = compositor.getBlendRect();
+	std::cout << "  blended : " << std::setprecision( 3 ) << 100.0 * blendRect.getWidth() * blendRect.getHeight() / PIXELS << " % of the frame (last frame)" << std::endl;
+
+	// fɔ̒𐔂čʂƈv邱ƂmF(߃ZbgAaA}XN摜̒[ɐڂꍇƃ}XNꍇ)
+	std::vector<uint8_t> edgeMask( PIXELS, 0 );
+	for( int y = 0; y < 200; y++ ){
+		std::memset( &edgeMask[y * WIDTH], 255, 100 );
+		std::memset( &edgeMask[( HEIGHT - 1 - y ) * WIDTH + WIDTH - 150 + y % 7], 255, 150 - y % 7 );
+	}
+	std::vector<uint8_t> emptyMask( PIXELS, 0 );
+	const int checkRadii[] = { 0, 1, 4, 15 };
+	for( int r = 0; r < 4; r++ ){
+		compositor.setFeatherRadius( checkRadii[r] );
+		for( int i = 0; i < 3; i++ ){
+			const uint8_t* mask = ( i == 0 ) ? &masks[r][0] : ( ( i == 1 ) ? &edgeMask[0] : &emptyMask[0] );
+			compositeByBoxFilter( &colors[r][0], mask, &background[0], &expected[0], checkRadii[r] );
+			for( int level = SIMD_SCALAR; level <= getSimdLevel(); level++ ){
+				compositor.setSimdLevel( static_cast<SimdLevel>( level ) );
+				std::fill( composite.begin(), composite.end(), static_cast<uint8_t>( 0 ) );
+				compositor.process( &colors[r][0], mask, &background[0], &composite[0] );
+				if( composite != expected ){
+					std::cerr << "Error : background compositor output differs from box filter output (" << getSimdLevelName( static_cast<SimdLevel>( level ) ) << ", radius " << checkRadii[r] << ", mask " << i << ")" << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// t[̉摜obt@̊m
+static bool benchBufferPool( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+
+	ThreadPool threadPool;
+	DepthPipeline pipeline( table, &threadPool );
+	pipeline.setPlayerColors( PLAYER_COLORS[0] );
+
+	// t[mۂ0Ŗ߂ꍇ(cv::Mat::zeros()Ɠ)
+	long start = g_heapAllocations;
+	const double allocatingMs = measure( iterations, [&]( int i ){
+		std::vector<uint16_t> registMat( PIXELS, 0 );
+		std::vector<uint8_t> depthMat( PIXELS, 0 );
+		std::vector<uint8_t> playerMat( PIXELS * 3, 0 );
+		std::vector<uint8_t> maskMat( PIXELS, 0 );
+		DepthPipelineOutput frameOutput;
+		frameOutput.registered = &registMat[0];
+		frameOutput.depth8 = &depthMat[0];
+		frameOutput.player = &playerMat[0];
+		frameOutput.mask = &maskMat[0];
+		pipeline.process( &g_depthFrames[i % frameCount][0], frameOutput );
+	} );
+	const double allocatingCount = static_cast<double>( g_heapAllocations - start ) / ( iterations + 1 );
+	printResult( "frame buffers allocated per frame", allocatingMs );
+	std::cout << "  heap allocations per frame : " << std::setprecision( 2 ) << allocatingCount << std::endl;
+
+	// v[؂ꍇ(ŏ̃t[łmۂ)
+	FrameBufferPool framePool;
+	auto pooledFrame = [&]( int i ){
+		PooledFrameBuffer registBuffer( framePool, PIXEL_FORMAT_DEPTH16, WIDTH, HEIGHT );
+		PooledFrameBuffer depthBuffer( framePool, PIXEL_FORMAT_GRAY8, WIDTH, HEIGHT );
+		PooledFrameBuffer playerBuffer( framePool, PIXEL_FORMAT_BGR24, WIDTH, HEIGHT );
+		PooledFrameBuffer maskBuffer( framePool, PIXEL_FORMAT_GRAY8, WIDTH, HEIGHT );
+		DepthPipelineOutput frameOutput;
+		frameOutput.registered = registBuffer.ptr<uint16_t>();
+		frameOutput.depth8 = depthBuffer.data();
+		frameOutput.player = playerBuffer.data();
+		frameOutput.mask = maskBuffer.data();
+		pipeline.process( &g_depthFrames[i % frameCount][0], frameOutput );
+	};
+	pooledFrame( 0 );
+	start = g_heapAllocations;
+	const double pooledMs = measure( iterations, pooledFrame );
+	const long steadyAllocations = g_heapAllocations - start;
+	printResult( "frame buffers from pool", pooledMs );
+	const FrameBufferPool::Statistics statistics = framePool.getStatistics();
+	std::cout << "  pool buffers : " << statistics.heapAllocations << " (" << statistics.bytesAllocated / 1024 << " KB), acquisitions : " << statistics.acquisitions << std::endl;
+	std::cout << "  heap allocations in steady state : " << steadyAllocations << " in " << iterations + 1 << " frames" << std::endl;
+	return true;
+}
+
+// t[̑(hCõL[͂Đ)
+static bool benchEarlyRelease( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+
+	ThreadPool threadPool;
+	DepthPipeline pipeline( table, &threadPool );
+	std::vector<uint8_t> depth8( PIXELS );
+	DepthPipelineOutput frameOutput;
+	frameOutput.registered = &registered[0];
+	frameOutput.depth8 = &depth8[0];
+
+	// ̏t[ێꍇ͂āA10t[ɔwiƂănhcĂ
+	FrameRing depthRing( PIXEL_FORMAT_DEPTH16, WIDTH, HEIGHT, 4 );
+	FrameHandle backgroundFrame;
+
+	// ۂɃOobt@ւ̃Rs[ƏsāAt[̎Ԃv
+	// \(imshowAwaitKey)̎Ԃ15msŁA5t[1x70mŝƂ
+	const int simulatedFrames = ( std::max )( iterations, 300 );
+	std::vector<double> copyMs( simulatedFrames );
+	std::vector<double> processMs( simulatedFrames );
+	for( int i = 0; i < simulatedFrames; i++ ){
+		const uint16_t* src = &g_depthFrames[i % frameCount][0];
+		double start = getTimeInSeconds();
+		FrameHandle depthFrame;
+		depthRing.write( reinterpret_cast<const uint8_t*>( src ), WIDTH * 2, i, 0, depthFrame );
+		copyMs[i] = ( getTimeInSeconds() - start ) * 1000.0;
+
+		start = getTimeInSeconds();
+		pipeline.process( depthFrame.ptr<uint16_t>(), frameOutput );
+		const double displayMs = ( i % 5 == 4 ) ? 70.0 : 15.0;
+		processMs[i] = ( getTimeInSeconds() - start ) * 1000.0 + displayMs;
+		if( i % 10 == 0 ){
+			backgroundFrame = depthFrame;
+		}
+	}
+	backgroundFrame.reset();
+
+	// ]ǂ\I܂Ńt[ێꍇ
+	std::vector<double> none( simulatedFrames, 0.0 );
+	FrameDropCounter holdDropCounter;
+	simulateDriverQueue( 2, processMs, none, holdDropCounter );
+
+	// Oobt@փRs[ĂɕԂꍇ
+	FrameDropCounter releaseDropCounter;
+	simulateDriverQueue( 2, copyMs, processMs, releaseDropCounter );
+
+	double copyTotal = 0.0;
+	for( int i = 0; i < simulatedFrames; i++ ){
+		copyTotal += copyMs[i];
+	}
+	printResult( "frame ring copy (depth)", copyTotal / simulatedFrames );
+	const FrameRing::Statistics statistics = depthRing.getStatistics();
+	std::cout << "  ring slots : " << depthRing.getCapacity() << ", held slots skipped : " << statistics.heldSkips << ", overflows : " << statistics.overflows << std::endl;
+	std::cout << std::setprecision( 1 );
+	std::cout << "  2-deep driver queue, frames held until displayed : " << holdDropCounter.getDropped() << " dropped / " << holdDropCounter.getReceived() << " received (" << holdDropCounter.getDropRate() * 100.0 << "%)" << std::endl;
+	std::cout << "  2-deep driver queue, frames released after copy  : " << releaseDropCounter.getDropped() << " dropped / " << releaseDropCounter.getReceived() << " received (" << releaseDropCounter.getDropRate() * 100.0 << "%)" << std::endl;
+	return true;
+}
+
+// L^t@C݂̏Ɠǂݍ
+static bool benchRecording( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+
+	// ColorADepth&PlayerASkeletonA(1t[)1gƂāA҂ɘAċL^
+	// (30fps葬ނ̂ŁAfBXNǂȂ΃obt@󂭂̂҂)
+	const char* recordingPath = "Benchmark.kbr";
+	const int recordedFrames = ( std::max )( iterations, 300 );
+	std::vector<uint8_t> color;
+	std::vector<SkeletonFrame> skeletons( frameCount );
+	makeSyntheticColorAndSkeleton( color, skeletons[0], 0 );
+	for( int i = 1; i < frameCount; i++ ){
+		std::vector<uint8_t> unused;
+		makeSyntheticColorAndSkeleton( unused, skeletons[i], i );
+	}
+	const uint32_t audioSamples = RECORDING_AUDIO_SAMPLES_PER_SECOND / 30;
+	std::vector<int16_t> audio( audioSamples );
+	for( uint32_t i = 0; i < audioSamples; i++ ){
+		audio[i] = static_cast<int16_t>( 8000.0 * std::sin( i * 0.2 ) );
+	}
+
+	RecordingWriter writer;
+	double start = getTimeInSeconds();
+	if( !writer.open( recordingPath, FRAME_STREAM_FLAG_ALL | RECORD_STREAM_FLAG_AUDIO ) ){
+		std::cerr << "Error : RecordingWriter::open( " << recordingPath << " )" << std::endl;
+		return false;
+	}
+	double maxCallMs = 0.0;
+	for( int i = 0; i < recordedFrames; i++ ){
+		SkeletonFrame& skeleton = skeletons[i % frameCount];
+		skeleton.timestamp = i * 33;
+		skeleton.frameNumber = i;
+		FrameInfo info = { static_cast<uint32_t>( i ), i * 33, PIXEL_FORMAT_BGRX32, WIDTH, HEIGHT };
+
+		// 擾̃[v݂Ŏ~܂ȂƂm߂邽߁A1g݂̏ɂԂ̍ől𒲂ׂ
+		const double callStart = getTimeInSeconds();
+		writer.write( FRAME_STREAM_COLOR, info, &color[0], static_cast<uint32_t>( color.size() ), &skeleton.floorClipPlane );
+		info.format = PIXEL_FORMAT_DEPTH16;
+		writer.write( FRAME_STREAM_DEPTH, info, &g_depthFrames[i % frameCount][0], sizeof( uint16_t ) * PIXELS, &skeleton.floorClipPlane );
+		writer.writeSkeleton( skeleton );
+		writer.writeAudio( i * 33, i * audioSamples, &audio[0], audioSamples );
+		maxCallMs = ( std::max )( maxCallMs, ( getTimeInSeconds() - callStart ) * 1000.0 );
+	}
+	const double queuedSeconds = getTimeInSeconds() - start;
+	if( !writer.close() ){
+		std::cerr << "Error : RecordingWriter::close" << std::endl;
+		return false;
+	}
+	const double writeSeconds = getTimeInSeconds() - start;
+	const RecordingWriter::Statistics writeStatistics = writer.getStatistics();
+	const double megabytes = writer.getBytesWritten() / ( 1024.0 * 1024.0 );
+
+	// SẴR[hǂ(}bv̈8oCgɓǂōv)
+	RecordingReader reader;
+	start = getTimeInSeconds();
+	if( !reader.open( recordingPath ) ){
+		std::cerr << "Error : RecordingReader::open( " << recordingPath << " )" << std::endl;
+		return false;
+	}
+	const double openMs = ( getTimeInSeconds() - start ) * 1000.0;
+	start = getTimeInSeconds();
+	uint64_t checksum = 0;
+	uint64_t bytesRead = 0;
+	for( int stream = 0; stream < RECORD_STREAM_COUNT; stream++ ){
+		for( int i = 0; i < reader.getFrameCount( stream ); i++ ){
+			const uint64_t* data = reinterpret_cast<const uint64_t*>( reader.getRecordData( stream, i ) );
+			const uint32_t size = reader.getIndexEntry( stream, i ).size;
+			for( uint32_t j = 0; j < size / 8; j++ ){
+				checksum += data[j];
+			}
+			bytesRead += size;
+		}
+	}
+	const double readSeconds = getTimeInSeconds() - start;
+
+	// CfbNXgƃt[ԍɂړ(SďɂǂʂƔׂ)
+	const int depthCount = reader.getFrameCount( FRAME_STREAM_DEPTH );
+	const int seekCount = 100000;
+	bool seekMatched = true;
+	volatile int found = 0;
+	start = getTimeInSeconds();
+	for( int i = 0; i < seekCount; i++ ){
+		const int64_t timestamp = ( static_cast<int64_t>( i ) * 7919 ) % ( recordedFrames * 33 );
+		found += reader.findByTime( FRAME_STREAM_DEPTH, timestamp );
+		found += reader.findByFrameNumber( FRAME_STREAM_DEPTH, static_cast<uint32_t>( timestamp / 33 ) );
+	}
+	const double seekNs = ( getTimeInSeconds() - start ) * 1e9 / ( seekCount * 2 );
+	for( int i = 0; i < recordedFrames * 33 && seekMatched; i += 17 ){
+		int expected = 0;
+		while( expected + 1 < depthCount && reader.getIndexEntry( FRAME_STREAM_DEPTH, expected + 1 ).timestamp <= i ){
+			expected++;
+		}
+		seekMatched = ( reader.findByTime( FRAME_STREAM_DEPTH, i ) == expected ) && ( reader.findByFrameNumber( FRAME_STREAM_DEPTH, i / 33 ) == i / 33 );
+	}
+	const bool indexed = reader.hasIndex();
+	int recordCounts[RECORD_STREAM_COUNT];
+	for( int stream = 0; stream < RECORD_STREAM_COUNT; stream++ ){
+		recordCounts[stream] = reader.getFrameCount( stream );
+	}
+	reader.close();
+
+	// CfbNXĂ(ʒủZӂꂷAGg̃R[hCfbNX̑OɎ܂Ȃ)t@ĆA
+	// CfbNXg킸ɃR[hǂĊJƂm߂(tb^[Ɛ擪̃Gg)
+	const uint64_t fileSize = writer.getBytesWritten();
+	auto patchFile = [&]( uint64_t offset, const void* data, size_t size ) -> bool {
+		std::fstream file( recordingPath, std::ios::in | std::ios::out | std::ios::binary );
+		file.seekp( static_cast<std::streamoff>( offset ) );
+		file.write( static_cast<const char*>( data ), size );
+		return !file.fail();
+	};
+	RecordingFooter footer;
+	RecordIndexEntry entry;
+	{
+		std::ifstream file( recordingPath, std::ios::binary );
+		file.seekg( static_cast<std::streamoff>( fileSize - sizeof( footer ) ) );
+		file.read( reinterpret_cast<char*>( &footer ), sizeof( footer ) );
+		file.seekg( static_cast<std::streamoff>( footer.indexOffset + sizeof( RecordHeader ) ) );
+		file.read( reinterpret_cast<char*>( &entry ), sizeof( entry ) );
+	}
+	const uint64_t entryOffset = footer.indexOffset + sizeof( RecordHeader );
+	bool rescanned = true;
+	for( int i = 0; i < 3 && rescanned; i++ ){
+		RecordingFooter brokenFooter = footer;
+		RecordIndexEntry brokenEntry = entry;
+		if( i == 0 ){
+			brokenFooter.indexOffset = 0 - static_cast<uint64_t>( sizeof( RecordHeader ) );
+		}
+		else if( i == 1 ){
+			brokenEntry.size = 0xffffff00u;
+		}
+		else{
+			brokenEntry.offset = footer.indexOffset;
+		}
+		rescanned = patchFile( fileSize - sizeof( footer ), &brokenFooter, sizeof( footer ) ) && patchFile( entryOffset, &brokenEntry, sizeof( entry ) ) && reader.open( recordingPath ) && !reader.hasIndex();
+		for( int stream = 0; stream < RECORD_STREAM_COUNT && rescanned; stream++ ){
+			rescanned = reader.getFrameCount( stream ) == recordCounts[stream];
+		}
+		reader.close();
+	}
+	std::remove( recordingPath );
+	if( !rescanned ){
+		std::cerr << "Error : recording with a broken index was not scanned" << std::endl;
+		return false;
+	}
+
+	std::cout << std::setprecision( 1 );
+	std::cout << "recording write (unpaced) : " << megabytes << " MB in " << writeSeconds * 1000.0 << " ms (" << megabytes / writeSeconds << " MB/s), "
+		<< recordedFrames << " frame sets (" << recordedFrames / writeSeconds << " sets/s)" << std::endl;
+	std::cout << std::setprecision( 3 );
+	std::cout << "  capture thread : " << queuedSeconds * 1000.0 / recordedFrames << " ms/set average, " << maxCallMs << " ms/set max" << std::endl;
+	std::cout << "  write buffers : " << writeStatistics.buffersAllocated << ", peak pending : " << writeStatistics.peakPendingBuffers << ", stalls : " << writeStatistics.stalls << std::endl;
+	std::cout << std::setprecision( 1 );
+	std::cout << "recording read (mmap) : " << bytesRead / ( 1024.0 * 1024.0 ) / readSeconds << " MB/s, open " << std::setprecision( 3 ) << openMs << " ms ("
+		<< ( indexed ? "trailing index" : "scanned" ) << "), checksum " << std::hex << checksum << std::dec << std::endl;
+	std::cout << "  seek by time / frame number : " << std::setprecision( 1 ) << seekNs << " ns/seek, matches linear search : " << ( seekMatched ? "yes" : "NO" ) << std::endl;
+	return true;
+}
+
+// Depth̉tk(L^t@CDepth̃R[h)
+static bool benchDepthCodec( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const char* depthPath = context.depthPath;
+
+	// t[̓mCŶŁAۂ̃ZT[ɋ߂mCŶłv
+	std::vector< std::vector<uint16_t> > noisyFrames( g_depthFrames );
+	for( int i = 0; i < frameCount; i++ ){
+		addDepthNoise( noisyFrames[i], i );
+	}
+	const std::string name = depthPath ? "recorded" : "synthetic";
+	std::cout << "depth codec (raw " << sizeof( uint16_t ) * PIXELS / 1024 << " KB/frame, budget 2 ms/frame) :" << std::endl;
+	measureDepthCodec( ( name + ", spatial" ).c_str(), g_depthFrames, false, iterations );
+	measureDepthCodec( ( name + ", temporal" ).c_str(), g_depthFrames, true, iterations );
+	measureDepthCodec( "synthetic + noise, spatial", noisyFrames, false, iterations );
+	measureDepthCodec( "synthetic + noise, temporal", noisyFrames, true, iterations );
+
+	// WJƑ傫Ⴄt[́AWJɏ܂falseԂƂmF
+	DepthCompressor compressor( WIDTH, HEIGHT );
+	std::vector<uint8_t> compressed( compressor.getMaxCompressedSize() );
+	const size_t size = compressor.compress( &g_depthFrames[0][0], &compressed[0] );
+	DepthDecompressor decompressor;
+	std::vector<uint16_t> smaller( PIXELS / 4 );
+	std::vector<uint16_t> decoded( PIXELS );
+	if( decompressor.decompress( &compressed[0], size, &smaller[0], WIDTH / 2, HEIGHT / 2 ) || !decompressor.decompress( &compressed[0], size, &decoded[0], WIDTH, HEIGHT ) ){
+		std::cerr << "Error : depth decompressor did not check the frame size" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// L^t@C̍Đ(ZT[̖łAL^t[Ŏۂ̏s)
+static bool benchReplay( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+	const char* replayPath = context.replayPath;
+	std::vector<uint16_t> registered( PIXELS );
+
+	// -replayŎw肵ȂƂ́At[L^t@CɏŎg
+	const char* recordingPath = replayPath ? replayPath : "Benchmark.kbr";
+	if( !replayPath ){
+		RecordingWriter writer;
+		writer.setDepthCompression( true );
+		if( !writer.open( recordingPath, FRAME_STREAM_FLAG_ALL ) ){
+			std::cerr << "Error : RecordingWriter::open( " << recordingPath << " )" << std::endl;
+			return false;
+		}
+		std::vector<uint8_t> color;
+		SkeletonFrame skeleton;
+		for( int i = 0; i < frameCount; i++ ){
+			makeSyntheticColorAndSkeleton( color, skeleton, i );
+			FrameInfo info = { static_cast<uint32_t>( i ), i * 33, PIXEL_FORMAT_BGRX32, WIDTH, HEIGHT };
+			writer.write( FRAME_STREAM_COLOR, info, &color[0], static_cast<uint32_t>( color.size() ) );
+			info.format = PIXEL_FORMAT_DEPTH16;
+			writer.write( FRAME_STREAM_DEPTH, info, &g_depthFrames[i][0], sizeof( uint16_t ) * PIXELS );
+			writer.writeSkeleton( skeleton );
+		}
+		if( !writer.close() ){
+			std::cerr << "Error : RecordingWriter::close" << std::endl;
+			return false;
+		}
+	}
+
+	ReplayFrameSource replay;
+	if( !replay.open( recordingPath ) ){
+		std::cerr << "Error : ReplayFrameSource::open( " << recordingPath << " )" << std::endl;
+		return false;
+	}
+	replay.setLoop( true );
+	const int replayFrames = replay.getFrameCount();
+
+	// t[̎擾(}bv̈wŁAkDepthWJ)
+	FrameSet frames;
+	const double readMs = measure( iterations, [&]( int ){
+		replay.read( frames );
+	} );
+
+	// Đt[̈ʒu킹AfR[hASkeleton̓e
+	ThreadPool threadPool;
+	DepthPipeline pipeline( table, &threadPool );
+	std::vector<uint8_t> mask( PIXELS );
+	DepthPipelineOutput frameOutput;
+	frameOutput.registered = &registered[0];
+	frameOutput.mask = &mask[0];
+	int projectedJoints = 0;
+	bool identical = true;
+	replay.seek( 0 );
+	const double processMs = measure( iterations, [&]( int ){
+		replay.read( frames );
+		if( !frames.depth.data ){
+			return;
+		}
+		const uint16_t* depth = reinterpret_cast<const uint16_t*>( frames.depth.data );
+		if( !replayPath ){
+			const std::vector<uint16_t>& source = g_depthFrames[frames.depth.info.frameNumber % frameCount];
+			identical = identical && std::memcmp( depth, &source[0], sizeof( uint16_t ) * PIXELS ) == 0;
+		}
+		pipeline.process( depth, frameOutput );
+		if( frames.skeleton ){
+			for( int i = 0; i < KINECT_SKELETON_COUNT; i++ ){
+				const SkeletonData& skeleton = frames.skeleton->skeletons[i];
+				if( skeleton.trackingState != SKELETON_TRACKED ){
+					continue;
+				}
+				for( int j = 0; j < KINECT_SKELETON_POSITION_COUNT; j++ ){
+					float x, y;
+					projectSkeletonToDepth( skeleton.positions[j], WIDTH, HEIGHT, &x, &y );
+					if( x >= 0.0f && x < WIDTH && y >= 0.0f && y < HEIGHT && mask[static_cast<int>( y ) * WIDTH + static_cast<int>( x )] ){
+						projectedJoints++;
+					}
+				}
+			}
+		}
+	} );
+
+	// kDepth̓L[t[WĴŁA납珇ɈړĂL^t[ƈv邱Ƃm߂
+	if( !replayPath ){
+		for( int i = replayFrames - 1; i >= 0 && identical; i -= 7 ){
+			replay.seek( i );
+			identical = replay.read( frames ) && std::memcmp( frames.depth.data, &g_depthFrames[i % frameCount][0], sizeof( uint16_t ) * PIXELS ) == 0;
+		}
+	}
+	replay.close();
+
+	printResult( "replay read (depth decompressed)", readMs );
+	printResult( "replay + registration/decode/skeleton", processMs );
+	std::cout << "  recording : " << recordingPath << ", " << replayFrames << " frame sets, joints on player mask : " << projectedJoints << std::endl;
+	if( !replayPath ){
+		std::cout << "  replayed depth identical to recorded : " << ( identical ? "yes" : "NO" ) << std::endl;
+	}
+
+	// ĐXg[Ƀ^CX^vƓ̗͂h炬(}4ms)At[(5%)āAXg[̓m߂
+	RecordingReader reader;
+	if( !reader.open( recordingPath ) ){
+		std::cerr << "Error : RecordingReader::open( " << recordingPath << " )" << std::endl;
+		return false;
+	}
+	std::vector<StreamEvent> events;
+	makeJitteredEvents( reader, ( std::max )( 1, 300 / ( std::max )( 1, replayFrames ) ), 4, 5, events );
+	std::cout << "stream synchronization (jitter 4 ms, drop 5 %, tolerance " << FrameSynchronizer::DEFAULT_TOLERANCE_MS << " ms)" << std::endl;
+	measureWaitAll( reader, events, !replayPath );
+	measureSynchronizer( "latest matched", reader, events, SYNC_LATEST_MATCHED, FrameSynchronizer::DEFAULT_TOLERANCE_MS, !replayPath );
+	measureSynchronizer( "every depth", reader, events, SYNC_EVERY_DEPTH, FrameSynchronizer::DEFAULT_TOLERANCE_MS, !replayPath );
+	measureSynchronizer( "any stream", reader, events, SYNC_ANY_STREAM, FrameSynchronizer::DEFAULT_TOLERANCE_MS, false );
+	reader.close();
+	if( !replayPath ){
+		std::remove( recordingPath );
+	}
+
+	// 傫̍ȂR[h(ColorAkĂȂDepthASkeleton)ƁȂÕt[̑g܂łōĐI邱Ƃm߂
+	const char* brokenPath = "BenchmarkBroken.kbr";
+	for( int stream = 0; stream < FRAME_STREAM_COUNT; stream++ ){
+		RecordingWriter writer;
+		if( !writer.open( brokenPath, FRAME_STREAM_FLAG_ALL ) ){
+			std::cerr << "Error : RecordingWriter::open( " << brokenPath << " )" << std::endl;
+			return false;
+		}
+		std::vector<uint8_t> color;
+		SkeletonFrame skeleton;
+		for( int i = 0; i < 3; i++ ){
+			// 2Ԗڂ̑gAstream̃R[h𔼕̑傫ɂ
+			const uint32_t divisor = ( i == 1 ) ? 2 : 1;
+			makeSyntheticColorAndSkeleton( color, skeleton, i );
+			FrameInfo info = { static_cast<uint32_t>( i ), i * 33, PIXEL_FORMAT_BGRX32, WIDTH, HEIGHT };
+			writer.write( FRAME_STREAM_COLOR, info, &color[0], static_cast<uint32_t>( color.size() ) / ( stream == FRAME_STREAM_COLOR ? divisor : 1 ) );
+			info.format = PIXEL_FORMAT_DEPTH16;
+			writer.write( FRAME_STREAM_DEPTH, info, &g_depthFrames[i % frameCount][0], sizeof( uint16_t ) * PIXELS / ( stream == FRAME_STREAM_DEPTH ? divisor : 1 ) );
+			writer.write( FRAME_STREAM_SKELETON, info, &skeleton, sizeof( skeleton ) / ( stream == FRAME_STREAM_SKELETON ? divisor : 1 ) );
+		}
+		if( !writer.close() ){
+			std::cerr << "Error : RecordingWriter::close" << std::endl;
+			return false;
+		}
+		ReplayFrameSource broken;
+		int replayed = 0;
+		if( broken.open( brokenPath ) ){
+			while( broken.read( frames ) ){
+				replayed++;
+			}
+			broken.close();
+		}
+		std::remove( brokenPath );
+		if( replayed != 1 || frames.color.data || frames.depth.data || frames.skeleton ){
+			std::cerr << "Error : replay did not stop at a " << getFrameStreamName( static_cast<FrameStream>( stream ) ) << " record of the wrong size" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// V[̐(ZT[̖łׂ̐̕)
+static bool benchSynthetic( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const RegistrationTable& table = context.table;
+	std::vector<uint16_t> registered( PIXELS );
+
+	// ̑(lƃXbh)
+	ThreadPool threadPool;
+	ThreadPool singleThread( 1 );
+	const int playerCounts[] = { 1, KINECT_PLAYER_COUNT };
+	for( int p = 0; p < 2; p++ ){
+		SyntheticScene scene;
+		scene.players = playerCounts[p];
+		for( int t = 0; t < 2; t++ ){
+			ThreadPool& pool = t ? threadPool : singleThread;
+			SyntheticFrameSource synthetic( scene, FRAME_STREAM_FLAG_ALL, &pool );
+			FrameSet frames;
+			const double ms = measure( iterations, [&]( int ){
+				synthetic.read( frames );
+			} );
+			std::ostringstream name;
+			name << "synthetic " << scene.players << " players (" << pool.getThreadCount() << " threads)";
+			printResult( name.str().c_str(), ms );
+		}
+	}
+
+	// t[ԍ́AXbhɂ炸t[𐶐
+	SyntheticScene scene;
+	scene.players = KINECT_PLAYER_COUNT;
+	SyntheticFrameSource synthetic( scene, FRAME_STREAM_FLAG_ALL, &threadPool );
+	SyntheticFrameSource reference( scene, FRAME_STREAM_FLAG_ALL, &singleThread );
+	std::vector<uint16_t> depth( PIXELS ), depthRef( PIXELS );
+	std::vector<uint8_t> color( PIXELS * 4 ), colorRef( PIXELS * 4 );
+	SkeletonFrame skeleton, skeletonRef;
+	bool deterministic = true;
+	for( uint32_t i = 0; i < 300 && deterministic; i += 37 ){
+		synthetic.render( i, &depth[0], &color[0], &skeleton );
+		reference.render( i, &depthRef[0], &colorRef[0], &skeletonRef );
+		deterministic = depth == depthRef && color == colorRef && std::memcmp( &skeleton, &skeletonRef, sizeof( skeleton ) ) == 0;
+	}
+
+	// Depth̏Skeleton̓eɓn(ǐՂĂl̊֐߂ADepth摜̓Playeȑɂ邩𐔂)
+	DepthPipeline pipeline( table, &threadPool );
+	std::vector<uint8_t> mask( PIXELS );
+	DepthPipelineOutput frameOutput;
+	frameOutput.registered = &registered[0];
+	frameOutput.mask = &mask[0];
+	int joints = 0;
+	int jointsOnPlayer = 0;
+	int playerPixels = 0;
+	FrameSet frames;
+	double generateSeconds = 0.0;
+	const double processMs = measure( iterations, [&]( int ){
+		const double start = getTimeInSeconds();
+		synthetic.read( frames );
+		generateSeconds += getTimeInSeconds() - start;
+		const uint16_t* depth = reinterpret_cast<const uint16_t*>( frames.depth.data );
+		pipeline.process( depth, frameOutput );
+		for( int i = 0; i < PIXELS; i++ ){
+			playerPixels += mask[i] != 0;
+		}
+		for( int i = 0; i < KINECT_SKELETON_COUNT; i++ ){
+			const SkeletonData& data = frames.skeleton->skeletons[i];
+			if( data.trackingState != SKELETON_TRACKED ){
+				continue;
+			}
+			for( int j = 0; j < KINECT_SKELETON_POSITION_COUNT; j++ ){
+				float x, y;
+				projectSkeletonToDepth( data.positions[j], WIDTH, HEIGHT, &x, &y );
+				if( x >= 0.0f && x < WIDTH && y >= 0.0f && y < HEIGHT ){
+					joints++;
+					jointsOnPlayer += ( depth[static_cast<int>( y ) * WIDTH + static_cast<int>( x )] & KINECT_PLAYER_INDEX_MASK ) == i + 1;
+				}
+			}
+		}
+	} );
+
+	printResult( "synthetic + registration/decode/skeleton", processMs );
+	std::cout << "  generation : " << std::setprecision( 1 ) << generateSeconds * 1000.0 / ( iterations + 1 ) / processMs * 100.0 << "% of frame time"
+		<< ", player pixels : " << playerPixels / ( iterations + 1 ) << "/frame"
+		<< ", tracked joints on own player index : " << jointsOnPlayer << "/" << joints << std::endl;
+	std::cout << "  same frames with " << threadPool.getThreadCount() << " threads and 1 thread : " << ( deterministic ? "yes" : "NO" ) << std::endl;
+	return true;
+}
+
+// ĩXbhœpCvC(擾\)
+static bool benchStagePipeline( BenchmarkContext& )
+{
+	// SpscQueue̎󂯓n̑(ʂ̃XbhŎo)
+	{
+		const int itemCount = 200000;
+		SpscQueue<int> queue( 64, QUEUE_BLOCK );
+		struct Consumer
+		{
+			SpscQueue<int>* queue;
+			int64_t sum;
+			static void entry( void* argument )
+			{
+				Consumer* consumer = static_cast<Consumer*>( argument );
+				int item;
+				while( consumer->queue->pop( item ) ){
+					consumer->sum += item;
+				}
+			}
+		} consumer = { &queue, 0 };
+		Thread thread;
+		const double start = getTimeInSeconds();
+		thread.start( &Consumer::entry, &consumer );
+		for( int i = 0; i < itemCount; i++ ){
+			queue.push( i );
+		}
+		queue.close();
+		thread.join();
+		const double seconds = getTimeInSeconds() - start;
+		std::cout << std::left << std::setw( 40 ) << "spsc queue transfer" << " : " << std::right << std::fixed << std::setprecision( 1 )
+			<< std::setw( 9 ) << seconds * 1e9 / itemCount << " ns/item (sum " << ( consumer.sum == static_cast<int64_t>( itemCount ) * ( itemCount - 1 ) / 2 ? "ok" : "NG" ) << ")" << std::endl;
+	}
+
+	// 擾AA\(waitKey()̑҂܂)ɂ鎞Ԃ҂̒iŖ͂āA1̃XbhŏɎsꍇƔׂ
+	const int stageMs[3] = { 6, 12, 8 };
+	const char* stageNames[3] = { "capture", "process", "present" };
+	const int pipelineFrames = 60;
+	double start = getTimeInSeconds();
+	for( int i = 0; i < pipelineFrames; i++ ){
+		for( int s = 0; s < 3; s++ ){
+			sleepMilliseconds( stageMs[s] );
+		}
+	}
+	const double sequentialMs = ( getTimeInSeconds() - start ) * 1000.0 / pipelineFrames;
+	printResult( "stages in sequence (6 + 12 + 8 ms)", sequentialMs );
+
+	// jobs[i]̓Wũt[ԍ(iʂ鏇Ԃ̊mFɎg)
+	const QueueDropPolicy policies[3] = { QUEUE_BLOCK, QUEUE_DROP_OLDEST, QUEUE_DROP_NEWEST };
+	for( int p = 0; p < 3; p++ ){
+		StagePipeline stagePipeline( 6 );
+		std::vector<int> jobs( stagePipeline.getJobCount() );
+		int captured = 0;
+		int presented = 0;
+		int lastPresented = -1;
+		bool inOrder = true;
+		stagePipeline.addStage( stageNames[0], [&]( int job ) -> bool {
+			if( captured == pipelineFrames ){
+				return false;
+			}
+			sleepMilliseconds( stageMs[0] );
+			jobs[job] = captured++;
+			return true;
+		} );
+		stagePipeline.addStage( stageNames[1], [&]( int ) -> bool {
+			sleepMilliseconds( stageMs[1] );
+			return true;
+		}, 2, policies[p] );
+		stagePipeline.addStage( stageNames[2], [&]( int job ) -> bool {
+			sleepMilliseconds( stageMs[2] );
+			inOrder = inOrder && jobs[job] > lastPresented;
+			lastPresented = jobs[job];
+			presented++;
+			return true;
+		}, 2, policies[p] );
+
+		start = getTimeInSeconds();
+		stagePipeline.run();
+		const double pipelinedMs = ( getTimeInSeconds() - start ) * 1000.0 / presented;
+		const std::string name = std::string( "stage threads (" ) + getQueueDropPolicyName( policies[p] ) + ")";
+		printResult( name.c_str(), pipelinedMs );
+		std::cout << "  presented " << presented << "/" << pipelineFrames << " frames, in order : " << ( inOrder ? "yes" : "NO" ) << std::endl;
+		std::ostringstream statistics;
+		stagePipeline.printStatistics( statistics );
+		std::istringstream lines( statistics.str() );
+		std::string line;
+		while( std::getline( lines, line ) ){
+			std::cout << "  " << line << std::endl;
+		}
+	}
+	return true;
+}
+
+// ȉԂ̋L^(qXgO)
+static bool benchHistogram( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	const RegistrationTable& table = context.table;
+
+	// ΐKzɋ߂l(Ԃ炵Eɐ)L^Aבւċ߂mȒlƃp[Z^Cׂ
+	// oPbg͒̕l1/32ȉȂ̂ŁAΌ덷͈̔͂Ɏ܂
+	const int sampleCount = 200000;
+	std::vector<uint32_t> samples( sampleCount );
+	uint32_t seed = 12345;
+	for( int i = 0; i < sampleCount; i++ ){
+		double sum = 0.0;
+		for( int k = 0; k < 4; k++ ){
+			seed = seed * 1664525u + 1013904223u;
+			sum += ( seed >> 8 ) / static_cast<double>( 1 << 24 );
+		}
+		samples[i] = static_cast<uint32_t>( 500.0 * std::exp( ( sum - 2.0 ) * 2.5 ) );
+	}
+	LatencyHistogram histogram;
+	double start = getTimeInSeconds();
+	for( int i = 0; i < sampleCount; i++ ){
+		histogram.record( samples[i] );
+	}
+	const double recordNs = ( getTimeInSeconds() - start ) * 1e9 / sampleCount;
+	std::sort( samples.begin(), samples.end() );
+	const double percentiles[3] = { 50.0, 99.0, 100.0 };
+	double maximumError = 0.0;
+	std::cout << std::left << std::setw( 40 ) << "latency histogram record" << " : " << std::right << std::fixed << std::setprecision( 1 ) << std::setw( 9 ) << recordNs << " ns/value" << std::endl;
+	for( int i = 0; i < 3; i++ ){
+		const size_t rank = static_cast<size_t>( percentiles[i] / 100.0 * sampleCount + 0.5 );
+		const uint32_t exact = samples[( std::max )( rank, static_cast<size_t>( 1 ) ) - 1];
+		const uint32_t approximate = ( percentiles[i] < 100.0 ) ? histogram.getPercentile( percentiles[i] ) : histogram.getMaximum();
+		const double error = exact > 0 ? std::fabs( static_cast<double>( approximate ) - exact ) / exact : 0.0;
+		maximumError = ( std::max )( maximumError, error );
+		std::cout << "  " << ( percentiles[i] < 100.0 ? ( percentiles[i] < 90.0 ? "p50" : "p99" ) : "max" ) << " : " << exact << " us exact, " << approximate << " us histogram" << std::endl;
+	}
+	if( maximumError > 1.0 / LatencyHistogram::SUB_BUCKET_COUNT ){
+		std::cerr << "Error : latency histogram percentile error " << maximumError * 100.0 << " % exceeds the bucket width" << std::endl;
+		return false;
+	}
+
+	// ScopedMetric1񂠂̎(̂Ƃ͎ǂ܂Ȃ)
+	const int timerCount = 1000000;
+	double timerNs[2];
+	for( int enabled = 0; enabled < 2; enabled++ ){
+		setMetricsEnabled( enabled != 0 );
+		start = getTimeInSeconds();
+		for( int i = 0; i < timerCount; i++ ){
+			ScopedMetric metric( METRIC_DRAW );
+		}
+		timerNs[enabled] = ( getTimeInSeconds() - start ) * 1e9 / timerCount;
+	}
+
+	// Clipping̏(ʒu킹AMorphology)ɋL^ꂽƂ̑
+	// 1t[ŋL^͎̂擾AbNA(ColorDepth)Aʒu킹AMorphologyA\Ax9xȂ̂ŁA̕t[̏ԂƔׂ
+	ClippingProcessor clippingProcessor( table );
+	std::vector<uint8_t> color( PIXELS * 4 );
+	std::vector<uint8_t> mask( PIXELS );
+	std::vector<uint8_t> clip( PIXELS * 4 );
+	double clippingMs[2];
+	for( int enabled = 0; enabled < 2; enabled++ ){
+		setMetricsEnabled( enabled != 0 );
+		clippingMs[enabled] = measure( iterations, [&]( int i ){
+			clippingProcessor.process( &g_depthFrames[i % frameCount][0], &color[0], &mask[0], &clip[0] );
+		} );
+	}
+	setMetricsEnabled( false );
+	const int timersPerFrame = 9;
+	std::cout << std::left << std::setw( 40 ) << "scoped metric timer" << " : " << std::right << std::setprecision( 1 )
+		<< std::setw( 9 ) << timerNs[1] << " ns enabled, " << timerNs[0] << " ns disabled" << std::endl;
+	printResult( "clipping process (metrics disabled)", clippingMs[0] );
+	printResult( "clipping process (metrics enabled)", clippingMs[1] );
+	std::cout << "  overhead estimate : " << timersPerFrame << " timers x " << std::setprecision( 1 ) << timerNs[1] << " ns = "
+		<< std::setprecision( 3 ) << timersPerFrame * timerNs[1] * 1e-6 / clippingMs[0] * 100.0 << " % of the clipping process" << std::endl;
+
+	LatencyHistogram snapshot;
+	getMetricSnapshot( METRIC_MORPH, snapshot );
+	std::cout << "  morph recorded : " << snapshot.getCount() << " frames, p50 " << std::setprecision( 2 ) << snapshot.getPercentile( 50.0 ) / 1000.0
+		<< " ms, p99 " << snapshot.getPercentile( 99.0 ) / 1000.0 << " ms, max " << snapshot.getMaximum() / 1000.0 << " ms" << std::endl;
+	return true;
+}
+
+// ȉ̃g[X(Chromẽg[X`)
+static bool benchTrace( BenchmarkContext& )
+{
+	// Oobt@㏑邾L^A1Cxg̎ԂƏo̎Ԃv
+	const char* tracePath = "Benchmark.trace.json";
+	if( !startTrace( tracePath ) ){
+		std::cerr << "Error : startTrace( " << tracePath << " )" << std::endl;
+		return false;
+	}
+	setTraceThreadName( "benchmark" );
+	const int eventCount = 1000000;
+	double start = getTimeInSeconds();
+	for( int i = 0; i < eventCount; i++ ){
+		setTraceFrame( i / 10 );
+		TraceScope trace( "scope" );
+	}
+	const double eventNs = ( getTimeInSeconds() - start ) * 1e9 / eventCount;
+	start = getTimeInSeconds();
+	const bool written = writeTrace();
+	const double writeMs = ( getTimeInSeconds() - start ) * 1000.0;
+	stopTrace();
+	std::remove( tracePath );
+	if( !written ){
+		std::cerr << "Error : writeTrace( " << tracePath << " )" << std::endl;
+		return false;
+	}
+	std::cout << std::left << std::setw( 40 ) << "trace scope" << " : " << std::right << std::setprecision( 1 )
+		<< std::setw( 9 ) << eventNs << " ns/event" << std::endl;
+	std::cout << std::left << std::setw( 40 ) << "trace write" << " : " << std::right << std::setprecision( 1 )
+		<< std::setw( 9 ) << writeMs << " ms (" << TRACE_DEFAULT_CAPACITY << " events)" << std::endl;
+	return true;
+}
+
+// t[̃^C~O(`Ǝ擾̊ԊuA擾\܂ł̒x)
+static bool benchFrameTiming( BenchmarkContext& )
+{
+	// 30fpsŎ擾A60fpsŕ`悵āA`̊Ԋu1񂨂2{ɂƂ̓vm߂
+	// ͈ŗ^̂ŁAۂɂ͑҂Ȃ
+	FrameTiming timing;
+	double now = 0.0;
+	for( int i = 0; i < 300; i++ ){
+		if( i % 2 == 0 ){
+			timing.onCapture( now );
+		}
+		now += ( i % 4 == 3 ) ? 2.0 / 60.0 : 1.0 / 60.0;
+		timing.onPresent( now );
+	}
+	const TimingSeries& render = timing.getRenderInterval();
+	const TimingSeries& capture = timing.getCaptureInterval();
+	const TimingSeries& latency = timing.getCaptureToPresent();
+	const double expectedAverage = ( 1000.0 / 60.0 ) * 5.0 / 4.0;
+	if( std::abs( render.getMinimum() - 1000.0 / 60.0 ) > 1e-6 || std::abs( render.getMaximum() - 2000.0 / 60.0 ) > 1e-6
+		|| std::abs( render.getAverage() - expectedAverage ) > 0.5 || std::abs( render.getEwma() - expectedAverage ) > 2.0
+		|| capture.getCount() == 0 || latency.getCount() == 0 || latency.getMinimum() <= 0.0 ){
+		std::cerr << "Error : FrameTiming" << std::endl;
+		return false;
+	}
+	std::cout << std::left << std::setw( 40 ) << "frame timing render" << " : " << std::right << std::setprecision( 1 )
+		<< std::setw( 9 ) << FrameTiming::toFps( render.getEwma() ) << " fps (" << render.getMinimum() << "/" << render.getAverage() << "/" << render.getMaximum() << " ms)" << std::endl;
+	std::cout << std::left << std::setw( 40 ) << "frame timing capture" << " : " << std::right << std::setprecision( 1 )
+		<< std::setw( 9 ) << FrameTiming::toFps( capture.getEwma() ) << " fps" << std::endl;
+	std::cout << std::left << std::setw( 40 ) << "frame timing capture to present" << " : " << std::right << std::setprecision( 1 )
+		<< std::setw( 9 ) << latency.getEwma() << " ms (" << latency.getMinimum() << "/" << latency.getAverage() << "/" << latency.getMaximum() << " ms)" << std::endl;
+	return true;
+}
+
+#ifdef _WIN32
+// Kinect SDK̊֐𖈉fĂяoꍇ(ZT[Kv)
+static bool benchSensor( BenchmarkContext& context )
+{
+	const int iterations = context.iterations;
+	const int frameCount = context.frameCount;
+	std::vector<uint16_t> registered( PIXELS );
+	std::vector<uint16_t> reference( PIXELS );
+
+	INuiSensor* pSensor;
+	HRESULT hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	if( FAILED( hResult ) ){
+		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		return false;
+	}
+	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX );
+	if( FAILED( hResult ) ){
+		std::cerr << "Error : NuiInitialize" << std::endl;
+		return false;
+	}
+
+	const double sdkMs = measure( iterations, [&]( int i ){
+		const uint16_t* pBuffer = &g_depthFrames[i % frameCount][0];
+		std::memset( &reference[0], 0, sizeof( uint16_t ) * PIXELS );
+		for( int y = 0; y < HEIGHT; y++ ){
+			for( int x = 0; x < WIDTH; x++ ){
+				LONG registX = 0;
+				LONG registY = 0;
+				pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480, nullptr, x, y, *pBuffer, &registX, &registY );
+				if( ( registX >= 0 ) && ( registX < WIDTH ) && ( registY >= 0 ) && ( registY < HEIGHT ) ){
+					reference[registY * WIDTH + registX] = *pBuffer;
+				}
+				pBuffer++;
+			}
+		}
+	} );
+	printResult( "registration Kinect SDK per-pixel calls", sdkMs );
+	const double tableMs = measure( iterations, [&]( int i ){
+		context.table.registerFrame( &g_depthFrames[i % frameCount][0], &registered[0] );
+	} );
+
+	RegistrationTable sensorTable;
+	const double start = getTimeInSeconds();
+	hResult = buildRegistrationTable( pSensor, NUI_IMAGE_RESOLUTION_640x480, sensorTable );
+	if( FAILED( hResult ) ){
+		std::cerr << "Error : buildRegistrationTable" << std::endl;
+		return false;
+	}
+	printResult( "registration table build from sensor", ( getTimeInSeconds() - start ) * 1000.0 );
+	sensorTable.registerFrame( &g_depthFrames[0][0], &registered[0] );
+	std::cout << "  speed-up : " << std::setprecision( 2 ) << sdkMs / tableMs << "x" << std::endl;
+	std::cout << "  match with Kinect SDK : " << std::setprecision( 2 ) << matchRate( registered, reference ) << "%" << std::endl;
+	if( context.saveSensorTable ){
+		context.table = sensorTable;
+	}
+
+	pSensor->NuiShutdown();
+	return true;
+}
+#endif
+
+// ZNV̈ꗗ(-section/-skipŖOw肵đIԁArunByDefaultfalsẽZNV͖Ow肵Ƃs)
+// ֐falseԂƎs(ʂ̏ƈvȂȂ)
+struct BenchmarkSection
+{
+	const char* name;
+	bool ( *run )( BenchmarkContext& context );
+	bool runByDefault;
+};
+
+static const BenchmarkSection BENCHMARK_SECTIONS[] = {
+	{ "suite",          benchKernelSuite,      false },
+	{ "registration",   benchRegistration,     true },
+	{ "decode",         benchDecode,           true },
+	{ "player-stats",   benchPlayerStats,      true },
+	{ "colorizer",      benchColorizer,        true },
+	{ "threads",        benchThreads,          true },
+	{ "morphology",     benchMorphology,       true },
+	{ "bitmask",        benchBitMask,          true },
+	{ "roi",            benchRegionOfInterest, true },
+	{ "incremental",    benchIncremental,      true },
+	{ "labeler",        benchLabeler,          true },
+	{ "compositor",     benchCompositor,       true },
+	{ "buffer-pool",    benchBufferPool,       true },
+	{ "early-release",  benchEarlyRelease,     true },
+	{ "recording",      benchRecording,        true },
+	{ "depth-codec",    benchDepthCodec,       true },
+	{ "replay",         benchReplay,           true },
+	{ "synthetic",      benchSynthetic,        true },
+	{ "stage-pipeline", benchStagePipeline,    true },
+	{ "histogram",      benchHistogram,        true },
+	{ "trace",          benchTrace,            true },
+	{ "frame-timing",   benchFrameTiming,      true },
+#ifdef _WIN32
+	{ "sensor",         benchSensor,           false },
+#endif
+};
+static const int BENCHMARK_SECTION_COUNT = sizeof( BENCHMARK_SECTIONS ) / sizeof( BENCHMARK_SECTIONS[0] );
+
+static int findSection( const std::string& name )
+{
+	for( int i = 0; i < BENCHMARK_SECTION_COUNT; i++ ){
+		if( name == BENCHMARK_SECTIONS[i].name ){
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void printUsage()
+{
+	std::cout << "Usage : Benchmark [-depth <file.raw>] [-model <camera.txt>] [-table <table.bin>] [-frames <N>] [-save-table <table.bin>] [-replay <file.kbr>]" << std::endl;
+	std::cout << "                  [-section <name>] ... [-skip <name>] ... [-list] [-baseline <baseline.json>] [-save-baseline <baseline.json>] [-tolerance <percent>] [-repeat <N>]" << std::endl;
+	std::cout << "        Benchmark -suite ... (per-frame kernels only, same as -section suite)" << std::endl;
+#ifdef _WIN32
+	std::cout << "        Benchmark -sensor ... (measure Kinect SDK per-pixel calls and build the table from the sensor, same as adding -section sensor)" << std::endl;
+#endif
+}
+
+int main( int argc, char* argv[] )
+{
+	// ̉
+	const char* depthPath = nullptr;
+	const char* modelPath = nullptr;
+	const char* tablePath = nullptr;
+	const char* saveTablePath = nullptr;
+	const char* replayPath = nullptr;
+	const char* baselinePath = nullptr;
+	const char* saveBaselinePath = nullptr;
+	double tolerance = 0.15;
+	int repetitions = 5;
+	int iterations = 100;
+
+	// sZNV(-section1łw肵Ƃ͎w肵̂Aw肵ȂƂrunByDefault̂)
+	std::vector<bool> selected( BENCHMARK_SECTION_COUNT, false );
+	std::vector<bool> skipped( BENCHMARK_SECTION_COUNT, false );
+	bool anySelected = false;
+	for( int i = 1; i < argc; i++ ){
+		const std::string arg = argv[i];
+		if( arg == "-depth" && i + 1 < argc ){
+			depthPath = argv[++i];
+		}
+		else if( arg == "-model" && i + 1 < argc ){
+			modelPath = argv[++i];
+		}
+		else if( arg == "-table" && i + 1 < argc ){
+			tablePath = argv[++i];
+		}
+		else if( arg == "-save-table" && i + 1 < argc ){
+			saveTablePath = argv[++i];
+		}
+		else if( arg == "-replay" && i + 1 < argc ){
+			replayPath = argv[++i];
+		}
+		else if( arg == "-frames" && i + 1 < argc ){
+			iterations = std::atoi( argv[++i] );
+		}
+		else if( ( arg == "-section" || arg == "-skip" ) && i + 1 < argc ){
+			const int index = findSection( argv[++i] );
+			if( index < 0 ){
+				std::cerr << "Error : unknown section " << argv[i] << std::endl;
+				return -1;
+			}
+			if( arg == "-section" ){
+				selected[index] = true;
+				anySelected = true;
+			}
+			else{
+				skipped[index] = true;
+			}
+		}
+		else if( arg == "-list" ){
+			for( int j = 0; j < BENCHMARK_SECTION_COUNT; j++ ){
+				std::cout << BENCHMARK_SECTIONS[j].name << ( BENCHMARK_SECTIONS[j].runByDefault ? "" : " (only when selected)" ) << std::endl;
+			}
+			return 0;
+		}
+		else if( arg == "-suite" ){
+			selected[findSection( "suite" )] = true;
+			anySelected = true;
+		}
+		else if( arg == "-baseline" && i + 1 < argc ){
+			baselinePath = argv[++i];
+		}
+		else if( arg == "-save-baseline" && i + 1 < argc ){
+			saveBaselinePath = argv[++i];
+		}
+		else if( arg == "-tolerance" && i + 1 < argc ){
+			tolerance = std::atof( argv[++i] ) / 100.0;
+		}
+		else if( arg == "-repeat" && i + 1 < argc ){
+			repetitions = std::atoi( argv[++i] );
+		}
+#ifdef _WIN32
+		else if( arg == "-sensor" ){
+			selected[findSection( "sensor" )] = true;
+		}
+#endif
+		else{
+			printUsage();
+			return -1;
+		}
+	}
+	if( iterations <= 0 ){
+		iterations = 1;
+	}
+
+	// lw肵Ƃ́A]ǂ}CNx`}[Nׂ
+	if( !anySelected && ( baselinePath || saveBaselinePath ) ){
+		selected[findSection( "suite" )] = true;
+		anySelected = true;
+	}
+	for( int i = 0; i < BENCHMARK_SECTION_COUNT; i++ ){
+		if( !anySelected && BENCHMARK_SECTIONS[i].runByDefault ){
+			selected[i] = true;
+		}
+		if( skipped[i] ){
+			selected[i] = false;
+		}
+	}
+
+	// Depth&Playert[̏
+	if( depthPath ){
+		if( !loadRawDepth( depthPath, iterations ) ){
+			std::cerr << "Error : loadRawDepth( " << depthPath << " )" << std::endl;
+			return -1;
+		}
+	}
+	else{
+		const int syntheticCount = 30;
+		g_depthFrames.resize( syntheticCount );
+		for( int i = 0; i < syntheticCount; i++ ){
+			makeSyntheticDepth( g_depthFrames[i], i );
+		}
+	}
+	BenchmarkContext context;
+	context.iterations = iterations;
+	context.repetitions = repetitions;
+	context.frameCount = static_cast<int>( g_depthFrames.size() );
+	context.depthPath = depthPath;
+	context.replayPath = replayPath;
+	context.tableLoaded = tablePath != nullptr;
+#ifdef _WIN32
+	context.saveSensorTable = saveTablePath != nullptr;
+#endif
+	std::cout << "frames : " << context.frameCount << " (" << ( depthPath ? depthPath : "synthetic" ) << "), iterations : " << iterations << std::endl;
+
+	// Jf
+	context.model.setDefault();
+	if( modelPath && !context.model.load( modelPath ) ){
+		std::cerr << "Error : CameraModel::load( " << modelPath << " )" << std::endl;
+		return -1;
+	}
+
+	// ʒu킹e[u̍쐬(N1x)
+	const double start = getTimeInSeconds();
+	if( tablePath ){
+		if( !context.table.load( tablePath ) ){
+			std::cerr << "Error : RegistrationTable::load( " << tablePath << " )" << std::endl;
+			return -1;
+		}
+	}
+	else{
+		context.table.build( context.model );
+	}
+	const double tableBuildMs = ( getTimeInSeconds() - start ) * 1000.0;
+
+	// ZNVɌv
+	BenchmarkSuite suite( iterations, repetitions );
+	g_suite = &suite;
+	if( selected[findSection( "registration" )] ){
+		printResult( "registration table build (once)", tableBuildMs );
+	}
+	for( int i = 0; i < BENCHMARK_SECTION_COUNT; i++ ){
+		if( selected[i] && !BENCHMARK_SECTIONS[i].run( context ) ){
+			std::cerr << "Error : section " << BENCHMARK_SECTIONS[i].name << " failed" << std::endl;
+			return -1;
+		}
+	}
+
+	// ZT[̖Ŏg߂Ƀe[uۑ
+	if( saveTablePath ){
+		if( !context.table.save( saveTablePath ) ){
+			std::cerr << "Error : RegistrationTable::save( " << saveTablePath << " )" << std::endl;
+			return -1;
+		}
+	}
+
+	if( saveBaselinePath ){
+		if( !suite.saveBaseline( saveBaselinePath ) ){
+			std::cerr << "Error : BenchmarkSuite::saveBaseline( " << saveBaselinePath << " )" << std::endl;
+			return -1;
+		}
+		std::cout << "baseline saved : " << saveBaselinePath << std::endl;
+	}
+
+	// lxȂJ[lΎsɂ
+	if( baselinePath ){
+		const int regressions = suite.compareBaseline( baselinePath, tolerance, std::cout );
+		if( regressions < 0 ){
+			std::cerr << "Error : BenchmarkSuite::compareBaseline( " << baselinePath << " )" << std::endl;
+			return -1;
+		}
+		if( regressions > 0 ){
+			std::cerr << "Error : " << regressions << " kernels are slower than the baseline" << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
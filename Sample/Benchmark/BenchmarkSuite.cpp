@@ -0,0 +1,163 @@
+// BenchmarkSuite.cpp : t[̏(J[l)̌vƁAۑl(JSON)Ƃ̔r
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "stdafx.h"
+#include "BenchmarkSuite.h"
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+
+BenchmarkSuite::BenchmarkSuite( int iterations, int repetitions )
+	: iterations( iterations > 0 ? iterations : 1 ), repetitions( repetitions > 0 ? repetitions : 1 )
+{
+}
+
+void BenchmarkSuite::printResult( const KernelResult& result, std::ostream& os )
+{
+	os << std::left << std::setw( 44 ) << result.name << " : "
+		<< std::right << std::fixed << std::setprecision( 0 ) << std::setw( 11 ) << result.nsPerFrame << " ns/frame";
+	if( result.cyclesPerFrame > 0.0 && result.bytesPerFrame > 0.0 ){
+		os << ", " << std::setprecision( 3 ) << std::setw( 7 ) << result.getBytesPerCycle() << " bytes/cycle";
+	}
+	os << std::endl;
+}
+
+// JSON̕Ƃďo(J[l̖Oɂ͐䕶gȂ)
+static std::string quote( const std::string& text )
+{
+	std::string quoted = "\"";
+	for( size_t i = 0; i < text.size(); i++ ){
+		if( text[i] == '"' || text[i] == '\\' ){
+			quoted += '\\';
+		}
+		quoted += text[i];
+	}
+	return quoted + "\"";
+}
+
+bool BenchmarkSuite::saveBaseline( const char* path ) const
+{
+	std::ofstream ofs( path );
+	if( !ofs ){
+		return false;
+	}
+	ofs << "{" << std::endl;
+	ofs << "  \"iterations\" : " << iterations << "," << std::endl;
+	ofs << "  \"kernels\" : [" << std::endl;
+	for( size_t i = 0; i < results.size(); i++ ){
+		const KernelResult& result = results[i];
+		ofs << "    { \"name\" : " << quote( result.name )
+			<< ", \"ns_per_frame\" : " << std::fixed << std::setprecision( 1 ) << result.nsPerFrame
+			<< ", \"bytes_per_frame\" : " << std::setprecision( 0 ) << result.bytesPerFrame
+			<< ", \"bytes_per_cycle\" : " << std::setprecision( 4 ) << result.getBytesPerCycle()
+			<< " }" << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+	}
+	ofs << "  ]" << std::endl;
+	ofs << "}" << std::endl;
+	return static_cast<bool>( ofs );
+}
+
+// l̃t@Cǂݍ
+// saveBaseline()ŏo`OɁAƐlɓǂ"name""ns_per_frame"̑gE
+// (ŕҏWċ󔒂sAL[̏ςĂǂ߂邪Aq̔zȂǂ̈ʂJSONɂ͑ΉȂ)
+bool BenchmarkSuite::loadBaseline( const char* path, std::vector<KernelResult>& baseline )
+{
+	std::ifstream ifs( path );
+	if( !ifs ){
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << ifs.rdbuf();
+	const std::string text = buffer.str();
+
+	baseline.clear();
+	std::string key;
+	bool hasKey = false;
+	bool isValue = false;
+	for( size_t i = 0; i < text.size(); i++ ){
+		const char c = text[i];
+		if( c == '"' ){
+			std::string value;
+			for( i++; i < text.size() && text[i] != '"'; i++ ){
+				if( text[i] == '\\' && i + 1 < text.size() ){
+					i++;
+				}
+				value += text[i];
+			}
+			if( isValue && hasKey && key == "name" ){
+				KernelResult result;
+				result.name = value;
+				result.nsPerFrame = 0.0;
+				result.bytesPerFrame = 0.0;
+				result.cyclesPerFrame = 0.0;
+				baseline.push_back( result );
+			}
+			key = value;
+			hasKey = !isValue;
+			isValue = false;
+		}
+		else if( c == ':' ){
+			isValue = true;
+		}
+		else if( c == ',' || c == '{' || c == '}' || c == '[' || c == ']' ){
+			hasKey = false;
+			isValue = false;
+		}
+		else if( isValue && ( c == '-' || ( c >= '0' && c <= '9' ) ) ){
+			char* end = nullptr;
+			const double value = std::strtod( text.c_str() + i, &end );
+			i = end - text.c_str() - 1;
+			if( hasKey && key == "ns_per_frame" && !baseline.empty() ){
+				baseline.back().nsPerFrame = value;
+			}
+			hasKey = false;
+			isValue = false;
+		}
+	}
+	return !baseline.empty();
+}
+
+int BenchmarkSuite::compareBaseline( const char* path, double tolerance, std::ostream& os ) const
+{
+	std::vector<KernelResult> baseline;
+	if( !loadBaseline( path, baseline ) ){
+		return -1;
+	}
+
+	int regressions = 0;
+	os << "baseline : " << path << " (tolerance " << std::fixed << std::setprecision( 0 ) << tolerance * 100.0 << " %)" << std::endl;
+	for( size_t i = 0; i < results.size(); i++ ){
+		const KernelResult& result = results[i];
+		os << "  " << std::left << std::setw( 44 ) << result.name << " : " << std::right;
+		const KernelResult* reference = nullptr;
+		for( size_t j = 0; j < baseline.size() && !reference; j++ ){
+			if( baseline[j].name == result.name ){
+				reference = &baseline[j];
+			}
+		}
+		if( !reference || reference->nsPerFrame <= 0.0 ){
+			os << "new (not in baseline)" << std::endl;
+			continue;
+		}
+		const double change = result.nsPerFrame / reference->nsPerFrame - 1.0;
+		const bool regressed = change > tolerance;
+		os << std::setprecision( 0 ) << std::setw( 11 ) << reference->nsPerFrame << " -> " << std::setw( 11 ) << result.nsPerFrame << " ns/frame ("
+			<< std::showpos << std::setprecision( 1 ) << change * 100.0 << std::noshowpos << " %)" << ( regressed ? "  SLOWER" : "" ) << std::endl;
+		if( regressed ){
+			regressions++;
+		}
+	}
+	for( size_t j = 0; j < baseline.size(); j++ ){
+		bool measured = false;
+		for( size_t i = 0; i < results.size() && !measured; i++ ){
+			measured = ( results[i].name == baseline[j].name );
+		}
+		if( !measured ){
+			os << "  " << std::left << std::setw( 44 ) << baseline[j].name << " : " << std::right << "not measured" << std::endl;
+		}
+	}
+	return regressions;
+}
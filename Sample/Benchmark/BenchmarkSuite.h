@@ -0,0 +1,99 @@
+// BenchmarkSuite.h : t[̏(J[l)̌vƁAۑl(JSON)Ƃ̔r
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Platform.h"
+
+
+// 1̃J[ľv
+struct KernelResult
+{
+	std::string name;
+	double nsPerFrame;     // 1t[̏[ns](vJԂōł)
+	double bytesPerFrame;  // 1t[œǂݏ摜̃oCg(Ɨp̃obt@)
+	double cyclesPerFrame; // 1t[̃^CX^vJE^̃TCN(擾łȂł0)
+
+	double getBytesPerCycle() const { return cyclesPerFrame > 0.0 ? bytesPerFrame / cyclesPerFrame : 0.0; }
+};
+
+// J[l𓯂ŌvAʂl̃t@CɕۑlƔׂ肷
+// l̃t@Č͎`JSON(namens_per_frameȊO͎Ql̒lŁArɂ͎gȂ)
+//   { "iterations" : 100, "kernels" : [ { "name" : "...", "ns_per_frame" : 123.4, "bytes_per_frame" : 614400, "bytes_per_cycle" : 1.23 }, ... ] }
+class BenchmarkSuite
+{
+public:
+	// iterations1̌vŏt[̐Arepetitions͌vJԂ
+	BenchmarkSuite( int iterations, int repetitions = 5 );
+
+	// func( frameIndex )vČʂ\
+	// ŏ1xEH[AbvƂČĂяoǍiterationšvrepetitionsJԂčłg
+	// (̃vZX̊荞݂ȂǂŒxȂ߁Aςł͂Ȃŏlg)
+	template<class Func>
+	const KernelResult& run( const std::string& name, size_t bytesPerFrame, Func func )
+	{
+		func( 0 );
+		double bestSeconds = 0.0;
+		uint64_t bestCycles = 0;
+		for( int r = 0; r < repetitions; r++ ){
+			const double start = getTimeInSeconds();
+			const uint64_t startCycles = readCycleCounter();
+			for( int i = 0; i < iterations; i++ ){
+				func( i );
+			}
+			const uint64_t cycles = readCycleCounter() - startCycles;
+			const double seconds = getTimeInSeconds() - start;
+			if( r == 0 || seconds < bestSeconds ){
+				bestSeconds = seconds;
+				bestCycles = cycles;
+			}
+		}
+
+		KernelResult result;
+		result.name = name;
+		result.nsPerFrame = bestSeconds * 1e9 / iterations;
+		result.bytesPerFrame = static_cast<double>( bytesPerFrame );
+		result.cyclesPerFrame = static_cast<double>( bestCycles ) / iterations;
+		results.push_back( result );
+		printResult( results.back(), std::cout );
+		return results.back();
+	}
+
+	// ̕@ŌvʂL^(\͂ȂAlƂ̔rɎg)
+	void record( const std::string& name, double msPerFrame )
+	{
+		KernelResult result;
+		result.name = name;
+		result.nsPerFrame = msPerFrame * 1e6;
+		result.bytesPerFrame = 0.0;
+		result.cyclesPerFrame = 0.0;
+		results.push_back( result );
+	}
+
+	int getIterations() const { return iterations; }
+	const std::vector<KernelResult>& getResults() const { return results; }
+
+	// vʂl̃t@Cɕۑ
+	bool saveBaseline( const char* path ) const;
+
+	// l̃t@CƔׂĕ\
+	// tolerance͋ex̊(0.1Ȃl10%xƂ܂)
+	// e͈͂xȂJ[l̐Ԃ(l̃t@Cǂݍ߂ȂƂ-1)
+	// lɖJ[lAvȂJ[l͕\ĐȂ
+	int compareBaseline( const char* path, double tolerance, std::ostream& os ) const;
+
+	static void printResult( const KernelResult& result, std::ostream& os );
+
+private:
+	static bool loadBaseline( const char* path, std::vector<KernelResult>& baseline );
+
+	int iterations;
+	int repetitions;
+	std::vector<KernelResult> results;
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+// SDKDDKVer.h CN[hƁApłłʂ Windows vbgtH[`܂B
+
+// ȑO Windows vbgtH[pɃAvP[Vrhꍇ́AWinSDKVer.h CN[hA
+// SDKDDKVer.h CN[hOɁAT|[gΏۂƂvbgtH[悤 _WIN32_WINNT }Nݒ肵܂B
+
+#include <SDKDDKVer.h>
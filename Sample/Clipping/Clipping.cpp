@@ -4,143 +4,252 @@
 
 #include "stdafx.h"
 #include <Windows.h>
+#include <sstream>
+#include <iomanip>
 #include <NuiApi.h>
 #include <opencv2/opencv.hpp>
+#include "NuiFrameSource.h"
+#include "FrameProcessor.h"
+#include "PlayerLabeler.h"
+#include "Compositor.h"
+#include "StagePipeline.h"
 
 
 int _tmain(int argc, _TCHAR* argv[])
 {
 	cv::setUseOptimized( true );
 
-	// Kinect̃CX^XA
-	INuiSensor* pSensor;
-	HRESULT hResult = S_OK;
-	hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	// t[\[X̍쐬
+	// Kinectg("-replay <file>"w肵Ƃ͋L^t@CĐA"-synthetic <l>"w肵Ƃ͍V[𐶐A"-record <file>"w肵Ƃ͋L^)
+	// ʒu킹e[u쐬(t[ɑSfNuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()ĂяoɁAN1x쐬)
+	std::unique_ptr<FrameSource> frameSource;
+	RegistrationTable registrationTable;
+	HRESULT hResult = createFrameSource( argc, argv, FRAME_STREAM_FLAG_COLOR | FRAME_STREAM_FLAG_DEPTH | NUI_FRAME_SOURCE_PLAYER_STATS, frameSource, &registrationTable );
 	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		std::cerr << "Error : createFrameSource" << std::endl;
 		return -1;
 	}
 
-	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiInitialize" << std::endl;
-		return -1;
-	}
+	// l̐؂蔲(ʒu킹A}XNAopening/closingA؂蔲)
+	// Depth̏͘_vZbT̐̃XbhŕS(Batchg)
+	ThreadPool threadPool;
+	ClippingProcessor clippingProcessor( registrationTable, &threadPool );
 
-	// ColorXg[
-	HANDLE hColorEvent = INVALID_HANDLE_VALUE;
-	HANDLE hColorHandle = INVALID_HANDLE_VALUE;
-	hColorEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hColorEvent, &hColorHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( COLOR )" << std::endl;
-		return -1;
-	}
+	// "-record"̂Ƃ́AfR[ĥƂɈꏏɋ߂Player̓vL^t@Cɏ(Depth̃t[ǂݒɋ߂)
+	RecordingFrameSource* recording = dynamic_cast<RecordingFrameSource*>( frameSource.get() );
+	clippingProcessor.setPlayerStats( recording != nullptr );
 
-	// Depth&PlayerXg[
-	HANDLE hDepthPlayerEvent = INVALID_HANDLE_VALUE;
-	HANDLE hDepthPlayerHandle = INVALID_HANDLE_VALUE;
-	hDepthPlayerEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hDepthPlayerEvent, &hDepthPlayerHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( DEPTH&PLAYER )" << std::endl;
-		return -1;
+	// Player̘A(ꂽ𕪂Aȉ)͈̔́AdSA1x̑ŋ߂
+	// "-overlay"w肵ƂA؂蔲摜̕ɕ`ĕ\
+	PlayerLabeler playerLabeler( 640, 480, &threadPool );
+	bool overlay = false;
+	for( int i = 1; i < argc; i++ ){
+		if( _tcscmp( argv[i], _T( "-overlay" ) ) == 0 ){
+			overlay = true;
+		}
 	}
 
-	HANDLE hEvents[2] = { hColorEvent, hDepthPlayerEvent };
+	// wi̒u(EڂĐlwiɏd˂)
+	// "-background <file>"w肵Ƃ͉摜܂͓(Ō܂ōĐŏɖ߂)wiɂAw肵ȂƂ͊DFɂ
+	BackgroundCompositor compositor( 640, 480 );
+	cv::Mat backgroundMat( 480, 640, CV_8UC4, cv::Scalar( 128, 128, 128, 255 ) );
+	cv::VideoCapture backgroundVideo;
+	for( int i = 1; i + 1 < argc; i++ ){
+		if( _tcscmp( argv[i], _T( "-background" ) ) == 0 ){
+			const std::string backgroundPath = toMultiByteString( argv[i + 1] );
+			cv::Mat imageMat = cv::imread( backgroundPath );
+			if( imageMat.empty() ){
+				if( !backgroundVideo.open( backgroundPath ) || !backgroundVideo.read( imageMat ) ){
+					std::cerr << "Error : background" << std::endl;
+					return -1;
+				}
+			}
+			cv::resize( imageMat, imageMat, cv::Size( 640, 480 ) );
+			cv::cvtColor( imageMat, backgroundMat, CV_BGR2BGRA );
+		}
+	}
 
 	cv::namedWindow( "Mask" );
 	cv::namedWindow( "Clip" );
+	cv::namedWindow( "Composite" );
 
 	// gbNo[̐
+	// kƖc̎Ԃ͉񐔂ɂ炸قڈȂ̂ŁA傫ȉ񐔂Iׂ悤ɂ
+	// octagon1ɂƍ\vf𔪊p`(`Ə\)ɂ
+	// incremental1ɂƑÕt[ς^C(l0)
+	// ʒu킹ƃfR[h͖t[ŜōsAPlayer͈̔͂̕@葬Ȃ͕̂ς^C1%x̂Ƃ
 	int iterationErode = 2;
 	int iterationDilate = 2;
-	cv::createTrackbar( "erode", "Mask", &iterationErode, 10 );
-	cv::createTrackbar( "dilate", "Mask", &iterationDilate, 10 );
-
-	while( 1 ){
-		// t[̍XV҂
-		ResetEvent( hColorEvent );
-		ResetEvent( hDepthPlayerEvent );
-		WaitForMultipleObjects( ARRAYSIZE( hEvents ), hEvents, true, INFINITE );
-
-		// ColorJt[擾
-		NUI_IMAGE_FRAME pColorImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hColorHandle, 0, &pColorImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( COLOR )" << std::endl;
-			return -1;
+	int octagon = 0;
+	int incremental = 0;
+	int feather = BackgroundCompositor::DEFAULT_FEATHER_RADIUS;
+	cv::createTrackbar( "erode", "Mask", &iterationErode, 15 );
+	cv::createTrackbar( "dilate", "Mask", &iterationDilate, 15 );
+	cv::createTrackbar( "octagon", "Mask", &octagon, 1 );
+	cv::createTrackbar( "incremental", "Mask", &incremental, 1 );
+	cv::createTrackbar( "feather", "Composite", &feather, BackgroundCompositor::MAX_FEATHER_RADIUS );
+
+	// gbNo[̒lwaitKey()Ăяo\̃Xbhŏ̂ŁA̒i͒ړǂ܂Ȃ
+	// \̒iatomicStore()ŏ݁A̒ił̓t[1xatomicLoad()œǂŁA1t[̊Ԃ͓lg
+	struct ClipSettings
+	{
+		volatile long erode;
+		volatile long dilate;
+		volatile long octagon;
+		volatile long incremental;
+		volatile long feather;
+	};
+	ClipSettings settings = { iterationErode, iterationDilate, octagon, incremental, feather };
+
+	// t[̎擾AA\ꂼ̃Xbhŕsčs
+	// i̊Ԃ̃L[1t[ŁAt̂Ƃ͌Ât[̂Ă(xi͏ɍŐṼt[)
+	// Wủ摜͋NɊmۂĎg(3i + L[2̕)
+	struct ClipJob
+	{
+		int64_t timestamp;     // Depth̃^CX^v[ms](x̋L^Ɏg)
+		uint32_t frameNumber;  // Depth̃t[ԍ(g[X̃Cxgɕt)
+		cv::Mat colorMat;
+		cv::Mat depthMat;
+		cv::Mat registeredMat; // ʒu킹Depth&Player
+		cv::Mat maskMat;
+		cv::Mat clipMat;       // ClippingProcessoȑo(incremental̂Ƃ͎̃t[ŏ^CXV̂ŁAȂ)
+		cv::Mat displayMat;    // ؂蔲摜ɕ`ŕ\摜("-overlay"̂Ƃ)
+		cv::Mat compositeMat;  // wiu摜
+	};
+	StagePipeline pipeline( 5 );
+	std::vector<ClipJob> jobs( pipeline.getJobCount() );
+	for( size_t i = 0; i < jobs.size(); i++ ){
+		jobs[i].colorMat.create( 480, 640, CV_8UC4 );
+		jobs[i].depthMat.create( 480, 640, CV_16UC1 );
+		jobs[i].registeredMat.create( 480, 640, CV_16UC1 );
+		jobs[i].maskMat.create( 480, 640, CV_8UC1 );
+		jobs[i].clipMat.create( 480, 640, CV_8UC4 );
+		if( overlay ){
+			jobs[i].displayMat.create( 480, 640, CV_8UC4 );
 		}
+		jobs[i].compositeMat.create( 480, 640, CV_8UC4 );
+	}
 
-		// DepthZT[t[擾
-		NUI_IMAGE_FRAME pDepthPlayerImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hDepthPlayerHandle, 0, &pDepthPlayerImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( DEPTH&PLAYER )" << std::endl;
-			return -1;
+	pipeline.addStage( "capture", [&]( int job ) -> bool {
+		// t[̎擾(^CX^vg҂AĐII)
+		FrameSet frames;
+		if( !frameSource->read( frames ) ){
+			return false;
 		}
+		jobs[job].timestamp = frames.depth.info.timestamp;
+		jobs[job].frameNumber = frames.depth.info.frameNumber;
+		setTraceFrame( frames.depth.info.frameNumber );
+
+		// ̃t[擾g悤ɁAWủ摜փRs[
+		std::memcpy( jobs[job].colorMat.data, frames.color.data, 640 * 480 * 4 );
+		std::memcpy( jobs[job].depthMat.data, frames.depth.data, 640 * 480 * sizeof( ushort ) );
+		return true;
+	} );
 
-		// Color摜f[^̎擾
-		INuiFrameTexture* pColorFrameTexture = pColorImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sColorLockedRect;
-		pColorFrameTexture->LockRect( 0, &sColorLockedRect, nullptr, 0 );
-
-		// Depthf[^̎擾
-		INuiFrameTexture* pDepthPlayerFrameTexture = pDepthPlayerImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sDepthPlayerLockedRect;
-		pDepthPlayerFrameTexture->LockRect( 0, &sDepthPlayerLockedRect, nullptr, 0 );
-
-		// 摜̎擾
-		cv::Mat colorMat( 480, 640, CV_8UC4, reinterpret_cast<uchar*>( sColorLockedRect.pBits ) );
-		LONG registX = 0;
-		LONG registY = 0;
-		ushort* pBuffer = reinterpret_cast<ushort*>( sDepthPlayerLockedRect.pBits );
-		cv::Mat maskMat = cv::Mat::zeros( 480, 640, CV_8UC1 );
-		for( int y = 0; y < 480; y++ ){
-			for( int x = 0; x < 640; x++ ){
-				pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480, nullptr, x, y, *pBuffer, &registX, &registY );
-				if( ( registX >= 0 ) && ( registX < 640 ) && ( registY >= 0 ) && ( registY < 480 ) ){
-					if( ( *pBuffer & 0x7 ) != 0 ){
-						maskMat.at<uchar>( registY, registX ) = 0xff; // 255
-					}
+	pipeline.addStage( "process", [&]( int job ) -> bool {
+		setTraceFrame( jobs[job].frameNumber );
+
+		// \̒inꂽgbNo[̒l(1t[̊Ԃ͓lg)
+		ClipJob& clipJob = jobs[job];
+		const int erode = atomicLoad( &settings.erode );
+		const int dilate = atomicLoad( &settings.dilate );
+		const bool octagonShape = atomicLoad( &settings.octagon ) != 0;
+		const bool incrementalUpdate = atomicLoad( &settings.incremental ) != 0;
+		const int featherRadius = atomicLoad( &settings.feather );
+		clippingProcessor.setIterations( erode, dilate );
+		clippingProcessor.setShape( octagonShape ? MORPHOLOGY_OCTAGON : MORPHOLOGY_RECT );
+		clippingProcessor.setIncremental( incrementalUpdate );
+		clippingProcessor.process( reinterpret_cast<ushort*>( clipJob.depthMat.data ), clipJob.colorMat.data, clipJob.maskMat.data, clipJob.clipMat.data, reinterpret_cast<ushort*>( clipJob.registeredMat.data ) );
+		if( recording ){
+			const FrameInfo info = { clipJob.frameNumber, clipJob.timestamp, PIXEL_FORMAT_DEPTH16, 640, 480 };
+			recording->writePlayerStats( info, clippingProcessor.getPlayerStats() );
+		}
+
+		// wi̒u(̂Ƃ͏t[ɔwii߂)
+		if( backgroundVideo.isOpened() ){
+			cv::Mat frameMat;
+			if( !backgroundVideo.read( frameMat ) ){
+				backgroundVideo.set( CV_CAP_PROP_POS_FRAMES, 0 );
+				backgroundVideo.read( frameMat );
+			}
+			if( !frameMat.empty() ){
+				cv::resize( frameMat, frameMat, cv::Size( 640, 480 ) );
+				cv::cvtColor( frameMat, backgroundMat, CV_BGR2BGRA );
+			}
+		}
+		compositor.setFeatherRadius( featherRadius );
+		compositor.process( clipJob.colorMat.data, clipJob.maskMat.data, backgroundMat.data, clipJob.compositeMat.data );
+
+		// "-overlay"̂Ƃ́A؂蔲摜̕ɁAPlayer͈̉̔͂ƁAPlayeȑdSƋ`
+		if( overlay ){
+			clipJob.clipMat.copyTo( clipJob.displayMat );
+			playerLabeler.process( reinterpret_cast<ushort*>( clipJob.registeredMat.data ), PlayerLabelOutput() );
+			const std::vector<PlayerComponent>& components = playerLabeler.getComponents();
+			for( size_t i = 0; i < components.size(); i++ ){
+				if( !components[i].removed ){
+					const MaskRect& bounds = components[i].bounds;
+					cv::rectangle( clipJob.displayMat, cv::Point( bounds.left, bounds.top ), cv::Point( bounds.right - 1, bounds.bottom - 1 ), cv::Scalar( 0, 255, 0 ), 1 );
+				}
+			}
+			for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+				const PlayerSegment& segment = playerLabeler.getSegment( player );
+				if( segment.area == 0 ){
+					continue;
 				}
-				pBuffer++;
+				const cv::Point centroid( static_cast<int>( segment.centroidX ), static_cast<int>( segment.centroidY ) );
+				std::ostringstream stream;
+				stream << "Player " << player << " : " << std::fixed << std::setprecision( 2 ) << segment.meanDepth / 1000.0f << "m";
+				cv::circle( clipJob.displayMat, centroid, 5, cv::Scalar( 0, 255, 0 ), -1, CV_AA );
+				cv::putText( clipJob.displayMat, stream.str(), centroid + cv::Point( 8, 0 ), cv::FONT_HERSHEY_SIMPLEX, 0.5f, cv::Scalar( 0, 255, 0 ), 1, CV_AA );
 			}
 		}
+		return true;
+	}, 1, QUEUE_DROP_OLDEST );
+
+	// \̓EBhẼXbhōs
+	pipeline.addStage( "present", [&]( int job ) -> bool {
+		setTraceFrame( jobs[job].frameNumber );
+
+		// \(EBhE̍XVwaitKey()ōŝŁA܂ł`̎Ԃɂ)
+		// [v̏I(EscL[)Ag[X̏o(tL[)
+		// \̊Ԋu̓t[̎擾Ō܂̂ŁAL[͂͑҂Ȃ
+		int key;
+		{
+			ScopedMetric metric( METRIC_DRAW );
+			cv::imshow( "Mask", jobs[job].maskMat );
+			cv::imshow( "Clip", overlay ? jobs[job].displayMat : jobs[job].clipMat );
+			cv::imshow( "Composite", jobs[job].compositeMat );
+			key = cv::waitKey( 1 );
+		}
+		recordFrameLatency( jobs[job].timestamp );
+		if( key == 't' ){
+			writeTrace();
+		}
+
+		// waitKey()̒ŕςgbNo[̒l̒i֓n
+		atomicStore( &settings.erode, iterationErode );
+		atomicStore( &settings.dilate, iterationDilate );
+		atomicStore( &settings.octagon, octagon );
+		atomicStore( &settings.incremental, incremental );
+		atomicStore( &settings.feather, feather );
+		return key != VK_ESCAPE;
+	}, 1, QUEUE_DROP_OLDEST );
+
+	pipeline.run();
+
+	// ĩt[[gƃL[̏
+	pipeline.printStatistics( std::cout );
 
-		// 
-		// Mathematical Morphology - opening
-		cv::erode( maskMat, maskMat, cv::Mat(), cv::Point( -1, -1 ), iterationErode );
-		cv::dilate( maskMat, maskMat, cv::Mat(), cv::Point( -1, -1 ), iterationDilate );
-
-		// Mathematical Morphology - cpening
-		cv::dilate( maskMat, maskMat, cv::Mat(), cv::Point( -1, -1 ), iterationDilate );
-		cv::erode( maskMat, maskMat, cv::Mat(), cv::Point( -1, -1 ), iterationErode );
-		
-		cv::Mat clipMat = cv::Mat::zeros( 480, 640, CV_8UC4 );
-		colorMat.copyTo( clipMat, maskMat );
-
-		cv::imshow( "Mask", maskMat );
-		cv::imshow( "Clip", clipMat );
-
-		// t[̉
-		pColorFrameTexture->UnlockRect( 0 );
-		pDepthPlayerFrameTexture->UnlockRect( 0 );
-		pSensor->NuiImageStreamReleaseFrame( hColorHandle, &pColorImageFrame );
-		pSensor->NuiImageStreamReleaseFrame( hDepthPlayerHandle, &pDepthPlayerImageFrame );
-
-		// [v̏I(EscL[)
-		if( cv::waitKey( 30 ) == VK_ESCAPE ){
-			break;
+	// t[̐
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( frameSource->getStreams() & ( 1 << i ) ){
+			const FrameDropCounter& dropCounter = frameSource->getDropCounter( static_cast<FrameStream>( i ) );
+			std::cout << getFrameStreamName( static_cast<FrameStream>( i ) ) << " : " << dropCounter.getDropped() << " frames dropped / " << dropCounter.getReceived() << " frames received" << std::endl;
 		}
 	}
 
-	// Kinect̏I
-	pSensor->NuiShutdown();
-	CloseHandle( hColorEvent );
-	CloseHandle( hDepthPlayerEvent );
-	CloseHandle( hColorHandle );
-	CloseHandle( hDepthPlayerHandle );
+	// t[\[X̏I(Kinect̏I)
+	frameSource.reset();
 
 	cv::destroyAllWindows();
 
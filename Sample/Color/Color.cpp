@@ -6,77 +6,69 @@
 #include <Windows.h>
 #include <NuiApi.h>
 #include <opencv2/opencv.hpp>
+#include "NuiFrameSource.h"
 
 
 int _tmain(int argc, _TCHAR* argv[])
 {
 	cv::setUseOptimized( true );
 
-	// Kinect̃CX^XA
-	INuiSensor* pSensor;
-	HRESULT hResult = S_OK;
-	hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	// t[\[X̍쐬
+	// Kinectg("-replay <file>"w肵Ƃ͋L^t@CĐA"-synthetic <l>"w肵Ƃ͍V[𐶐A"-record <file>"w肵Ƃ͋L^)
+	std::unique_ptr<FrameSource> frameSource;
+	HRESULT hResult = createFrameSource( argc, argv, FRAME_STREAM_FLAG_COLOR, frameSource );
 	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		std::cerr << "Error : createFrameSource" << std::endl;
 		return -1;
 	}
 
-	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiInitialize" << std::endl;
-		return -1;
-	}
-
-	// ColorXg[̊Jn
-	HANDLE hColorEvent = INVALID_HANDLE_VALUE;
-	HANDLE hColorHandle = INVALID_HANDLE_VALUE;
-	hColorEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hColorEvent, &hColorHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( COLOR )" << std::endl;
-		return -1;
-	}
-
-	HANDLE hEvents[1] = { hColorEvent };
-
 	cv::namedWindow( "Color" );
 
 	while( 1 ){
-		// t[̍XV҂
-		ResetEvent( hColorEvent );
-		WaitForMultipleObjects( ARRAYSIZE( hEvents ), hEvents, true, INFINITE );
-
-		// ColorJt[擾
-		NUI_IMAGE_FRAME pColorImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hColorHandle, 0, &pColorImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( COLOR )" << std::endl;
-			return -1;
+		// t[̎擾(SẴXg[̃t[܂ő҂AĐII)
+		FrameSet frames;
+		bool read;
+		{
+			TraceScope trace( "read" );
+			read = frameSource->read( frames );
 		}
-
-		// Color摜f[^̎擾
-		INuiFrameTexture* pColorFrameTexture = pColorImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sColorLockedRect;
-		pColorFrameTexture->LockRect( 0, &sColorLockedRect, nullptr, 0 );
+		if( !read ){
+			break;
+		}
+		setTraceFrame( frames.color.info.frameNumber );
 
 		// \
-		cv::Mat colorMat( 480, 640, CV_8UC4, reinterpret_cast<uchar*>( sColorLockedRect.pBits ) );
-		cv::imshow( "Color", colorMat );
+		cv::Mat colorMat( 480, 640, CV_8UC4, frames.color.data );
+		{
+			ScopedMetric metric( METRIC_DRAW );
+			cv::imshow( "Color", colorMat );
+		}
+		recordFrameLatency( frames.color.info.timestamp );
 		
-		// t[̉
-		pColorFrameTexture->UnlockRect( 0 );
-		pSensor->NuiImageStreamReleaseFrame( hColorHandle, &pColorImageFrame );
-
-		// [v̏I(EscL[)
-		if( cv::waitKey( 30 ) == VK_ESCAPE ){
+		// [v̏I(EscL[)Ag[X̏o(tL[)
+		int key;
+		{
+			TraceScope trace( "wait" );
+			key = cv::waitKey( 30 );
+		}
+		if( key == 't' ){
+			writeTrace();
+		}
+		if( key == VK_ESCAPE ){
 			break;
 		}
 	}
 
-	// Kinect̏I
-	pSensor->NuiShutdown();
-	CloseHandle( hColorEvent );
-	CloseHandle( hColorHandle );
+	// t[̐
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( frameSource->getStreams() & ( 1 << i ) ){
+			const FrameDropCounter& dropCounter = frameSource->getDropCounter( static_cast<FrameStream>( i ) );
+			std::cout << getFrameStreamName( static_cast<FrameStream>( i ) ) << " : " << dropCounter.getDropped() << " frames dropped / " << dropCounter.getReceived() << " frames received" << std::endl;
+		}
+	}
+
+	// t[\[X̏I(Kinect̏I)
+	frameSource.reset();
 
 	cv::destroyAllWindows();
 
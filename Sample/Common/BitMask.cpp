@@ -0,0 +1,385 @@
+// BitMask.cpp : 1f1rbgŕ\2l̃}XN摜
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "BitMask.h"
+#include <algorithm>
+#include <cstring>
+
+
+// 1̃rbg̐(rbg̉ZAPOPCNT߂̖CPUłg)
+static inline int countBits( uint64_t value )
+{
+	value = value - ( ( value >> 1 ) & 0x5555555555555555ULL );
+	value = ( value & 0x3333333333333333ULL ) + ( ( value >> 2 ) & 0x3333333333333333ULL );
+	value = ( value + ( value >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<int>( ( value * 0x0101010101010101ULL ) >> 56 );
+}
+
+// łʂƍłʂ1̃rbg̈ʒu(value0ȊO)
+static inline int findLowestBit( uint64_t value )
+{
+	return countBits( ( value & ( 0 - value ) ) - 1 );
+}
+
+static inline int findHighestBit( uint64_t value )
+{
+	value |= value >> 1;
+	value |= value >> 2;
+	value |= value >> 4;
+	value |= value >> 8;
+	value |= value >> 16;
+	value |= value >> 32;
+	return countBits( value ) - 1;
+}
+
+// s̃rbgshiftf炵or
+// row[x] |= row[x + shift](Ẻf)Arow[x] |= row[x - shift](̉fE)As̊O0
+static void orShiftedLeft( uint64_t* row, int count, int shift )
+{
+	const int wordShift = shift >> 6;
+	const int bitShift = shift & 63;
+	for( int i = 0; i + wordShift < count; i++ ){
+		uint64_t value = row[i + wordShift] >> bitShift;
+		if( bitShift && ( i + wordShift + 1 < count ) ){
+			value |= row[i + wordShift + 1] << ( 64 - bitShift );
+		}
+		row[i] |= value;
+	}
+}
+
+static void orShiftedRight( uint64_t* row, int count, int shift )
+{
+	const int wordShift = shift >> 6;
+	const int bitShift = shift & 63;
+	for( int i = count - 1; i - wordShift >= 0; i-- ){
+		uint64_t value = row[i - wordShift] << bitShift;
+		if( bitShift && ( i - wordShift - 1 >= 0 ) ){
+			value |= row[i - wordShift - 1] >> ( 64 - bitShift );
+		}
+		row[i] |= value;
+	}
+}
+
+#ifdef KINECT_SIMD_X86
+
+// SSE4.1(g߂SSE2͈̔)
+// 16f0ƔׁApmovmskb16rbgɂ܂Ƃ߂
+KINECT_TARGET_SSE41
+static void packRowSse41( const uint8_t* src, uint64_t* dst, int width )
+{
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+	for( ; x + 64 <= width; x += 64 ){
+		uint64_t word = 0;
+		for( int i = 0; i < 4; i++ ){
+			const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + x + i * 16 ) );
+			const uint64_t bits = static_cast<uint16_t>( ~_mm_movemask_epi8( _mm_cmpeq_epi8( value, zero ) ) );
+			word |= bits << ( i * 16 );
+		}
+		dst[x >> 6] = word;
+	}
+	if( x < width ){
+		uint64_t word = 0;
+		for( int i = 0; x + i < width; i++ ){
+			if( src[x + i] ){
+				word |= 1ULL << i;
+			}
+		}
+		dst[x >> 6] = word;
+	}
+}
+
+// 16rbg16oCgɍL(rbgi1ȂiԖڂ̃oCgvalueɂ)
+KINECT_TARGET_SSE41
+static void unpackRowSse41( const uint64_t* src, uint8_t* dst, int width, uint8_t value )
+{
+	const __m128i select = _mm_set_epi8( -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1 );
+	const __m128i fill = _mm_set1_epi8( static_cast<char>( value ) );
+	int x = 0;
+	for( ; x + 16 <= width; x += 16 ){
+		const uint32_t bits = static_cast<uint32_t>( src[x >> 6] >> ( x & 63 ) ) & 0xFFFF;
+		const uint32_t low = ( bits & 0xFF ) * 0x01010101u;
+		const uint32_t high = ( bits >> 8 ) * 0x01010101u;
+		const __m128i spread = _mm_set_epi32( high, high, low, low );
+		const __m128i set = _mm_cmpeq_epi8( _mm_and_si128( spread, select ), select );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x ), _mm_and_si128( set, fill ) );
+	}
+	for( ; x < width; x++ ){
+		dst[x] = ( ( src[x >> 6] >> ( x & 63 ) ) & 1 ) ? value : 0;
+	}
+}
+
+// 4rbgBGRX4f̃}XNɍLăRs[
+// }XN̑̓[h(64f)Ŝ01Ȃ̂ŁÂƂ͂܂Ƃ߂0ɂ邩Rs[
+KINECT_TARGET_SSE41
+static void copyRowSse41( const uint32_t* src, const uint64_t* mask, uint32_t* dst, int width )
+{
+	const __m128i select = _mm_set_epi32( 8, 4, 2, 1 );
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+	for( ; x + 64 <= width; x += 64 ){
+		const uint64_t word = mask[x >> 6];
+		if( word == 0 ){
+			for( int i = 0; i < 64; i += 4 ){
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x + i ), zero );
+			}
+			continue;
+		}
+		if( word == ~0ULL ){
+			std::memcpy( dst + x, src + x, sizeof( uint32_t ) * 64 );
+			continue;
+		}
+		for( int i = 0; i < 64; i += 4 ){
+			const __m128i bits = _mm_set1_epi32( static_cast<int>( ( word >> i ) & 0xF ) );
+			const __m128i lanes = _mm_cmpeq_epi32( _mm_and_si128( bits, select ), select );
+			const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + x + i ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x + i ), _mm_and_si128( pixels, lanes ) );
+		}
+	}
+	for( ; x < width; x++ ){
+		dst[x] = ( ( mask[x >> 6] >> ( x & 63 ) ) & 1 ) ? src[x] : 0;
+	}
+}
+
+#endif
+
+
+BitMask::BitMask()
+	: width( 0 ), height( 0 ), wordsPerRow( 0 ), lastWordMask( 0 ), simdLevel( getSimdLevel() )
+{
+}
+
+BitMask::BitMask( int width, int height )
+	: width( 0 ), height( 0 ), wordsPerRow( 0 ), lastWordMask( 0 ), simdLevel( getSimdLevel() )
+{
+	create( width, height );
+}
+
+void BitMask::create( int width, int height )
+{
+	this->width = width;
+	this->height = height;
+	wordsPerRow = ( width + 63 ) / 64;
+	lastWordMask = ( width % 64 ) ? ( 1ULL << ( width % 64 ) ) - 1 : ~0ULL;
+	words.assign( static_cast<size_t>( wordsPerRow ) * height, 0 );
+}
+
+void BitMask::clear()
+{
+	std::fill( words.begin(), words.end(), 0 );
+}
+
+void BitMask::pack( const uint8_t* src, int stride )
+{
+	for( int y = 0; y < height; y++ ){
+		const uint8_t* srcRow = src + y * stride;
+		uint64_t* dstRow = getRow( y );
+#ifdef KINECT_SIMD_X86
+		if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+			packRowSse41( srcRow, dstRow, width );
+			continue;
+		}
+#endif
+		std::memset( dstRow, 0, sizeof( uint64_t ) * wordsPerRow );
+		for( int x = 0; x < width; x++ ){
+			if( srcRow[x] ){
+				dstRow[x >> 6] |= 1ULL << ( x & 63 );
+			}
+		}
+	}
+}
+
+void BitMask::unpack( uint8_t* dst, int stride, uint8_t value ) const
+{
+	for( int y = 0; y < height; y++ ){
+		const uint64_t* srcRow = getRow( y );
+		uint8_t* dstRow = dst + y * stride;
+#ifdef KINECT_SIMD_X86
+		if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+			unpackRowSse41( srcRow, dstRow, width, value );
+			continue;
+		}
+#endif
+		for( int x = 0; x < width; x++ ){
+			dstRow[x] = ( ( srcRow[x >> 6] >> ( x & 63 ) ) & 1 ) ? value : 0;
+		}
+	}
+}
+
+void BitMask::erode( int iterations, MorphologyShape shape )
+{
+	// 摜̊O1ƂḱA]ĊO0ƂcƓ
+	if( iterations > 0 ){
+		invert();
+		dilate( iterations, shape );
+		invert();
+	}
+}
+
+void BitMask::dilate( int iterations, MorphologyShape shape )
+{
+	if( iterations <= 0 ){
+		return;
+	}
+
+	// p`͋`ceil( iterations / 2 )A\floor( iterations / 2 )(MorphologyFilterƓ)
+	const int rectRadius = ( shape == MORPHOLOGY_OCTAGON ) ? ( iterations + 1 ) / 2 : iterations;
+	dilateRect( rectRadius );
+	for( int i = rectRadius; i < iterations; i++ ){
+		dilateCross();
+	}
+}
+
+void BitMask::dilateRect( int radius )
+{
+	// E͈̔[x, x + radius]ƍ͈̔[x - radius, x]ꂼꕝ{ɂȂ狁߂or
+	// Б͈̔͂ȂA摜̊O͈̔͂͋Ȃ̂0ƂĈ
+	scratch.resize( words.size() );
+	const int length = radius + 1;
+
+	// 
+	for( int y = 0; y < height; y++ ){
+		uint64_t* row = getRow( y );
+		uint64_t* left = &scratch[y * wordsPerRow];
+		std::memcpy( left, row, sizeof( uint64_t ) * wordsPerRow );
+		for( int covered = 1; covered < length; ){
+			const int shift = ( std::min )( covered, length - covered );
+			orShiftedLeft( row, wordsPerRow, shift );
+			orShiftedRight( left, wordsPerRow, shift );
+			covered += shift;
+		}
+		for( int i = 0; i < wordsPerRow; i++ ){
+			row[i] |= left[i];
+		}
+		row[wordsPerRow - 1] &= lastWordMask;
+	}
+
+	// c(s[ĥ܂܁A̍sƉ̍sor)
+	std::memcpy( &scratch[0], &words[0], sizeof( uint64_t ) * words.size() );
+	for( int covered = 1; covered < length; ){
+		const int shift = ( std::min )( covered, length - covered );
+		for( int y = 0; y + shift < height; y++ ){
+			uint64_t* row = getRow( y );
+			const uint64_t* below = getRow( y + shift );
+			for( int i = 0; i < wordsPerRow; i++ ){
+				row[i] |= below[i];
+			}
+		}
+		for( int y = height - 1; y - shift >= 0; y-- ){
+			uint64_t* row = &scratch[y * wordsPerRow];
+			const uint64_t* above = &scratch[( y - shift ) * wordsPerRow];
+			for( int i = 0; i < wordsPerRow; i++ ){
+				row[i] |= above[i];
+			}
+		}
+		covered += shift;
+	}
+	for( size_t i = 0; i < words.size(); i++ ){
+		words[i] |= scratch[i];
+	}
+}
+
+void BitMask::dilateCross()
+{
+	scratch = words;
+	for( int y = 0; y < height; y++ ){
+		uint64_t* row = getRow( y );
+		orShiftedLeft( row, wordsPerRow, 1 );
+		orShiftedRight( row, wordsPerRow, 1 );
+		row[wordsPerRow - 1] &= lastWordMask;
+		if( y > 0 ){
+			const uint64_t* above = &scratch[( y - 1 ) * wordsPerRow];
+			for( int i = 0; i < wordsPerRow; i++ ){
+				row[i] |= above[i];
+			}
+		}
+		if( y + 1 < height ){
+			const uint64_t* below = &scratch[( y + 1 ) * wordsPerRow];
+			for( int i = 0; i < wordsPerRow; i++ ){
+				row[i] |= below[i];
+			}
+		}
+	}
+}
+
+void BitMask::invert()
+{
+	for( int y = 0; y < height; y++ ){
+		uint64_t* row = getRow( y );
+		for( int i = 0; i < wordsPerRow; i++ ){
+			row[i] = ~row[i];
+		}
+		row[wordsPerRow - 1] &= lastWordMask;
+	}
+}
+
+int BitMask::getArea() const
+{
+	int area = 0;
+	for( size_t i = 0; i < words.size(); i++ ){
+		area += countBits( words[i] );
+	}
+	return area;
+}
+
+MaskRect BitMask::getBoundingBox() const
+{
+	// s1̃rbg邩𒲂ׁASĂ̍sor[h獶E̒[߂
+	MaskRect rect;
+	std::vector<uint64_t> columns( wordsPerRow, 0 );
+	int top = -1;
+	int bottom = -1;
+	for( int y = 0; y < height; y++ ){
+		const uint64_t* row = getRow( y );
+		uint64_t any = 0;
+		for( int i = 0; i < wordsPerRow; i++ ){
+			columns[i] |= row[i];
+			any |= row[i];
+		}
+		if( any ){
+			if( top < 0 ){
+				top = y;
+			}
+			bottom = y;
+		}
+	}
+	if( top < 0 ){
+		return rect;
+	}
+
+	int first = 0;
+	while( columns[first] == 0 ){
+		first++;
+	}
+	int last = wordsPerRow - 1;
+	while( columns[last] == 0 ){
+		last--;
+	}
+	rect.left = first * 64 + findLowestBit( columns[first] );
+	rect.right = last * 64 + findHighestBit( columns[last] ) + 1;
+	rect.top = top;
+	rect.bottom = bottom + 1;
+	return rect;
+}
+
+void BitMask::copyPixels( const uint32_t* src, uint32_t* dst, int stride ) const
+{
+	if( stride <= 0 ){
+		stride = width;
+	}
+	for( int y = 0; y < height; y++ ){
+		const uint64_t* mask = getRow( y );
+		const uint32_t* srcRow = src + y * stride;
+		uint32_t* dstRow = dst + y * stride;
+#ifdef KINECT_SIMD_X86
+		if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+			copyRowSse41( srcRow, mask, dstRow, width );
+			continue;
+		}
+#endif
+		for( int x = 0; x < width; x++ ){
+			dstRow[x] = ( ( mask[x >> 6] >> ( x & 63 ) ) & 1 ) ? srcRow[x] : 0;
+		}
+	}
+}
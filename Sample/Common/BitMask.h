@@ -0,0 +1,72 @@
+// BitMask.h : 1f1rbgŕ\2l̃}XN摜
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "KinectTypes.h"
+#include "Morphology.h"
+#include "Simd.h"
+
+
+// s64f1[h(uint64_t)ɂ܂Ƃ߂2l̃}XN
+// xԖڂ̉f( x / 64 )Ԗڂ̃[h( x % 64 )rbg(s̖̗]rbg͏0)
+// 640~480ł38400oCgɂȂ̂ŁA8rbg̃}XN(307200oCg)ƈL2LbVɎ܂
+// kƖc64f̃rbgZōsAMorphologyFilter0255̃}XNƂƓʂɂȂ
+class BitMask
+{
+public:
+	BitMask();
+	BitMask( int width, int height );
+
+	// SẲf0ɂĊmۂ
+	void create( int width, int height );
+	void clear();
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getWordsPerRow() const { return wordsPerRow; }
+	uint64_t* getRow( int y ) { return &words[y * wordsPerRow]; }
+	const uint64_t* getRow( int y ) const { return &words[y * wordsPerRow]; }
+
+	// gp閽߃Zbg(łCPUΉĂł߃Zbg)
+	void setSimdLevel( SimdLevel level ) { simdLevel = level; }
+
+	// 8rbg̃}XN(0ȊO1ɂ)Astride͍s̃oCg(cv::Matdatastep)
+	void pack( const uint8_t* src, int stride );
+
+	// 8rbg̃}XNɏo(1valueA00)
+	void unpack( uint8_t* dst, int stride, uint8_t value = 255 ) const;
+
+	// 3~3̍\vfiterationsk/c(MorphologyFiltererode()/dilate()Ɠ)
+	void erode( int iterations, MorphologyShape shape = MORPHOLOGY_RECT );
+	void dilate( int iterations, MorphologyShape shape = MORPHOLOGY_RECT );
+
+	// 1̉f̐
+	int getArea() const;
+
+	// 1̉fSĊ܂ލŏ̋`(1̉fƂ͋)
+	MaskRect getBoundingBox() const;
+
+	// 1̉fsrcdstփRs[AȊO0ɂ(copyWithMask()ƓABGRX4oCg̉f)
+	// stridesrcdst̍s̉f(0̂ƂwidthA傫ȉ摜̈ꕔ͈̔͂ƂɎg)
+	void copyPixels( const uint32_t* src, uint32_t* dst, int stride = 0 ) const;
+
+private:
+	// 摜̊O0ƂĖc
+	void dilateRect( int radius );
+	void dilateCross();
+
+	// 01ւ(s̖̗]rbg0̂܂܂ɂ)
+	void invert();
+
+	int width;
+	int height;
+	int wordsPerRow;
+	uint64_t lastWordMask; // s̍Ō̃[h̗Lȃrbg
+	SimdLevel simdLevel;
+	std::vector<uint64_t> words;
+	std::vector<uint64_t> scratch;
+};
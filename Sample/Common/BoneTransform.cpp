@@ -0,0 +1,106 @@
+// BoneTransform.cpp : Bone Orientation3DfBone̕ϊs߂(MotionCapturěvZ)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "BoneTransform.h"
+
+
+void SkeleState::reset()
+{
+	for( int i = 0; i < KINECT_SKELETON_POSITION_COUNT; i++ ){
+		endJointPos[i].x = 0.0f;
+		endJointPos[i].y = 0.0f;
+		endJointPos[i].z = 0.0f;
+		setBoneMatrixIdentity( localTrans[i] );
+		boneTracked[i] = false;
+	}
+	isValid = false;
+}
+
+void setBoneMatrixIdentity( BoneMatrix& out )
+{
+	setBoneMatrixScaling( out, 1.0f, 1.0f, 1.0f );
+}
+
+void setBoneMatrixScaling( BoneMatrix& out, float x, float y, float z )
+{
+	for( int i = 0; i < 4; i++ ){
+		for( int j = 0; j < 4; j++ ){
+			out.m[i][j] = 0.0f;
+		}
+	}
+	out.m[0][0] = x;
+	out.m[1][1] = y;
+	out.m[2][2] = z;
+	out.m[3][3] = 1.0f;
+}
+
+void setBoneMatrixTranslation( BoneMatrix& out, float x, float y, float z )
+{
+	setBoneMatrixIdentity( out );
+	out.m[3][0] = x;
+	out.m[3][1] = y;
+	out.m[3][2] = z;
+}
+
+void multiplyBoneMatrix( BoneMatrix& out, const BoneMatrix& a, const BoneMatrix& b )
+{
+	BoneMatrix result;
+	for( int i = 0; i < 4; i++ ){
+		for( int j = 0; j < 4; j++ ){
+			result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+		}
+	}
+	out = result;
+}
+
+void transformBoneCoord( BoneVector& out, const BoneVector& v, const BoneMatrix& m )
+{
+	const float x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + m.m[3][0];
+	const float y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + m.m[3][1];
+	const float z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + m.m[3][2];
+	const float w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + m.m[3][3];
+	const float scale = ( w != 0.0f ) ? 1.0f / w : 1.0f;
+	out.x = x * scale;
+	out.y = y * scale;
+	out.z = z * scale;
+}
+
+void calcSkeleState( const SkeletonData& skele, int start, int end, const BoneVector& jointStartPos, const BoneMatrix& rotate, float boneLength, SkeleState* state )
+{
+	BoneMatrix mat;
+	BoneMatrix matScale, matTrans;
+	const BoneVector yVec = { 0.0f, 1.0f, 0.0f }; // y1LтĂxNg
+
+	// 3DfYɊg傷
+	setBoneMatrixScaling( matScale, 1.0f, boneLength, 1.0f );
+
+	// ړ
+	setBoneMatrixTranslation( matTrans, jointStartPos.x, jointStartPos.y, jointStartPos.z );
+
+	// ϊs쐬(gA]Aړ̏)
+	multiplyBoneMatrix( mat, matScale, rotate );
+	multiplyBoneMatrix( state->localTrans[end], mat, matTrans );
+
+	// _Wϊ
+	transformBoneCoord( state->endJointPos[end], yVec, state->localTrans[end] );
+
+	// BonẽgbLOԂݒ肷
+	state->boneTracked[end] = skele.positionTrackingStates[start] == SKELETON_POSITION_TRACKED
+		&& skele.positionTrackingStates[end] == SKELETON_POSITION_TRACKED;
+}
+
+void setSkeleStateFromOrient( const SkeletonData& skele, const BoneOrientation* orient, const float* boneLengths, SkeleState* state )
+{
+	// Root͕\ł{[Ȃ̂ŁA[JϊšvZ͏ȗ
+	// gbLOԂ擾
+	state->boneTracked[SKELETON_POSITION_HIP_CENTER] = skele.positionTrackingStates[SKELETON_POSITION_HIP_CENTER] == SKELETON_POSITION_TRACKED;
+
+	// RootȊOBoneɑ΂calcSkeleState()Ăяo
+	// Bone͐e珇ɕł̂ŁAstartJoinẗʒu͐ɋ܂Ă
+	for( int i = 1; i < KINECT_SKELETON_POSITION_COUNT; i++ ){
+		const int jointStart = orient[i].startJoint;
+		const int jointEnd = orient[i].endJoint;
+		calcSkeleState( skele, jointStart, jointEnd, state->endJointPos[jointStart], orient[jointEnd].absoluteRotation.rotationMatrix, boneLengths[jointEnd], state );
+	}
+}
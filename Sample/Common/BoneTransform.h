@@ -0,0 +1,79 @@
+// BoneTransform.h : Bone Orientation3DfBone̕ϊs߂(MotionCapturěvZ)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "SkeletonFrame.h"
+
+
+// 3̃xNg(D3DXVECTOR3Ɠ)
+struct BoneVector
+{
+	float x;
+	float y;
+	float z;
+};
+
+// 4~4̍s(D3DXMATRIXAMatrix4Ɠ)
+// D3DXƓsxNgɉE|̂ŁAړ4sڂɓ
+struct BoneMatrix
+{
+	float m[4][4];
+};
+
+// Bonẻ](NUI_SKELETON_BONE_ROTATIONƓ)
+struct BoneRotation
+{
+	BoneMatrix rotationMatrix;
+	SkeletonVector rotationQuaternion;
+};
+
+// Boně(NUI_SKELETON_BONE_ORIENTATIONƓ)
+// Kinect SDK̂łNuiSkeletonCalculateBoneOrientations()̌ʂ̂܂ܓn
+struct BoneOrientation
+{
+	int32_t endJoint;   // SkeletonPositionIndex
+	int32_t startJoint; // SkeletonPositionIndex
+	BoneRotation hierarchicalRotation;
+	BoneRotation absoluteRotation;
+};
+
+// Bone̕\ɕKvȌvZʂi[邽߂̍\
+struct SkeleState
+{
+	// Joinẗʒu
+	BoneVector endJointPos[KINECT_SKELETON_POSITION_COUNT];
+
+	// [Jϊs
+	BoneMatrix localTrans[KINECT_SKELETON_POSITION_COUNT];
+
+	// gbLO
+	bool boneTracked[KINECT_SKELETON_POSITION_COUNT];
+
+	// ]ʒuȂǂLۂ
+	bool isValid;
+
+	// o[ϐSď
+	void reset();
+};
+
+// PʍsAgAړ̍s(D3DXMatrixIdentity()AD3DXMatrixScaling()AD3DXMatrixTranslation()Ɠ)
+void setBoneMatrixIdentity( BoneMatrix& out );
+void setBoneMatrixScaling( BoneMatrix& out, float x, float y, float z );
+void setBoneMatrixTranslation( BoneMatrix& out, float x, float y, float z );
+
+// out = a ~ b(D3DXMatrixMultiply()ƓAoutabƓł悢)
+void multiplyBoneMatrix( BoneMatrix& out, const BoneMatrix& a, const BoneMatrix& b );
+
+// _Wϊ(D3DXVec3TransformCoord()ƓAwŊ)
+void transformBoneCoord( BoneVector& out, const BoneVector& v, const BoneMatrix& m );
+
+// WϊƃgbLOԂSkeleStateɊi[
+// jointStartPos璷boneLengthBonerotateŉ]Ƃ́Aend̕ϊsJoinẗʒu߂
+void calcSkeleState( const SkeletonData& skele, int start, int end, const BoneVector& jointStartPos, const BoneMatrix& rotate, float boneLength, SkeleState* state );
+
+// Bone Orientation\ɕKvȏ߂SkeleStateɊi[
+// orientboneLengths͊֐߂̐(KINECT_SKELETON_POSITION_COUNT)̗vf
+void setSkeleStateFromOrient( const SkeletonData& skele, const BoneOrientation* orient, const float* boneLengths, SkeleState* state );
@@ -0,0 +1,287 @@
+// Compositor.cpp : ؂蔲l̔wi̒u
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Compositor.h"
+#include <cstring>
+
+
+// 1f(4oCg)̍( v / 255̎ľܓ( v + 128 )̏ʂ̌ŋ߂)
+static inline uint8_t blendChannel( int foreground, int background, int alpha )
+{
+	const int value = foreground * alpha + background * ( 255 - alpha ) + 128;
+	return static_cast<uint8_t>( ( value + ( value >> 8 ) ) >> 8 );
+}
+
+static void blendScalar( const uint8_t* foreground, const uint8_t* alpha, const uint8_t* background, uint8_t* dst, int begin, int count )
+{
+	for( int i = begin; i < count; i++ ){
+		const int a = alpha[i];
+		for( int c = 0; c < 4; c++ ){
+			dst[i * 4 + c] = blendChannel( foreground[i * 4 + c], background[i * 4 + c], a );
+		}
+	}
+}
+
+#ifdef KINECT_SIMD_X86
+
+// 8f(16rbg)̍
+KINECT_TARGET_SSE41
+static inline __m128i blendWordsSse41( __m128i foreground, __m128i background, __m128i alpha )
+{
+	const __m128i full = _mm_set1_epi16( 255 );
+	const __m128i round = _mm_set1_epi16( 128 );
+	__m128i value = _mm_add_epi16( _mm_mullo_epi16( foreground, alpha ), _mm_mullo_epi16( background, _mm_sub_epi16( full, alpha ) ) );
+	value = _mm_add_epi16( value, round );
+	return _mm_srli_epi16( _mm_add_epi16( value, _mm_srli_epi16( value, 8 ) ), 8 );
+}
+
+// SSE4.1
+// 4fAf4oCgɍL16rbgō(4f̃S0255̂Ƃ̓Rs[)
+KINECT_TARGET_SSE41
+static void blendSse41( const uint8_t* foreground, const uint8_t* alpha, const uint8_t* background, uint8_t* dst, int count )
+{
+	const __m128i spread = _mm_setr_epi8( 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3 );
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+	for( ; i + 4 <= count; i += 4 ){
+		uint32_t alpha4;
+		std::memcpy( &alpha4, alpha + i, sizeof( alpha4 ) );
+		const __m128i f = _mm_loadu_si128( reinterpret_cast<const __m128i*>( foreground + i * 4 ) );
+		const __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( background + i * 4 ) );
+		__m128i result;
+		if( alpha4 == 0 ){
+			result = b;
+		}
+		else if( alpha4 == 0xffffffff ){
+			result = f;
+		}
+		else{
+			const __m128i a = _mm_shuffle_epi8( _mm_cvtsi32_si128( static_cast<int>( alpha4 ) ), spread );
+			const __m128i low = blendWordsSse41( _mm_unpacklo_epi8( f, zero ), _mm_unpacklo_epi8( b, zero ), _mm_unpacklo_epi8( a, zero ) );
+			const __m128i high = blendWordsSse41( _mm_unpackhi_epi8( f, zero ), _mm_unpackhi_epi8( b, zero ), _mm_unpackhi_epi8( a, zero ) );
+			result = _mm_packus_epi16( low, high );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i * 4 ), result );
+	}
+	blendScalar( foreground, alpha, background, dst, i, count );
+}
+
+#endif
+
+#ifdef KINECT_SIMD_AVX2
+
+KINECT_TARGET_AVX2
+static inline __m256i blendWordsAvx2( __m256i foreground, __m256i background, __m256i alpha )
+{
+	const __m256i full = _mm256_set1_epi16( 255 );
+	const __m256i round = _mm256_set1_epi16( 128 );
+	__m256i value = _mm256_add_epi16( _mm256_mullo_epi16( foreground, alpha ), _mm256_mullo_epi16( background, _mm256_sub_epi16( full, alpha ) ) );
+	value = _mm256_add_epi16( value, round );
+	return _mm256_srli_epi16( _mm256_add_epi16( value, _mm256_srli_epi16( value, 8 ) ), 8 );
+}
+
+// AVX2
+// 8fA32rbgɍLĂ0x01010101|ĉf4oCgɍL
+// oCg16rbg̕ϊ̓[ɍsAColorAwiA𓯂悤ɕׂ̂Ōʂ̕т͕ςȂ
+KINECT_TARGET_AVX2
+static void blendAvx2( const uint8_t* foreground, const uint8_t* alpha, const uint8_t* background, uint8_t* dst, int count )
+{
+	const __m256i spread = _mm256_set1_epi32( 0x01010101 );
+	const __m256i zero = _mm256_setzero_si256();
+	int i = 0;
+	for( ; i + 8 <= count; i += 8 ){
+		uint64_t alpha8;
+		std::memcpy( &alpha8, alpha + i, sizeof( alpha8 ) );
+		const __m256i f = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( foreground + i * 4 ) );
+		const __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( background + i * 4 ) );
+		__m256i result;
+		if( alpha8 == 0 ){
+			result = b;
+		}
+		else if( alpha8 == ~0ULL ){
+			result = f;
+		}
+		else{
+			const __m256i a = _mm256_mullo_epi32( _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( alpha + i ) ) ), spread );
+			const __m256i low = blendWordsAvx2( _mm256_unpacklo_epi8( f, zero ), _mm256_unpacklo_epi8( b, zero ), _mm256_unpacklo_epi8( a, zero ) );
+			const __m256i high = blendWordsAvx2( _mm256_unpackhi_epi8( f, zero ), _mm256_unpackhi_epi8( b, zero ), _mm256_unpackhi_epi8( a, zero ) );
+			result = _mm256_packus_epi16( low, high );
+		}
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( dst + i * 4 ), result );
+	}
+	blendScalar( foreground, alpha, background, dst, i, count );
+}
+
+#endif
+
+// }XN0ȊỎfSĊ܂ލŏ̋`(8fׂ)
+static MaskRect findMaskRect( const uint8_t* mask, int width, int height )
+{
+	MaskRect rect;
+	for( int y = 0; y < height; y++ ){
+		const uint8_t* row = mask + y * width;
+		int x = 0;
+		while( x + 8 <= width ){
+			uint64_t word;
+			std::memcpy( &word, row + x, sizeof( word ) );
+			if( word ){
+				break;
+			}
+			x += 8;
+		}
+		while( x < width && row[x] == 0 ){
+			x++;
+		}
+		if( x == width ){
+			continue;
+		}
+		int right = width;
+		while( right - 8 >= x ){
+			uint64_t word;
+			std::memcpy( &word, row + right - 8, sizeof( word ) );
+			if( word ){
+				break;
+			}
+			right -= 8;
+		}
+		while( row[right - 1] == 0 ){
+			right--;
+		}
+		if( rect.isEmpty() ){
+			rect.left = x;
+			rect.top = y;
+			rect.right = right;
+		}
+		rect.left = ( x < rect.left ) ? x : rect.left;
+		rect.right = ( right > rect.right ) ? right : rect.right;
+		rect.bottom = y + 1;
+	}
+	return rect;
+}
+
+
+BackgroundCompositor::BackgroundCompositor( int width, int height )
+	: width( width ), height( height ), featherRadius( -1 ), simdLevel( getSimdLevel() )
+{
+	rowSums.resize( width * height );
+	zeroRow.assign( width, 0 );
+	columnSums.resize( width );
+	alphaRow.resize( width );
+	setFeatherRadius( DEFAULT_FEATHER_RADIUS );
+}
+
+void BackgroundCompositor::setFeatherRadius( int radius )
+{
+	radius = ( radius < 0 ) ? 0 : ( ( radius > MAX_FEATHER_RADIUS ) ? MAX_FEATHER_RADIUS : radius );
+	if( radius == featherRadius ){
+		return;
+	}
+	featherRadius = radius;
+
+	// ̒̃}XN̉fn烿 = 255 ~ n / ̉f(ľܓ)
+	const int area = ( 2 * radius + 1 ) * ( 2 * radius + 1 );
+	alphaTable.resize( area + 1 );
+	for( int count = 0; count <= area; count++ ){
+		alphaTable[count] = static_cast<uint8_t>( ( 255 * count + area / 2 ) / area );
+	}
+}
+
+void BackgroundCompositor::process( const uint8_t* foreground, const uint8_t* mask, const uint8_t* background, uint8_t* dst )
+{
+	const int radius = featherRadius;
+	blendRect = findMaskRect( mask, width, height ).inflate( radius, width, height );
+
+	// ͈͂̊O̍sƁA͈͂̍s̍E͔wî܂
+	for( int y = 0; y < height; y++ ){
+		const int offset = y * width * 4;
+		if( y < blendRect.top || y >= blendRect.bottom ){
+			if( dst != background ){
+				std::memcpy( dst + offset, background + offset, width * 4 );
+			}
+			continue;
+		}
+		if( dst != background ){
+			std::memcpy( dst + offset, background + offset, blendRect.left * 4 );
+			std::memcpy( dst + offset + blendRect.right * 4, background + offset + blendRect.right * 4, ( width - blendRect.right ) * 4 );
+		}
+	}
+	if( blendRect.isEmpty() ){
+		return;
+	}
+
+	// ̈ړa
+	for( int y = blendRect.top; y < blendRect.bottom; y++ ){
+		sumRow( mask, y );
+	}
+
+	// c̈ړa(摜̊O̍s͒[̍sA͈͂̊O̍s0)
+	auto sumsOf = [&]( int y ) -> const uint8_t* {
+		y = ( y < 0 ) ? 0 : ( ( y >= height ) ? height - 1 : y );
+		return ( y >= blendRect.top && y < blendRect.bottom ) ? &rowSums[y * width] : &zeroRow[0];
+	};
+	const int left = blendRect.left;
+	const int count = blendRect.getWidth();
+	uint16_t* columns = &columnSums[left];
+	std::memset( columns, 0, count * sizeof( uint16_t ) );
+	for( int k = -radius; k <= radius; k++ ){
+		const uint8_t* sums = sumsOf( blendRect.top + k ) + left;
+		for( int x = 0; x < count; x++ ){
+			columns[x] = static_cast<uint16_t>( columns[x] + sums[x] );
+		}
+	}
+
+	const uint8_t* table = &alphaTable[0];
+	uint8_t* alpha = &alphaRow[0];
+	for( int y = blendRect.top; y < blendRect.bottom; y++ ){
+		if( y > blendRect.top ){
+			const uint8_t* added = sumsOf( y + radius ) + left;
+			const uint8_t* removed = sumsOf( y - radius - 1 ) + left;
+			for( int x = 0; x < count; x++ ){
+				columns[x] = static_cast<uint16_t>( columns[x] + added[x] - removed[x] );
+			}
+		}
+		for( int x = 0; x < count; x++ ){
+			alpha[x] = table[columns[x]];
+		}
+		const int offset = ( y * width + left ) * 4;
+		blendRow( foreground + offset, alpha, background + offset, dst + offset, count );
+	}
+}
+
+void BackgroundCompositor::sumRow( const uint8_t* mask, int y )
+{
+	// 摜̊O̗͒[̗̃}XNg
+	const uint8_t* row = mask + y * width;
+	uint8_t* sums = &rowSums[y * width];
+	const int radius = featherRadius;
+	auto at = [&]( int x ) -> int {
+		x = ( x < 0 ) ? 0 : ( ( x >= width ) ? width - 1 : x );
+		return row[x] ? 1 : 0;
+	};
+	int sum = 0;
+	for( int k = -radius; k <= radius; k++ ){
+		sum += at( blendRect.left + k );
+	}
+	for( int x = blendRect.left; x < blendRect.right; x++ ){
+		sums[x] = static_cast<uint8_t>( sum );
+		sum += at( x + radius + 1 ) - at( x - radius );
+	}
+}
+
+void BackgroundCompositor::blendRow( const uint8_t* foreground, const uint8_t* alpha, const uint8_t* background, uint8_t* dst, int count ) const
+{
+#ifdef KINECT_SIMD_AVX2
+	if( ( simdLevel >= SIMD_AVX2 ) && ( getSimdLevel() >= SIMD_AVX2 ) ){
+		blendAvx2( foreground, alpha, background, dst, count );
+		return;
+	}
+#endif
+#ifdef KINECT_SIMD_X86
+	if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+		blendSse41( foreground, alpha, background, dst, count );
+		return;
+	}
+#endif
+	blendScalar( foreground, alpha, background, dst, 0, count );
+}
@@ -0,0 +1,62 @@
+// Compositor.h : ؂蔲l̔wi̒u
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "KinectTypes.h"
+#include "Simd.h"
+
+
+// Player̃}XN狫Eڂ(sx)AColorPlayer̗̈悾wiɏd˂
+// ̓}XN( 2 ~ a + 1 )fl̔^tB^ŕς(ƏcɕĈړaŋ߂̂ŁAԂ͔aɂȂ)
+// 摜̊O͒[̉f̂ƂĈ(摜̒[Ő؂ꂽl̒[͂ڂȂ)
+//  dst = ( fg ~  + bg ~ ( 255 -  ) ) / 255 BGRX̃`lɎľܓčsASIMDł4f(AVX2ł8f)
+// }XN܂ޔ͈͂𔼌a̕L͈͂̊ÓAwî܂܃Rs[
+class BackgroundCompositor
+{
+public:
+	// Eڂålƍől[pixel]
+	static const int DEFAULT_FEATHER_RADIUS = 4;
+	static const int MAX_FEATHER_RADIUS = 15;
+
+	BackgroundCompositor( int width, int height );
+
+	// Eڂa(0̂Ƃ͂ڂɃ}XN̂Ƃɐ؂蔲)
+	void setFeatherRadius( int radius );
+	int getFeatherRadius() const { return featherRadius; }
+
+	// gp閽߃Zbg(łCPUΉĂł߃Zbg)
+	void setSimdLevel( SimdLevel level ) { simdLevel = level; }
+
+	// foreground : BGRXColorAmask : Player̗̈(PlayerȂ0ȊO)Abackground : BGRX̔wi
+	// dst : BGRX̉摜(foregroundAbackgroundƓł悢)
+	void process( const uint8_t* foreground, const uint8_t* mask, const uint8_t* background, uint8_t* dst );
+
+	// Õt[Ń߂͈(}XN܂ޔ͈͂𔼌a̕L͈)
+	const MaskRect& getBlendRect() const { return blendRect; }
+
+private:
+	// sɉ̈ړa(}XN̉f)߂
+	void sumRow( const uint8_t* mask, int y );
+
+	// 1s
+	void blendRow( const uint8_t* foreground, const uint8_t* alpha, const uint8_t* background, uint8_t* dst, int count ) const;
+
+	int width;
+	int height;
+	int featherRadius;
+	SimdLevel simdLevel;
+	MaskRect blendRect;
+
+	std::vector<uint8_t> rowSums;     // ̈ړa(摜Ɠ傫AblendRect͈̔͂g)
+	std::vector<uint8_t> zeroRow;     // blendRect̊O̍s̈ړa
+	std::vector<uint16_t> columnSums; // c̈ړa
+	std::vector<uint8_t> alphaRow;    // 1s̃
+	std::vector<uint8_t> alphaTable;  // ̒̃}XN̉f烿ւ̕ϊe[u
+
+	BackgroundCompositor( const BackgroundCompositor& );
+	BackgroundCompositor& operator=( const BackgroundCompositor& );
+};
@@ -0,0 +1,260 @@
+// DepthCodec.cpp : Depth&Playert[̉tk
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "DepthCodec.h"
+#include <cstring>
+
+
+static const uint8_t DEPTH_CODEC_MAGIC = 'D';
+
+// s̗\̎
+static const uint8_t PREDICT_SPATIAL  = 0;
+static const uint8_t PREDICT_TEMPORAL = 1;
+
+static const int MAX_RUN = 63;
+
+// \Ƃ̍(16rbgŐ܂Ԃ)AΒl̏0, 1, 2, ...ƂȂ镄Ȃ̒lɂ
+static inline uint16_t zigzag( uint16_t value, uint16_t predicted )
+{
+	const int16_t difference = static_cast<int16_t>( value - predicted );
+	return static_cast<uint16_t>( ( static_cast<uint16_t>( difference ) << 1 ) ^ ( difference >> 15 ) );
+}
+
+static inline uint16_t unzigzag( uint16_t zz, uint16_t predicted )
+{
+	const uint16_t difference = static_cast<uint16_t>( ( zz >> 1 ) ^ ( 0 - ( zz & 1 ) ) );
+	return static_cast<uint16_t>( predicted + difference );
+}
+
+// 1s𕄍
+// predict͗\f̗(Ԃ̗\ł1fɂ炵̍s)ŁA擪̉f̗\first
+static uint8_t* encodeRow( const uint16_t* row, const uint16_t* predict, uint16_t first, int width, uint8_t* out )
+{
+	int x = 0;
+	uint16_t predicted = first;
+	while( x < width ){
+		const uint16_t zz = zigzag( row[x], predicted );
+		if( zz == 0 ){
+			// \ƈvf̘A
+			int run = 1;
+			while( run < MAX_RUN && x + run < width && row[x + run] == predict[x + run] ){
+				run++;
+			}
+			*out++ = static_cast<uint8_t>( 0xC0 + run - 1 );
+			x += run;
+		}
+		else if( zz < 0x80 ){
+			*out++ = static_cast<uint8_t>( zz );
+			x++;
+		}
+		else if( zz < 0x4000 ){
+			*out++ = static_cast<uint8_t>( 0x80 | ( zz >> 8 ) );
+			*out++ = static_cast<uint8_t>( zz );
+			x++;
+		}
+		else{
+			*out++ = 0xFF;
+			*out++ = static_cast<uint8_t>( zz );
+			*out++ = static_cast<uint8_t>( zz >> 8 );
+			x++;
+		}
+		if( x < width ){
+			predicted = predict[x];
+		}
+	}
+	return out;
+}
+
+// 1s𕜍(f[^ȂƂnullptrԂ)
+// Ԃ̗\łpredictrow1f炵ĎŵŁA񂾉f̗\Ɏg
+static const uint8_t* decodeRow( const uint8_t* in, const uint8_t* end, const uint16_t* predict, uint16_t first, int width, uint16_t* row )
+{
+	int x = 0;
+	uint16_t predicted = first;
+	while( x < width ){
+		if( in >= end ){
+			return nullptr;
+		}
+		const uint8_t tag = *in++;
+		uint16_t zz;
+		if( tag < 0x80 ){
+			zz = tag;
+		}
+		else if( tag < 0xC0 ){
+			if( in >= end ){
+				return nullptr;
+			}
+			zz = static_cast<uint16_t>( ( ( tag & 0x3F ) << 8 ) | *in++ );
+		}
+		else if( tag != 0xFF ){
+			const int run = tag - 0xC0 + 1;
+			if( x + run > width ){
+				return nullptr;
+			}
+			row[x++] = predicted;
+			for( int i = 1; i < run; i++, x++ ){
+				row[x] = predict[x];
+			}
+			if( x < width ){
+				predicted = predict[x];
+			}
+			continue;
+		}
+		else{
+			if( end - in < 2 ){
+				return nullptr;
+			}
+			zz = static_cast<uint16_t>( in[0] | ( in[1] << 8 ) );
+			in += 2;
+		}
+		row[x++] = unzigzag( zz, predicted );
+		if( x < width ){
+			predicted = predict[x];
+		}
+	}
+	return in;
+}
+
+// \Ƃ̍𕄍Ƃ̑傫̖ڈ(8fɒׂ)
+static int estimateRowCost( const uint16_t* row, const uint16_t* predict, int width )
+{
+	int cost = 0;
+	for( int x = 8; x < width; x += 8 ){
+		const uint16_t zz = zigzag( row[x], predict[x] );
+		cost += ( zz != 0 ) + ( zz >= 0x80 ) + ( zz >= 0x4000 );
+	}
+	return cost;
+}
+
+
+/*----- DepthCompressor -----*/
+
+DepthCompressor::DepthCompressor( int width, int height )
+	: width( width ), height( height ), temporal( false ), keyframeInterval( 30 ), framesSinceKeyframe( -1 )
+{
+}
+
+void DepthCompressor::setTemporal( bool temporal, int keyframeInterval )
+{
+	this->temporal = temporal;
+	this->keyframeInterval = ( keyframeInterval > 0 ) ? keyframeInterval : 1;
+	reset();
+}
+
+size_t DepthCompressor::getMaxCompressedSize( int width, int height )
+{
+	return sizeof( DepthCodecHeader ) + static_cast<size_t>( height ) * ( 1 + 3 * static_cast<size_t>( width ) );
+}
+
+size_t DepthCompressor::compress( const uint16_t* src, uint8_t* dst )
+{
+	const bool keyframe = !temporal || framesSinceKeyframe < 0 || framesSinceKeyframe + 1 >= keyframeInterval;
+	framesSinceKeyframe = keyframe ? 0 : framesSinceKeyframe + 1;
+
+	DepthCodecHeader header;
+	header.magic = DEPTH_CODEC_MAGIC;
+	header.version = DEPTH_CODEC_VERSION;
+	header.flags = keyframe ? DEPTH_CODEC_FLAG_KEYFRAME : 0;
+	header.reserved = 0;
+	header.width = static_cast<uint16_t>( width );
+	header.height = static_cast<uint16_t>( height );
+	std::memcpy( dst, &header, sizeof( header ) );
+
+	uint8_t* out = dst + sizeof( header );
+	for( int y = 0; y < height; y++ ){
+		const uint16_t* row = src + y * width;
+		const uint16_t spatialFirst = ( y > 0 ) ? row[-width] : 0;
+
+		// Õt[Ƃ̍̕Ȃ肻ȍs͎Ԃ̗\g
+		uint8_t mode = PREDICT_SPATIAL;
+		if( !keyframe ){
+			const uint16_t* previousRow = &previous[y * width];
+			if( estimateRowCost( row, previousRow, width ) < estimateRowCost( row, row - 1, width ) ){
+				mode = PREDICT_TEMPORAL;
+			}
+		}
+		*out++ = mode;
+		if( mode == PREDICT_TEMPORAL ){
+			const uint16_t* previousRow = &previous[y * width];
+			out = encodeRow( row, previousRow, previousRow[0], width, out );
+		}
+		else{
+			out = encodeRow( row, row - 1, spatialFirst, width, out );
+		}
+	}
+
+	if( temporal ){
+		previous.assign( src, src + width * height );
+	}
+	return static_cast<size_t>( out - dst );
+}
+
+
+/*----- DepthDecompressor -----*/
+
+DepthDecompressor::DepthDecompressor()
+{
+}
+
+bool DepthDecompressor::getFrameSize( const uint8_t* src, size_t size, int* width, int* height )
+{
+	if( size < sizeof( DepthCodecHeader ) ){
+		return false;
+	}
+	DepthCodecHeader header;
+	std::memcpy( &header, src, sizeof( header ) );
+	if( header.magic != DEPTH_CODEC_MAGIC || header.version != DEPTH_CODEC_VERSION ){
+		return false;
+	}
+	*width = header.width;
+	*height = header.height;
+	return true;
+}
+
+bool DepthDecompressor::isKeyframe( const uint8_t* src, size_t size )
+{
+	int width, height;
+	return getFrameSize( src, size, &width, &height ) && ( src[offsetof( DepthCodecHeader, flags )] & DEPTH_CODEC_FLAG_KEYFRAME );
+}
+
+bool DepthDecompressor::decompress( const uint8_t* src, size_t size, uint16_t* dst, int width, int height )
+{
+	int frameWidth, frameHeight;
+	if( !getFrameSize( src, size, &frameWidth, &frameHeight ) || frameWidth != width || frameHeight != height ){
+		return false;
+	}
+	const int pixels = width * height;
+	const bool keyframe = isKeyframe( src, size );
+	if( !keyframe && static_cast<int>( previous.size() ) != pixels ){
+		return false;
+	}
+
+	const uint8_t* in = src + sizeof( DepthCodecHeader );
+	const uint8_t* end = src + size;
+	for( int y = 0; y < height && in; y++ ){
+		uint16_t* row = dst + y * width;
+		if( in >= end ){
+			in = nullptr;
+			break;
+		}
+		const uint8_t mode = *in++;
+		if( mode == PREDICT_TEMPORAL && !keyframe ){
+			const uint16_t* previousRow = &previous[y * width];
+			in = decodeRow( in, end, previousRow, previousRow[0], width, row );
+		}
+		else if( mode == PREDICT_SPATIAL ){
+			in = decodeRow( in, end, row - 1, ( y > 0 ) ? row[-width] : 0, width, row );
+		}
+		else{
+			in = nullptr;
+		}
+	}
+	if( !in ){
+		previous.clear();
+		return false;
+	}
+
+	previous.assign( dst, dst + pixels );
+	return true;
+}
@@ -0,0 +1,86 @@
+// DepthCodec.h : Depth&Playert[̉tk
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+
+// kt[̍\
+// wb_[̌ɍs̗\̎(1oCg)ƁA\Ƃ̍𕄍oCg񂪑
+//
+// \Ƃ̍(16rbgŐ܂ԂWOUOlzz)͎̃oCgŕ\
+//   0xxxxxxx                   : zz < 128
+//   10xxxxxx xxxxxxxx          : zz < 16384(6rbg)
+//   11rrrrrr(0xC0`0xFE)       : \ƈvfrrrrrr + 1(1`63f)
+//   11111111 xxxxxxxx xxxxxxxx : ȊO(gGfBA)
+//
+// \̎
+//    : ̉f(s̐擪͏̉f)
+//    : Õt[̓ʒủf(L[t[ȊOŁAsɍ̏I)
+// Depth&Player̒l̂܂ܗ\̂ŁAPlayer̃CfbNX܂߂Č̃t[ɖ߂
+static const uint8_t DEPTH_CODEC_VERSION = 1;
+static const uint8_t DEPTH_CODEC_FLAG_KEYFRAME = 1 << 0;
+
+struct DepthCodecHeader
+{
+	uint8_t magic;   // 'D'
+	uint8_t version; // DEPTH_CODEC_VERSION
+	uint8_t flags;   // DEPTH_CODEC_FLAG_*
+	uint8_t reserved;
+	uint16_t width;
+	uint16_t height;
+};
+
+// Depth&Playert[̈k
+class DepthCompressor
+{
+public:
+	DepthCompressor( int width, int height );
+
+	// truêƂ͑Õt[Ƃ̍g(keyframeIntervalt[ɑÕt[gȂL[t[ɂ)
+	void setTemporal( bool temporal, int keyframeInterval = 30 );
+
+	// ̃t[L[t[ɂ
+	void reset() { framesSinceKeyframe = -1; }
+
+	// koCgԂ(dstgetMaxCompressedSize()oCgȏ)
+	size_t compress( const uint16_t* src, uint8_t* dst );
+
+	size_t getMaxCompressedSize() const { return getMaxCompressedSize( width, height ); }
+	static size_t getMaxCompressedSize( int width, int height );
+
+private:
+	int width;
+	int height;
+	bool temporal;
+	int keyframeInterval;
+	int framesSinceKeyframe;
+	std::vector<uint16_t> previous;
+};
+
+// Depth&Playert[̓WJ
+class DepthDecompressor
+{
+public:
+	DepthDecompressor();
+
+	// WJt[dst(width~heightf)ɏ
+	// ꂽf[^Akt[̑傫width~heightƈႤƂAL[t[łȂÕt[WJĂȂƂfalseԂ
+	// (傫ႤƂdstɏ܂Ȃ)
+	bool decompress( const uint8_t* src, size_t size, uint16_t* dst, int width, int height );
+
+	// ̃t[L[t[WJ
+	void reset() { previous.clear(); }
+
+	static bool isKeyframe( const uint8_t* src, size_t size );
+
+	// kt[̉摜̑傫(ꂽf[^łfalse)
+	static bool getFrameSize( const uint8_t* src, size_t size, int* width, int* height );
+
+private:
+	std::vector<uint16_t> previous;
+};
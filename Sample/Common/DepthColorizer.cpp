@@ -0,0 +1,229 @@
+// DepthColorizer.cpp : Depth̕\p̐Ft
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "DepthColorizer.h"
+#include <cmath>
+#include <cstring>
+
+
+// 0`1̒l0`255Ɋۂ߂
+static inline uint32_t toByte( double value )
+{
+	value = ( value < 0.0 ) ? 0.0 : ( ( value > 1.0 ) ? 1.0 : value );
+	return static_cast<uint32_t>( std::floor( value * 255.0 + 0.5 ) );
+}
+
+static inline uint32_t toBgrx( uint32_t blue, uint32_t green, uint32_t red )
+{
+	return blue | ( green << 8 ) | ( red << 16 ) | 0xff000000;
+}
+
+// t = 0()`1(߂)̐F
+static uint32_t jetColor( double t )
+{
+	return toBgrx( toByte( 1.5 - std::fabs( 4.0 * t - 1.0 ) ), toByte( 1.5 - std::fabs( 4.0 * t - 2.0 ) ), toByte( 1.5 - std::fabs( 4.0 * t - 3.0 ) ) );
+}
+
+// turbȏɂߎ
+static uint32_t turboColor( double t )
+{
+	const double red   = 0.13572138 + t * ( 4.61539260 + t * ( -42.66032258 + t * ( 132.13108234 + t * ( -152.94239396 + t * 59.28637943 ) ) ) );
+	const double green = 0.09140261 + t * ( 2.19418839 + t * ( 4.84296658 + t * ( -14.18503333 + t * ( 4.27729857 + t * 2.82956604 ) ) ) );
+	const double blue  = 0.10667330 + t * ( 12.64194608 + t * ( -60.58204836 + t * ( 110.36276771 + t * ( -89.90310912 + t * 27.34824973 ) ) ) );
+	return toBgrx( toByte( blue ), toByte( green ), toByte( red ) );
+}
+
+// \BGRX4f332rbg(BGR12oCg)ɂ܂Ƃ߂ď
+static inline void storeBgr4( uint8_t* dst, uint32_t a, uint32_t b, uint32_t c, uint32_t d )
+{
+	const uint32_t words[3] = {
+		( a & 0x00ffffff ) | ( b << 24 ),
+		( ( b >> 8 ) & 0x0000ffff ) | ( c << 16 ),
+		( ( c >> 16 ) & 0x000000ff ) | ( d << 8 )
+	};
+	std::memcpy( dst, words, sizeof( words ) );
+}
+
+static void colorizeScalar( const uint16_t* src, uint8_t* dst, int begin, int pixels, int channels, const uint32_t* lut )
+{
+	int i = begin;
+	if( channels == 4 ){
+		uint32_t* bgrx = reinterpret_cast<uint32_t*>( dst );
+		for( ; i < pixels; i++ ){
+			bgrx[i] = lut[src[i] >> KINECT_PLAYER_INDEX_SHIFT];
+		}
+		return;
+	}
+	for( ; i + 4 <= pixels; i += 4 ){
+		storeBgr4( dst + i * 3, lut[src[i] >> KINECT_PLAYER_INDEX_SHIFT], lut[src[i + 1] >> KINECT_PLAYER_INDEX_SHIFT], lut[src[i + 2] >> KINECT_PLAYER_INDEX_SHIFT], lut[src[i + 3] >> KINECT_PLAYER_INDEX_SHIFT] );
+	}
+	for( ; i < pixels; i++ ){
+		const uint32_t color = lut[src[i] >> KINECT_PLAYER_INDEX_SHIFT];
+		dst[i * 3 + 0] = static_cast<uint8_t>( color );
+		dst[i * 3 + 1] = static_cast<uint8_t>( color >> 8 );
+		dst[i * 3 + 2] = static_cast<uint8_t>( color >> 16 );
+	}
+}
+
+#ifdef KINECT_SIMD_X86
+
+// SSE4.1
+// SSE4.1ɂgather߂̂ŕ\̓XJ[ōsABGR4fpshufb12oCgɋl߂16oCg
+// (4oCg͎4fŏ㏑̂ŁA݂o̖͂zȂ͈͂)
+KINECT_TARGET_SSE41
+static void colorizeSse41( const uint16_t* src, uint8_t* dst, int pixels, int channels, const uint32_t* lut )
+{
+	if( channels == 4 ){
+		colorizeScalar( src, dst, 0, pixels, channels, lut );
+		return;
+	}
+	const __m128i pack = _mm_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+	int i = 0;
+	for( ; i + 6 <= pixels; i += 4 ){
+		const __m128i colors = _mm_setr_epi32( static_cast<int>( lut[src[i] >> KINECT_PLAYER_INDEX_SHIFT] ), static_cast<int>( lut[src[i + 1] >> KINECT_PLAYER_INDEX_SHIFT] ),
+		                                       static_cast<int>( lut[src[i + 2] >> KINECT_PLAYER_INDEX_SHIFT] ), static_cast<int>( lut[src[i + 3] >> KINECT_PLAYER_INDEX_SHIFT] ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i * 3 ), _mm_shuffle_epi8( colors, pack ) );
+	}
+	colorizeScalar( src, dst, i, pixels, channels, lut );
+}
+
+#endif
+
+#ifdef KINECT_SIMD_AVX2
+
+// AVX2
+// 8fgather߂ŕ\(BGR̓[12oCgɋl߂āA2ɕď)
+KINECT_TARGET_AVX2
+static void colorizeAvx2( const uint16_t* src, uint8_t* dst, int pixels, int channels, const uint32_t* lut )
+{
+	const int* table = reinterpret_cast<const int*>( lut );
+	int i = 0;
+	if( channels == 4 ){
+		for( ; i + 8 <= pixels; i += 8 ){
+			const __m256i mm = _mm256_srli_epi32( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) ) ), KINECT_PLAYER_INDEX_SHIFT );
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>( dst + i * 4 ), _mm256_i32gather_epi32( table, mm, 4 ) );
+		}
+	}
+	else{
+		const __m256i pack = _mm256_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+		for( ; i + 10 <= pixels; i += 8 ){
+			const __m256i mm = _mm256_srli_epi32( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) ) ), KINECT_PLAYER_INDEX_SHIFT );
+			const __m256i colors = _mm256_shuffle_epi8( _mm256_i32gather_epi32( table, mm, 4 ), pack );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i * 3 ), _mm256_castsi256_si128( colors ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i * 3 + 12 ), _mm256_extracti128_si256( colors, 1 ) );
+		}
+	}
+	colorizeScalar( src, dst, i, pixels, channels, lut );
+}
+
+#endif
+
+
+DepthColorizer::DepthColorizer()
+	: colorMap( DEPTH_COLOR_MAP_GRAY ), range( DEPTH_RANGE_DEFAULT ), simdLevel( getSimdLevel() )
+{
+	table.resize( KINECT_DEPTH_MM_COUNT );
+	histogram.resize( KINECT_DEPTH_MM_COUNT * HISTOGRAM_COUNT );
+	buildTable();
+}
+
+void DepthColorizer::setColorMap( DepthColorMap colorMap )
+{
+	if( colorMap != this->colorMap ){
+		this->colorMap = colorMap;
+		buildTable();
+	}
+}
+
+void DepthColorizer::setRange( DepthRange range )
+{
+	if( range != this->range ){
+		this->range = range;
+		buildTable();
+	}
+}
+
+void DepthColorizer::buildTable()
+{
+	const int minimum = ( range == DEPTH_RANGE_NEAR ) ? KINECT_DEPTH_MINIMUM_NEAR_MODE_MM : KINECT_DEPTH_MINIMUM_MM;
+	const int maximum = ( range == DEPTH_RANGE_NEAR ) ? KINECT_DEPTH_MAXIMUM_NEAR_MODE_MM : KINECT_DEPTH_MAXIMUM_MM;
+	const int maximumValue = ( range == DEPTH_RANGE_NEAR ) ? KINECT_DEPTH_MAXIMUM_NEAR_MODE_VALUE : KINECT_DEPTH_MAXIMUM_VALUE;
+	for( int mm = 0; mm < KINECT_DEPTH_MM_COUNT; mm++ ){
+		const double t = static_cast<double>( maximum - mm ) / ( maximum - minimum );
+		switch( colorMap ){
+			case DEPTH_COLOR_MAP_GRAY:
+			{
+				// DepthDecoder::setDepthScale()Ɠ
+				const double scaled = std::floor( ( mm << KINECT_PLAYER_INDEX_SHIFT ) * ( -255.0 / maximumValue ) + 255.0 + 0.5 );
+				const uint32_t gray = static_cast<uint32_t>( ( scaled < 0.0 ) ? 0.0 : ( ( scaled > 255.0 ) ? 255.0 : scaled ) );
+				table[mm] = toBgrx( gray, gray, gray );
+				break;
+			}
+			case DEPTH_COLOR_MAP_JET:
+				table[mm] = mm ? jetColor( ( t < 0.0 ) ? 0.0 : ( ( t > 1.0 ) ? 1.0 : t ) ) : toBgrx( 0, 0, 0 );
+				break;
+			case DEPTH_COLOR_MAP_TURBO:
+				table[mm] = mm ? turboColor( ( t < 0.0 ) ? 0.0 : ( ( t > 1.0 ) ? 1.0 : t ) ) : toBgrx( 0, 0, 0 );
+				break;
+			default:
+				// qXgO̕R̓t[ɍ
+				table[mm] = toBgrx( 0, 0, 0 );
+				break;
+		}
+	}
+}
+
+void DepthColorizer::buildEqualizedTable( const uint16_t* src, int pixels )
+{
+	// vłf̗̋ݐϕzŊK蓖Ă(ł߂f255)
+	// ׂ̉f͓̂Ƃ̂ŁAfHISTOGRAM_COUNT̃qXgO֐U蕪ērւ̉ZȂ悤ɂ
+	std::memset( &histogram[0], 0, histogram.size() * sizeof( uint32_t ) );
+	uint32_t* bins = &histogram[0];
+	int i = 0;
+	for( ; i + HISTOGRAM_COUNT <= pixels; i += HISTOGRAM_COUNT ){
+		for( int j = 0; j < HISTOGRAM_COUNT; j++ ){
+			bins[j * KINECT_DEPTH_MM_COUNT + ( src[i + j] >> KINECT_PLAYER_INDEX_SHIFT )]++;
+		}
+	}
+	for( ; i < pixels; i++ ){
+		bins[src[i] >> KINECT_PLAYER_INDEX_SHIFT]++;
+	}
+	for( int j = 1; j < HISTOGRAM_COUNT; j++ ){
+		for( int mm = 0; mm < KINECT_DEPTH_MM_COUNT; mm++ ){
+			bins[mm] += bins[j * KINECT_DEPTH_MM_COUNT + mm];
+		}
+	}
+	const uint32_t total = pixels - histogram[0];
+	table[0] = toBgrx( 0, 0, 0 );
+	if( total == 0 ){
+		return;
+	}
+	uint32_t cumulative = 0;
+	for( int mm = 1; mm < KINECT_DEPTH_MM_COUNT; mm++ ){
+		const uint32_t gray = static_cast<uint32_t>( 255 - ( static_cast<uint64_t>( 255 ) * cumulative + total / 2 ) / total );
+		table[mm] = toBgrx( gray, gray, gray );
+		cumulative += histogram[mm];
+	}
+}
+
+void DepthColorizer::colorize( const uint16_t* src, uint8_t* dst, int pixels, int channels )
+{
+	if( colorMap == DEPTH_COLOR_MAP_EQUALIZED ){
+		buildEqualizedTable( src, pixels );
+	}
+
+#ifdef KINECT_SIMD_AVX2
+	if( ( simdLevel >= SIMD_AVX2 ) && ( getSimdLevel() >= SIMD_AVX2 ) ){
+		colorizeAvx2( src, dst, pixels, channels, &table[0] );
+		return;
+	}
+#endif
+#ifdef KINECT_SIMD_X86
+	if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+		colorizeSse41( src, dst, pixels, channels, &table[0] );
+		return;
+	}
+#endif
+	colorizeScalar( src, dst, 0, pixels, channels, &table[0] );
+}
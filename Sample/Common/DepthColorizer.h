@@ -0,0 +1,67 @@
+// DepthColorizer.h : Depth̕\p̐Ft
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "KinectTypes.h"
+#include "Simd.h"
+
+
+// F̕t
+enum DepthColorMap
+{
+	DEPTH_COLOR_MAP_GRAY = 0,  // ߂قǖ邢O[XP[(cv::Mat::convertTo( CV_8U, -255.0 / ől, 255.0 )ƓA0͔)
+	DEPTH_COLOR_MAP_JET,       // ߂قǐԂAقǐ(MATLABjet)
+	DEPTH_COLOR_MAP_TURBO,     // jet𖾂邳炩ɕς悤ɂ(Googleturbo)
+	DEPTH_COLOR_MAP_EQUALIZED, // t[Depth̃qXgO𕽒RO[XP[(f̑قǊK𑽂蓖Ă)
+	DEPTH_COLOR_MAP_COUNT
+};
+
+// F蓖Ă鋗͈̔
+enum DepthRange
+{
+	DEPTH_RANGE_DEFAULT = 0, // 800`4000mm
+	DEPTH_RANGE_NEAR         // Near Mode(400`3000mm)
+};
+
+// Depth&Player̒l(Player̃CfbNX͖)A[mm]̐F̃e[u1xɈBGRBGRXɕϊ
+// (cv::Mat::convertTo()8rbgɂĂcv::cvtColor( CV_GRAY2BGR )ōL2̑̑)
+// e[u͋8192ʂ蕪(BGRX32KB)ŁAF̕tƔ͈͂ςƂ蒼
+// qXgO̕ŔAt[ɃqXgO𐔂ăe[u蒼
+// ͈͂߂/f͔͈͂̒[̐FA0(vłȂf)DEPTH_COLOR_MAP_GRAYł͔AȊOł͍ɂ
+class DepthColorizer
+{
+public:
+	DepthColorizer();
+
+	void setColorMap( DepthColorMap colorMap );
+	DepthColorMap getColorMap() const { return colorMap; }
+	void setRange( DepthRange range );
+	DepthRange getRange() const { return range; }
+
+	// gp閽߃Zbg(łCPUΉĂł߃Zbg)
+	void setSimdLevel( SimdLevel level ) { simdLevel = level; }
+
+	// src : Depth&PlayerAdst : channels3̂ƂBGRA4̂ƂBGRX(X255)
+	void colorize( const uint16_t* src, uint8_t* dst, int pixels, int channels );
+
+	// [mm]̐F(BGRXAgGfBA32rbg)
+	const uint32_t* getTable() const { return &table[0]; }
+
+private:
+	// qXgO̕RŎgqXgO̐
+	static const int HISTOGRAM_COUNT = 4;
+
+	void buildTable();
+	void buildEqualizedTable( const uint16_t* src, int pixels );
+
+	DepthColorMap colorMap;
+	DepthRange range;
+	SimdLevel simdLevel;
+
+	std::vector<uint32_t> table;
+	std::vector<uint32_t> histogram;
+};
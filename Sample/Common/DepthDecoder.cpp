@@ -0,0 +1,466 @@
+// DepthDecoder.cpp : Depth&Playerf[^̃fR[h
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "DepthDecoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+/*----- PlayerRegions -----*/
+
+void PlayerRegions::reset()
+{
+	for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+		pixels[i] = 0;
+		bounds[i] = MaskRect();
+	}
+}
+
+// ͈ba܂߂(b̂Ƃaɂ)
+static void unionRect( MaskRect& b, const MaskRect& a )
+{
+	if( a.isEmpty() ){
+		return;
+	}
+	if( b.isEmpty() ){
+		b = a;
+		return;
+	}
+	b.left = ( std::min )( b.left, a.left );
+	b.top = ( std::min )( b.top, a.top );
+	b.right = ( std::max )( b.right, a.right );
+	b.bottom = ( std::max )( b.bottom, a.bottom );
+}
+
+void PlayerRegions::merge( const PlayerRegions& other )
+{
+	for( int i = 1; i <= KINECT_PLAYER_COUNT; i++ ){
+		pixels[i] += other.pixels[i];
+		unionRect( bounds[i], other.bounds[i] );
+	}
+}
+
+int PlayerRegions::getTotalPixels() const
+{
+	int total = 0;
+	for( int i = 1; i <= KINECT_PLAYER_COUNT; i++ ){
+		total += pixels[i];
+	}
+	return total;
+}
+
+MaskRect PlayerRegions::getUnion() const
+{
+	MaskRect rect;
+	for( int i = 1; i <= KINECT_PLAYER_COUNT; i++ ){
+		unionRect( rect, bounds[i] );
+	}
+	return rect;
+}
+
+// Player̉f(x, y)𐔂(index1`6AĂяo7)
+static inline void addRegionPixel( PlayerRegions& regions, int index, int x, int y )
+{
+	MaskRect& rect = regions.bounds[index];
+	if( regions.pixels[index]++ == 0 ){
+		rect.left = x;
+		rect.top = y;
+		rect.right = x + 1;
+		rect.bottom = y + 1;
+		return;
+	}
+	if( x < rect.left ){
+		rect.left = x;
+	}
+	if( x >= rect.right ){
+		rect.right = x + 1;
+	}
+	if( y < rect.top ){
+		rect.top = y;
+	}
+	if( y >= rect.bottom ){
+		rect.bottom = y + 1;
+	}
+}
+
+
+/*----- PlayerStats -----*/
+
+void PlayerStats::reset()
+{
+	pixels = 0;
+	depthPixels = 0;
+	sumX = 0;
+	sumY = 0;
+	depthSum = 0;
+	nearest = 0;
+	farthest = 0;
+	std::memset( histogram, 0, sizeof( histogram ) );
+}
+
+void PlayerStats::merge( const PlayerStats& other )
+{
+	if( other.depthPixels ){
+		nearest = ( depthPixels && nearest < other.nearest ) ? nearest : other.nearest;
+		farthest = ( farthest > other.farthest ) ? farthest : other.farthest;
+	}
+	pixels += other.pixels;
+	depthPixels += other.depthPixels;
+	sumX += other.sumX;
+	sumY += other.sumY;
+	depthSum += other.depthSum;
+	for( int i = 0; i < PLAYER_STATS_BIN_COUNT; i++ ){
+		histogram[i] += other.histogram[i];
+	}
+}
+
+// 1̃fR[h̊ԂPlayer̓v(ŌPlayerStats։)
+// ł߂Depth͌vłfƂ0xffff̂܂܂ɂĂ
+struct PlayerStatsAccumulator
+{
+	PlayerStats stats[KINECT_PLAYER_COUNT + 1];
+
+	PlayerStatsAccumulator()
+	{
+		for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+			stats[i].nearest = 0xffff;
+		}
+	}
+
+	void addTo( PlayerStats* output )
+	{
+		for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+			output[i].merge( stats[i] );
+		}
+	}
+};
+
+// Player̉f(x, y)𓝌vɉ(CfbNX0`6A7͎gȂlȂ̂ŐȂ)
+static inline void addStatsPixel( PlayerStatsAccumulator& accumulator, uint16_t value, int x, int y )
+{
+	const int index = value & KINECT_PLAYER_INDEX_MASK;
+	if( index > KINECT_PLAYER_COUNT ){
+		return;
+	}
+	PlayerStats& stats = accumulator.stats[index];
+	const int depth = value >> KINECT_PLAYER_INDEX_SHIFT;
+	stats.pixels++;
+	stats.sumX += x;
+	stats.sumY += y;
+	stats.histogram[depth >> PLAYER_STATS_BIN_SHIFT]++;
+	if( depth ){
+		stats.depthPixels++;
+		stats.depthSum += depth;
+		if( depth < stats.nearest ){
+			stats.nearest = static_cast<uint16_t>( depth );
+		}
+		if( depth > stats.farthest ){
+			stats.farthest = static_cast<uint16_t>( depth );
+		}
+	}
+}
+
+// Ărbg̐
+static inline int countBits( uint32_t bits )
+{
+	bits = bits - ( ( bits >> 1 ) & 0x55555555 );
+	bits = ( bits & 0x33333333 ) + ( ( bits >> 2 ) & 0x33333333 );
+	bits = ( bits + ( bits >> 4 ) ) & 0x0f0f0f0f;
+	return static_cast<int>( ( bits * 0x01010101 ) >> 24 );
+}
+
+
+/*----- DepthDecoder -----*/
+
+DepthDecoder::DepthDecoder()
+	: simdLevel( getSimdLevel() )
+{
+	setDepthScale( -255.0 / ( ( KINECT_DEPTH_MAXIMUM_MM << KINECT_PLAYER_INDEX_SHIFT ) | KINECT_PLAYER_INDEX_MASK ), 255.0 );
+	std::memset( playerColors, 0, sizeof( playerColors ) );
+}
+
+void DepthDecoder::setDepthScale( double alpha, double beta )
+{
+	depth8Table.resize( 65536 );
+	for( int value = 0; value < 65536; value++ ){
+		const double scaled = std::floor( ( value & KINECT_DEPTH_MASK ) * alpha + beta + 0.5 );
+		depth8Table[value] = static_cast<uint8_t>( ( scaled < 0.0 ) ? 0.0 : ( ( scaled > 255.0 ) ? 255.0 : scaled ) );
+	}
+}
+
+void DepthDecoder::setPlayerColors( const uint8_t* colors )
+{
+	std::memset( playerColors, 0, sizeof( playerColors ) );
+	std::memcpy( playerColors, colors, 3 * ( KINECT_PLAYER_COUNT + 1 ) );
+}
+
+void DepthDecoder::decode( const uint16_t* src, const DepthDecodeOutput& output, int begin, int end ) const
+{
+#ifdef KINECT_SIMD_X86
+	// AVX2ł̓oCgPʂ̃Vbt[ɌBGR̕בւ̂ŁASSE4.1łg
+	if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+		decodeSse41( src, output, begin, end );
+		return;
+	}
+#endif
+	decodeScalar( src, output, begin, end );
+}
+
+void DepthDecoder::decodeScalar( const uint16_t* src, const DepthDecodeOutput& output, int begin, int end ) const
+{
+	// o͐[JϐɈڂĂ(oCgPʂ݂̏̂тɓǂݒȂ悤)
+	uint16_t* depth = output.depth;
+	uint8_t* depth8 = output.depth8;
+	uint8_t* player = output.player;
+	uint8_t* mask = output.mask;
+	PlayerRegions* regions = output.regions;
+	PlayerStats* stats = output.stats;
+	PlayerStatsAccumulator accumulator;
+	int x = begin % output.width;
+	int y = begin / output.width;
+	bool hasPlayerMask = false;
+	for( int index = 1; index <= KINECT_PLAYER_COUNT; index++ ){
+		hasPlayerMask = hasPlayerMask || ( output.playerMask[index] != nullptr );
+	}
+
+	const uint8_t* lut = &depth8Table[0];
+	for( int i = begin; i < end; i++ ){
+		const uint16_t value = src[i];
+		const int index = value & KINECT_PLAYER_INDEX_MASK;
+		if( depth ){
+			depth[i] = value & KINECT_DEPTH_MASK;
+		}
+		if( depth8 ){
+			depth8[i] = lut[value];
+		}
+		if( player ){
+			player[i * 3 + 0] = playerColors[index][0];
+			player[i * 3 + 1] = playerColors[index][1];
+			player[i * 3 + 2] = playerColors[index][2];
+		}
+		if( mask ){
+			mask[i] = ( index != 0 && index <= KINECT_PLAYER_COUNT ) ? 255 : 0;
+		}
+		if( regions && index != 0 && index <= KINECT_PLAYER_COUNT ){
+			addRegionPixel( *regions, index, i % output.width, i / output.width );
+		}
+		if( hasPlayerMask ){
+			for( int playerIndex = 1; playerIndex <= KINECT_PLAYER_COUNT; playerIndex++ ){
+				if( output.playerMask[playerIndex] ){
+					output.playerMask[playerIndex][i] = ( index == playerIndex ) ? 255 : 0;
+				}
+			}
+		}
+		if( stats ){
+			addStatsPixel( accumulator, value, x, y );
+			if( ++x == output.width ){
+				x = 0;
+				y++;
+			}
+		}
+	}
+	if( stats ){
+		accumulator.addTo( stats );
+	}
+}
+
+#ifdef KINECT_SIMD_X86
+
+// SSE4.1
+// 16fǂݍ݁APlayer̃CfbNXpshufbŐFɕϊBGȐɕבւ
+// 8rbgւ̕ϊe[u̎QƂ̓XJ[ōs
+// Player̓v́A16fSēPlayer̂ƂɁADepth̘aAŏlAőlPlayer̃xNgɑ݁A
+// qXgO16f̊K̍ŏlől܂ŁAKɈvfrŐ(16f͂قƂ1`2KɎ܂)
+KINECT_TARGET_SSE41
+void DepthDecoder::decodeSse41( const uint16_t* src, const DepthDecodeOutput& output, int begin, int end ) const
+{
+	uint16_t* depth = output.depth;
+	uint8_t* depth8 = output.depth8;
+	uint8_t* player = output.player;
+	uint8_t* mask = output.mask;
+	uint8_t* playerMask[KINECT_PLAYER_COUNT + 1];
+	for( int index = 0; index <= KINECT_PLAYER_COUNT; index++ ){
+		playerMask[index] = output.playerMask[index];
+	}
+	PlayerRegions* regions = output.regions;
+	PlayerStats* stats = output.stats;
+	const int width = output.width;
+
+	const uint8_t* lut = &depth8Table[0];
+	const __m128i depthMask = _mm_set1_epi16( static_cast<short>( KINECT_DEPTH_MASK ) );
+	const __m128i indexMask = _mm_set1_epi16( KINECT_PLAYER_INDEX_MASK );
+	const __m128i zero = _mm_setzero_si128();
+
+	// CfbNX̐F(`l)
+	int8_t channel[3][16];
+	for( int c = 0; c < 3; c++ ){
+		for( int i = 0; i < 16; i++ ){
+			channel[c][i] = static_cast<int8_t>( playerColors[i & 7][c] );
+		}
+	}
+	const __m128i blue = _mm_loadu_si128( reinterpret_cast<const __m128i*>( channel[0] ) );
+	const __m128i green = _mm_loadu_si128( reinterpret_cast<const __m128i*>( channel[1] ) );
+	const __m128i red = _mm_loadu_si128( reinterpret_cast<const __m128i*>( channel[2] ) );
+
+	// B, G, R16f48oCgBGRɕבւVbt
+	int8_t order[3][3][16];
+	for( int chunk = 0; chunk < 3; chunk++ ){
+		for( int c = 0; c < 3; c++ ){
+			for( int i = 0; i < 16; i++ ){
+				const int j = chunk * 16 + i;
+				order[chunk][c][i] = static_cast<int8_t>( ( j % 3 == c ) ? j / 3 : 0x80 );
+			}
+		}
+	}
+	__m128i shuffle[3][3];
+	for( int chunk = 0; chunk < 3; chunk++ ){
+		for( int c = 0; c < 3; c++ ){
+			shuffle[chunk][c] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( order[chunk][c] ) );
+		}
+	}
+
+	// Player̓ṽxNg(Depth̘a432rbgAŏlƍől816rbg)
+	PlayerStatsAccumulator accumulator;
+	__m128i depthSum[KINECT_PLAYER_COUNT + 1];
+	__m128i depthMinimum[KINECT_PLAYER_COUNT + 1];
+	__m128i depthMaximum[KINECT_PLAYER_COUNT + 1];
+	for( int index = 0; index <= KINECT_PLAYER_COUNT; index++ ){
+		depthSum[index] = zero;
+		depthMinimum[index] = _mm_set1_epi16( -1 );
+		depthMaximum[index] = zero;
+	}
+	const __m128i ones = _mm_set1_epi16( 1 );
+	const __m128i playerLimit = _mm_set1_epi8( KINECT_PLAYER_COUNT + 1 );
+	const __m128i lastBin = _mm_set1_epi16( PLAYER_STATS_BIN_COUNT - 1 );
+
+	int i = begin;
+	for( ; i + 16 <= end; i += 16 ){
+		const __m128i value0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+		const __m128i value1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i + 8 ) );
+
+		if( depth ){
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( depth + i ), _mm_and_si128( value0, depthMask ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( depth + i + 8 ), _mm_and_si128( value1, depthMask ) );
+		}
+		if( depth8 ){
+			for( int j = 0; j < 16; j++ ){
+				depth8[i + j] = lut[src[i + j]];
+			}
+		}
+
+		// 16fPlayer̃CfbNX(oCg)
+		const __m128i index = _mm_packus_epi16( _mm_and_si128( value0, indexMask ), _mm_and_si128( value1, indexMask ) );
+
+		if( player ){
+			const __m128i b = _mm_shuffle_epi8( blue, index );
+			const __m128i g = _mm_shuffle_epi8( green, index );
+			const __m128i r = _mm_shuffle_epi8( red, index );
+			__m128i* dst = reinterpret_cast<__m128i*>( player + i * 3 );
+			for( int chunk = 0; chunk < 3; chunk++ ){
+				const __m128i bgr = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8( b, shuffle[chunk][0] ), _mm_shuffle_epi8( g, shuffle[chunk][1] ) ), _mm_shuffle_epi8( r, shuffle[chunk][2] ) );
+				_mm_storeu_si128( dst + chunk, bgr );
+			}
+		}
+		// Player̉f(CfbNX1`6A7͎gȂlȂ̂ŔwiƂĈ)
+		const __m128i isPlayer = _mm_and_si128( _mm_cmpgt_epi8( index, zero ), _mm_cmplt_epi8( index, playerLimit ) );
+		if( mask ){
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( mask + i ), isPlayer );
+		}
+		for( int playerIndex = 1; playerIndex <= KINECT_PLAYER_COUNT; playerIndex++ ){
+			if( playerMask[playerIndex] ){
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( playerMask[playerIndex] + i ), _mm_cmpeq_epi8( index, _mm_set1_epi8( static_cast<char>( playerIndex ) ) ) );
+			}
+		}
+
+		if( stats ){
+			const int x = i % width;
+			const int y = i / width;
+			const int first = _mm_extract_epi8( index, 0 );
+			if( first <= KINECT_PLAYER_COUNT && x + 16 <= width && _mm_movemask_epi8( _mm_cmpeq_epi8( index, _mm_set1_epi8( static_cast<char>( first ) ) ) ) == 0xffff ){
+				// 16fs̓Player
+				PlayerStats& playerStats = accumulator.stats[first];
+				const __m128i depth0 = _mm_srli_epi16( value0, KINECT_PLAYER_INDEX_SHIFT );
+				const __m128i depth1 = _mm_srli_epi16( value1, KINECT_PLAYER_INDEX_SHIFT );
+				const __m128i unknown0 = _mm_cmpeq_epi16( depth0, zero );
+				const __m128i unknown1 = _mm_cmpeq_epi16( depth1, zero );
+				const int unknownCount = countBits( _mm_movemask_epi8( _mm_packs_epi16( unknown0, unknown1 ) ) );
+				playerStats.pixels += 16;
+				playerStats.depthPixels += 16 - unknownCount;
+				playerStats.sumX += 16 * x + 120;
+				playerStats.sumY += 16 * y;
+				depthSum[first] = _mm_add_epi32( depthSum[first], _mm_add_epi32( _mm_madd_epi16( depth0, ones ), _mm_madd_epi16( depth1, ones ) ) );
+				depthMinimum[first] = _mm_min_epu16( depthMinimum[first], _mm_min_epu16( _mm_or_si128( depth0, unknown0 ), _mm_or_si128( depth1, unknown1 ) ) );
+				depthMaximum[first] = _mm_max_epu16( depthMaximum[first], _mm_max_epu16( depth0, depth1 ) );
+
+				// K̍ŏlƍől(ől( 31 - K )̍ŏl狁߂)
+				const __m128i bin0 = _mm_srli_epi16( value0, KINECT_PLAYER_INDEX_SHIFT + PLAYER_STATS_BIN_SHIFT );
+				const __m128i bin1 = _mm_srli_epi16( value1, KINECT_PLAYER_INDEX_SHIFT + PLAYER_STATS_BIN_SHIFT );
+				const int binLow = _mm_extract_epi16( _mm_minpos_epu16( _mm_min_epu16( bin0, bin1 ) ), 0 );
+				const int binHigh = PLAYER_STATS_BIN_COUNT - 1 - _mm_extract_epi16( _mm_minpos_epu16( _mm_sub_epi16( lastBin, _mm_max_epu16( bin0, bin1 ) ) ), 0 );
+				if( binLow == binHigh ){
+					playerStats.histogram[binLow] += 16;
+				}
+				else{
+					const __m128i bins = _mm_packus_epi16( bin0, bin1 );
+					for( int bin = binLow; bin <= binHigh; bin++ ){
+						playerStats.histogram[bin] += countBits( _mm_movemask_epi8( _mm_cmpeq_epi8( bins, _mm_set1_epi8( static_cast<char>( bin ) ) ) ) );
+					}
+				}
+			}
+			else{
+				// Player̋EAs̋E܂16f
+				int pixelX = x;
+				int pixelY = y;
+				for( int j = 0; j < 16; j++ ){
+					addStatsPixel( accumulator, src[i + j], pixelX, pixelY );
+					if( ++pixelX == width ){
+						pixelX = 0;
+						pixelY++;
+					}
+				}
+			}
+		}
+
+		// Player̉f16f͐ɔ΂
+		if( regions && _mm_movemask_epi8( isPlayer ) ){
+			uint8_t indices[16];
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( indices ), _mm_and_si128( index, isPlayer ) );
+			int x = i % width;
+			int y = i / width;
+			for( int j = 0; j < 16; j++ ){
+				if( indices[j] ){
+					addRegionPixel( *regions, indices[j], x, y );
+				}
+				if( ++x == width ){
+					x = 0;
+					y++;
+				}
+			}
+		}
+	}
+
+	// Player̃xNg܂Ƃ߂
+	if( stats ){
+		for( int index = 0; index <= KINECT_PLAYER_COUNT; index++ ){
+			PlayerStats& playerStats = accumulator.stats[index];
+			int32_t sum[4];
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( sum ), depthSum[index] );
+			playerStats.depthSum += sum[0] + sum[1] + sum[2] + sum[3];
+			const int minimum = _mm_extract_epi16( _mm_minpos_epu16( depthMinimum[index] ), 0 );
+			const int maximum = 0xffff - _mm_extract_epi16( _mm_minpos_epu16( _mm_xor_si128( depthMaximum[index], _mm_set1_epi16( -1 ) ) ), 0 );
+			if( minimum < playerStats.nearest ){
+				playerStats.nearest = static_cast<uint16_t>( minimum );
+			}
+			if( maximum > playerStats.farthest ){
+				playerStats.farthest = static_cast<uint16_t>( maximum );
+			}
+		}
+		accumulator.addTo( stats );
+	}
+
+	decodeScalar( src, output, i, end );
+}
+
+#endif
@@ -0,0 +1,125 @@
+// DepthDecoder.h : Depth&Playerf[^̃fR[h
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "KinectTypes.h"
+#include "Simd.h"
+
+
+// Player̉fƔ͈(CfbNX1`6g)
+// fR[hƂɈꏏɐ̂ŁȀPlayer͈̔͂ɍiƂɉ摜ǂݒȂĂ悢
+struct PlayerRegions
+{
+	int pixels[KINECT_PLAYER_COUNT + 1];
+	MaskRect bounds[KINECT_PLAYER_COUNT + 1];
+
+	PlayerRegions()
+	{
+		reset();
+	}
+
+	void reset();
+
+	// 摜̕ʂ̌̕ʂ(іɐʂ܂Ƃ߂)
+	void merge( const PlayerRegions& other );
+
+	// SĂPlayer̉fƁASĂPlayer܂ޔ͈
+	int getTotalPixels() const;
+	MaskRect getUnion() const;
+};
+
+// Player̓vDepth̃qXgO̊K(256mmA32K13rbg̑SĂ̋܂)
+static const int PLAYER_STATS_BIN_SHIFT = 8;
+static const int PLAYER_STATS_BIN_COUNT = KINECT_DEPTH_MM_COUNT >> PLAYER_STATS_BIN_SHIFT;
+
+// Player̓v(KINECT_PLAYER_COUNT + 1̔z1t[ACfbNX0Player̂Ȃf)
+// fR[hƂɈꏏɋ߂̂ŁA͂̂߂DepthǂݒȂĂ悢
+// ςł͂ȂaŎ̂ŁAіɋ߂ʂ̂܂ܑ킹(640~480܂ł̉摜ŃI[o[t[Ȃ)
+// L^t@Cɂ̂܂܏(RecordingWriter::writePlayerStats())
+struct PlayerStats
+{
+	uint32_t pixels;      // f
+	uint32_t depthPixels; // Depthvł(0łȂ)f
+	uint32_t sumX;        // W̘a(dS = sumX / pixels)
+	uint32_t sumY;
+	uint32_t depthSum;    // vłfDepth[mm]̘a
+	uint16_t nearest;     // vłf̍ł߂ADepth[mm](vłfƂ0)
+	uint16_t farthest;
+	uint32_t histogram[PLAYER_STATS_BIN_COUNT]; // Depth[mm]̊K̉f(0Ԗڂ̊K͌vłȂf܂)
+
+	PlayerStats()
+	{
+		reset();
+	}
+
+	void reset();
+
+	// 摜̕ʂ̌̕ʂ(іɋ߂ʂ܂Ƃ߂)
+	void merge( const PlayerStats& other );
+
+	// dS[pixel]Depth̕[mm](fƂ0)
+	float getCentroidX() const { return pixels ? static_cast<float>( static_cast<double>( sumX ) / pixels ) : 0.0f; }
+	float getCentroidY() const { return pixels ? static_cast<float>( static_cast<double>( sumY ) / pixels ) : 0.0f; }
+	float getMeanDepth() const { return depthPixels ? static_cast<float>( static_cast<double>( depthSum ) / depthPixels ) : 0.0f; }
+};
+
+// fR[hʂ̏o͐
+// svȏo͂nullptrɂĂ
+struct DepthDecodeOutput
+{
+	uint16_t* depth;   // Player̃rbg𗎂ƂDepth(& 0xFFF8)
+	uint8_t* depth8;   // 8rbgɕϊDepth(cv::Mat::convertTo( CV_8U, alpha, beta )Ɠ)
+	uint8_t* player;   // Player̐F(BGR)
+	uint8_t* mask;     // ꂩPlayer̗̈(PlayerȂ255AȊO0ACfbNX7͎gȂlȂ̂0)
+	uint8_t* playerMask[KINECT_PLAYER_COUNT + 1]; // Player̗̈(CfbNX1`6g)
+	PlayerRegions* regions; // Player̉fƔ͈(fR[hf̕)
+	PlayerStats* stats;     // Player̓v(KINECT_PLAYER_COUNT + 1̔zAfR[hf̕)
+	int width;              // 摜̕(regionsstats̍W߂ƂɎg)
+
+	DepthDecodeOutput()
+		: depth( nullptr ), depth8( nullptr ), player( nullptr ), mask( nullptr ), regions( nullptr ), stats( nullptr ), width( KINECT_IMAGE_WIDTH )
+	{
+		for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+			playerMask[i] = nullptr;
+		}
+	}
+};
+
+// 16rbgDepth&Playerf[^1񂾂ǂ݁ASĂ̏o͂1x̑ŏo
+// 8rbgւ̕ϊ͕_̐Ϙał͂ȂA16rbg̒l̂܂܈65536vf̕ϊe[uōs
+// Player̓v́A16fSēPlayer̂ƂSIMDł܂Ƃ߂ĐAE16f1f
+class DepthDecoder
+{
+public:
+	DepthDecoder();
+
+	// depth8̕ϊ saturate( ( Depth&Player̒l & ~PlayerIndex ) * alpha + beta )
+	void setDepthScale( double alpha, double beta );
+
+	// Player̐F(BGȐ7FA21oCg)
+	void setPlayerColors( const uint8_t* colors );
+
+	// gp閽߃Zbg(łCPUΉĂł߃Zbg)
+	void setSimdLevel( SimdLevel level ) { simdLevel = level; }
+
+	// f[begin, end)fR[h
+	void decode( const uint16_t* src, const DepthDecodeOutput& output, int begin, int end ) const;
+
+private:
+	void decodeScalar( const uint16_t* src, const DepthDecodeOutput& output, int begin, int end ) const;
+#ifdef KINECT_SIMD_X86
+	void decodeSse41( const uint16_t* src, const DepthDecodeOutput& output, int begin, int end ) const;
+#endif
+
+	SimdLevel simdLevel;
+
+	// Depth&Player̒l8rbg̒lւ̕ϊe[u
+	std::vector<uint8_t> depth8Table;
+
+	// Player̃CfbNX(3rbg)̐F
+	uint8_t playerColors[8][3];
+};
@@ -0,0 +1,120 @@
+// DepthPipeline.cpp : t[Depth̏(ʒu킹AfR[h)𕡐̃XbhŕS
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "DepthPipeline.h"
+#include <cstring>
+
+
+DepthPipeline::DepthPipeline( const RegistrationTable& table, ThreadPool* pool )
+	: table( table ), pool( pool ), simdLevel( getSimdLevel() )
+{
+	width = table.getWidth();
+	height = table.getHeight();
+
+	// Xbh1̑т󂯎
+	bandCount = pool ? pool->getThreadCount() : 1;
+	if( bandCount > height ){
+		bandCount = height;
+	}
+	if( bandCount > 1 ){
+		scratch.resize( bandCount );
+		for( int i = 0; i < bandCount; i++ ){
+			scratch[i].assign( width * height, 0 );
+		}
+		scratchFirst.assign( bandCount, 0 );
+		scratchLast.assign( bandCount, -1 );
+		bandRegions.resize( bandCount );
+		bandStats.resize( bandCount * ( KINECT_PLAYER_COUNT + 1 ) );
+	}
+}
+
+void DepthPipeline::process( const uint16_t* src, const DepthPipelineOutput& output )
+{
+	DepthPipelineOutput frameOutput = output;
+	frameOutput.width = width;
+	if( output.regions ){
+		output.regions->reset();
+	}
+	if( output.stats ){
+		for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+			output.stats[i].reset();
+		}
+	}
+
+	// 1XbĥƂ͍Ɨ̈g킸ɒڏ
+	if( bandCount == 1 ){
+		table.registerFrame( src, output.registered, simdLevel );
+		decoder.decode( output.registered, frameOutput, 0, width * height );
+		return;
+	}
+
+	pool->run( bandCount, [&]( int band, int ){
+		registerBand( src, band );
+	} );
+	pool->run( bandCount, [&]( int band, int ){
+		mergeBand( frameOutput, band );
+	} );
+	if( output.regions ){
+		for( int band = 0; band < bandCount; band++ ){
+			output.regions->merge( bandRegions[band] );
+		}
+	}
+	if( output.stats ){
+		for( int band = 0; band < bandCount; band++ ){
+			for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+				output.stats[i].merge( bandStats[band * ( KINECT_PLAYER_COUNT + 1 ) + i] );
+			}
+		}
+	}
+}
+
+void DepthPipeline::registerBand( const uint16_t* src, int band )
+{
+	// Ɨ̈͑Õt[̓̂Ƃ0ɖ߂Ă
+	const int rowBegin = height * band / bandCount;
+	const int rowEnd = height * ( band + 1 ) / bandCount;
+	table.registerRange( src, &scratch[band][0], rowBegin * width, rowEnd * width, simdLevel, &scratchFirst[band], &scratchLast[band] );
+}
+
+void DepthPipeline::mergeBand( const DepthPipelineOutput& output, int band )
+{
+	const int rowBegin = height * band / bandCount;
+	const int rowEnd = height * ( band + 1 ) / bandCount;
+	const int begin = rowBegin * width;
+	const int end = rowEnd * width;
+
+	uint16_t* dst = output.registered;
+	std::memset( dst + begin, 0, sizeof( uint16_t ) * ( end - begin ) );
+
+	// eƗ̈̂Ȃтɏ܂ꂽỎfcēAƗ̈0ɖ߂
+	for( int i = 0; i < bandCount; i++ ){
+		const int first = ( scratchFirst[i] > begin ) ? scratchFirst[i] : begin;
+		const int last = ( scratchLast[i] < end - 1 ) ? scratchLast[i] : end - 1;
+		uint16_t* work = &scratch[i][0];
+		for( int j = first; j <= last; j++ ){
+			const uint16_t value = work[j];
+			if( value != 0 ){
+				const uint16_t current = dst[j];
+				if( ( current == 0 ) || ( value < current ) ){
+					dst[j] = value;
+				}
+				work[j] = 0;
+			}
+		}
+	}
+
+	// Player̉fƔ͈́Av͑іɐāASĂ̑тɂ܂Ƃ߂
+	DepthPipelineOutput bandOutput = output;
+	if( output.regions ){
+		bandRegions[band].reset();
+		bandOutput.regions = &bandRegions[band];
+	}
+	if( output.stats ){
+		bandOutput.stats = &bandStats[band * ( KINECT_PLAYER_COUNT + 1 )];
+		for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+			bandOutput.stats[i].reset();
+		}
+	}
+	decoder.decode( output.registered, bandOutput, begin, end );
+}
@@ -0,0 +1,70 @@
+// DepthPipeline.h : t[Depth̏(ʒu킹AfR[h)𕡐̃XbhŕS
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Registration.h"
+#include "DepthDecoder.h"
+#include "ThreadPool.h"
+
+
+// ʂ̏o͐
+// 摜TCY͈ʒu킹e[uƓAsvȃfR[hʂnullptrɂĂ
+struct DepthPipelineOutput : public DepthDecodeOutput
+{
+	uint16_t* registered; // ʒu킹Depth&Player(K{)
+
+	DepthPipelineOutput()
+		: registered( nullptr )
+	{
+	}
+};
+
+// Depth̏sPʂ̑(^C)ɕāAXbhv[̃XbhŕS
+// 1. ʒu킹 : ϊ̑іɃXbh̍Ɨ̈ɏ
+// 2. ƃfR[h : ϊ̑іɁAƗ̈̒lỎfcēĂfR[h
+// ͏ޏԂɂȂ̂ŁAXbhɂ炸1XbhŏƂƓʂɂȂ
+class DepthPipeline
+{
+public:
+	// poolnullptr̂Ƃ͌ĂяoXbhŏ
+	DepthPipeline( const RegistrationTable& table, ThreadPool* pool = nullptr );
+
+	// depth8̕ϊ saturate( ( Depth&Player̒l & ~PlayerIndex ) * alpha + beta )
+	void setDepthScale( double alpha, double beta ) { decoder.setDepthScale( alpha, beta ); }
+
+	// Player̐F(BGȐ7FA21oCg)
+	void setPlayerColors( const uint8_t* colors ) { decoder.setPlayerColors( colors ); }
+
+	// gp閽߃Zbg(łCPUΉĂł߃Zbg)
+	void setSimdLevel( SimdLevel level ) { simdLevel = level; decoder.setSimdLevel( level ); }
+
+	// 1t[̏s
+	// output.regionsnƁAPlayer̉fƔ͈͂t[Ŝɂċ߂(іɐĂ܂Ƃ߂)
+	// output.statsnƁAPlayer̓v悤Ƀt[Ŝɂċ߂
+	void process( const uint16_t* src, const DepthPipelineOutput& output );
+
+private:
+	void registerBand( const uint16_t* src, int band );
+	void mergeBand( const DepthPipelineOutput& output, int band );
+
+	const RegistrationTable& table;
+	DepthDecoder decoder;
+	ThreadPool* pool;
+	SimdLevel simdLevel;
+	int width;
+	int height;
+	int bandCount;
+
+	// ϊ̑і̍Ɨ̈ƁA܂ꂽf̃CfbNX͈̔
+	std::vector< std::vector<uint16_t> > scratch;
+	std::vector<int> scratchFirst;
+	std::vector<int> scratchLast;
+
+	// іPlayer̉fƔ͈́Av(іKINECT_PLAYER_COUNT + 1)
+	std::vector<PlayerRegions> bandRegions;
+	std::vector<PlayerStats> bandStats;
+};
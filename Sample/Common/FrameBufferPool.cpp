@@ -0,0 +1,122 @@
+// FrameBufferPool.cpp : t[Ɏg摜obt@̍ėp
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "FrameBufferPool.h"
+#include <cstring>
+
+
+// obt@̒OALIGNMENToCgɁAǂBucket̃obt@L^Ă
+struct FrameBufferHeader
+{
+	int bucketIndex;
+};
+
+FrameBufferPool::FrameBufferPool()
+{
+	std::memset( &statistics, 0, sizeof( statistics ) );
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+	// ݂õobt@͕ԂꂽƂɉłȂ̂ŁAł͕Ԃꂽ̂
+	for( size_t i = 0; i < buckets.size(); i++ ){
+		for( size_t j = 0; j < buckets[i].available.size(); j++ ){
+			alignedFree( buckets[i].available[j] - ALIGNMENT );
+		}
+	}
+}
+
+int FrameBufferPool::findBucket( PixelFormat format, int width, int height )
+{
+	for( size_t i = 0; i < buckets.size(); i++ ){
+		if( ( buckets[i].format == format ) && ( buckets[i].width == width ) && ( buckets[i].height == height ) ){
+			return static_cast<int>( i );
+		}
+	}
+
+	Bucket bucket;
+	bucket.format = format;
+	bucket.width = width;
+	bucket.height = height;
+	bucket.size = static_cast<size_t>( width ) * height * getBytesPerPixel( format );
+	bucket.created = 0;
+	buckets.push_back( bucket );
+	return static_cast<int>( buckets.size() ) - 1;
+}
+
+uint8_t* FrameBufferPool::allocate( int bucketIndex )
+{
+	Bucket& bucket = buckets[bucketIndex];
+	const size_t alignment = ALIGNMENT;
+	uint8_t* base = static_cast<uint8_t*>( alignedAlloc( alignment + bucket.size, alignment ) );
+	if( !base ){
+		return nullptr;
+	}
+	reinterpret_cast<FrameBufferHeader*>( base )->bucketIndex = bucketIndex;
+
+	// ԋpavailableLтăq[vmۂȂ悤ɁAobt@̐eʂmۂĂ
+	bucket.created++;
+	bucket.available.reserve( bucket.created );
+
+	statistics.heapAllocations++;
+	statistics.bytesAllocated += bucket.size;
+	return base + alignment;
+}
+
+uint8_t* FrameBufferPool::acquire( PixelFormat format, int width, int height, bool clear )
+{
+	ScopedLock lock( mutex );
+	const int bucketIndex = findBucket( format, width, height );
+	Bucket& bucket = buckets[bucketIndex];
+
+	uint8_t* buffer = nullptr;
+	if( bucket.available.empty() ){
+		buffer = allocate( bucketIndex );
+		if( !buffer ){
+			return nullptr;
+		}
+	}
+	else{
+		buffer = bucket.available.back();
+		bucket.available.pop_back();
+	}
+
+	statistics.acquisitions++;
+	statistics.outstanding++;
+	if( clear ){
+		std::memset( buffer, 0, bucket.size );
+		statistics.clears++;
+	}
+	return buffer;
+}
+
+void FrameBufferPool::release( uint8_t* buffer )
+{
+	if( !buffer ){
+		return;
+	}
+	ScopedLock lock( mutex );
+	const int bucketIndex = reinterpret_cast<FrameBufferHeader*>( buffer - ALIGNMENT )->bucketIndex;
+	buckets[bucketIndex].available.push_back( buffer );
+	statistics.outstanding--;
+}
+
+void FrameBufferPool::reserve( PixelFormat format, int width, int height, int count )
+{
+	ScopedLock lock( mutex );
+	const int bucketIndex = findBucket( format, width, height );
+	while( static_cast<int>( buckets[bucketIndex].available.size() ) < count ){
+		uint8_t* buffer = allocate( bucketIndex );
+		if( !buffer ){
+			break;
+		}
+		buckets[bucketIndex].available.push_back( buffer );
+	}
+}
+
+FrameBufferPool::Statistics FrameBufferPool::getStatistics() const
+{
+	ScopedLock lock( mutex );
+	return statistics;
+}
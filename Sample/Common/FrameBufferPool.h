@@ -0,0 +1,119 @@
+// FrameBufferPool.h : t[Ɏg摜obt@̍ėp
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "Platform.h"
+
+
+// f̌`
+enum PixelFormat
+{
+	PIXEL_FORMAT_GRAY8 = 0, // 8rbg1`l(CV_8UC1)
+	PIXEL_FORMAT_DEPTH16,   // 16rbg1`l(CV_16UC1)
+	PIXEL_FORMAT_BGR24,     // 8rbg3`l(CV_8UC3)
+	PIXEL_FORMAT_BGRX32     // 8rbg4`l(CV_8UC4)
+};
+
+inline int getBytesPerPixel( PixelFormat format )
+{
+	switch( format ){
+		case PIXEL_FORMAT_DEPTH16:
+			return 2;
+		case PIXEL_FORMAT_BGR24:
+			return 3;
+		case PIXEL_FORMAT_BGRX32:
+			return 4;
+		default:
+			return 1;
+	}
+}
+
+// f̌`Ɖ𑜓xɁAACg𑵂摜obt@g
+// xmۂobt@͉Ɏ̃t[ōėp̂ŁAԂł̓q[v̊mۂNȂ
+// ̃Xbhg
+class FrameBufferPool
+{
+public:
+	// obt@̐擪̃ACg(LbVC̋EAAVX̃[h/XgAɂ\)
+	static const size_t ALIGNMENT = 64;
+
+	// v
+	struct Statistics
+	{
+		uint64_t heapAllocations; // obt@̂߂Ƀq[vmۂ
+		uint64_t acquisitions;    // acquire()̉
+		uint64_t clears;          // 0Ŗ߂
+		uint64_t bytesAllocated;  // mۂobt@̍vTCY[byte]
+		int outstanding;          // ݂õobt@̐
+	};
+
+	FrameBufferPool();
+	~FrameBufferPool();
+
+	// obt@؂AgIrelease()ŕԂ
+	// g͑OɎgƂ̂܂܂Ȃ̂ŁA0Ŗ߂KvƂcleartrueɂ
+	uint8_t* acquire( PixelFormat format, int width, int height, bool clear = false );
+
+	// ؂肽obt@Ԃ
+	void release( uint8_t* buffer );
+
+	// Ncount̃obt@mۂĂ
+	void reserve( PixelFormat format, int width, int height, int count );
+
+	Statistics getStatistics() const;
+
+private:
+	// f̌`Ɖ𑜓x̑g̃obt@
+	struct Bucket
+	{
+		PixelFormat format;
+		int width;
+		int height;
+		size_t size;
+		int created;
+		std::vector<uint8_t*> available;
+	};
+
+	int findBucket( PixelFormat format, int width, int height );
+	uint8_t* allocate( int bucketIndex );
+
+	std::vector<Bucket> buckets;
+	Statistics statistics;
+	mutable Mutex mutex;
+
+	FrameBufferPool( const FrameBufferPool& );
+	FrameBufferPool& operator=( const FrameBufferPool& );
+};
+
+// XR[v𔲂ƂɃv[֕Ԃobt@
+// cv::Mat( height, width, type, buffer.data() )̂悤ɕŎg
+class PooledFrameBuffer
+{
+public:
+	PooledFrameBuffer( FrameBufferPool& pool, PixelFormat format, int width, int height, bool clear = false )
+		: pool( pool ), buffer( pool.acquire( format, width, height, clear ) )
+	{
+	}
+
+	~PooledFrameBuffer()
+	{
+		pool.release( buffer );
+	}
+
+	uint8_t* data() const { return buffer; }
+
+	template<class T>
+	T* ptr() const { return reinterpret_cast<T*>( buffer ); }
+
+private:
+	FrameBufferPool& pool;
+	uint8_t* buffer;
+
+	PooledFrameBuffer( const PooledFrameBuffer& );
+	PooledFrameBuffer& operator=( const PooledFrameBuffer& );
+};
@@ -0,0 +1,484 @@
+// FrameProcessor.cpp : ClippingPlayer̃t[̏(EBhEZT[g킸Ɏsł)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "FrameProcessor.h"
+#include <algorithm>
+#include <cstring>
+#include "Metrics.h"
+
+
+void copyWithMask( const uint32_t* src, const uint8_t* mask, uint32_t* dst, int pixels )
+{
+	for( int i = 0; i < pixels; i++ ){
+		dst[i] = mask[i] ? src[i] : 0;
+	}
+}
+
+// rect̊Ỏf0ɂ(pixelSize1f̃oCg)
+static void clearOutside( uint8_t* image, int width, int height, int pixelSize, const MaskRect& rect )
+{
+	const int stride = width * pixelSize;
+	if( rect.isEmpty() ){
+		std::memset( image, 0, stride * height );
+		return;
+	}
+	std::memset( image, 0, stride * rect.top );
+	for( int y = rect.top; y < rect.bottom; y++ ){
+		uint8_t* row = image + y * stride;
+		std::memset( row, 0, rect.left * pixelSize );
+		std::memset( row + rect.right * pixelSize, 0, ( width - rect.right ) * pixelSize );
+	}
+	std::memset( image + rect.bottom * stride, 0, stride * ( height - rect.bottom ) );
+}
+
+// Õt[͈̔previouŝÃt[͈̔current̊O0Ŗ߂(ȊO͈̔͂̊O͑Õt[0ɂȂĂ)
+static void clearStale( uint8_t* image, int width, int pixelSize, const MaskRect& previous, const MaskRect& current )
+{
+	const int stride = width * pixelSize;
+	for( int y = previous.top; y < previous.bottom; y++ ){
+		uint8_t* row = image + y * stride;
+		if( current.isEmpty() || y < current.top || y >= current.bottom ){
+			std::memset( row + previous.left * pixelSize, 0, previous.getWidth() * pixelSize );
+			continue;
+		}
+		if( previous.left < current.left ){
+			std::memset( row + previous.left * pixelSize, 0, ( ( std::min )( previous.right, current.left ) - previous.left ) * pixelSize );
+		}
+		if( previous.right > current.right ){
+			const int left = ( std::max )( previous.left, current.right );
+			std::memset( row + left * pixelSize, 0, ( previous.right - left ) * pixelSize );
+		}
+	}
+}
+
+// ^C̑傫[f]
+static const int TILE_SIZE = 16;
+
+// ^C( left ` right, y )͈̔(摜̒[̃^C͏Ȃ)
+static MaskRect getTileRect( int left, int y, int right, int width, int height )
+{
+	MaskRect rect;
+	rect.left = left * TILE_SIZE;
+	rect.top = y * TILE_SIZE;
+	rect.right = ( std::min )( ( right + 1 ) * TILE_SIZE, width );
+	rect.bottom = ( std::min )( ( y + 1 ) * TILE_SIZE, height );
+	return rect;
+}
+
+// maskrect͈̔͂0ȊỎf邩(8oCgׂ)
+static bool hasMask( const uint8_t* mask, int width, const MaskRect& rect )
+{
+	for( int y = rect.top; y < rect.bottom; y++ ){
+		const uint8_t* row = mask + y * width;
+		uint64_t bits = 0;
+		int x = rect.left;
+		for( ; x + 8 <= rect.right; x += 8 ){
+			uint64_t word;
+			std::memcpy( &word, row + x, 8 );
+			bits |= word;
+		}
+		for( ; x < rect.right; x++ ){
+			bits |= row[x];
+		}
+		if( bits ){
+			return true;
+		}
+	}
+	return false;
+}
+
+// 2̃}XNׂāAႤf܂ރ^C1ɂ(ς^C̐Ԃ)
+// 1s̃^C̕(16oCg)8oCgׂ
+static int findChangedTiles( const uint8_t* a, const uint8_t* b, int width, int height, int tilesX, uint8_t* changed )
+{
+	const int tilesY = ( height + TILE_SIZE - 1 ) / TILE_SIZE;
+	std::memset( changed, 0, tilesX * tilesY );
+	for( int y = 0; y < height; y++ ){
+		const uint8_t* rowA = a + y * width;
+		const uint8_t* rowB = b + y * width;
+		uint8_t* tiles = changed + ( y / TILE_SIZE ) * tilesX;
+		for( int tx = 0; tx < tilesX; tx++ ){
+			const int left = tx * TILE_SIZE;
+			if( left + TILE_SIZE <= width ){
+				uint64_t a0, a1, b0, b1;
+				std::memcpy( &a0, rowA + left, 8 );
+				std::memcpy( &a1, rowA + left + 8, 8 );
+				std::memcpy( &b0, rowB + left, 8 );
+				std::memcpy( &b1, rowB + left + 8, 8 );
+				tiles[tx] |= ( ( a0 ^ b0 ) | ( a1 ^ b1 ) ) ? 1 : 0;
+			}
+			else if( std::memcmp( rowA + left, rowB + left, width - left ) != 0 ){
+				tiles[tx] = 1;
+			}
+		}
+	}
+	int count = 0;
+	for( int i = 0; i < tilesX * tilesY; i++ ){
+		count += changed[i];
+	}
+	return count;
+}
+
+// rect͈̔͂srcdstփRs[(pixelSize1f̃oCg)
+static void copyRect( const uint8_t* src, uint8_t* dst, int width, int pixelSize, const MaskRect& rect )
+{
+	const int stride = width * pixelSize;
+	const int offset = rect.left * pixelSize;
+	for( int y = rect.top; y < rect.bottom; y++ ){
+		std::memcpy( dst + y * stride + offset, src + y * stride + offset, rect.getWidth() * pixelSize );
+	}
+}
+
+// 2̉摜rect͈̔͂(pixelSize1f̃oCg)
+static bool isSameRect( const uint8_t* a, const uint8_t* b, int width, int pixelSize, const MaskRect& rect )
+{
+	const int stride = width * pixelSize;
+	const int offset = rect.left * pixelSize;
+	const int bytes = rect.getWidth() * pixelSize;
+	for( int y = rect.top; y < rect.bottom; y++ ){
+		if( std::memcmp( a + y * stride + offset, b + y * stride + offset, bytes ) != 0 ){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*----- ClippingProcessor -----*/
+
+ClippingProcessor::ClippingProcessor( const RegistrationTable& table, ThreadPool* pool )
+	: pipeline( table, pool ), width( table.getWidth() ), height( table.getHeight() ), iterationErode( 2 ), iterationDilate( 2 ), shape( MORPHOLOGY_RECT ), regionOfInterest( true ), playerStatsEnabled( false ),
+	  incremental( false ), hasPrevious( false ), previousErode( 0 ), previousDilate( 0 ), previousShape( MORPHOLOGY_RECT ), frameNumber( 0 ),
+	  tilesX( ( width + TILE_SIZE - 1 ) / TILE_SIZE ), tilesY( ( height + TILE_SIZE - 1 ) / TILE_SIZE ), changedTiles( 0 ), updatedTiles( 0 ), copiedTiles( 0 ), nextOutput( 0 )
+{
+	std::memset( outputs, 0, sizeof( outputs ) );
+	registeredBuffer.resize( width * height );
+	bitMask.create( width, height );
+}
+
+void ClippingProcessor::setIncremental( bool enable )
+{
+	if( enable == incremental ){
+		return;
+	}
+	incremental = enable;
+	hasPrevious = false;
+	std::memset( outputs, 0, sizeof( outputs ) );
+
+	// Ɨ͍̈ŏɗLɂƂɊmۂ
+	if( enable && rawMask.empty() ){
+		const int pixels = width * height;
+		rawMask.resize( pixels );
+		previousRawMask.resize( pixels );
+		resultMask.resize( pixels );
+		resultClip.resize( pixels * 4 );
+		previousColor.resize( pixels * 4 );
+		windowMask.resize( pixels );
+		tileChanged.resize( tilesX * tilesY );
+		tileDirty.resize( tilesX * tilesY );
+		tileOccupied.resize( tilesX * tilesY );
+		tileCopied.resize( tilesX * tilesY );
+		tileStack.reserve( tilesX * tilesY );
+		tileMaskFrame.resize( tilesX * tilesY );
+		tileClipFrame.resize( tilesX * tilesY );
+	}
+}
+
+void ClippingProcessor::process( const uint16_t* depth, const uint8_t* color, uint8_t* mask, uint8_t* clip, uint16_t* registered )
+{
+	DepthPipelineOutput depthOutput;
+	depthOutput.registered = registered ? registered : &registeredBuffer[0];
+	depthOutput.mask = incremental ? &rawMask[0] : mask; // Player̉f255(0xff)
+	depthOutput.regions = &regions;
+	depthOutput.stats = playerStatsEnabled ? playerStats : nullptr;
+	{
+		ScopedMetric metric( METRIC_REGISTER );
+		pipeline.process( depth, depthOutput );
+	}
+
+
+	// }XN𐮂Đ؂蔲i(ʂ̃Rs[܂)
+	ScopedMetric metric( METRIC_MORPH );
+	if( !incremental ){
+		processFrame( color, mask, clip );
+		return;
+	}
+
+	// ʂ͓̃obt@ɕێāÃt[ŕςȂ^CɎg
+	frameNumber++;
+	if( !hasPrevious || previousErode != iterationErode || previousDilate != iterationDilate || previousShape != shape ){
+		std::memcpy( &resultMask[0], &rawMask[0], width * height );
+		processFrame( color, &resultMask[0], &resultClip[0] );
+		std::memcpy( &previousColor[0], color, width * height * 4 );
+		for( int ty = 0; ty < tilesY; ty++ ){
+			for( int tx = 0; tx < tilesX; tx++ ){
+				tileOccupied[ty * tilesX + tx] = hasMask( &resultMask[0], width, getTileRect( tx, ty, tx, width, height ) ) ? 1 : 0;
+			}
+		}
+		hasPrevious = true;
+		previousErode = iterationErode;
+		previousDilate = iterationDilate;
+		previousShape = shape;
+		changedTiles = updatedTiles = copiedTiles = tilesX * tilesY;
+		std::fill( tileMaskFrame.begin(), tileMaskFrame.end(), frameNumber );
+		std::fill( tileClipFrame.begin(), tileClipFrame.end(), frameNumber );
+	}
+	else{
+		processTiles( color );
+		for( int tile = 0; tile < tilesX * tilesY; tile++ ){
+			if( tileDirty[tile] ){
+				tileMaskFrame[tile] = frameNumber;
+			}
+			if( tileCopied[tile] ){
+				tileClipFrame[tile] = frameNumber;
+			}
+		}
+	}
+	rawMask.swap( previousRawMask );
+
+	// ȑOɏ񂾃obt@ɂ́ÂƂȍ~ɏ^C
+	OutputBuffer* output = nullptr;
+	for( int i = 0; i < OUTPUT_BUFFER_COUNT && !output; i++ ){
+		if( outputs[i].frame != 0 && outputs[i].mask == mask && outputs[i].clip == clip ){
+			output = &outputs[i];
+		}
+	}
+	if( output ){
+		for( int ty = 0; ty < tilesY; ty++ ){
+			for( int tx = 0; tx < tilesX; tx++ ){
+				const MaskRect rect = getTileRect( tx, ty, tx, width, height );
+				if( tileMaskFrame[ty * tilesX + tx] > output->frame ){
+					copyRect( &resultMask[0], mask, width, 1, rect );
+				}
+				if( tileClipFrame[ty * tilesX + tx] > output->frame ){
+					copyRect( &resultClip[0], clip, width, 4, rect );
+				}
+			}
+		}
+	}
+	else{
+		std::memcpy( mask, &resultMask[0], width * height );
+		std::memcpy( clip, &resultClip[0], width * height * 4 );
+		output = &outputs[nextOutput];
+		nextOutput = ( nextOutput + 1 ) % OUTPUT_BUFFER_COUNT;
+		output->mask = mask;
+		output->clip = clip;
+	}
+	output->frame = frameNumber;
+}
+
+void ClippingProcessor::processFrame( const uint8_t* color, uint8_t* mask, uint8_t* clip )
+{
+	// ͈
+	// ͈͂̊Ỏf́Akł̓}XN̊O(1)ƂĈ邪A͈͂̒[erodefȓ̉f͖c0Ȃ̂ŌʂɉeȂ
+	processedRect = MaskRect();
+	if( regionOfInterest ){
+		const int padding = ( std::max )( iterationErode, 0 ) + 2 * ( std::max )( iterationDilate, 0 );
+		processedRect = regions.getUnion().inflate( padding, width, height );
+	}
+	else{
+		processedRect.right = width;
+		processedRect.bottom = height;
+	}
+
+	// PlayerȂƂ̓}XN(fR[hőS0ɂȂĂ)؂蔲Color0
+	if( processedRect.isEmpty() ){
+		std::memset( clip, 0, width * height * 4 );
+		return;
+	}
+
+	const int offset = processedRect.top * width + processedRect.left;
+	bitMask.create( processedRect.getWidth(), processedRect.getHeight() );
+	bitMask.pack( mask + offset, width );
+
+	// Mathematical Morphology - opening
+	bitMask.erode( iterationErode, shape );
+	bitMask.dilate( iterationDilate, shape );
+
+	// Mathematical Morphology - closing
+	bitMask.dilate( iterationDilate, shape );
+	bitMask.erode( iterationErode, shape );
+
+	// }XN̉fColorRs[A\}XNo(͈͂̊Õ}XN̓fR[h0ɂȂĂ)
+	bitMask.copyPixels( reinterpret_cast<const uint32_t*>( color ) + offset, reinterpret_cast<uint32_t*>( clip ) + offset, width );
+	bitMask.unpack( mask + offset, width );
+	clearOutside( clip, width, height, 4, processedRect );
+}
+
+void ClippingProcessor::processTiles( const uint8_t* color )
+{
+	// Player̗̈悪ς^C
+	changedTiles = findChangedTiles( &rawMask[0], &previousRawMask[0], width, height, tilesX, &tileChanged[0] );
+
+	// openingAclosinǧʂ́A4̎kƖc( k̉ + c̉ ) ~ 2fꂽf܂ŉe󂯂
+	// ς^C炻͈̔͂̃^C蒼(Ac̏ɍL)
+	const int reach = 2 * ( std::max )( iterationErode, 0 ) + 2 * ( std::max )( iterationDilate, 0 );
+	const int haloTiles = ( reach + TILE_SIZE - 1 ) / TILE_SIZE;
+	for( int ty = 0; ty < tilesY; ty++ ){
+		for( int tx = 0; tx < tilesX; tx++ ){
+			uint8_t dirty = 0;
+			for( int x = ( std::max )( tx - haloTiles, 0 ); x <= ( std::min )( tx + haloTiles, tilesX - 1 ) && !dirty; x++ ){
+				dirty = tileChanged[ty * tilesX + x];
+			}
+			tileDirty[ty * tilesX + tx] = dirty;
+		}
+	}
+	for( int tx = 0; tx < tilesX; tx++ ){
+		for( int ty = 0; ty < tilesY; ty++ ){
+			uint8_t dirty = 0;
+			for( int y = ( std::max )( ty - haloTiles, 0 ); y <= ( std::min )( ty + haloTiles, tilesY - 1 ) && !dirty; y++ ){
+				dirty = tileDirty[y * tilesX + tx];
+			}
+			tileChanged[ty * tilesX + tx] = dirty;
+		}
+	}
+	tileDirty.swap( tileChanged );
+
+	// 蒼^ĈȂ򖈂ɁA܂ދ`reachfL͈͂ŏ
+	// L͈͂̊Ỏf͎ۂ̒lƈႤlƂĈ邪Ảereachf܂łȂ̂ŁA`͈̔͂̌ʂ͕ςȂ
+	// (`Ɋ܂܂蒼Ȃ^CAÕt[ƓʂɂȂ)
+	updatedTiles = 0;
+	for( int start = 0; start < tilesX * tilesY; start++ ){
+		if( tileDirty[start] != 1 ){
+			continue;
+		}
+
+		// HĔ͈͂߂(H^C2ɂ)
+		int left = start % tilesX;
+		int right = left;
+		int top = start / tilesX;
+		int bottom = top;
+		tileStack.clear();
+		tileStack.push_back( start );
+		tileDirty[start] = 2;
+		while( !tileStack.empty() ){
+			const int tile = tileStack.back();
+			tileStack.pop_back();
+			updatedTiles++;
+			const int tx = tile % tilesX;
+			const int ty = tile / tilesX;
+			left = ( std::min )( left, tx );
+			right = ( std::max )( right, tx );
+			top = ( std::min )( top, ty );
+			bottom = ( std::max )( bottom, ty );
+			const int neighbors[4] = { ( tx > 0 ) ? tile - 1 : -1, ( tx < tilesX - 1 ) ? tile + 1 : -1, ( ty > 0 ) ? tile - tilesX : -1, ( ty < tilesY - 1 ) ? tile + tilesX : -1 };
+			for( int i = 0; i < 4; i++ ){
+				if( neighbors[i] >= 0 && tileDirty[neighbors[i]] == 1 ){
+					tileDirty[neighbors[i]] = 2;
+					tileStack.push_back( neighbors[i] );
+				}
+			}
+		}
+
+		MaskRect rect = getTileRect( left, top, right, width, height );
+		rect.bottom = getTileRect( left, bottom, right, width, height ).bottom;
+		const MaskRect window = rect.inflate( reach, width, height );
+		const int windowWidth = window.getWidth();
+		bitMask.create( windowWidth, window.getHeight() );
+		bitMask.pack( &rawMask[window.top * width + window.left], width );
+
+		// Mathematical Morphology - opening
+		bitMask.erode( iterationErode, shape );
+		bitMask.dilate( iterationDilate, shape );
+
+		// Mathematical Morphology - closing
+		bitMask.dilate( iterationDilate, shape );
+		bitMask.erode( iterationErode, shape );
+
+		bitMask.unpack( &windowMask[0], windowWidth );
+		for( int y = rect.top; y < rect.bottom; y++ ){
+			std::memcpy( &resultMask[y * width + rect.left], &windowMask[( y - window.top ) * windowWidth + rect.left - window.left], rect.getWidth() );
+		}
+	}
+
+	// }XN蒼^CƁA}XNColorς^C؂蔲
+	copiedTiles = 0;
+	for( int ty = 0; ty < tilesY; ty++ ){
+		for( int tx = 0; tx < tilesX; tx++ ){
+			const int tile = ty * tilesX + tx;
+			const MaskRect rect = getTileRect( tx, ty, tx, width, height );
+			tileCopied[tile] = 0;
+			if( tileDirty[tile] ){
+				tileOccupied[tile] = hasMask( &resultMask[0], width, rect ) ? 1 : 0;
+			}
+			else if( !tileOccupied[tile] || isSameRect( color, &previousColor[0], width, 4, rect ) ){
+				continue;
+			}
+
+			for( int y = rect.top; y < rect.bottom; y++ ){
+				const int offset = y * width + rect.left;
+				copyWithMask( reinterpret_cast<const uint32_t*>( color ) + offset, &resultMask[offset], reinterpret_cast<uint32_t*>( &resultClip[0] ) + offset, rect.getWidth() );
+				std::memcpy( &previousColor[offset * 4], color + offset * 4, rect.getWidth() * 4 );
+			}
+			tileCopied[tile] = 1;
+			copiedTiles++;
+		}
+	}
+}
+
+
+/*----- PlayerProcessor -----*/
+
+PlayerProcessor::PlayerProcessor( const RegistrationTable& table, ThreadPool* pool )
+	: pipeline( table, pool ), width( table.getWidth() ), height( table.getHeight() ), regionOfInterest( false ), playerStatsEnabled( false ), lastPlayer( nullptr )
+{
+	registeredBuffer.resize( width * height );
+
+	// 8rbgDepth͋߂قǖ邭
+	pipeline.setDepthScale( -255.0f / KINECT_DEPTH_MAXIMUM_VALUE, 255.0f );
+
+	// J[e[u(BGR)
+	static const uint8_t colors[( KINECT_PLAYER_COUNT + 1 ) * 3] = {
+		  0,   0,   0,
+		255,   0,   0,
+		  0, 255,   0,
+		  0,   0, 255,
+		255, 255,   0,
+		255,   0, 255,
+		  0, 255, 255
+	};
+	pipeline.setPlayerColors( colors );
+	colorDecoder.setPlayerColors( colors );
+}
+
+void PlayerProcessor::process( const uint16_t* depth, uint8_t* depth8, uint8_t* player, uint16_t* registered )
+{
+	DepthPipelineOutput depthOutput;
+	depthOutput.registered = registered ? registered : &registeredBuffer[0];
+	depthOutput.depth8 = depth8;
+	depthOutput.regions = &regions;
+	depthOutput.stats = playerStatsEnabled ? playerStats : nullptr;
+
+	// Õt[Player͈̔͂t[̔ȏ̂Ƃ́AFtfR[hƈꏏɃt[Ŝōs
+	const MaskRect previous = regions.getUnion();
+	const bool limited = regionOfInterest && ( previous.getWidth() * previous.getHeight() * 2 < width * height );
+	if( !limited ){
+		depthOutput.player = player;
+	}
+
+	ScopedMetric metric( METRIC_REGISTER );
+	pipeline.process( depth, depthOutput );
+	if( !limited ){
+		lastPlayer = nullptr;
+		return;
+	}
+
+	// ʒu킹Depth&PlayerAPlayerSĊ܂ޔ͈͂̍sɐFt(͈͂̊OPlayer̃CfbNX0Ȃ̂ō)
+	const MaskRect rect = regions.getUnion();
+	DepthDecodeOutput colorOutput;
+	colorOutput.player = player;
+	for( int y = rect.top; y < rect.bottom; y++ ){
+		colorDecoder.decode( depthOutput.registered, colorOutput, y * width + rect.left, y * width + rect.right );
+	}
+
+	// Õt[Ɠobt@́AÕt[͈̔͂̂̃t[͈̔͂̊O0Ŗ߂
+	if( player == lastPlayer ){
+		clearStale( player, width, 3, lastRect, rect );
+	}
+	else{
+		clearOutside( player, width, height, 3, rect );
+	}
+	lastPlayer = player;
+	lastRect = rect;
+}
@@ -0,0 +1,168 @@
+// FrameProcessor.h : ClippingPlayer̃t[̏(EBhEZT[g킸Ɏsł)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "DepthPipeline.h"
+#include "BitMask.h"
+
+
+// mask0ȊỎfsrcdstփRs[AȊO0ɂ(colorMat.copyTo( clipMat, maskMat )ƓA4oCg̉f)
+void copyWithMask( const uint32_t* src, const uint8_t* mask, uint32_t* dst, int pixels );
+
+// Clipping̏
+// Depth&Playerʒu킹Player̗̈}XNɂAopeningAclosingŐĂColor؂蔲
+// openingAclosingƐ؂蔲1rbg̃}XN(BitMask)ōsAŌ8rbg̃}XN֏o
+class ClippingProcessor
+{
+public:
+	// poolnullptr̂Ƃ͌ĂяoXbhŏ
+	ClippingProcessor( const RegistrationTable& table, ThreadPool* pool = nullptr );
+
+	// kƖc̉(Clipping̃gbNo[̒lAl͂ǂ2)
+	void setIterations( int erode, int dilate ) { iterationErode = erode; iterationDilate = dilate; }
+
+	// kƖc̍\vf̌`(łMORPHOLOGY_RECTAԂ͉񐔂ɂ炸قڈ)
+	void setShape( MorphologyShape shape ) { this->shape = shape; }
+
+	// kƖcA؂蔲Player͈̔͂̎ӂōs(ł͗L)
+	// PlayerSĊ܂ޔ͈͂( k̉ + c̉ ~ 2 )fL͈͂̊ÓA}XN؂蔲ColorK0ɂȂ̂Ōʂ͕ςȂ
+	// ɂƃt[Ŝ
+	void setRegionOfInterest( bool enable ) { regionOfInterest = enable; }
+	bool getRegionOfInterest() const { return regionOfInterest; }
+
+	// Õt[Player̉fƔ͈(fR[hŋ߂)A͈
+	const PlayerRegions& getRegions() const { return regions; }
+	const MaskRect& getProcessedRect() const { return processedRect; }
+
+	// fR[ĥƂPlayer̓v߂(ł͖)
+	// Õt[̓vgetPlayerStats()Ŏ擾(KINECT_PLAYER_COUNT + 1̔zAʒu킹Depth&Player̓v)
+	void setPlayerStats( bool enable ) { playerStatsEnabled = enable; }
+	const PlayerStats* getPlayerStats() const { return playerStats; }
+
+	// Õt[̌ʂێAPlayer̗̈悩Colorς16~16f̃^C(ł͖)
+	// Õt[Player̗̈悪ς^CkƖc͈͂͂̃^CopeningAclosing蒼A
+	// }XNς^CƁA}XN^ĈColorς^C؂蔲(ʂ̓t[ŜƂƓ)
+	// ŏ̃t[ƁAkƖc̉񐔂`ςƂ̓t[Ŝ
+	// ʂ͓ɕێmaskclipփRs[
+	// ȑOɓnƂ̂obt@(OUTPUT_BUFFER_COUNTg܂ŁApCvCŏԂɎg̃obt@ł悢)ɂ́A
+	// ̃obt@ɏ񂾌ŏ^CRs[̂ŁAĂяoŃobt@Ȃ
+	// ʒu킹ƃfR[h͖t[ŜōŝŁAȂ͎̂kƖcA؂蔲̕
+	void setIncremental( bool enable );
+	bool getIncremental() const { return incremental; }
+
+	// Õt[ŁAPlayer̗̈悪ς^CAopeningAclosing蒼^CA؂蔲^C̐
+	int getTileCount() const { return tilesX * tilesY; }
+	int getChangedTileCount() const { return changedTiles; }
+	int getUpdatedTileCount() const { return updatedTiles; }
+	int getCopiedTileCount() const { return copiedTiles; }
+
+	// depth : Depth&PlayerAcolor : BGRXColor
+	// mask : Player̗̈(PlayerȂ255)Aclip : ؂蔲Color(BGRXÄ̊O0)
+	// registerednƈʒu킹Depth&Playero(nullptr̂Ƃ͓̃obt@g)
+	// ʒu킹ƃfR[h̎ԂMETRIC_REGISTERAkƖcƐ؂蔲(ʂ̃Rs[܂)̎ԂMETRIC_MORPHɋL^
+	void process( const uint16_t* depth, const uint8_t* color, uint8_t* mask, uint8_t* clip, uint16_t* registered = nullptr );
+
+private:
+	// fR[hmaskopeningAclosingŐclip؂蔲(Player͈̔͂̎ӂt[S)
+	void processFrame( const uint8_t* color, uint8_t* mask, uint8_t* clip );
+
+	// rawMaskƑÕt[ׂāAς^CresultMaskresultClipXV
+	void processTiles( const uint8_t* color );
+
+	DepthPipeline pipeline;
+	BitMask bitMask;
+	int width;
+	int height;
+	int iterationErode;
+	int iterationDilate;
+	MorphologyShape shape;
+	bool regionOfInterest;
+	PlayerRegions regions;
+	MaskRect processedRect;
+	bool playerStatsEnabled;
+	PlayerStats playerStats[KINECT_PLAYER_COUNT + 1];
+	std::vector<uint16_t> registeredBuffer;
+
+	// ^C̏̏
+	bool incremental;
+	bool hasPrevious;       // Õt[̌ʂ邩
+	int previousErode;      // Õt[̌ʂkƖc̉񐔂ƌ`
+	int previousDilate;
+	MorphologyShape previousShape;
+	uint32_t frameNumber;   // t[̔ԍ(1)
+	int tilesX;
+	int tilesY;
+	int changedTiles;
+	int updatedTiles;
+	int copiedTiles;
+	std::vector<uint8_t> rawMask;         // fR[h}XN
+	std::vector<uint8_t> previousRawMask; // Õt[̃fR[h}XN
+	std::vector<uint8_t> resultMask;      // openingAclosingŐ}XN
+	std::vector<uint8_t> resultClip;      // ؂蔲Color
+	std::vector<uint8_t> previousColor;   // ^CɍŌɐ؂蔲ƂColor
+	std::vector<uint8_t> windowMask;      // ͈͂̃}XN
+	std::vector<uint8_t> tileChanged;     // Player̗̈悪ς^C
+	std::vector<uint8_t> tileDirty;       // openingAclosing蒼^C
+	std::vector<uint8_t> tileOccupied;    // }XN^C
+	std::vector<uint8_t> tileCopied;      // ؂蔲^C
+	std::vector<int> tileStack;           // HƂ̃^C
+	std::vector<uint32_t> tileMaskFrame;  // ^CɍŌɃ}XNt[̔ԍ
+	std::vector<uint32_t> tileClipFrame;  // ^CɍŌɐ؂蔲Colort[̔ԍ
+
+	// ʂ񂾃obt@ƁÂƂ̃t[̔ԍ(0͖gp)
+	static const int OUTPUT_BUFFER_COUNT = 8;
+	struct OutputBuffer
+	{
+		uint8_t* mask;
+		uint8_t* clip;
+		uint32_t frame;
+	};
+	OutputBuffer outputs[OUTPUT_BUFFER_COUNT];
+	int nextOutput; // Vobt@Œuʒu
+};
+
+// Playeȑ
+// Depth&Playerʒu킹āA8rbgDepthPlayerɐFt摜ɂ
+class PlayerProcessor
+{
+public:
+	// poolnullptr̂Ƃ͌ĂяoXbhŏ
+	PlayerProcessor( const RegistrationTable& table, ThreadPool* pool = nullptr );
+
+	// Player̐FtPlayerSĊ܂ޔ͈͂ōs(ł͖A͈͂̊O͍)
+	// Õt[Ɠobt@nƂ́AÕt[͈̔͂̂̃t[͈̔͂̊O0Ŗ߂̂ŁAĂяoŃobt@Ȃ
+	// fR[h̓t[ŜōŝŁAȂ̂PlayerȂƂ(傫Playerł͔͈͂2񑖍镪xȂ)
+	// ɂ邩AÕt[Player͈̔͂t[̔ȏ̂Ƃ́At[ŜfR[hƂɈꏏɐFt
+	void setRegionOfInterest( bool enable ) { regionOfInterest = enable; }
+	bool getRegionOfInterest() const { return regionOfInterest; }
+
+	// Õt[Player̉fƔ͈
+	const PlayerRegions& getRegions() const { return regions; }
+
+	// fR[ĥƂPlayer̓v߂(ł͖AClippingProcessorƓ)
+	void setPlayerStats( bool enable ) { playerStatsEnabled = enable; }
+	const PlayerStats* getPlayerStats() const { return playerStats; }
+
+	// depth : Depth&Player
+	// depth8 : 8rbgDepth(߂قǖ邢)Aplayer : Player̐F(BGR)
+	// registerednƈʒu킹Depth&Playero(nullptr̂Ƃ͓̃obt@g)
+	// ̎ԂMETRIC_REGISTERɋL^
+	void process( const uint16_t* depth, uint8_t* depth8, uint8_t* player, uint16_t* registered = nullptr );
+
+private:
+	DepthPipeline pipeline;
+	DepthDecoder colorDecoder; // Player͈̔͂̐Ft
+	int width;
+	int height;
+	bool regionOfInterest;
+	PlayerRegions regions;
+	bool playerStatsEnabled;
+	PlayerStats playerStats[KINECT_PLAYER_COUNT + 1];
+	std::vector<uint16_t> registeredBuffer;
+	uint8_t* lastPlayer; // Õt[Ŕ͈͂ɐFtobt@
+	MaskRect lastRect;   // ͈̔
+};
@@ -0,0 +1,159 @@
+// FrameRing.cpp : ZT[擾t[ێ郊Oobt@
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "FrameRing.h"
+#include <cstring>
+
+
+/*----- FrameHandle -----*/
+
+FrameHandle::FrameHandle()
+	: slot( nullptr )
+{
+}
+
+FrameHandle::FrameHandle( const FrameHandle& other )
+	: slot( other.slot )
+{
+	if( slot ){
+		atomicAdd( &slot->references, 1 );
+	}
+}
+
+FrameHandle::~FrameHandle()
+{
+	reset();
+}
+
+FrameHandle& FrameHandle::operator=( const FrameHandle& other )
+{
+	if( slot != other.slot ){
+		reset();
+		slot = other.slot;
+		if( slot ){
+			atomicAdd( &slot->references, 1 );
+		}
+	}
+	return *this;
+}
+
+void FrameHandle::reset()
+{
+	if( slot ){
+		atomicAdd( &slot->references, -1 );
+		slot = nullptr;
+	}
+}
+
+
+/*----- FrameRing -----*/
+
+FrameRing::FrameRing( PixelFormat format, int width, int height, int capacity )
+	: format( format ), width( width ), height( height ), next( 0 )
+{
+	std::memset( &statistics, 0, sizeof( statistics ) );
+
+	// SẴXbgNɊmۂ(t[Ƀq[vmۂȂ)
+	const size_t size = static_cast<size_t>( width ) * height * getBytesPerPixel( format );
+	const size_t alignment = FrameBufferPool::ALIGNMENT;
+	slots.resize( capacity > 0 ? capacity : 1 );
+	for( size_t i = 0; i < slots.size(); i++ ){
+		slots[i].data = static_cast<uint8_t*>( alignedAlloc( size, alignment ) );
+		std::memset( &slots[i].info, 0, sizeof( slots[i].info ) );
+		slots[i].info.format = format;
+		slots[i].info.width = width;
+		slots[i].info.height = height;
+		slots[i].references = 0;
+	}
+}
+
+FrameRing::~FrameRing()
+{
+	for( size_t i = 0; i < slots.size(); i++ ){
+		alignedFree( slots[i].data );
+	}
+}
+
+bool FrameRing::write( const uint8_t* src, int pitch, uint32_t frameNumber, int64_t timestamp, FrameHandle& handle )
+{
+	handle.reset();
+
+	ScopedLock lock( mutex );
+
+	// ̃Xbg珇ɁAǂ̃nhQƂĂȂXbgT
+	const int capacity = static_cast<int>( slots.size() );
+	FrameSlot* slot = nullptr;
+	for( int i = 0; i < capacity; i++ ){
+		FrameSlot& candidate = slots[( next + i ) % capacity];
+		if( atomicAdd( &candidate.references, 0 ) == 0 ){
+			slot = &candidate;
+			next = ( next + i + 1 ) % capacity;
+			break;
+		}
+		statistics.heldSkips++;
+	}
+	if( !slot || !slot->data ){
+		statistics.overflows++;
+		return false;
+	}
+
+	// s̒Ȃ1xɃRs[
+	const size_t rowBytes = static_cast<size_t>( width ) * getBytesPerPixel( format );
+	if( static_cast<size_t>( pitch ) == rowBytes ){
+		std::memcpy( slot->data, src, rowBytes * height );
+	}
+	else{
+		for( int y = 0; y < height; y++ ){
+			std::memcpy( slot->data + rowBytes * y, src + static_cast<size_t>( pitch ) * y, rowBytes );
+		}
+	}
+	slot->info.frameNumber = frameNumber;
+	slot->info.timestamp = timestamp;
+
+	// 񂾃Xbgnh֓n
+	atomicAdd( &slot->references, 1 );
+	handle.slot = slot;
+
+	statistics.written++;
+	return true;
+}
+
+FrameRing::Statistics FrameRing::getStatistics() const
+{
+	ScopedLock lock( mutex );
+	return statistics;
+}
+
+
+/*----- FrameDropCounter -----*/
+
+FrameDropCounter::FrameDropCounter()
+{
+	reset();
+}
+
+void FrameDropCounter::reset()
+{
+	started = false;
+	lastFrameNumber = 0;
+	received = 0;
+	dropped = 0;
+}
+
+void FrameDropCounter::update( uint32_t frameNumber )
+{
+	received++;
+	if( started && ( frameNumber > lastFrameNumber ) ){
+		dropped += frameNumber - lastFrameNumber - 1;
+	}
+	// ŏ̃t[ƁAXg[JĔԍ߂Ƃ͐n߂
+	started = true;
+	lastFrameNumber = frameNumber;
+}
+
+double FrameDropCounter::getDropRate() const
+{
+	const uint64_t total = received + dropped;
+	return total ? static_cast<double>( dropped ) / total : 0.0;
+}
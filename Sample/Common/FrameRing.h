@@ -0,0 +1,116 @@
+// FrameRing.h : ZT[擾t[ێ郊Oobt@
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Platform.h"
+#include "FrameBufferPool.h"
+
+
+// t[̏
+struct FrameInfo
+{
+	uint32_t frameNumber; // t[ԍ(NUI_IMAGE_FRAME::dwFrameNumber)
+	int64_t timestamp;    // ^CX^v[ms](NUI_IMAGE_FRAME::liTimeStamp)
+	PixelFormat format;
+	int width;
+	int height;
+};
+
+// Oobt@1t[̗̈
+struct FrameSlot
+{
+	uint8_t* data;
+	FrameInfo info;
+	volatile long references; // ̃XbgQƂĂFrameHandle̐
+};
+
+// Oobt@̃t[ւ̎QƃJEgt̃nh
+// Rs[Ɠt[QƂASẴnhȂƃXbgėp
+// nh͌FrameRingɔj邱
+class FrameHandle
+{
+public:
+	FrameHandle();
+	FrameHandle( const FrameHandle& other );
+	~FrameHandle();
+	FrameHandle& operator=( const FrameHandle& other );
+
+	// QƂ߂
+	void reset();
+
+	bool empty() const { return slot == nullptr; }
+	uint8_t* data() const { return slot ? slot->data : nullptr; }
+	const FrameInfo& info() const { return slot->info; }
+
+	template<class T>
+	T* ptr() const { return reinterpret_cast<T*>( data() ); }
+
+private:
+	friend class FrameRing;
+
+	FrameSlot* slot;
+};
+
+// ZT[̃t[Rs[ĕێÑOobt@
+// Rs[ɃZT[̃t[ł̂ŁAhCõL[(ʏ2t[)𒷂LȂ
+// ŕێĂ(nhcĂ)Xbg͏㏑ɔ΂āA̋󂢂ĂXbgփRs[
+class FrameRing
+{
+public:
+	// v
+	struct Statistics
+	{
+		uint64_t written;   // Rs[t[̐
+		uint64_t heldSkips; // ێĂ̂Ŕ΂Xbg̐
+		uint64_t overflows; // SẴXbgێĂĎ̂Ăt[̐
+	};
+
+	FrameRing( PixelFormat format, int width, int height, int capacity = 4 );
+	~FrameRing();
+
+	// src̉摜(1spitchoCg)󂢂ĂXbgփRs[āÃnhԂ
+	// SẴXbgێĂƂ̓t[̂ĂfalseԂ(handle͋ɂȂ)
+	bool write( const uint8_t* src, int pitch, uint32_t frameNumber, int64_t timestamp, FrameHandle& handle );
+
+	int getCapacity() const { return static_cast<int>( slots.size() ); }
+	Statistics getStatistics() const;
+
+private:
+	PixelFormat format;
+	int width;
+	int height;
+	std::vector<FrameSlot> slots;
+	int next;
+	Statistics statistics;
+	mutable Mutex mutex;
+
+	FrameRing( const FrameRing& );
+	FrameRing& operator=( const FrameRing& );
+};
+
+// t[ԍ̔тAhCo(܂̓AvP[V)Ƃt[𐔂
+class FrameDropCounter
+{
+public:
+	FrameDropCounter();
+
+	// 󂯎t[̔ԍn
+	void update( uint32_t frameNumber );
+	void reset();
+
+	uint64_t getReceived() const { return received; }
+	uint64_t getDropped() const { return dropped; }
+
+	// Ƃt[̊(0.0`1.0)
+	double getDropRate() const;
+
+private:
+	bool started;
+	uint32_t lastFrameNumber;
+	uint64_t received;
+	uint64_t dropped;
+};
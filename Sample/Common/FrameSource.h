@@ -0,0 +1,100 @@
+// FrameSource.h : ColorADepth&PlayerASkeletoñt[擾C^[tF[X
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include "FrameRing.h"
+#include "SkeletonFrame.h"
+
+
+// Xg[̎
+enum FrameStream
+{
+	FRAME_STREAM_COLOR = 0,
+	FRAME_STREAM_DEPTH,    // Depth&Player(13rbg[mm]A3rbgPlayer̃CfbNX)
+	FRAME_STREAM_SKELETON,
+	FRAME_STREAM_COUNT
+};
+
+// gXg[̑g\rbg
+static const int FRAME_STREAM_FLAG_COLOR    = 1 << FRAME_STREAM_COLOR;
+static const int FRAME_STREAM_FLAG_DEPTH    = 1 << FRAME_STREAM_DEPTH;
+static const int FRAME_STREAM_FLAG_SKELETON = 1 << FRAME_STREAM_SKELETON;
+static const int FRAME_STREAM_FLAG_ALL      = ( 1 << FRAME_STREAM_COUNT ) - 1;
+
+inline const char* getFrameStreamName( FrameStream stream )
+{
+	switch( stream ){
+		case FRAME_STREAM_COLOR:
+			return "COLOR";
+		case FRAME_STREAM_DEPTH:
+			return "DEPTH";
+		case FRAME_STREAM_SKELETON:
+			return "SKELETON";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+// 1̉摜t[
+struct ImageFrame
+{
+	// ff[^(Xg[gȂƂnullptr)
+	// L^̍Đł̓}bvt@C̗̈𒼐ڎw(y[WRs[)
+	uint8_t* data;
+	FrameInfo info;
+
+	// Kinect擾Ƃ́AOobt@̃Xbg̃nhŕێ
+	FrameHandle handle;
+
+	ImageFrame() : data( nullptr ) { std::memset( &info, 0, sizeof( info ) ); }
+
+	void reset()
+	{
+		data = nullptr;
+		std::memset( &info, 0, sizeof( info ) );
+		handle.reset();
+	}
+};
+
+// ^C~OŎ擾t[̑g
+// g͎read()Ăяo܂(nhێĂ΂̊)L
+struct FrameSet
+{
+	ImageFrame color;
+	ImageFrame depth;
+	const SkeletonFrame* skeleton; // Xg[gȂƂnullptr
+
+	FrameSet() : skeleton( nullptr ) {}
+
+	void reset()
+	{
+		color.reset();
+		depth.reset();
+		skeleton = nullptr;
+	}
+};
+
+// t[擾C^[tF[X
+// Kinect(NuiFrameSource)ƋL^̍Đ(ReplayFrameSource)𓯂ň
+class FrameSource
+{
+public:
+	virtual ~FrameSource() {}
+
+	// gSẴXg[̃t[܂ő҂Ď擾
+	// ĐIƂA܂̓t[擾łȂƂfalseԂ
+	virtual bool read( FrameSet& frames ) = 0;
+
+	// read()ĂяoƂɑ҂Ƀt[擾ł邩ǂ
+	virtual bool isFrameReady() = 0;
+
+	// gXg[(FRAME_STREAM_FLAG_*̑g)
+	virtual int getStreams() const = 0;
+
+	// t[ԍ̔т琔At[̐
+	virtual const FrameDropCounter& getDropCounter( FrameStream stream ) const = 0;
+};
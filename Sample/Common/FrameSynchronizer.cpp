@@ -0,0 +1,308 @@
+// FrameSynchronizer.cpp : Xg[ɓ͂t[^CX^vőgݍ킹
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "FrameSynchronizer.h"
+#include <algorithm>
+#include <cstring>
+
+
+static inline int64_t timestampDistance( int64_t a, int64_t b )
+{
+	return ( a > b ) ? a - b : b - a;
+}
+
+FrameSynchronizer::FrameSynchronizer( int streams, SyncPolicy policy, int toleranceMs, int queueDepth )
+	: streams( streams & FRAME_STREAM_FLAG_ALL ), policy( policy ), toleranceMs( toleranceMs ), queueDepth( 0 )
+{
+	std::memset( &latestSkeleton, 0, sizeof( latestSkeleton ) );
+	resetStatistics();
+	setQueueDepth( queueDepth );
+}
+
+void FrameSynchronizer::setStreams( int streams )
+{
+	this->streams = streams & FRAME_STREAM_FLAG_ALL;
+	clear();
+}
+
+void FrameSynchronizer::setPolicy( SyncPolicy policy )
+{
+	this->policy = policy;
+	clear();
+}
+
+void FrameSynchronizer::setQueueDepth( int queueDepth )
+{
+	this->queueDepth = ( queueDepth > 0 ) ? queueDepth : 1;
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		queues[i].entries.clear();
+		queues[i].entries.resize( this->queueDepth );
+		queues[i].skeletons.resize( ( i == FRAME_STREAM_SKELETON ) ? this->queueDepth : 0 );
+	}
+	clear();
+}
+
+void FrameSynchronizer::clear()
+{
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		Queue& queue = queues[i];
+		for( size_t j = 0; j < queue.entries.size(); j++ ){
+			queue.entries[j].image.reset();
+		}
+		queue.head = 0;
+		queue.count = 0;
+		hasLatest[i] = false;
+		latest[i].image.reset();
+	}
+}
+
+void FrameSynchronizer::resetStatistics()
+{
+	std::memset( &statistics, 0, sizeof( statistics ) );
+}
+
+FrameStream FrameSynchronizer::getAnchorStream() const
+{
+	if( streams & FRAME_STREAM_FLAG_DEPTH ){
+		return FRAME_STREAM_DEPTH;
+	}
+	if( streams & FRAME_STREAM_FLAG_COLOR ){
+		return FRAME_STREAM_COLOR;
+	}
+	return FRAME_STREAM_SKELETON;
+}
+
+int FrameSynchronizer::pushEntry( int stream, double arrival )
+{
+	Queue& queue = queues[stream];
+
+	// t̂Ƃ͍łÂt[̂Ă
+	if( queue.count == queueDepth ){
+		queue.at( 0 ).image.reset();
+		queue.head = ( queue.head + 1 ) % queueDepth;
+		queue.count--;
+		statistics.discarded[stream]++;
+	}
+
+	const int slot = queue.slotOf( queue.count );
+	queue.count++;
+	queue.entries[slot].arrival = arrival;
+	statistics.received[stream]++;
+	return slot;
+}
+
+void FrameSynchronizer::push( FrameStream stream, const ImageFrame& frame, double arrival )
+{
+	if( !( streams & ( 1 << stream ) ) || stream == FRAME_STREAM_SKELETON ){
+		return;
+	}
+	Entry& entry = queues[stream].entries[pushEntry( stream, arrival )];
+	entry.image = frame;
+	entry.timestamp = frame.info.timestamp;
+}
+
+void FrameSynchronizer::pushSkeleton( const SkeletonFrame& frame, double arrival )
+{
+	if( !( streams & FRAME_STREAM_FLAG_SKELETON ) ){
+		return;
+	}
+	Queue& queue = queues[FRAME_STREAM_SKELETON];
+	const int slot = pushEntry( FRAME_STREAM_SKELETON, arrival );
+	queue.entries[slot].image.reset();
+	queue.entries[slot].timestamp = frame.timestamp;
+	queue.skeletons[slot] = frame;
+}
+
+int FrameSynchronizer::findNearest( int stream, int64_t timestamp, bool useLatest, int64_t* difference ) const
+{
+	int nearest = -2;
+	int64_t best = 0;
+	if( useLatest && hasLatest[stream] ){
+		nearest = -1;
+		best = timestampDistance( latest[stream].timestamp, timestamp );
+	}
+	const Queue& queue = queues[stream];
+	for( int i = 0; i < queue.count; i++ ){
+		const int64_t d = timestampDistance( queue.at( i ).timestamp, timestamp );
+		if( nearest == -2 || d < best ){
+			nearest = i;
+			best = d;
+		}
+	}
+	*difference = best;
+	return nearest;
+}
+
+bool FrameSynchronizer::select( Selection& selection ) const
+{
+	if( !streams ){
+		return false;
+	}
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		selection.index[i] = -1;
+	}
+	switch( policy ){
+		case SYNC_EVERY_DEPTH:
+			return selectEveryDepth( selection );
+		case SYNC_ANY_STREAM:
+			return selectAnyStream( selection );
+		default:
+			return selectLatestMatched( selection );
+	}
+}
+
+bool FrameSynchronizer::selectLatestMatched( Selection& selection ) const
+{
+	// ̃Xg[̐Vt[珇ɁȂSẴXg[ɋẽ͈͓t[̂T
+	const FrameStream anchor = getAnchorStream();
+	const Queue& anchorQueue = queues[anchor];
+	for( int i = anchorQueue.count - 1; i >= 0; i-- ){
+		const int64_t timestamp = anchorQueue.at( i ).timestamp;
+		bool matched = true;
+		for( int s = 0; s < FRAME_STREAM_COUNT && matched; s++ ){
+			if( s == anchor || !( streams & ( 1 << s ) ) ){
+				continue;
+			}
+			int64_t difference;
+			selection.index[s] = findNearest( s, timestamp, false, &difference );
+			matched = selection.index[s] >= 0 && difference <= toleranceMs;
+		}
+		if( matched ){
+			selection.index[anchor] = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FrameSynchronizer::selectEveryDepth( Selection& selection ) const
+{
+	// ̃Xg[̍łÂt[ɁÃXg[̃^CX^vł߂t[gݍ킹
+	const FrameStream anchor = getAnchorStream();
+	const Queue& anchorQueue = queues[anchor];
+	if( anchorQueue.count == 0 ){
+		return false;
+	}
+	const int64_t timestamp = anchorQueue.at( 0 ).timestamp;
+
+	// ̃L[tɂȂAẽ͈͓t[͂̂҂Ɏo
+	const bool force = anchorQueue.count >= queueDepth;
+	for( int s = 0; s < FRAME_STREAM_COUNT; s++ ){
+		if( s == anchor || !( streams & ( 1 << s ) ) ){
+			continue;
+		}
+		int64_t difference;
+		selection.index[s] = findNearest( s, timestamp, true, &difference );
+		if( selection.index[s] == -2 ){
+			return false;
+		}
+		if( difference <= toleranceMs || force ){
+			continue;
+		}
+
+		// ꂩ͂t[̓L[̂ǂ̃t[V̂ŁAꂪe͈͓ɓ蓾Ƃ͑҂
+		const Queue& queue = queues[s];
+		const int64_t newest = ( queue.count > 0 ) ? queue.at( queue.count - 1 ).timestamp : latest[s].timestamp;
+		if( newest < timestamp + toleranceMs ){
+			return false;
+		}
+	}
+	selection.index[anchor] = 0;
+	return true;
+}
+
+bool FrameSynchronizer::selectAnyStream( Selection& selection ) const
+{
+	// Vt[1ȏ゠ASẴXg[1x̓t[󂯎ĂΎo
+	bool updated = false;
+	for( int s = 0; s < FRAME_STREAM_COUNT; s++ ){
+		if( !( streams & ( 1 << s ) ) ){
+			continue;
+		}
+		const int count = queues[s].count;
+		if( count == 0 && !hasLatest[s] ){
+			return false;
+		}
+		selection.index[s] = count - 1;
+		updated = updated || count > 0;
+	}
+	return updated;
+}
+
+bool FrameSynchronizer::isReady() const
+{
+	Selection selection;
+	return select( selection );
+}
+
+bool FrameSynchronizer::pop( FrameSet& frames, double now )
+{
+	frames.reset();
+
+	Selection selection;
+	if( !select( selection ) ){
+		return false;
+	}
+
+	double firstArrival = now;
+	for( int s = 0; s < FRAME_STREAM_COUNT; s++ ){
+		if( !( streams & ( 1 << s ) ) ){
+			continue;
+		}
+		Queue& queue = queues[s];
+		const int index = selection.index[s];
+		if( index >= 0 ){
+			// I񂾃t[Ȏg̃t[ƂĕێAÂt[͎̂Ă
+			Entry& entry = queue.at( index );
+			latest[s].image = entry.image;
+			latest[s].timestamp = entry.timestamp;
+			latest[s].arrival = entry.arrival;
+			if( s == FRAME_STREAM_SKELETON ){
+				latestSkeleton = queue.skeletons[queue.slotOf( index )];
+			}
+			hasLatest[s] = true;
+			firstArrival = ( std::min )( firstArrival, entry.arrival );
+			for( int i = 0; i <= index; i++ ){
+				queue.at( i ).image.reset();
+			}
+			queue.head = queue.slotOf( index + 1 );
+			queue.count -= index + 1;
+			statistics.discarded[s] += index;
+		}
+		else{
+			statistics.reused[s]++;
+		}
+	}
+
+	// ̃Xg[Ƃ̃^CX^v̍̍ől
+	const int64_t anchorTimestamp = latest[getAnchorStream()].timestamp;
+	int64_t skew = 0;
+	for( int s = 0; s < FRAME_STREAM_COUNT; s++ ){
+		if( streams & ( 1 << s ) ){
+			skew = ( std::max )( skew, timestampDistance( latest[s].timestamp, anchorTimestamp ) );
+		}
+	}
+
+	if( streams & FRAME_STREAM_FLAG_COLOR ){
+		frames.color = latest[FRAME_STREAM_COLOR].image;
+	}
+	if( streams & FRAME_STREAM_FLAG_DEPTH ){
+		frames.depth = latest[FRAME_STREAM_DEPTH].image;
+	}
+	if( streams & FRAME_STREAM_FLAG_SKELETON ){
+		frames.skeleton = &latestSkeleton;
+	}
+
+	// xƃ^CX^v̍
+	const double latency = ( now - firstArrival ) * 1000.0;
+	statistics.sets++;
+	statistics.skewSumMs += skew;
+	statistics.skewMaxMs = ( std::max )( statistics.skewMaxMs, skew );
+	statistics.latencySumMs += latency;
+	statistics.latencyMaxMs = ( std::max )( statistics.latencyMaxMs, latency );
+	if( skew > toleranceMs ){
+		statistics.outOfTolerance++;
+	}
+	return true;
+}
@@ -0,0 +1,138 @@
+// FrameSynchronizer.h : Xg[ɓ͂t[^CX^vőgݍ킹
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "FrameSource.h"
+
+
+// t[gݍ킹j
+enum SyncPolicy
+{
+	SYNC_LATEST_MATCHED = 0, // SẴXg[̃^CX^ve͈͓őĝAłVg擾(Ât[͎̂Ă)
+	SYNC_EVERY_DEPTH,        // Depth̑SẴt[Ɏ擾ÃXg[̓^CX^vł߂t[gݍ킹
+	SYNC_ANY_STREAM          // ǂꂩ̃Xg[XVꂽAXg[̍ŐṼt[gݍ킹Ď擾
+};
+
+// Xg[ɓ͂t[ʁX̃L[ɗ߂āA^CX^v(liTimeStamp)őgݍ킹
+// SẴXg[̂҂ɁA͂Xg[珇push()Apop()őgo
+// ͌Ăяon̂ŁAL^t[ɃWb^[ē͂ԂČĂ悤ɓ
+class FrameSynchronizer
+{
+public:
+	// ^CX^v̍̋e͈͂̊l[ms](30fps1t[̖1/3)
+	static const int DEFAULT_TOLERANCE_MS = 10;
+
+	// Xg[ɗ߂Ăt[̐̊l
+	static const int DEFAULT_QUEUE_DEPTH = 3;
+
+	// v
+	struct Statistics
+	{
+		uint64_t sets;                            // og̐
+		uint64_t received[FRAME_STREAM_COUNT];    // 󂯎t[̐
+		uint64_t discarded[FRAME_STREAM_COUNT];   // gɂȂ炸Ɏ̂Ăt[̐
+		uint64_t reused[FRAME_STREAM_COUNT];      // ȎgƓt[gݍ킹
+		uint64_t outOfTolerance;                  // ^CX^v̍e͈͂𒴂g̐
+		double latencySumMs;                      // g̍ł͂t[󂯎ĂAgo܂ł̎Ԃ̍v[ms]
+		double latencyMaxMs;
+		int64_t skewSumMs;                        // g̒̊̃Xg[Ƃ̃^CX^v̍(ől)̍v[ms]
+		int64_t skewMaxMs;
+
+		double getMeanLatencyMs() const { return sets ? latencySumMs / static_cast<double>( sets ) : 0.0; }
+		double getMeanSkewMs() const { return sets ? static_cast<double>( skewSumMs ) / static_cast<double>( sets ) : 0.0; }
+	};
+
+	// streams͑gݍ킹Xg[(FRAME_STREAM_FLAG_*̑g)
+	explicit FrameSynchronizer( int streams = FRAME_STREAM_FLAG_ALL, SyncPolicy policy = SYNC_LATEST_MATCHED,
+		int toleranceMs = DEFAULT_TOLERANCE_MS, int queueDepth = DEFAULT_QUEUE_DEPTH );
+
+	// ݒςƁA߂Ăt[͎̂Ă
+	void setStreams( int streams );
+	void setPolicy( SyncPolicy policy );
+	void setTolerance( int toleranceMs ) { this->toleranceMs = toleranceMs; }
+	void setQueueDepth( int queueDepth );
+
+	int getStreams() const { return streams; }
+	SyncPolicy getPolicy() const { return policy; }
+	int getTolerance() const { return toleranceMs; }
+	int getQueueDepth() const { return queueDepth; }
+
+	// ߂Ăt[ƁAȎg̃t[̂Ă
+	void clear();
+
+	// ͂t[n(arrival͎󂯎[s])
+	// L[t̂Ƃ͍łÂt[̂Ă
+	void push( FrameStream stream, const ImageFrame& frame, double arrival );
+	void pushSkeleton( const SkeletonFrame& frame, double arrival );
+
+	// jɏ]đgo邩ǂ
+	bool isReady() const;
+
+	// jɏ]đgo(oȂƂfalseԂ)
+	// frames̒g͎pop()Aclear()Ăяo܂ŗL(nhێĂ΂̊)
+	// now͎o[s]ŁAx̓vɎg
+	bool pop( FrameSet& frames, double now );
+
+	Statistics getStatistics() const { return statistics; }
+	void resetStatistics();
+
+private:
+	struct Entry
+	{
+		ImageFrame image;
+		int64_t timestamp;
+		double arrival;
+	};
+
+	// Xg[̃L[(ÂɕԌŒ蒷̃O)
+	struct Queue
+	{
+		std::vector<Entry> entries;
+		std::vector<SkeletonFrame> skeletons; // SkeletoñXg[g
+		int head;
+		int count;
+
+		Entry& at( int i ) { return entries[( head + i ) % entries.size()]; }
+		const Entry& at( int i ) const { return entries[( head + i ) % entries.size()]; }
+		int slotOf( int i ) const { return static_cast<int>( ( head + i ) % entries.size() ); }
+	};
+
+	// gɂt[̑Iѕ(Xg[̃L[̈ʒuA-1͑Ȏg̃t[g)
+	struct Selection
+	{
+		int index[FRAME_STREAM_COUNT];
+	};
+
+	bool select( Selection& selection ) const;
+	bool selectLatestMatched( Selection& selection ) const;
+	bool selectEveryDepth( Selection& selection ) const;
+	bool selectAnyStream( Selection& selection ) const;
+
+	// L[̒timestampɍł߂t[̈ʒu(Ȏg̃t[̕߂Ƃ-1)
+	// ₪Ƃ-2Ԃ
+	// useLatesttruêƂ͑Ȏg̃t[ɂ
+	int findNearest( int stream, int64_t timestamp, bool useLatest, int64_t* difference ) const;
+
+	// ɂXg[(DepthAColorASkeleton̏ɎgĂ)
+	FrameStream getAnchorStream() const;
+
+	// L[̖ɗ̈mۂāÄʒuԂ
+	int pushEntry( int stream, double arrival );
+
+	int streams;
+	SyncPolicy policy;
+	int toleranceMs;
+	int queueDepth;
+	Queue queues[FRAME_STREAM_COUNT];
+
+	// Ȏg̃t[(SYNC_ANY_STREAMł͍XVĂȂXg[ɂg)
+	bool hasLatest[FRAME_STREAM_COUNT];
+	Entry latest[FRAME_STREAM_COUNT];
+	SkeletonFrame latestSkeleton;
+
+	Statistics statistics;
+};
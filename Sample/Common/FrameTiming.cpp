@@ -0,0 +1,131 @@
+// FrameTiming.cpp : `Ǝ擾̃t[[gA擾\܂ł̒xP鎞vŌv
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "FrameTiming.h"
+#include "Metrics.h"
+
+
+/*----- TimingSeries -----*/
+
+TimingSeries::TimingSeries( double windowSeconds, double smoothing, int capacity )
+	: windowSeconds( windowSeconds ), smoothing( smoothing ), samples( capacity > 0 ? capacity : 1 )
+{
+	reset();
+}
+
+void TimingSeries::reset()
+{
+	ewma = 0.0;
+	hasEwma = false;
+	first = 0;
+	count = 0;
+	sum = 0.0;
+}
+
+void TimingSeries::add( double value, double now )
+{
+	ewma = hasEwma ? ewma + smoothing * ( value - ewma ) : value;
+	hasEwma = true;
+
+	expire( now );
+	const int capacity = static_cast<int>( samples.size() );
+	if( count == capacity ){
+		sum -= samples[first].value;
+		first = ( first + 1 ) % capacity;
+		count--;
+	}
+	Sample& sample = samples[( first + count ) % capacity];
+	sample.time = now;
+	sample.value = value;
+	sum += value;
+	count++;
+}
+
+void TimingSeries::expire( double now )
+{
+	const int capacity = static_cast<int>( samples.size() );
+	while( count > 0 && samples[first].time < now - windowSeconds ){
+		sum -= samples[first].value;
+		first = ( first + 1 ) % capacity;
+		count--;
+	}
+	// SďƂ͉Ž덷zȂ
+	if( count == 0 ){
+		sum = 0.0;
+	}
+}
+
+double TimingSeries::getMinimum() const
+{
+	const int capacity = static_cast<int>( samples.size() );
+	double minimum = 0.0;
+	for( int i = 0; i < count; i++ ){
+		const double value = samples[( first + i ) % capacity].value;
+		if( i == 0 || value < minimum ){
+			minimum = value;
+		}
+	}
+	return minimum;
+}
+
+double TimingSeries::getAverage() const
+{
+	return count > 0 ? sum / count : 0.0;
+}
+
+double TimingSeries::getMaximum() const
+{
+	const int capacity = static_cast<int>( samples.size() );
+	double maximum = 0.0;
+	for( int i = 0; i < count; i++ ){
+		const double value = samples[( first + i ) % capacity].value;
+		if( i == 0 || value > maximum ){
+			maximum = value;
+		}
+	}
+	return maximum;
+}
+
+
+/*----- FrameTiming -----*/
+
+FrameTiming::FrameTiming( double windowSeconds, double smoothing )
+	: renderInterval( windowSeconds, smoothing ), captureInterval( windowSeconds, smoothing ), captureToPresent( windowSeconds, smoothing ),
+	  lastPresent( -1.0 ), lastCapture( -1.0 ), pendingCapture( -1.0 )
+{
+}
+
+void FrameTiming::onCapture( double now )
+{
+	if( lastCapture >= 0.0 ){
+		const double interval = now - lastCapture;
+		captureInterval.add( interval * 1000.0, now );
+		if( isMetricsEnabled() ){
+			recordMetric( METRIC_CAPTURE_INTERVAL, interval );
+		}
+	}
+	lastCapture = now;
+	pendingCapture = now;
+}
+
+void FrameTiming::onPresent( double now )
+{
+	if( lastPresent >= 0.0 ){
+		const double interval = now - lastPresent;
+		renderInterval.add( interval * 1000.0, now );
+		if( isMetricsEnabled() ){
+			recordMetric( METRIC_RENDER_INTERVAL, interval );
+		}
+	}
+	lastPresent = now;
+
+	if( pendingCapture >= 0.0 ){
+		const double latency = now - pendingCapture;
+		captureToPresent.add( latency * 1000.0, now );
+		if( isMetricsEnabled() ){
+			recordMetric( METRIC_CAPTURE_TO_PRESENT, latency );
+		}
+		pendingCapture = -1.0;
+	}
+}
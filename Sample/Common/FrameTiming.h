@@ -0,0 +1,81 @@
+// FrameTiming.h : `Ǝ擾̃t[[gA擾\܂ł̒xP鎞vŌv
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <vector>
+#include "Platform.h"
+
+
+// ľn̓v
+// wړ(EWMA)ƁAwindowSecondsb̒l̍ŏlAϒlAől߂
+class TimingSeries
+{
+public:
+	// smoothingEWMAŐVlɊ|d(0`1A傫قǑǏ])
+	// capacity͋Ԃɓl̐̏(͌Âl珜)
+	explicit TimingSeries( double windowSeconds = 1.0, double smoothing = 0.1, int capacity = 256 );
+
+	void reset();
+
+	// now[s](getTimeInSeconds())̒l
+	void add( double value, double now );
+
+	// Ԃ̒lƂ͑S0
+	double getEwma() const { return ewma; }
+	double getMinimum() const;
+	double getAverage() const;
+	double getMaximum() const;
+	int getCount() const { return count; }
+
+private:
+	// ԂOꂽl
+	void expire( double now );
+
+	struct Sample
+	{
+		double time;
+		double value;
+	};
+
+	double windowSeconds;
+	double smoothing;
+	double ewma;
+	bool hasEwma;
+	std::vector<Sample> samples; // Oobt@
+	int first;
+	int count;
+	double sum;
+};
+
+// t[̎擾ƕ\̃^C~O
+// 擾Ƃ(onCapture())ƕ\Ƃ(onPresent())̎Aꂼ̊ԊuƎ擾\܂ł̒x߂
+// v̋L^(Metrics.h)LȂƂ́AԊuƒxMETRIC_RENDER_INTERVALAMETRIC_CAPTURE_INTERVALAMETRIC_CAPTURE_TO_PRESENTɂL^
+class FrameTiming
+{
+public:
+	explicit FrameTiming( double windowSeconds = 1.0, double smoothing = 0.1 );
+
+	// Vt[擾ƂɌĂяo
+	void onCapture( double now = getTimeInSeconds() );
+
+	// `悵ĕ\ƂɌĂяo(擾t[߂ĕ\Ƃ͒x߂)
+	void onPresent( double now = getTimeInSeconds() );
+
+	// Ԋu[ms]ƒx[ms]
+	const TimingSeries& getRenderInterval() const { return renderInterval; }
+	const TimingSeries& getCaptureInterval() const { return captureInterval; }
+	const TimingSeries& getCaptureToPresent() const { return captureToPresent; }
+
+	// Ԋu[ms]t[[g[fps]ɂ(Ԋu0ȉ̂Ƃ0)
+	static double toFps( double intervalMs ) { return intervalMs > 0.0 ? 1000.0 / intervalMs : 0.0; }
+
+private:
+	TimingSeries renderInterval;
+	TimingSeries captureInterval;
+	TimingSeries captureToPresent;
+	double lastPresent;
+	double lastCapture;
+	double pendingCapture; // ܂\ĂȂt[擾(Ƃ͕)
+};
@@ -0,0 +1,64 @@
+// KinectTypes.h : Kinect SDKɈˑDepthf[^߂̒萔ƌ^
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+
+// 摜TCY(NUI_IMAGE_RESOLUTION_640x480)
+static const int KINECT_IMAGE_WIDTH  = 640;
+static const int KINECT_IMAGE_HEIGHT = 480;
+
+// Depth&Player̃rbg\(NuiImageCamera.h̒`Ɠl)
+// 13rbg[mm]A3rbgPlayer̃CfbNX
+static const int      KINECT_PLAYER_INDEX_SHIFT = 3;
+static const uint16_t KINECT_PLAYER_INDEX_MASK  = ( 1 << KINECT_PLAYER_INDEX_SHIFT ) - 1;
+static const uint16_t KINECT_DEPTH_MASK         = static_cast<uint16_t>( ~KINECT_PLAYER_INDEX_MASK );
+
+// Player̃CfbNX̍ől(NUI_SKELETON_COUNT)
+static const int KINECT_PLAYER_COUNT = 6;
+
+// [mm]̎蓾l̐(13rbg)
+static const int KINECT_DEPTH_MM_COUNT = 1 << ( 16 - KINECT_PLAYER_INDEX_SHIFT );
+
+// v͈[mm]
+static const int KINECT_DEPTH_MINIMUM_NEAR_MODE_MM = 400;
+static const int KINECT_DEPTH_MINIMUM_MM           = 800;
+static const int KINECT_DEPTH_MAXIMUM_NEAR_MODE_MM = 3000;
+static const int KINECT_DEPTH_MAXIMUM_MM           = 4000;
+
+// v͈͂̍łDepth&Player̒l(NUI_IMAGE_DEPTH_MAXIMUMANUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE)
+static const int KINECT_DEPTH_MAXIMUM_VALUE = ( KINECT_DEPTH_MAXIMUM_MM << KINECT_PLAYER_INDEX_SHIFT ) | KINECT_PLAYER_INDEX_MASK;
+static const int KINECT_DEPTH_MAXIMUM_NEAR_MODE_VALUE = ( KINECT_DEPTH_MAXIMUM_NEAR_MODE_MM << KINECT_PLAYER_INDEX_SHIFT ) | KINECT_PLAYER_INDEX_MASK;
+
+// 摜̋`͈̔(rightAbottom͊܂܂ȂÂƂleft >= right)
+struct MaskRect
+{
+	int left;
+	int top;
+	int right;
+	int bottom;
+
+	MaskRect()
+		: left( 0 ), top( 0 ), right( 0 ), bottom( 0 )
+	{
+	}
+
+	bool isEmpty() const { return ( left >= right ) || ( top >= bottom ); }
+	int getWidth() const { return isEmpty() ? 0 : right - left; }
+	int getHeight() const { return isEmpty() ? 0 : bottom - top; }
+
+	// ㉺EpaddingfLāAwidth~height̉摜͈̔͂Ɏ߂(̂Ƃ͋̂܂)
+	MaskRect inflate( int padding, int width, int height ) const
+	{
+		MaskRect rect;
+		if( !isEmpty() ){
+			rect.left = ( left - padding > 0 ) ? left - padding : 0;
+			rect.top = ( top - padding > 0 ) ? top - padding : 0;
+			rect.right = ( right + padding < width ) ? right + padding : width;
+			rect.bottom = ( bottom + padding < height ) ? bottom + padding : height;
+		}
+		return rect;
+	}
+};
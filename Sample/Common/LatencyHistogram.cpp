@@ -0,0 +1,120 @@
+// LatencyHistogram.cpp : Ԃ̕z̑ΐxŐqXgO
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "LatencyHistogram.h"
+
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::reset()
+{
+	for( int i = 0; i < BUCKET_COUNT; i++ ){
+		counts[i] = 0;
+	}
+}
+
+void LatencyHistogram::add( const LatencyHistogram& other )
+{
+	for( int i = 0; i < BUCKET_COUNT; i++ ){
+		counts[i] = counts[i] + atomicLoad( &other.counts[i] );
+	}
+}
+
+void LatencyHistogram::subtract( const LatencyHistogram& other )
+{
+	for( int i = 0; i < BUCKET_COUNT; i++ ){
+		counts[i] = counts[i] - atomicLoad( &other.counts[i] );
+	}
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+	uint64_t count = 0;
+	for( int i = 0; i < BUCKET_COUNT; i++ ){
+		count += counts[i];
+	}
+	return count;
+}
+
+uint32_t LatencyHistogram::getPercentile( double percentile ) const
+{
+	const uint64_t count = getCount();
+	if( count == 0 ){
+		return 0;
+	}
+
+	// 琔rankԖڂ̒lĂoPbg
+	uint64_t rank = static_cast<uint64_t>( percentile / 100.0 * count + 0.5 );
+	if( rank < 1 ){
+		rank = 1;
+	}
+	if( rank > count ){
+		rank = count;
+	}
+	uint64_t accumulated = 0;
+	for( int i = 0; i < BUCKET_COUNT; i++ ){
+		accumulated += counts[i];
+		if( accumulated >= rank ){
+			return getBucketUpperBound( i );
+		}
+	}
+	return getMaximum();
+}
+
+uint32_t LatencyHistogram::getMaximum() const
+{
+	for( int i = BUCKET_COUNT - 1; i >= 0; i-- ){
+		if( counts[i] > 0 ){
+			return getBucketUpperBound( i );
+		}
+	}
+	return 0;
+}
+
+// 2 * SUB_BUCKET_COUNT͂̂܂ܔԍɂ
+// ȏ͏SUB_BUCKET_BITS + 1rbgcAƂrbg(shift)SUB_BUCKET_COUNT̃oPbg蓖Ă
+// shift͎crbgɂrbg̐(񕪒Tŋ߂)
+int LatencyHistogram::getBucketIndex( uint32_t value )
+{
+	if( value > MAXIMUM_VALUE ){
+		value = MAXIMUM_VALUE;
+	}
+	uint32_t high = value >> ( SUB_BUCKET_BITS + 1 );
+	int shift = 0;
+	if( high >> 16 ){
+		high >>= 16;
+		shift += 16;
+	}
+	if( high >> 8 ){
+		high >>= 8;
+		shift += 8;
+	}
+	if( high >> 4 ){
+		high >>= 4;
+		shift += 4;
+	}
+	if( high >> 2 ){
+		high >>= 2;
+		shift += 2;
+	}
+	if( high >> 1 ){
+		high >>= 1;
+		shift += 1;
+	}
+	shift += static_cast<int>( high );
+	return ( shift + 1 ) * SUB_BUCKET_COUNT + static_cast<int>( value >> shift ) - SUB_BUCKET_COUNT;
+}
+
+uint32_t LatencyHistogram::getBucketUpperBound( int index )
+{
+	if( index < 2 * SUB_BUCKET_COUNT ){
+		return static_cast<uint32_t>( index );
+	}
+	const int shift = index / SUB_BUCKET_COUNT - 1;
+	const uint32_t sub = static_cast<uint32_t>( index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT );
+	return ( ( sub + 1 ) << shift ) - 1;
+}
@@ -0,0 +1,57 @@
+// LatencyHistogram.h : Ԃ̕z̑ΐxŐqXgO(HdrHistogramƓΐE`̃oPbg)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "Platform.h"
+
+
+// l[us]2ׂ̂斈͈̔͂ɕAꂼ32̃oPbgŐ
+// 64us1us݁Aȏ͒l1/32(3%)ȉ݂̍ɂȂ(67bȏ͍Ō̃oPbgɓ)
+// L^1̃XbhsAWv͑̃XbhL^̍Œłs(JE^ɓǂނ̂ŁAr̋L^ꕔ邱Ƃ͂)
+class LatencyHistogram
+{
+public:
+	static const int SUB_BUCKET_BITS = 5;
+	static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	static const int VALUE_BITS = 26;
+	static const uint32_t MAXIMUM_VALUE = ( 1u << VALUE_BITS ) - 1;
+	static const int BUCKET_COUNT = ( VALUE_BITS - SUB_BUCKET_BITS + 1 ) * SUB_BUCKET_COUNT;
+
+	LatencyHistogram();
+
+	// SẴoPbg0ɂ
+	void reset();
+
+	// l[us]1L^(̃qXgOXbhĂяo)
+	void record( uint32_t microseconds )
+	{
+		const int index = getBucketIndex( microseconds );
+		counts[index] = counts[index] + 1;
+	}
+
+	// ̃qXgO̐A(̂͑ȌWvƂ̍߂Ƃ)
+	void add( const LatencyHistogram& other );
+	void subtract( const LatencyHistogram& other );
+
+	// L^
+	uint64_t getCount() const;
+
+	// percentile[%]̒l[us](̃oPbg̏AL^Ƃ0)
+	uint32_t getPercentile( double percentile ) const;
+
+	// ől[us](ł傫oPbg̏AL^Ƃ0)
+	uint32_t getMaximum() const;
+
+	// l[us]oPbg̔ԍƁAoPbgɓl̏[us]
+	static int getBucketIndex( uint32_t value );
+	static uint32_t getBucketUpperBound( int index );
+
+private:
+	volatile long counts[BUCKET_COUNT];
+
+	LatencyHistogram( const LatencyHistogram& );
+	LatencyHistogram& operator=( const LatencyHistogram& );
+};
@@ -0,0 +1,339 @@
+// Metrics.cpp : ̒i̎ԂƃZT[o͂܂ł̒xqXgOɋL^AIɏo
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Metrics.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+/*----- L^ -----*/
+
+// v̍𐄒肷[s](ZT[PC̎v̂ǂ悤ɁAÂt[͎gȂ)
+static const int CLOCK_OFFSET_WINDOW_SECONDS = 10;
+
+// Xbh̃qXgOƃZT[̎v̍
+// Xbg͏߂ċL^XbhɏɊ蓖āAqXgOmۂĂready𗧂Ă(WvXbhreadyXbgǂ)
+struct MetricRegistry
+{
+	volatile long enabled;
+	volatile long threadCount;
+	volatile long ready[METRIC_MAX_THREADS];
+	LatencyHistogram* histograms[METRIC_MAX_THREADS]; // METRIC_STAGE_COUNT
+
+	// 1b(PC̎[ms] - ^CX^v[ms])̍ŏl
+	Mutex clockMutex;
+	int64_t clockSeconds[CLOCK_OFFSET_WINDOW_SECONDS];
+	double clockOffsets[CLOCK_OFFSET_WINDOW_SECONDS];
+
+	MetricRegistry()
+		: enabled( 0 ), threadCount( 0 )
+	{
+		for( int i = 0; i < METRIC_MAX_THREADS; i++ ){
+			ready[i] = 0;
+			histograms[i] = nullptr;
+		}
+		for( int i = 0; i < CLOCK_OFFSET_WINDOW_SECONDS; i++ ){
+			clockSeconds[i] = -1;
+			clockOffsets[i] = 0.0;
+		}
+	}
+
+	~MetricRegistry()
+	{
+		for( int i = 0; i < METRIC_MAX_THREADS; i++ ){
+			delete[] histograms[i];
+		}
+	}
+
+	// v̍XVāA߂̋Ԃ̍ŏlԂ
+	double updateClockOffset( double offset, double now )
+	{
+		ScopedLock lock( clockMutex );
+		const int64_t second = static_cast<int64_t>( now );
+		const int slot = static_cast<int>( second % CLOCK_OFFSET_WINDOW_SECONDS );
+		if( clockSeconds[slot] != second || offset < clockOffsets[slot] ){
+			clockSeconds[slot] = second;
+			clockOffsets[slot] = offset;
+		}
+
+		double minimum = offset;
+		for( int i = 0; i < CLOCK_OFFSET_WINDOW_SECONDS; i++ ){
+			if( clockSeconds[i] > second - CLOCK_OFFSET_WINDOW_SECONDS && clockOffsets[i] < minimum ){
+				minimum = clockOffsets[i];
+			}
+		}
+		return minimum;
+	}
+
+private:
+	MetricRegistry( const MetricRegistry& );
+	MetricRegistry& operator=( const MetricRegistry& );
+};
+
+static MetricRegistry g_metricRegistry;
+
+// ݂̃Xbh̃qXgO(蓖ĂȂƂoverflowed𗧂Ănullptr̂܂܂ɂ)
+static PLATFORM_THREAD_LOCAL LatencyHistogram* t_metricHistograms = nullptr;
+static PLATFORM_THREAD_LOCAL bool t_metricOverflowed = false;
+
+static LatencyHistogram* getThreadHistograms()
+{
+	if( !t_metricHistograms && !t_metricOverflowed ){
+		const long slot = atomicAdd( &g_metricRegistry.threadCount, 1 ) - 1;
+		if( slot >= METRIC_MAX_THREADS ){
+			t_metricOverflowed = true;
+			return nullptr;
+		}
+		t_metricHistograms = new LatencyHistogram[METRIC_STAGE_COUNT];
+		g_metricRegistry.histograms[slot] = t_metricHistograms;
+		atomicStore( &g_metricRegistry.ready[slot], 1 );
+	}
+	return t_metricHistograms;
+}
+
+void setMetricsEnabled( bool enabled )
+{
+	atomicStore( &g_metricRegistry.enabled, enabled ? 1 : 0 );
+}
+
+bool isMetricsEnabled()
+{
+	return g_metricRegistry.enabled != 0;
+}
+
+void recordMetric( MetricStage stage, double seconds )
+{
+	LatencyHistogram* histograms = getThreadHistograms();
+	if( !histograms ){
+		return;
+	}
+	const double microseconds = seconds * 1e6 + 0.5;
+	uint32_t value = 0;
+	if( microseconds >= LatencyHistogram::MAXIMUM_VALUE ){
+		value = LatencyHistogram::MAXIMUM_VALUE;
+	}
+	else if( microseconds > 0.0 ){
+		value = static_cast<uint32_t>( microseconds );
+	}
+	histograms[stage].record( value );
+}
+
+void recordMetricScope( MetricStage stage, double startSeconds, double endSeconds )
+{
+	if( isMetricsEnabled() ){
+		recordMetric( stage, endSeconds - startSeconds );
+	}
+	if( isTraceEnabled() ){
+		recordTraceEvent( getMetricStageName( stage ), startSeconds, endSeconds );
+	}
+}
+
+void recordFrameArrival( int64_t timestamp )
+{
+	if( !isMetricsEnabled() ){
+		return;
+	}
+	const double now = getTimeInSeconds();
+	g_metricRegistry.updateClockOffset( now * 1000.0 - static_cast<double>( timestamp ), now );
+}
+
+void recordFrameLatency( int64_t timestamp )
+{
+	if( !isMetricsEnabled() ){
+		return;
+	}
+	const double now = getTimeInSeconds();
+	const double offset = now * 1000.0 - static_cast<double>( timestamp );
+	const double minimum = g_metricRegistry.updateClockOffset( offset, now );
+	recordMetric( METRIC_LATENCY, ( offset - minimum ) / 1000.0 );
+}
+
+void getMetricSnapshot( MetricStage stage, LatencyHistogram& snapshot )
+{
+	snapshot.reset();
+	long count = atomicLoad( &g_metricRegistry.threadCount );
+	if( count > METRIC_MAX_THREADS ){
+		count = METRIC_MAX_THREADS;
+	}
+	for( long i = 0; i < count; i++ ){
+		if( atomicLoad( &g_metricRegistry.ready[i] ) ){
+			snapshot.add( g_metricRegistry.histograms[i][stage] );
+		}
+	}
+}
+
+
+/*----- MetricsReporter -----*/
+
+// IɏWvďoXbh
+class MetricsReporter
+{
+public:
+	MetricsReporter()
+		: intervalSeconds( 1.0 ), startTime( 0.0 ), lastTime( 0.0 ), stopRequested( 0 )
+	{
+	}
+
+	~MetricsReporter()
+	{
+		stop();
+	}
+
+	bool start( const char* reportPath, double interval )
+	{
+		ScopedLock lock( mutex );
+		if( thread.joinable() ){
+			return false;
+		}
+		path = reportPath;
+		intervalSeconds = ( interval > 0.0 ) ? interval : 1.0;
+		for( int i = 0; i < METRIC_STAGE_COUNT; i++ ){
+			previous[i].reset();
+		}
+		startTime = getTimeInSeconds();
+		lastTime = startTime;
+		atomicStore( &stopRequested, 0 );
+		setMetricsEnabled( true );
+		return thread.start( entry, this );
+	}
+
+	void stop()
+	{
+		ScopedLock lock( mutex );
+		if( !thread.joinable() ){
+			return;
+		}
+		atomicStore( &stopRequested, 1 );
+		thread.join();
+		report();
+	}
+
+private:
+	static void entry( void* self )
+	{
+		static_cast<MetricsReporter*>( self )->loop();
+	}
+
+	// ~߂vɂ悤ɁAZԊuŋNĎm߂
+	void loop()
+	{
+		while( !atomicLoad( &stopRequested ) ){
+			sleepMilliseconds( 50 );
+			if( getTimeInSeconds() - lastTime >= intervalSeconds ){
+				report();
+			}
+		}
+	}
+
+	void report()
+	{
+		const double now = getTimeInSeconds();
+		for( int i = 0; i < METRIC_STAGE_COUNT; i++ ){
+			getMetricSnapshot( static_cast<MetricStage>( i ), total[i] );
+			interval[i].reset();
+			interval[i].add( total[i] );
+			interval[i].subtract( previous[i] );
+			previous[i].reset();
+			previous[i].add( total[i] );
+		}
+		if( path == "-" ){
+			writeLine( now, std::cout );
+		}
+		else{
+			writeFile( now );
+		}
+		lastTime = now;
+	}
+
+	static double toMilliseconds( uint32_t microseconds )
+	{
+		return microseconds / 1000.0;
+	}
+
+	// ԂɋL^i"i p50/p99/max ms ()"ׂ
+	void writeLine( double now, std::ostream& os ) const
+	{
+		std::ostringstream line;
+		line << "metrics " << std::fixed << std::setprecision( 1 ) << now - startTime << " s :";
+		for( int i = 0; i < METRIC_STAGE_COUNT; i++ ){
+			const uint64_t count = interval[i].getCount();
+			if( count == 0 ){
+				continue;
+			}
+			line << " " << getMetricStageName( static_cast<MetricStage>( i ) ) << " " << std::setprecision( 2 )
+				<< toMilliseconds( interval[i].getPercentile( 50.0 ) ) << "/"
+				<< toMilliseconds( interval[i].getPercentile( 99.0 ) ) << "/"
+				<< toMilliseconds( interval[i].getMaximum() ) << " ms (" << count << ")";
+		}
+		os << line.str() << std::endl;
+	}
+
+	static void writeStatistics( std::ostream& os, const char* prefix, const LatencyHistogram& histogram )
+	{
+		os << ", \"" << prefix << "count\" : " << histogram.getCount()
+			<< ", \"" << prefix << "p50_ms\" : " << toMilliseconds( histogram.getPercentile( 50.0 ) )
+			<< ", \"" << prefix << "p99_ms\" : " << toMilliseconds( histogram.getPercentile( 99.0 ) )
+			<< ", \"" << prefix << "max_ms\" : " << toMilliseconds( histogram.getMaximum() );
+	}
+
+	// ̌`JSON(Ԃ͑O񏑂oĂAtotal_͋L^n߂Ă)
+	//   { "time" : 12.0, "interval" : 1.0, "stages" : [ { "name" : "acquire", "count" : 30, "p50_ms" : 0.05, "p99_ms" : 0.2, "max_ms" : 0.3, "total_count" : 360, ... }, ... ] }
+	void writeFile( double now ) const
+	{
+		const std::string temporaryPath = path + ".tmp";
+		{
+			std::ofstream ofs( temporaryPath.c_str() );
+			if( !ofs ){
+				return;
+			}
+			ofs << std::fixed << std::setprecision( 3 );
+			ofs << "{" << std::endl;
+			ofs << "  \"time\" : " << now - startTime << "," << std::endl;
+			ofs << "  \"interval\" : " << now - lastTime << "," << std::endl;
+			ofs << "  \"stages\" : [" << std::endl;
+			for( int i = 0; i < METRIC_STAGE_COUNT; i++ ){
+				ofs << "    { \"name\" : \"" << getMetricStageName( static_cast<MetricStage>( i ) ) << "\"";
+				writeStatistics( ofs, "", interval[i] );
+				writeStatistics( ofs, "total_", total[i] );
+				ofs << " }" << ( i + 1 < METRIC_STAGE_COUNT ? "," : "" ) << std::endl;
+			}
+			ofs << "  ]" << std::endl;
+			ofs << "}" << std::endl;
+			if( !ofs ){
+				return;
+			}
+		}
+		replaceFile( temporaryPath.c_str(), path.c_str() );
+	}
+
+	std::string path;
+	double intervalSeconds;
+	double startTime;
+	double lastTime;
+	volatile long stopRequested;
+	LatencyHistogram total[METRIC_STAGE_COUNT];
+	LatencyHistogram interval[METRIC_STAGE_COUNT];
+	LatencyHistogram previous[METRIC_STAGE_COUNT];
+	Mutex mutex;
+	Thread thread;
+
+	MetricsReporter( const MetricsReporter& );
+	MetricsReporter& operator=( const MetricsReporter& );
+};
+
+// vȌIg_metricRegistryɔj(Ō̏WvoĂ~܂)悤ɁAɒ`
+static MetricsReporter g_metricsReporter;
+
+bool startMetricsReporter( const char* path, double intervalSeconds )
+{
+	return g_metricsReporter.start( path, intervalSeconds );
+}
+
+void stopMetricsReporter()
+{
+	g_metricsReporter.stop();
+}
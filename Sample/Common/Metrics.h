@@ -0,0 +1,114 @@
+// Metrics.h : ̒i̎ԂƃZT[o͂܂ł̒xqXgOɋL^AIɏo
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "LatencyHistogram.h"
+#include "Platform.h"
+#include "Trace.h"
+
+
+// vi
+enum MetricStage
+{
+	METRIC_ACQUIRE,             // t[̎擾(NuiImageStreamGetNextFrame()ANuiSkeletonGetNextFrame())
+	METRIC_LOCK,                // LockRect()UnlockRect()܂(Oobt@ւ̃Rs[܂)
+	METRIC_REGISTER,            // ʒu킹Depth̃fR[h(DepthPipeline)
+	METRIC_MORPH,               // Mathematical MorphologyƐ؂蔲(ClippingProcessor)
+	METRIC_TRACK,               // ̒ǐ(StartTracking()AContinueTracking())
+	METRIC_DRAW,                // `ƕ\
+	METRIC_RELEASE,             // t[̉(NuiImageStreamReleaseFrame())
+	METRIC_LATENCY,             // ZT[̃^CX^vo͂܂(recordFrameLatency())
+	METRIC_RENDER_INTERVAL,     // \̊Ԋu(FrameTiming)
+	METRIC_CAPTURE_INTERVAL,    // 擾̊Ԋu(FrameTiming)
+	METRIC_CAPTURE_TO_PRESENT,  // 擾\܂(FrameTiming)
+	METRIC_STAGE_COUNT
+};
+
+inline const char* getMetricStageName( MetricStage stage )
+{
+	switch( stage ){
+		case METRIC_ACQUIRE:
+			return "acquire";
+		case METRIC_LOCK:
+			return "lock";
+		case METRIC_REGISTER:
+			return "register";
+		case METRIC_MORPH:
+			return "morph";
+		case METRIC_TRACK:
+			return "track";
+		case METRIC_DRAW:
+			return "draw";
+		case METRIC_RELEASE:
+			return "release";
+		case METRIC_LATENCY:
+			return "latency";
+		case METRIC_RENDER_INTERVAL:
+			return "render_interval";
+		case METRIC_CAPTURE_INTERVAL:
+			return "capture_interval";
+		case METRIC_CAPTURE_TO_PRESENT:
+			return "capture_to_present";
+		default:
+			return "unknown";
+	}
+}
+
+// L^Lɂ(ł͖ŁAg[XȂScopedMetric͎ǂ܂Ȃ)
+void setMetricsEnabled( bool enabled );
+bool isMetricsEnabled();
+
+// [s]݂̃Xbh̃qXgOɋL^
+// qXgO̓XbhɎ̂ŁAL^ƂɃbNs͎gȂ
+// (Xbh̃qXgO͏߂ċL^ƂɊmۂAXbh̐METRIC_MAX_THREADS𒴂͋L^Ȃ)
+static const int METRIC_MAX_THREADS = 32;
+void recordMetric( MetricStage stage, double seconds );
+
+// Kinectt[͂ƂɁÃ^CX^v[ms](NUI_IMAGE_FRAME::liTimeStamp)n
+// ZT[̎vƂPC̎v̍A߂̈莞Ԃɓ͂t[̂ł͂̂Ő肷
+void recordFrameArrival( int64_t timestamp );
+
+// ^CX^v[ms]̃t[o(\)ƂɌĂяoAZT[o͂܂ł̒xMETRIC_LATENCYɋL^
+// x͍ł͂t[ɂlŁAUSB̓]Ȃǂ̏ɂ镪͊܂܂Ȃ
+// (͂ȂL^̍ĐȂǂł́Ało͂t[ɂh炬ɂȂ)
+void recordFrameLatency( int64_t timestamp );
+
+// ScopedMetric̏ԂL^(L^LȂqXgOɁAg[XLȂi̖ÕCxgƂċL^)
+void recordMetricScope( MetricStage stage, double startSeconds, double endSeconds );
+
+// SẴXbh̃qXgO킹(L^n߂Ă̗݌v)snapshotɋ߂
+void getMetricSnapshot( MetricStage stage, LatencyHistogram& snapshot );
+
+// ʂ̃XbhŒI(intervalSeconds)WvāA߂̋ԂƗ݌vp50Ap99Aőlo
+// path̃t@CJSONŁAoxɒu(̃vZXǂނƂɏɂȂȂ悤ɁAꎞt@CɏĂ疼Oς)
+// path"-"̂Ƃ̓t@C̑ɕWo͂1so
+// JnƋL^LɂȂAstopMetricsReporter()܂̓vȌIɍŌ̏WvoĎ~܂
+bool startMetricsReporter( const char* path, double intervalSeconds = 1.0 );
+void stopMetricsReporter();
+
+// XR[v̏ԂL^(g[XLȂƂ̓CxgL^)
+class ScopedMetric
+{
+public:
+	explicit ScopedMetric( MetricStage stage )
+		: stage( stage ), start( ( isMetricsEnabled() || isTraceEnabled() ) ? getTimeInSeconds() : -1.0 )
+	{
+	}
+
+	~ScopedMetric()
+	{
+		if( start >= 0.0 ){
+			recordMetricScope( stage, start, getTimeInSeconds() );
+		}
+	}
+
+private:
+	MetricStage stage;
+	double start;
+
+	ScopedMetric( const ScopedMetric& );
+	ScopedMetric& operator=( const ScopedMetric& );
+};
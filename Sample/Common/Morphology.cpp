@@ -0,0 +1,254 @@
+// Morphology.cpp : 8rbg̃}XN摜̎kƖc
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Morphology.h"
+#include <cstring>
+
+
+#ifdef KINECT_SIMD_X86
+
+// SSE4.1(g߂SSE2͈̔)
+// 16fŏl/ől߂
+KINECT_TARGET_SSE41
+static void combineSse41( uint8_t* dst, const uint8_t* a, const uint8_t* b, int count, bool minimum )
+{
+	int i = 0;
+	if( minimum ){
+		for( ; i + 16 <= count; i += 16 ){
+			const __m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) );
+			const __m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + i ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i ), _mm_min_epu8( va, vb ) );
+		}
+		for( ; i < count; i++ ){
+			dst[i] = a[i] < b[i] ? a[i] : b[i];
+		}
+	}
+	else{
+		for( ; i + 16 <= count; i += 16 ){
+			const __m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) );
+			const __m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + i ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i ), _mm_max_epu8( va, vb ) );
+		}
+		for( ; i < count; i++ ){
+			dst[i] = a[i] > b[i] ? a[i] : b[i];
+		}
+	}
+}
+
+// 16~16f̃ubNɓ]u([̉f̓XJ[ŏ)
+// isi + 8soCgPʂŌ݂ɕׂƁAsƗ̔ԍ킹8rbg1rbg]̂ŁA4ōsƗ񂪓ւ
+KINECT_TARGET_SSE41
+static void transposeSse41( const uint8_t* src, uint8_t* dst, int width, int height )
+{
+	const int blockWidth = width & ~15;
+	const int blockHeight = height & ~15;
+	for( int y = 0; y < blockHeight; y += 16 ){
+		for( int x = 0; x < blockWidth; x += 16 ){
+			__m128i rows[16];
+			for( int i = 0; i < 16; i++ ){
+				rows[i] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + ( y + i ) * width + x ) );
+			}
+			for( int round = 0; round < 4; round++ ){
+				__m128i next[16];
+				for( int i = 0; i < 8; i++ ){
+					next[2 * i]     = _mm_unpacklo_epi8( rows[i], rows[i + 8] );
+					next[2 * i + 1] = _mm_unpackhi_epi8( rows[i], rows[i + 8] );
+				}
+				for( int i = 0; i < 16; i++ ){
+					rows[i] = next[i];
+				}
+			}
+			for( int i = 0; i < 16; i++ ){
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + ( x + i ) * height + y ), rows[i] );
+			}
+		}
+	}
+	for( int y = 0; y < height; y++ ){
+		const int begin = ( y < blockHeight ) ? blockWidth : 0;
+		for( int x = begin; x < width; x++ ){
+			dst[x * height + y] = src[y * width + x];
+		}
+	}
+}
+
+#endif
+
+
+MorphologyFilter::MorphologyFilter()
+	: shape( MORPHOLOGY_RECT ), simdLevel( getSimdLevel() )
+{
+}
+
+void MorphologyFilter::erode( uint8_t* image, int width, int height, int iterations )
+{
+	if( iterations > 0 ){
+		filter( image, width, height, iterations, true );
+	}
+}
+
+void MorphologyFilter::dilate( uint8_t* image, int width, int height, int iterations )
+{
+	if( iterations > 0 ){
+		filter( image, width, height, iterations, false );
+	}
+}
+
+void MorphologyFilter::filter( uint8_t* image, int width, int height, int iterations, bool minimum )
+{
+	// `ceil( iterations / 2 )A\floor( iterations / 2 )
+	// \kJԂƔak̂Ђ`ɂȂA`ƂЂ`킹Ɣp`ɂȂ
+	const int rectRadius = ( shape == MORPHOLOGY_OCTAGON ) ? ( iterations + 1 ) / 2 : iterations;
+	const int diamondRadius = iterations - rectRadius;
+	if( diamondRadius == 0 ){
+		rectPass( image, width, height, rectRadius, minimum );
+		return;
+	}
+
+	// Ђ`2{̎΂߂̘̐a(΂߂̘̐a͎s͗l̔̉f܂܂ȂAa1ȏ̋`ƍ킹Ɩ܂)
+	// ̓r̈ʒu摜̊OɏoĂ摜̊OPʌƂĈ悤ɁA͂iterationsfL摜ŏ
+	const uint8_t neutral = minimum ? 255 : 0;
+	const int canvasWidth = width + 2 * iterations;
+	const int canvasHeight = height + 2 * iterations;
+	canvas.assign( static_cast<size_t>( canvasWidth ) * canvasHeight, neutral );
+	for( int y = 0; y < height; y++ ){
+		std::memcpy( &canvas[( y + iterations ) * canvasWidth + iterations], image + y * width, width );
+	}
+
+	rectPass( &canvas[0], canvasWidth, canvasHeight, rectRadius, minimum );
+
+	// Eւ̐(i, i)ƍւ̐(-j, j)̘a(i - j + shift, i + j)ɂȂ
+	// diamondRadius̂Ƃ͐̒ɂȂAS1fEɂ̂shiftŖ߂
+	const int half = diamondRadius / 2;
+	diagonalPass( &canvas[0], canvasWidth, canvasHeight, 1, half, diamondRadius - half, -( diamondRadius % 2 ), minimum );
+	diagonalPass( &canvas[0], canvasWidth, canvasHeight, -1, diamondRadius - half, half, 0, minimum );
+
+	for( int y = 0; y < height; y++ ){
+		std::memcpy( image + y * width, &canvas[( y + iterations ) * canvasWidth + iterations], width );
+	}
+}
+
+void MorphologyFilter::rectPass( uint8_t* image, int width, int height, int radius, bool minimum )
+{
+	if( radius <= 0 ){
+		return;
+	}
+
+	//  : ]uďcɏĂ߂(fsɉĕԂ̂ŁAsPʂ̍ŏl/őlSIMDŋ߂)
+	transposed.resize( static_cast<size_t>( width ) * height );
+	transpose( image, &transposed[0], width, height );
+	linePass( &transposed[0], height, width, radius, radius, minimum );
+	transpose( &transposed[0], image, height, width );
+
+	// c
+	linePass( image, width, height, radius, radius, minimum );
+}
+
+void MorphologyFilter::linePass( uint8_t* image, int width, int height, int before, int after, bool minimum )
+{
+	const int length = before + after + 1;
+	if( length <= 1 || width <= 0 || height <= 0 ){
+		return;
+	}
+
+	// 摜̏㉺beforesaftersLst = -before ... height - 1 + afterAlength̃ubNɕ
+	// ubN̖̗ݐsuffixƐ擪̗ݐprefix߂ƁA
+	// yšʂ( y - before )ssuffix( y + after )sprefix̍ŏl/őlɂȂ(1s3̔r)
+	const int rows = height + length - 1;
+	suffix.resize( static_cast<size_t>( rows ) * width );
+	prefix.resize( width );
+	neutralRow.assign( width, minimum ? 255 : 0 );
+	auto row = [&]( int index ) -> const uint8_t* {
+		const int t = index - before;
+		return ( t >= 0 && t < height ) ? image + t * width : &neutralRow[0];
+	};
+
+	for( int index = rows - 1; index >= 0; index-- ){
+		uint8_t* dst = &suffix[index * width];
+		if( ( index % length == length - 1 ) || ( index == rows - 1 ) ){
+			std::memcpy( dst, row( index ), width );
+		}
+		else{
+			combine( dst, row( index ), dst + width, width, minimum );
+		}
+	}
+
+	// ʂ̍syނƂɂ́A艺̍sǂނ̂ŉ摜̂܂܏
+	for( int index = 0; index < rows; index++ ){
+		if( index % length == 0 ){
+			std::memcpy( &prefix[0], row( index ), width );
+		}
+		else{
+			combine( &prefix[0], &prefix[0], row( index ), width, minimum );
+		}
+		const int y = index - ( length - 1 );
+		if( y >= 0 ){
+			combine( image + y * width, &suffix[y * width], &prefix[0], width, minimum );
+		}
+	}
+}
+
+void MorphologyFilter::diagonalPass( uint8_t* image, int width, int height, int direction, int before, int after, int shift, bool minimum )
+{
+	// stdirection ~ tf炵ĕ(u = x - direction ~ y)A΂߂̐c̐ɂ
+	const uint8_t neutral = minimum ? 255 : 0;
+	const int shearedWidth = width + height - 1;
+	const int origin = ( direction > 0 ) ? height - 1 : 0;
+	sheared.resize( static_cast<size_t>( shearedWidth ) * height );
+	for( int t = 0; t < height; t++ ){
+		uint8_t* dst = &sheared[t * shearedWidth];
+
+		// cɂ͉摜x = c - origin + direction ~ t + shift̉f
+		const int offset = origin - direction * t - shift;
+		const int begin = ( offset > 0 ) ? offset : 0;
+		const int end = ( offset + width < shearedWidth ) ? offset + width : shearedWidth;
+		if( begin >= end ){
+			std::memset( dst, neutral, shearedWidth );
+			continue;
+		}
+		std::memset( dst, neutral, begin );
+		std::memcpy( dst + begin, image + t * width + ( begin - offset ), end - begin );
+		std::memset( dst + end, neutral, shearedWidth - end );
+	}
+
+	linePass( &sheared[0], shearedWidth, height, before, after, minimum );
+
+	for( int y = 0; y < height; y++ ){
+		std::memcpy( image + y * width, &sheared[y * shearedWidth + origin - direction * y], width );
+	}
+}
+
+void MorphologyFilter::combine( uint8_t* dst, const uint8_t* a, const uint8_t* b, int count, bool minimum ) const
+{
+#ifdef KINECT_SIMD_X86
+	if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+		combineSse41( dst, a, b, count, minimum );
+		return;
+	}
+#endif
+	if( minimum ){
+		for( int i = 0; i < count; i++ ){
+			dst[i] = a[i] < b[i] ? a[i] : b[i];
+		}
+	}
+	else{
+		for( int i = 0; i < count; i++ ){
+			dst[i] = a[i] > b[i] ? a[i] : b[i];
+		}
+	}
+}
+
+void MorphologyFilter::transpose( const uint8_t* src, uint8_t* dst, int width, int height ) const
+{
+#ifdef KINECT_SIMD_X86
+	if( ( simdLevel >= SIMD_SSE41 ) && ( getSimdLevel() >= SIMD_SSE41 ) ){
+		transposeSse41( src, dst, width, height );
+		return;
+	}
+#endif
+	for( int y = 0; y < height; y++ ){
+		for( int x = 0; x < width; x++ ){
+			dst[x * height + y] = src[y * width + x];
+		}
+	}
+}
@@ -0,0 +1,69 @@
+// Morphology.h : 8rbg̃}XN摜̎kƖc
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "Simd.h"
+
+
+// \vf̌`
+enum MorphologyShape
+{
+	MORPHOLOGY_RECT = 0, // 3~3̋`(cv::Mat()AMORPH_RECT)iterations
+	MORPHOLOGY_OCTAGON   // 3~3̋`Ə\(MORPH_CROSS)`݂iterations(p`ɂȂ)
+};
+
+// 3~3̍\vfiterationsk/c
+// cv::erode()/cv::dilate()3~3̍\vfƊ̋EnƂƓʂɂȂ
+// (摜̊Ỏf́Akł͍őlAcł͍ŏlƂĈ̂ŌʂɉeȂ)
+// iterationsJԂ̂͑傫ȍ\vf1񏈗̂ƓȂ̂ŁA
+// `͉ƏcAp`͂2{̎΂߂̐ɕAꂼvan Herk/Gil-Werman̕@ŏ
+// (̒̃ubN̐擪̗ݐςƖ̗ݐς߂̂ŁA1f̔riterationsɂ炸)
+class MorphologyFilter
+{
+public:
+	MorphologyFilter();
+
+	// \vf̌`(łMORPHOLOGY_RECT)
+	void setShape( MorphologyShape shape ) { this->shape = shape; }
+	MorphologyShape getShape() const { return shape; }
+
+	// gp閽߃Zbg(łCPUΉĂł߃Zbg)
+	void setSimdLevel( SimdLevel level ) { simdLevel = level; }
+
+	// image(iterations0ȉ̂Ƃ͉Ȃ)
+	void erode( uint8_t* image, int width, int height, int iterations );
+	void dilate( uint8_t* image, int width, int height, int iterations );
+
+private:
+	void filter( uint8_t* image, int width, int height, int iterations, bool minimum );
+
+	// (2 ~ radius + 1)l̋`
+	void rectPass( uint8_t* image, int width, int height, int radius, bool minimum );
+
+	// c̐ : image(x, y) = op( image(x, y - before) ... image(x, y + after) )
+	void linePass( uint8_t* image, int width, int height, int before, int after, bool minimum );
+
+	// ΂߂̐ : image(x, y) = op( image(x + direction ~ i + shift, y + i) )Ai = -before ... afterAdirection1-1
+	void diagonalPass( uint8_t* image, int width, int height, int direction, int before, int after, int shift, bool minimum );
+
+	// dst[i] = op( a[i], b[i] )
+	void combine( uint8_t* dst, const uint8_t* a, const uint8_t* b, int count, bool minimum ) const;
+
+	// dst(y, x) = src(x, y)Adst̕height
+	void transpose( const uint8_t* src, uint8_t* dst, int width, int height ) const;
+
+	MorphologyShape shape;
+	SimdLevel simdLevel;
+
+	std::vector<uint8_t> transposed; // ̏̂߂ɓ]u摜
+	std::vector<uint8_t> suffix;     // ubN̖̗ݐ(̒ - 1s)
+	std::vector<uint8_t> prefix;     // ubN̐擪̗ݐ(1s)
+	std::vector<uint8_t> neutralRow; // 摜̊O̍s(kł255Acł0)
+	std::vector<uint8_t> canvas;     // p`̂ƂɎ͂L摜
+	std::vector<uint8_t> sheared;    // ΂߂̐cɕׂ摜
+};
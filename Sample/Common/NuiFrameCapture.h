@@ -0,0 +1,56 @@
+// NuiFrameCapture.h : Kinect SDK̃t[Oobt@փRs[Ăɉ
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <Windows.h>
+#include <NuiApi.h>
+#include "FrameRing.h"
+#include "Metrics.h"
+
+
+// Xg[玟̃t[擾AOobt@փRs[Ă璼NuiImageStreamReleaseFrame()Ăяo
+// hCõobt@͏\̊ԂLȂ̂ŁANuiImageStreamOpen()̃L[2t[łɂȂ
+// dropCounternƃt[ԍ̔т痎t[𐔂
+// Oobt@̑SẴXbgێĂƂS_FALSEԂ(handle͋ɂȂ)
+// 擾AbNƃRs[A̎ԂMETRIC_ACQUIREAMETRIC_LOCKAMETRIC_RELEASEɋL^
+inline HRESULT captureImageFrame( INuiSensor* pSensor, HANDLE hStream, FrameRing& ring, FrameHandle& handle, FrameDropCounter* dropCounter = nullptr )
+{
+	handle.reset();
+
+	NUI_IMAGE_FRAME sImageFrame = { 0 };
+	HRESULT hResult;
+	{
+		ScopedMetric metric( METRIC_ACQUIRE );
+		hResult = pSensor->NuiImageStreamGetNextFrame( hStream, 0, &sImageFrame );
+	}
+	if( FAILED( hResult ) ){
+		return hResult;
+	}
+	recordFrameArrival( sImageFrame.liTimeStamp.QuadPart );
+	setTraceFrame( sImageFrame.dwFrameNumber );
+
+	INuiFrameTexture* pFrameTexture = sImageFrame.pFrameTexture;
+	NUI_LOCKED_RECT sLockedRect;
+	{
+		ScopedMetric metric( METRIC_LOCK );
+		hResult = pFrameTexture->LockRect( 0, &sLockedRect, nullptr, 0 );
+		if( SUCCEEDED( hResult ) ){
+			const bool written = ring.write( reinterpret_cast<const uint8_t*>( sLockedRect.pBits ), sLockedRect.Pitch, sImageFrame.dwFrameNumber, sImageFrame.liTimeStamp.QuadPart, handle );
+			pFrameTexture->UnlockRect( 0 );
+			hResult = written ? S_OK : S_FALSE;
+		}
+	}
+
+	// Rs[ς񂾂炷ɃhCo֕Ԃ
+	{
+		ScopedMetric metric( METRIC_RELEASE );
+		pSensor->NuiImageStreamReleaseFrame( hStream, &sImageFrame );
+	}
+
+	if( dropCounter ){
+		dropCounter->update( sImageFrame.dwFrameNumber );
+	}
+	return hResult;
+}
@@ -0,0 +1,399 @@
+// NuiFrameSource.h : Kinectt[擾t[\[X
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <Windows.h>
+#include <NuiApi.h>
+#include <tchar.h>
+#include <memory>
+#include <string>
+#include "FrameSource.h"
+#include "FrameSynchronizer.h"
+#include "ReplayFrameSource.h"
+#include "SyntheticFrameSource.h"
+#include "NuiFrameCapture.h"
+#include "NuiRegistration.h"
+
+
+// NuiFrameSourceŎgݒ(FRAME_STREAM_FLAG_*Ƒgݍ킹Ďw肷)
+static const int NUI_FRAME_SOURCE_NEAR_MODE  = 1 << 8;  // DepthNear Modeɂ
+static const int NUI_FRAME_SOURCE_DEPTH_ONLY = 1 << 9;  // Player̃CfbNXgȂ(NUI_IMAGE_TYPE_DEPTH)
+static const int NUI_FRAME_SOURCE_SEATED     = 1 << 10; // Skeleton̒ǐՂSeated Modeɂ
+static const int NUI_FRAME_SOURCE_SYNC_EVERY_DEPTH = 1 << 11; // Depth̑SẴt[擾(SYNC_EVERY_DEPTH)
+static const int NUI_FRAME_SOURCE_SYNC_ANY_STREAM  = 1 << 12; // ǂꂩ̃Xg[XVꂽ擾(SYNC_ANY_STREAM)
+static const int NUI_FRAME_SOURCE_PLAYER_STATS     = 1 << 13; // "-record"̂ƂɁAŋ߂Player̓vL^(RecordingFrameSource::writePlayerStats())
+
+// Kinectt[擾
+// 擾ColorADepth&Player̃t[̓Oobt@փRs[ĂɃhCo֕Ԃ
+// Xg[ɓ͂t[FrameSynchronizerŃ^CX^v߂̓mgݍ킹
+// (ł̓^CX^vŐV̑g擾AjNUI_FRAME_SOURCE_SYNC_*őI)
+class NuiFrameSource : public FrameSource
+{
+public:
+	// Oobt@ɂFrameSynchronizer̃L[AȎgȂg̃̕Xbgpӂ
+	NuiFrameSource()
+		: pSensor( nullptr ), streams( 0 ),
+		  colorRing( PIXEL_FORMAT_BGRX32, 640, 480, FrameSynchronizer::DEFAULT_QUEUE_DEPTH + 2 ),
+		  depthRing( PIXEL_FORMAT_DEPTH16, 640, 480, FrameSynchronizer::DEFAULT_QUEUE_DEPTH + 2 )
+	{
+		for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+			hEvents[i] = INVALID_HANDLE_VALUE;
+			hStreams[i] = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	~NuiFrameSource()
+	{
+		close();
+	}
+
+	// settingsFRAME_STREAM_FLAG_*NUI_FRAME_SOURCE_*̑g
+	HRESULT open( int settings, int sensorIndex = 0 )
+	{
+		close();
+		streams = settings & FRAME_STREAM_FLAG_ALL;
+		synchronizer.setStreams( streams );
+		if( settings & NUI_FRAME_SOURCE_SYNC_EVERY_DEPTH ){
+			synchronizer.setPolicy( SYNC_EVERY_DEPTH );
+		}
+		else if( settings & NUI_FRAME_SOURCE_SYNC_ANY_STREAM ){
+			synchronizer.setPolicy( SYNC_ANY_STREAM );
+		}
+		else{
+			synchronizer.setPolicy( SYNC_LATEST_MATCHED );
+		}
+		synchronizer.resetStatistics();
+
+		HRESULT hResult = NuiCreateSensorByIndex( sensorIndex, &pSensor );
+		if( FAILED( hResult ) ){
+			pSensor = nullptr;
+			return hResult;
+		}
+
+		DWORD initializeFlags = 0;
+		if( streams & FRAME_STREAM_FLAG_COLOR ){
+			initializeFlags |= NUI_INITIALIZE_FLAG_USES_COLOR;
+		}
+		if( streams & FRAME_STREAM_FLAG_DEPTH ){
+			initializeFlags |= ( settings & NUI_FRAME_SOURCE_DEPTH_ONLY ) ? NUI_INITIALIZE_FLAG_USES_DEPTH : NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX;
+		}
+		if( streams & FRAME_STREAM_FLAG_SKELETON ){
+			initializeFlags |= NUI_INITIALIZE_FLAG_USES_SKELETON;
+		}
+		hResult = pSensor->NuiInitialize( initializeFlags );
+		if( FAILED( hResult ) ){
+			return hResult;
+		}
+
+		// ColorXg[
+		if( streams & FRAME_STREAM_FLAG_COLOR ){
+			hEvents[FRAME_STREAM_COLOR] = CreateEvent( nullptr, true, false, nullptr );
+			hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hEvents[FRAME_STREAM_COLOR], &hStreams[FRAME_STREAM_COLOR] );
+			if( FAILED( hResult ) ){
+				return hResult;
+			}
+		}
+
+		// Depth(&Player)Xg[
+		if( streams & FRAME_STREAM_FLAG_DEPTH ){
+			const NUI_IMAGE_TYPE type = ( settings & NUI_FRAME_SOURCE_DEPTH_ONLY ) ? NUI_IMAGE_TYPE_DEPTH : NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX;
+			hEvents[FRAME_STREAM_DEPTH] = CreateEvent( nullptr, true, false, nullptr );
+			hResult = pSensor->NuiImageStreamOpen( type, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hEvents[FRAME_STREAM_DEPTH], &hStreams[FRAME_STREAM_DEPTH] );
+			if( FAILED( hResult ) ){
+				return hResult;
+			}
+			if( settings & NUI_FRAME_SOURCE_NEAR_MODE ){
+				hResult = pSensor->NuiImageStreamSetImageFrameFlags( hStreams[FRAME_STREAM_DEPTH], NUI_IMAGE_STREAM_FLAG_ENABLE_NEAR_MODE );
+				if( FAILED( hResult ) ){
+					return hResult;
+				}
+			}
+		}
+
+		// SkeletonXg[
+		if( streams & FRAME_STREAM_FLAG_SKELETON ){
+			const DWORD trackingFlags = ( settings & NUI_FRAME_SOURCE_SEATED ) ? ( NUI_SKELETON_TRACKING_FLAG_SUPPRESS_NO_FRAME_DATA | NUI_SKELETON_TRACKING_FLAG_ENABLE_SEATED_SUPPORT ) : 0;
+			hEvents[FRAME_STREAM_SKELETON] = CreateEvent( nullptr, true, false, nullptr );
+			hResult = pSensor->NuiSkeletonTrackingEnable( hEvents[FRAME_STREAM_SKELETON], trackingFlags );
+			if( FAILED( hResult ) ){
+				return hResult;
+			}
+		}
+		return S_OK;
+	}
+
+	void close()
+	{
+		if( pSensor ){
+			if( streams & FRAME_STREAM_FLAG_SKELETON ){
+				pSensor->NuiSkeletonTrackingDisable();
+			}
+			pSensor->NuiShutdown();
+			pSensor = nullptr;
+		}
+		for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+			if( hEvents[i] != INVALID_HANDLE_VALUE ){
+				CloseHandle( hEvents[i] );
+			}
+			hEvents[i] = INVALID_HANDLE_VALUE;
+			hStreams[i] = INVALID_HANDLE_VALUE;
+		}
+		synchronizer.clear();
+		streams = 0;
+	}
+
+	INuiSensor* getSensor() const { return pSensor; }
+
+	// e͈͂ȂǂςƂɎg(jopen()settingsőI)
+	FrameSynchronizer& getSynchronizer() { return synchronizer; }
+
+	bool isFrameReady()
+	{
+		return pSensor && captureReadyFrames() && synchronizer.isReady();
+	}
+
+	bool read( FrameSet& frames )
+	{
+		frames.reset();
+		if( !pSensor ){
+			return false;
+		}
+
+		HANDLE hWaitEvents[FRAME_STREAM_COUNT];
+		const DWORD count = getWaitEvents( hWaitEvents );
+		while( !synchronizer.pop( frames, getTimeInSeconds() ) ){
+			// ǂꂩ̃Xg[̃t[̍XV҂
+			if( WaitForMultipleObjects( count, hWaitEvents, false, INFINITE ) >= WAIT_OBJECT_0 + count ){
+				return false;
+			}
+			if( !captureReadyFrames() ){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int getStreams() const { return streams; }
+	const FrameDropCounter& getDropCounter( FrameStream stream ) const { return dropCounters[stream]; }
+
+private:
+	static_assert( sizeof( SkeletonFrame ) == sizeof( NUI_SKELETON_FRAME ), "SkeletonFrame must have the same layout as NUI_SKELETON_FRAME" );
+
+	DWORD getWaitEvents( HANDLE* hWaitEvents ) const
+	{
+		DWORD count = 0;
+		for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+			if( streams & ( 1 << i ) ){
+				hWaitEvents[count++] = hEvents[i];
+			}
+		}
+		return count;
+	}
+
+	// XVĂXg[̃t[SĎ擾āAFrameSynchronizer֓n
+	// Cxg̓t[擾ƃ^CZbĝŁAResetEvent()͌Ă΂Ȃ
+	// (҂ɃZbgƁÅԂɓ͂t[̒ʒmƂ)
+	bool captureReadyFrames()
+	{
+		const double arrival = getTimeInSeconds();
+		for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+			if( !( streams & ( 1 << i ) ) || WaitForSingleObject( hEvents[i], 0 ) != WAIT_OBJECT_0 ){
+				continue;
+			}
+			if( i == FRAME_STREAM_SKELETON ){
+				// Skeletont[擾(NUI_SKELETON_FRAMESkeletonFrame͓)
+				NUI_SKELETON_FRAME sSkeletonFrame = { 0 };
+				HRESULT hResult;
+				{
+					ScopedMetric metric( METRIC_ACQUIRE );
+					hResult = pSensor->NuiSkeletonGetNextFrame( 0, &sSkeletonFrame );
+				}
+				if( hResult == E_NUI_FRAME_NO_DATA ){
+					continue;
+				}
+				if( FAILED( hResult ) ){
+					return false;
+				}
+				synchronizer.pushSkeleton( reinterpret_cast<const SkeletonFrame&>( sSkeletonFrame ), arrival );
+				dropCounters[FRAME_STREAM_SKELETON].update( sSkeletonFrame.dwFrameNumber );
+				continue;
+			}
+
+			// ColorJADepthZT[t[擾
+			// Oobt@tŎ̂ĂƂ(S_FALSE)̓t[nȂ
+			ImageFrame frame;
+			FrameRing& ring = ( i == FRAME_STREAM_COLOR ) ? colorRing : depthRing;
+			const HRESULT hResult = captureImageFrame( pSensor, hStreams[i], ring, frame.handle, &dropCounters[i] );
+			if( hResult == E_NUI_FRAME_NO_DATA ){
+				continue;
+			}
+			if( FAILED( hResult ) ){
+				return false;
+			}
+			if( hResult == S_OK ){
+				frame.data = frame.handle.data();
+				frame.info = frame.handle.info();
+				synchronizer.push( static_cast<FrameStream>( i ), frame, arrival );
+			}
+		}
+		return true;
+	}
+
+	INuiSensor* pSensor;
+	int streams;
+	HANDLE hEvents[FRAME_STREAM_COUNT];
+	HANDLE hStreams[FRAME_STREAM_COUNT];
+	FrameRing colorRing;
+	FrameRing depthRing;
+	FrameSynchronizer synchronizer;
+	FrameDropCounter dropCounters[FRAME_STREAM_COUNT];
+
+	NuiFrameSource( const NuiFrameSource& );
+	NuiFrameSource& operator=( const NuiFrameSource& );
+};
+
+// NuiFrameSourceg(NUI_SKELETON_FRAME󂯎)SkeletonFramen
+inline const NUI_SKELETON_FRAME& toNuiSkeletonFrame( const SkeletonFrame& frame )
+{
+	return reinterpret_cast<const NUI_SKELETON_FRAME&>( frame );
+}
+
+// t[\[XgĂKinect̃CX^X(L^t@CĐĂƂnullptr)
+inline INuiSensor* getNuiSensor( FrameSource* source )
+{
+	RecordingFrameSource* recording = dynamic_cast<RecordingFrameSource*>( source );
+	if( recording ){
+		source = recording->getSource();
+	}
+	NuiFrameSource* nui = dynamic_cast<NuiFrameSource*>( source );
+	return nui ? nui->getSensor() : nullptr;
+}
+
+// R}hC̕}`oCgɕϊ
+inline std::string toMultiByteString( const _TCHAR* text )
+{
+#ifdef _UNICODE
+	const int size = WideCharToMultiByte( CP_ACP, 0, text, -1, nullptr, 0, nullptr, nullptr );
+	if( size <= 1 ){
+		return std::string();
+	}
+	std::string result( size - 1, '\0' );
+	WideCharToMultiByte( CP_ACP, 0, text, -1, &result[0], size, nullptr, nullptr );
+	return result;
+#else
+	return std::string( text );
+#endif
+}
+
+// R}hCɏ]ăt[\[X
+// "-replay <file>"w肳Ă΋L^t@CԂōĐA"-synthetic <l>"w肳Ă΍V[ԂŐAKinectg
+// "-record <file>"w肳Ă΁AKinect܂͍V[̃t[L^t@Cɏ(Depth͉tk)
+// tablenƈʒu킹e[u(Kinect̂Ƃ̓ZT[AȊO"-table <file>"ǂݍނJf̌̒l)
+// "-metrics <file>"w肳Ă΁AȉԂƒx̃qXgOL^ăt@Cɏo("-"̂Ƃ͕WóAMetrics.hQ)
+// "-trace <file>"w肳Ă΁Aȉ̊JnƏIL^ďI(܂writeTrace()ĂяoƂ)Ƀt@Cɏo(Trace.hQ)
+inline HRESULT createFrameSource( int argc, _TCHAR* argv[], int settings, std::unique_ptr<FrameSource>& source, RegistrationTable* table = nullptr )
+{
+	std::string replayPath;
+	std::string recordPath;
+	std::string tablePath;
+	std::string metricsPath;
+	std::string tracePath;
+	int syntheticPlayers = 0;
+	for( int i = 1; i + 1 < argc; i++ ){
+		if( _tcscmp( argv[i], _T( "-replay" ) ) == 0 ){
+			replayPath = toMultiByteString( argv[++i] );
+		}
+		else if( _tcscmp( argv[i], _T( "-record" ) ) == 0 ){
+			recordPath = toMultiByteString( argv[++i] );
+		}
+		else if( _tcscmp( argv[i], _T( "-table" ) ) == 0 ){
+			tablePath = toMultiByteString( argv[++i] );
+		}
+		else if( _tcscmp( argv[i], _T( "-synthetic" ) ) == 0 ){
+			syntheticPlayers = _ttoi( argv[++i] );
+		}
+		else if( _tcscmp( argv[i], _T( "-metrics" ) ) == 0 ){
+			metricsPath = toMultiByteString( argv[++i] );
+		}
+		else if( _tcscmp( argv[i], _T( "-trace" ) ) == 0 ){
+			tracePath = toMultiByteString( argv[++i] );
+		}
+	}
+
+	// ȉԂƒx̋L^(1bɏWvďo)
+	if( !metricsPath.empty() && !startMetricsReporter( metricsPath.c_str() ) ){
+		return E_FAIL;
+	}
+
+	// ȉ̊JnƏI̋L^(IChromẽg[X`ŏo)
+	if( !tracePath.empty() ){
+		if( !startTrace( tracePath.c_str() ) ){
+			return E_FAIL;
+		}
+		setTraceThreadName( "main" );
+	}
+
+	// KinectgȂƂ̈ʒu킹e[u
+	if( table && ( !replayPath.empty() || syntheticPlayers > 0 ) ){
+		if( !tablePath.empty() ){
+			if( !table->load( tablePath.c_str() ) ){
+				return E_FAIL;
+			}
+		}
+		else{
+			CameraModel model;
+			model.setDefault();
+			table->build( model );
+		}
+	}
+
+	// L^t@C̍Đ
+	if( !replayPath.empty() ){
+		ReplayFrameSource* replay = new ReplayFrameSource();
+		source.reset( replay );
+		if( !replay->open( replayPath.c_str(), settings & FRAME_STREAM_FLAG_ALL ) ){
+			return E_FAIL;
+		}
+		replay->setRealTime( true );
+		return S_OK;
+	}
+
+	if( syntheticPlayers > 0 ){
+		// V[
+		SyntheticScene scene;
+		scene.players = syntheticPlayers;
+		SyntheticFrameSource* synthetic = new SyntheticFrameSource( scene, settings & FRAME_STREAM_FLAG_ALL );
+		synthetic->setRealTime( true );
+		source.reset( synthetic );
+	}
+	else{
+		// Kinect
+		NuiFrameSource* nui = new NuiFrameSource();
+		source.reset( nui );
+		HRESULT hResult = nui->open( settings );
+		if( FAILED( hResult ) ){
+			return hResult;
+		}
+		if( table ){
+			hResult = buildRegistrationTable( nui->getSensor(), NUI_IMAGE_RESOLUTION_640x480, *table );
+			if( FAILED( hResult ) ){
+				return hResult;
+			}
+		}
+	}
+	if( !recordPath.empty() ){
+		RecordingFrameSource* recording = new RecordingFrameSource( source.release() );
+		source.reset( recording );
+
+		// Depth̃t[͉tkď(Õt[Ƃ̍g)
+		// NUI_FRAME_SOURCE_PLAYER_STATŜƂ́ADepth̃t[Player̓v(̉͂Depthǂ܂Ɏg)
+		recording->setDepthCompression( true );
+		recording->setPlayerStats( ( settings & NUI_FRAME_SOURCE_PLAYER_STATS ) != 0 );
+		if( !recording->open( recordPath.c_str() ) ){
+			return E_FAIL;
+		}
+	}
+	return S_OK;
+}
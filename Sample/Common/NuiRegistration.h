@@ -0,0 +1,37 @@
+// NuiRegistration.h : Kinect SDK̈ʒu킹֐ʒu킹e[u쐬
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <Windows.h>
+#include <NuiApi.h>
+#include "Registration.h"
+
+
+// NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()̌ʂe[uɏĂ
+// N1x(f~knot)ĂяoAȍ~̃t[łSDKĂяoɃe[u
+inline HRESULT buildRegistrationTable( INuiSensor* pSensor, NUI_IMAGE_RESOLUTION eResolution, RegistrationTable& table, int knotCount = RegistrationTable::DEFAULT_KNOT_COUNT )
+{
+	DWORD width = 0;
+	DWORD height = 0;
+	NuiImageResolutionToSize( eResolution, width, height );
+
+	HRESULT hResult = S_OK;
+	table.buildFromMapping( static_cast<int>( width ), static_cast<int>( height ), knotCount,
+		[&]( int x, int y, int depthMm, float* colorX, float* colorY ) -> bool {
+			LONG registX = 0;
+			LONG registY = 0;
+			const USHORT depthValue = static_cast<USHORT>( depthMm << NUI_IMAGE_PLAYER_INDEX_SHIFT );
+			HRESULT hr = pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( eResolution, eResolution, nullptr, x, y, depthValue, &registX, &registY );
+			if( FAILED( hr ) ){
+				hResult = hr;
+				return false;
+			}
+			*colorX = static_cast<float>( registX );
+			*colorY = static_cast<float>( registY );
+			return true;
+		}
+	);
+	return hResult;
+}
@@ -0,0 +1,402 @@
+// Platform.cpp : WindowsLinuxŎقȂ鏈
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Platform.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <process.h>
+#include <malloc.h>
+#include <intrin.h>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined( __i386__ ) || defined( __x86_64__ )
+#include <x86intrin.h>
+#endif
+#endif
+
+
+double getTimeInSeconds()
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency = { 0 };
+	if( frequency.QuadPart == 0 ){
+		QueryPerformanceFrequency( &frequency );
+	}
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	return static_cast<double>( counter.QuadPart ) / static_cast<double>( frequency.QuadPart );
+#else
+	timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return static_cast<double>( ts.tv_sec ) + static_cast<double>( ts.tv_nsec ) * 1e-9;
+#endif
+}
+
+uint64_t readCycleCounter()
+{
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+int getProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	const int count = static_cast<int>( info.dwNumberOfProcessors );
+#else
+	const int count = static_cast<int>( sysconf( _SC_NPROCESSORS_ONLN ) );
+#endif
+	return ( count > 0 ) ? count : 1;
+}
+
+void* alignedAlloc( size_t size, size_t alignment )
+{
+#ifdef _WIN32
+	return _aligned_malloc( size, alignment );
+#else
+	void* pointer = nullptr;
+	if( posix_memalign( &pointer, alignment, size ) != 0 ){
+		return nullptr;
+	}
+	return pointer;
+#endif
+}
+
+void alignedFree( void* pointer )
+{
+#ifdef _WIN32
+	_aligned_free( pointer );
+#else
+	free( pointer );
+#endif
+}
+
+long atomicAdd( volatile long* value, long delta )
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd( value, delta ) + delta;
+#else
+	return __sync_add_and_fetch( value, delta );
+#endif
+}
+
+long atomicLoad( const volatile long* value )
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange( const_cast<volatile long*>( value ), 0, 0 );
+#else
+	return __atomic_load_n( value, __ATOMIC_SEQ_CST );
+#endif
+}
+
+void atomicStore( volatile long* value, long newValue )
+{
+#ifdef _WIN32
+	InterlockedExchange( value, newValue );
+#else
+	__atomic_store_n( value, newValue, __ATOMIC_SEQ_CST );
+#endif
+}
+
+long atomicCompareExchange( volatile long* value, long exchange, long comparand )
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange( value, exchange, comparand );
+#else
+	return __sync_val_compare_and_swap( value, comparand, exchange );
+#endif
+}
+
+void sleepMilliseconds( int milliseconds )
+{
+#ifdef _WIN32
+	Sleep( static_cast<DWORD>( milliseconds ) );
+#else
+	timespec ts;
+	ts.tv_sec = milliseconds / 1000;
+	ts.tv_nsec = static_cast<long>( milliseconds % 1000 ) * 1000000;
+	nanosleep( &ts, nullptr );
+#endif
+}
+
+bool createDirectory( const char* path )
+{
+#ifdef _WIN32
+	return CreateDirectoryA( path, nullptr ) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	return mkdir( path, 0755 ) == 0 || errno == EEXIST;
+#endif
+}
+
+bool replaceFile( const char* source, const char* destination )
+{
+#ifdef _WIN32
+	return MoveFileExA( source, destination, MOVEFILE_REPLACE_EXISTING ) != FALSE;
+#else
+	return rename( source, destination ) == 0;
+#endif
+}
+
+
+/*----- Mutex -----*/
+
+Mutex::Mutex()
+{
+#ifdef _WIN32
+	CRITICAL_SECTION* cs = new CRITICAL_SECTION;
+	InitializeCriticalSection( cs );
+	handle = cs;
+#else
+	pthread_mutex_t* mutex = new pthread_mutex_t;
+	pthread_mutex_init( mutex, nullptr );
+	handle = mutex;
+#endif
+}
+
+Mutex::~Mutex()
+{
+#ifdef _WIN32
+	DeleteCriticalSection( static_cast<CRITICAL_SECTION*>( handle ) );
+	delete static_cast<CRITICAL_SECTION*>( handle );
+#else
+	pthread_mutex_destroy( static_cast<pthread_mutex_t*>( handle ) );
+	delete static_cast<pthread_mutex_t*>( handle );
+#endif
+}
+
+void Mutex::lock()
+{
+#ifdef _WIN32
+	EnterCriticalSection( static_cast<CRITICAL_SECTION*>( handle ) );
+#else
+	pthread_mutex_lock( static_cast<pthread_mutex_t*>( handle ) );
+#endif
+}
+
+void Mutex::unlock()
+{
+#ifdef _WIN32
+	LeaveCriticalSection( static_cast<CRITICAL_SECTION*>( handle ) );
+#else
+	pthread_mutex_unlock( static_cast<pthread_mutex_t*>( handle ) );
+#endif
+}
+
+
+/*----- ConditionVariable -----*/
+
+ConditionVariable::ConditionVariable()
+{
+#ifdef _WIN32
+	CONDITION_VARIABLE* cv = new CONDITION_VARIABLE;
+	InitializeConditionVariable( cv );
+	handle = cv;
+#else
+	pthread_cond_t* cv = new pthread_cond_t;
+	pthread_cond_init( cv, nullptr );
+	handle = cv;
+#endif
+}
+
+ConditionVariable::~ConditionVariable()
+{
+#ifdef _WIN32
+	delete static_cast<CONDITION_VARIABLE*>( handle );
+#else
+	pthread_cond_destroy( static_cast<pthread_cond_t*>( handle ) );
+	delete static_cast<pthread_cond_t*>( handle );
+#endif
+}
+
+void ConditionVariable::wait( Mutex& mutex )
+{
+#ifdef _WIN32
+	SleepConditionVariableCS( static_cast<CONDITION_VARIABLE*>( handle ), static_cast<CRITICAL_SECTION*>( mutex.handle ), INFINITE );
+#else
+	pthread_cond_wait( static_cast<pthread_cond_t*>( handle ), static_cast<pthread_mutex_t*>( mutex.handle ) );
+#endif
+}
+
+void ConditionVariable::notifyOne()
+{
+#ifdef _WIN32
+	WakeConditionVariable( static_cast<CONDITION_VARIABLE*>( handle ) );
+#else
+	pthread_cond_signal( static_cast<pthread_cond_t*>( handle ) );
+#endif
+}
+
+void ConditionVariable::notifyAll()
+{
+#ifdef _WIN32
+	WakeAllConditionVariable( static_cast<CONDITION_VARIABLE*>( handle ) );
+#else
+	pthread_cond_broadcast( static_cast<pthread_cond_t*>( handle ) );
+#endif
+}
+
+
+/*----- Thread -----*/
+
+Thread::Thread()
+	: handle( nullptr ), function( nullptr ), argument( nullptr )
+{
+}
+
+Thread::~Thread()
+{
+	join();
+}
+
+#ifdef _WIN32
+unsigned int __stdcall Thread::entry( void* self )
+{
+	Thread* thread = static_cast<Thread*>( self );
+	thread->function( thread->argument );
+	return 0;
+}
+#else
+void* Thread::entry( void* self )
+{
+	Thread* thread = static_cast<Thread*>( self );
+	thread->function( thread->argument );
+	return nullptr;
+}
+#endif
+
+bool Thread::start( Function function, void* argument )
+{
+	if( handle ){
+		return false;
+	}
+	this->function = function;
+	this->argument = argument;
+#ifdef _WIN32
+	const uintptr_t thread = _beginthreadex( nullptr, 0, &Thread::entry, this, 0, nullptr );
+	if( thread == 0 ){
+		return false;
+	}
+	handle = reinterpret_cast<void*>( thread );
+#else
+	pthread_t* thread = new pthread_t;
+	if( pthread_create( thread, nullptr, &Thread::entry, this ) != 0 ){
+		delete thread;
+		return false;
+	}
+	handle = thread;
+#endif
+	return true;
+}
+
+void Thread::join()
+{
+	if( !handle ){
+		return;
+	}
+#ifdef _WIN32
+	WaitForSingleObject( static_cast<HANDLE>( handle ), INFINITE );
+	CloseHandle( static_cast<HANDLE>( handle ) );
+#else
+	pthread_join( *static_cast<pthread_t*>( handle ), nullptr );
+	delete static_cast<pthread_t*>( handle );
+#endif
+	handle = nullptr;
+}
+
+
+/*----- MappedFile -----*/
+
+MappedFile::MappedFile()
+	: data( nullptr ), size( 0 ), file( nullptr ), mapping( nullptr )
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open( const char* path )
+{
+	close();
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if( hFile == INVALID_HANDLE_VALUE ){
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx( hFile, &fileSize ) || fileSize.QuadPart == 0 ){
+		CloseHandle( hFile );
+		return false;
+	}
+	HANDLE hMapping = CreateFileMappingA( hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+	if( !hMapping ){
+		CloseHandle( hFile );
+		return false;
+	}
+	void* view = MapViewOfFile( hMapping, FILE_MAP_COPY, 0, 0, 0 );
+	if( !view ){
+		CloseHandle( hMapping );
+		CloseHandle( hFile );
+		return false;
+	}
+	file = hFile;
+	mapping = hMapping;
+	size = static_cast<uint64_t>( fileSize.QuadPart );
+	data = static_cast<uint8_t*>( view );
+#else
+	const int fd = ::open( path, O_RDONLY );
+	if( fd < 0 ){
+		return false;
+	}
+	struct stat st;
+	if( fstat( fd, &st ) != 0 || st.st_size == 0 ){
+		::close( fd );
+		return false;
+	}
+	void* view = mmap( nullptr, static_cast<size_t>( st.st_size ), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+	::close( fd );
+	if( view == MAP_FAILED ){
+		return false;
+	}
+	// 擪珇ɓǂނƂJ[lɓ`āAǂ݂傫
+	madvise( view, static_cast<size_t>( st.st_size ), MADV_SEQUENTIAL );
+	size = static_cast<uint64_t>( st.st_size );
+	data = static_cast<uint8_t*>( view );
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+	if( !data ){
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile( data );
+	CloseHandle( static_cast<HANDLE>( mapping ) );
+	CloseHandle( static_cast<HANDLE>( file ) );
+#else
+	munmap( data, static_cast<size_t>( size ) );
+#endif
+	data = nullptr;
+	size = 0;
+	file = nullptr;
+	mapping = nullptr;
+}
@@ -0,0 +1,157 @@
+// Platform.h : WindowsLinuxŎقȂ鏈܂Ƃ߂wb_[
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Xbhɕʂ̎̂ϐ(ÓIȋLԂPODɂg)
+#ifdef _MSC_VER
+#define PLATFORM_THREAD_LOCAL __declspec( thread )
+#else
+#define PLATFORM_THREAD_LOCAL __thread
+#endif
+
+// P鍂\^C}[̌ݒlbPʂŎ擾
+double getTimeInSeconds();
+
+// CPŨ^CX^vJE^̌ݒl(x86rdtscAȊO̊ł0)
+// g͈(ĩNbN)Ȃ̂ŁAԂ̃TCN̖ڈɎg
+uint64_t readCycleCounter();
+
+// _vZbT̐擾
+int getProcessorCount();
+
+// ACgw肵ăm/(alignment2ׂ̂)
+void* alignedAlloc( size_t size, size_t alignment );
+void alignedFree( void* pointer );
+
+// ̃XbhXVJE^̉Z(Z̒lԂ)
+long atomicAdd( volatile long* value, long delta );
+
+// ̃Xbhޒl̓ǂݏ(ǂO̓ǂݏƏւȂ)
+long atomicLoad( const volatile long* value );
+void atomicStore( volatile long* value, long newValue );
+
+// *valuecomparandƓƂexchangeɒu(uO̒lԂ)
+long atomicCompareExchange( volatile long* value, long exchange, long comparand );
+
+// w肵[ms]݂̃Xbh~߂
+void sleepMilliseconds( int milliseconds );
+
+// fBNg쐬(ɂƂƂAẽfBNg͍Ȃ)
+bool createDirectory( const char* path );
+
+// t@C̖Oς(destinationɂƂ͒u)
+// ꎞt@CɏoĂuƁAǂޑ͏̃t@CȂ
+bool replaceFile( const char* source, const char* destination );
+
+
+// ~[ebNX
+class Mutex
+{
+public:
+	Mutex();
+	~Mutex();
+	void lock();
+	void unlock();
+
+private:
+	friend class ConditionVariable;
+	void* handle;
+
+	Mutex( const Mutex& );
+	Mutex& operator=( const Mutex& );
+};
+
+// XR[v𔲂ƂɃbN
+class ScopedLock
+{
+public:
+	explicit ScopedLock( Mutex& mutex ) : mutex( mutex ) { mutex.lock(); }
+	~ScopedLock() { mutex.unlock(); }
+
+private:
+	Mutex& mutex;
+
+	ScopedLock( const ScopedLock& );
+	ScopedLock& operator=( const ScopedLock& );
+};
+
+// ϐ
+class ConditionVariable
+{
+public:
+	ConditionVariable();
+	~ConditionVariable();
+
+	// mutexbNԂŌĂяo
+	void wait( Mutex& mutex );
+	void notifyOne();
+	void notifyAll();
+
+private:
+	void* handle;
+
+	ConditionVariable( const ConditionVariable& );
+	ConditionVariable& operator=( const ConditionVariable& );
+};
+
+// Xbh
+class Thread
+{
+public:
+	typedef void ( *Function )( void* argument );
+
+	Thread();
+	~Thread();
+
+	// XbhJn
+	bool start( Function function, void* argument );
+
+	// Xbh̏I҂
+	void join();
+
+	bool joinable() const { return handle != nullptr; }
+
+private:
+	void* handle;
+	Function function;
+	void* argument;
+
+	Thread( const Thread& );
+	Thread& operator=( const Thread& );
+
+#ifdef _WIN32
+	static unsigned int __stdcall entry( void* self );
+#else
+	static void* entry( void* self );
+#endif
+};
+
+// t@CɃ}bvēǂ
+// ݂̓Rs[ICgɂȂ(y[WRs[)At@Cɂ͔fȂ
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open( const char* path );
+	void close();
+
+	bool isOpen() const { return data != nullptr; }
+	uint8_t* getData() const { return data; }
+	uint64_t getSize() const { return size; }
+
+private:
+	uint8_t* data;
+	uint64_t size;
+	void* file;
+	void* mapping;
+
+	MappedFile( const MappedFile& );
+	MappedFile& operator=( const MappedFile& );
+};
@@ -0,0 +1,307 @@
+// PlayerLabeler.cpp : Player̘ÃxO
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "PlayerLabeler.h"
+#include <algorithm>
+#include <cstring>
+
+
+PlayerLabeler::PlayerLabeler( int width, int height, ThreadPool* pool )
+	: width( width ), height( height ), pool( pool ), minimumArea( DEFAULT_MINIMUM_AREA )
+{
+	// Xbh1̑т󂯎
+	bandCount = pool ? pool->getThreadCount() : 1;
+	if( bandCount > height ){
+		bandCount = height;
+	}
+	bands.resize( bandCount );
+	bandOffset.resize( bandCount + 1 );
+	for( int i = 0; i < bandCount; i++ ){
+		bands[i].rowBegin = height * i / bandCount;
+		bands[i].rowEnd = height * ( i + 1 ) / bandCount;
+		bands[i].rowRuns.resize( bands[i].rowEnd - bands[i].rowBegin + 1 );
+	}
+	clearSegments();
+}
+
+void PlayerLabeler::clearSegments()
+{
+	for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+		segments[i].area = 0;
+		segments[i].componentCount = 0;
+		segments[i].bounds = MaskRect();
+		segments[i].centroidX = 0.0f;
+		segments[i].centroidY = 0.0f;
+		segments[i].meanDepth = 0.0f;
+	}
+}
+
+int PlayerLabeler::findRoot( int* parent, int index )
+{
+	// HȂe1΂ɂ(path halving)
+	while( parent[index] != index ){
+		parent[index] = parent[parent[index]];
+		index = parent[index];
+	}
+	return index;
+}
+
+void PlayerLabeler::connectRows( const Run* upper, int upperCount, int upperIndex, const Run* lower, int lowerCount, int lowerIndex, int* parent )
+{
+	// ̍s̃ɁA΂߂ɐڂ̂܂߂ďdȂ̍s̃𒲂ׂ
+	// ͍ł̂ŁÃ荶ŏĨ͎̉̃ƂڂȂ
+	int first = 0;
+	for( int j = 0; j < lowerCount; j++ ){
+		const Run& run = lower[j];
+		while( first < upperCount && upper[first].right < run.left ){
+			first++;
+		}
+		for( int i = first; i < upperCount && upper[i].left <= run.right; i++ ){
+			if( upper[i].player != run.player ){
+				continue;
+			}
+
+			// ̃CfbNXeɂ(͏ɐ̍ŏ̃ɂȂ)
+			const int a = findRoot( parent, upperIndex + i );
+			const int b = findRoot( parent, lowerIndex + j );
+			if( a < b ){
+				parent[b] = a;
+			}
+			else if( b < a ){
+				parent[a] = b;
+			}
+		}
+	}
+}
+
+void PlayerLabeler::labelBand( const uint16_t* registered, int band )
+{
+	Band& current = bands[band];
+	current.runs.clear();
+	for( int y = current.rowBegin; y < current.rowEnd; y++ ){
+		current.rowRuns[y - current.rowBegin] = static_cast<int>( current.runs.size() );
+		const uint16_t* row = registered + y * width;
+		int x = 0;
+		while( x < width ){
+			// Player̂Ȃf4f΂
+			if( x + 4 <= width ){
+				uint64_t four;
+				std::memcpy( &four, row + x, sizeof( four ) );
+				if( ( four & 0x0007000700070007ULL ) == 0 ){
+					x += 4;
+					continue;
+				}
+			}
+			// CfbNX7͎gȂlȂ̂ŔwiƂĈ
+			const int player = row[x] & KINECT_PLAYER_INDEX_MASK;
+			if( player == 0 || player > KINECT_PLAYER_COUNT ){
+				x++;
+				continue;
+			}
+
+			Run run;
+			run.left = static_cast<int16_t>( x );
+			run.y = static_cast<int16_t>( y );
+			run.player = static_cast<uint8_t>( player );
+			run.depthSum = 0;
+			run.depthCount = 0;
+			for( ; x < width && ( row[x] & KINECT_PLAYER_INDEX_MASK ) == player; x++ ){
+				const int depth = row[x] >> KINECT_PLAYER_INDEX_SHIFT;
+				run.depthSum += depth;
+				run.depthCount += ( depth != 0 ) ? 1 : 0;
+			}
+			run.right = static_cast<int16_t>( x );
+			current.runs.push_back( run );
+		}
+	}
+	const int rows = current.rowEnd - current.rowBegin;
+	current.rowRuns[rows] = static_cast<int>( current.runs.size() );
+
+	// т̒ŏ̍s̃ƂȂ
+	const int count = static_cast<int>( current.runs.size() );
+	current.parent.resize( count );
+	for( int i = 0; i < count; i++ ){
+		current.parent[i] = i;
+	}
+	for( int row = 1; row < rows; row++ ){
+		const int upper = current.rowRuns[row - 1];
+		const int lower = current.rowRuns[row];
+		const int lowerEnd = current.rowRuns[row + 1];
+		if( lower > upper && lowerEnd > lower ){
+			connectRows( &current.runs[upper], lower - upper, upper, &current.runs[lower], lowerEnd - lower, lower, &current.parent[0] );
+		}
+	}
+}
+
+void PlayerLabeler::process( const uint16_t* registered, const PlayerLabelOutput& output )
+{
+	// 1. і̃
+	if( pool && bandCount > 1 ){
+		pool->run( bandCount, [&]( int band, int ){
+			labelBand( registered, band );
+		} );
+	}
+	else{
+		labelBand( registered, 0 );
+	}
+
+	// 2. Ŝunion-find
+	bandOffset[0] = 0;
+	for( int i = 0; i < bandCount; i++ ){
+		bandOffset[i + 1] = bandOffset[i] + static_cast<int>( bands[i].runs.size() );
+	}
+	const int runCount = bandOffset[bandCount];
+	parent.resize( runCount );
+	for( int i = 0; i < bandCount; i++ ){
+		const int offset = bandOffset[i];
+		for( size_t j = 0; j < bands[i].parent.size(); j++ ){
+			parent[offset + j] = offset + bands[i].parent[j];
+		}
+	}
+	for( int i = 0; i + 1 < bandCount; i++ ){
+		const Band& upper = bands[i];
+		const Band& lower = bands[i + 1];
+		const int upperFirst = upper.rowRuns[upper.rowEnd - upper.rowBegin - 1];
+		const int upperCount = static_cast<int>( upper.runs.size() ) - upperFirst;
+		const int lowerCount = lower.rowRuns[1];
+		if( upperCount > 0 && lowerCount > 0 ){
+			connectRows( &upper.runs[upperFirst], upperCount, bandOffset[i] + upperFirst, &lower.runs[0], lowerCount, bandOffset[i + 1], &parent[0] );
+		}
+	}
+
+	// ɏWv(͐̍ŏ̃Ȃ̂ŁACfbNX̏ɒHƍɌ)
+	components.clear();
+	sums.clear();
+	runComponent.resize( runCount );
+	for( int i = 0; i < bandCount; i++ ){
+		const Band& current = bands[i];
+		for( size_t j = 0; j < current.runs.size(); j++ ){
+			const int index = bandOffset[i] + static_cast<int>( j );
+			const Run& run = current.runs[j];
+			const int root = findRoot( &parent[0], index );
+			if( root == index ){
+				PlayerComponent component;
+				component.player = run.player;
+				component.area = 0;
+				component.bounds.left = run.left;
+				component.bounds.top = run.y;
+				component.bounds.right = run.right;
+				component.bounds.bottom = run.y + 1;
+				component.removed = false;
+				runComponent[index] = static_cast<int>( components.size() );
+				components.push_back( component );
+				const Sum sum = { 0, 0, 0, 0 };
+				sums.push_back( sum );
+			}
+			else{
+				runComponent[index] = runComponent[root];
+			}
+
+			const int id = runComponent[index];
+			PlayerComponent& component = components[id];
+			Sum& sum = sums[id];
+			const int length = run.right - run.left;
+			component.area += length;
+			component.bounds.left = ( std::min )( component.bounds.left, static_cast<int>( run.left ) );
+			component.bounds.right = ( std::max )( component.bounds.right, static_cast<int>( run.right ) );
+			component.bounds.bottom = run.y + 1;
+			sum.x += static_cast<int64_t>( length ) * ( run.left + run.right - 1 ) / 2;
+			sum.y += static_cast<int64_t>( length ) * run.y;
+			sum.depth += run.depthSum;
+			sum.depthCount += run.depthCount;
+		}
+	}
+
+	// APlayerɂ܂Ƃ߂
+	Sum playerSums[KINECT_PLAYER_COUNT + 1];
+	std::memset( playerSums, 0, sizeof( playerSums ) );
+	clearSegments();
+	for( size_t i = 0; i < components.size(); i++ ){
+		PlayerComponent& component = components[i];
+		const Sum& sum = sums[i];
+		component.centroidX = static_cast<float>( static_cast<double>( sum.x ) / component.area );
+		component.centroidY = static_cast<float>( static_cast<double>( sum.y ) / component.area );
+		component.meanDepth = sum.depthCount ? static_cast<float>( static_cast<double>( sum.depth ) / sum.depthCount ) : 0.0f;
+		component.removed = component.area < minimumArea;
+		if( component.removed ){
+			continue;
+		}
+
+		PlayerSegment& segment = segments[component.player];
+		Sum& playerSum = playerSums[component.player];
+		if( segment.area == 0 ){
+			segment.bounds = component.bounds;
+		}
+		else{
+			segment.bounds.left = ( std::min )( segment.bounds.left, component.bounds.left );
+			segment.bounds.top = ( std::min )( segment.bounds.top, component.bounds.top );
+			segment.bounds.right = ( std::max )( segment.bounds.right, component.bounds.right );
+			segment.bounds.bottom = ( std::max )( segment.bounds.bottom, component.bounds.bottom );
+		}
+		segment.area += component.area;
+		segment.componentCount++;
+		playerSum.x += sum.x;
+		playerSum.y += sum.y;
+		playerSum.depth += sum.depth;
+		playerSum.depthCount += sum.depthCount;
+	}
+	for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+		PlayerSegment& segment = segments[player];
+		const Sum& playerSum = playerSums[player];
+		if( segment.area ){
+			segment.centroidX = static_cast<float>( static_cast<double>( playerSum.x ) / segment.area );
+			segment.centroidY = static_cast<float>( static_cast<double>( playerSum.y ) / segment.area );
+			segment.meanDepth = playerSum.depthCount ? static_cast<float>( static_cast<double>( playerSum.depth ) / playerSum.depthCount ) : 0.0f;
+		}
+	}
+
+	// 3. і̏o
+	if( pool && bandCount > 1 ){
+		pool->run( bandCount, [&]( int band, int ){
+			writeBand( output, band );
+		} );
+	}
+	else{
+		writeBand( output, 0 );
+	}
+}
+
+void PlayerLabeler::writeBand( const PlayerLabelOutput& output, int band )
+{
+	const Band& current = bands[band];
+	const int begin = current.rowBegin * width;
+	const int pixels = ( current.rowEnd - current.rowBegin ) * width;
+
+	// т0Ŗ߂ĂAȂ
+	if( output.labels ){
+		std::memset( output.labels + begin, 0, pixels );
+	}
+	for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+		if( output.playerMask[player] ){
+			std::memset( output.playerMask[player] + begin, 0, pixels );
+		}
+		if( output.clip[player] ){
+			std::memset( output.clip[player] + begin * 4, 0, pixels * 4 );
+		}
+	}
+
+	const int offset = bandOffset[band];
+	for( size_t i = 0; i < current.runs.size(); i++ ){
+		const Run& run = current.runs[i];
+		if( components[runComponent[offset + i]].removed ){
+			continue;
+		}
+		const int start = run.y * width + run.left;
+		const int length = run.right - run.left;
+		if( output.labels ){
+			std::memset( output.labels + start, run.player, length );
+		}
+		if( output.playerMask[run.player] ){
+			std::memset( output.playerMask[run.player] + start, 255, length );
+		}
+		if( output.clip[run.player] ){
+			std::memcpy( output.clip[run.player] + start * 4, output.color + start * 4, length * 4 );
+		}
+	}
+}
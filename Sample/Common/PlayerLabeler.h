@@ -0,0 +1,137 @@
+// PlayerLabeler.h : Player̘ÃxO
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "KinectTypes.h"
+#include "ThreadPool.h"
+
+
+// A(Player̃CfbNX̉f8ߖTłȂ)
+struct PlayerComponent
+{
+	int player;       // Player̃CfbNX(1`6)
+	int area;         // f
+	MaskRect bounds;  // ͈
+	float centroidX;  // dS[pixel]
+	float centroidY;
+	float meanDepth;  // Depth̕[mm](vłf̕ρAƂ0)
+	bool removed;     // ̂ŏ
+};
+
+// Playeř(Ȃ܂Ƃ߂́AfƂarea0)
+struct PlayerSegment
+{
+	int area;
+	int componentCount;
+	MaskRect bounds;
+	float centroidX;
+	float centroidY;
+	float meanDepth;
+};
+
+// xȌo͐
+// svȏo͂nullptrɂĂ
+struct PlayerLabelOutput
+{
+	uint8_t* labels;                              // ȂfPlayer̃CfbNX(ȊO0)
+	uint8_t* playerMask[KINECT_PLAYER_COUNT + 1]; // Player̗̈(PlayerȂ255ACfbNX1`6g)
+	uint8_t* clip[KINECT_PLAYER_COUNT + 1];       // Playerɐ؂蔲Color(BGRXÄ̊O0ACfbNX1`6g)
+	const uint8_t* color;                         // ؂蔲Color(BGRXAclipgƂ͕K{)
+
+	PlayerLabelOutput()
+		: labels( nullptr ), color( nullptr )
+	{
+		for( int i = 0; i <= KINECT_PLAYER_COUNT; i++ ){
+			playerMask[i] = nullptr;
+			clip[i] = nullptr;
+		}
+	}
+};
+
+// ʒu킹Depth&PlayerAPlayer̘AƁAPlayer̃}XNA؂蔲Color1x̑ŋ߂
+// 1. іɁAs𓯂Player̃CfbNX()ɕA̍s̐ڂ郉union-findłȂ(CfbNX7͔wiƂĈ)
+//    (̉fAW̘aADepth̘aꏏɋ߂)
+// 2. т̋E̍s̃ȂŐɏWvAʐςminimumArea菬(ܗ)
+// 3. іɁA̒PʂŃxAPlayer̃}XNA؂蔲Coloro
+// 13͑тXbhv[̃XbhŕSA2̓̐ɔႷ鏈ĂяoXbhōs
+class PlayerLabeler
+{
+public:
+	// ̖ʐς̊l[pixel]
+	static const int DEFAULT_MINIMUM_AREA = 64;
+
+	// poolnullptr̂Ƃ͌ĂяoXbhŏ
+	PlayerLabeler( int width, int height, ThreadPool* pool = nullptr );
+
+	// ʐς菬(0̂Ƃ͑SĎc)
+	void setMinimumArea( int pixels ) { minimumArea = pixels; }
+	int getMinimumArea() const { return minimumArea; }
+
+	// registered : ʒu킹Depth&Player
+	void process( const uint16_t* registered, const PlayerLabelOutput& output );
+
+	// Õt[̐(܂ށAォ猩)ƁAPlayeř
+	const std::vector<PlayerComponent>& getComponents() const { return components; }
+	const PlayerSegment& getSegment( int player ) const { return segments[player]; }
+
+private:
+	// Player̃CfbNX[left, right)
+	struct Run
+	{
+		int16_t left;
+		int16_t right;
+		int16_t y;
+		uint8_t player;
+		int depthSum;    // vłfDepth̘a[mm]
+		int depthCount;
+	};
+
+	// і̃
+	struct Band
+	{
+		int rowBegin;
+		int rowEnd;
+		std::vector<Run> runs;
+		std::vector<int> rowRuns; // s̍ŏ̃̃CfbNX(т̍s + 1)
+		std::vector<int> parent;  // т̒łunion-find̐e
+	};
+
+	// ̘a
+	struct Sum
+	{
+		int64_t x;
+		int64_t y;
+		int64_t depth;
+		int depthCount;
+	};
+
+	void labelBand( const uint16_t* registered, int band );
+	void writeBand( const PlayerLabelOutput& output, int band );
+	void clearSegments();
+
+	// ̍s̃Ɖ̍s̃̂Aڂ(8ߖT)Player̃Ȃ
+	// upperIndexAlowerIndex͂ꂼ̍ŏ̃parentł̃CfbNX
+	static void connectRows( const Run* upper, int upperCount, int upperIndex, const Run* lower, int lowerCount, int lowerIndex, int* parent );
+	static int findRoot( int* parent, int index );
+
+	int width;
+	int height;
+	ThreadPool* pool;
+	int bandCount;
+	int minimumArea;
+
+	std::vector<Band> bands;
+	std::vector<int> bandOffset;   // т̍ŏ̃̑Ŝł̃CfbNX
+	std::vector<int> parent;       // Ŝłunion-find̐e
+	std::vector<int> runComponent; // ̐̃CfbNX
+	std::vector<Sum> sums;
+	std::vector<PlayerComponent> components;
+	PlayerSegment segments[KINECT_PLAYER_COUNT + 1];
+
+	PlayerLabeler( const PlayerLabeler& );
+	PlayerLabeler& operator=( const PlayerLabeler& );
+};
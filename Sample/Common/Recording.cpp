@@ -0,0 +1,629 @@
+// Recording.cpp : t[̋L^t@C̓ǂݏ
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Recording.h"
+#include <cstring>
+
+
+static const char RECORDING_MAGIC[4] = { 'K', 'B', 'R', 'C' };
+static const char RECORDING_INDEX_MAGIC[4] = { 'K', 'B', 'R', 'I' };
+
+// RECORDING_ALIGNMENT̔{ɐ؂グ
+static uint64_t alignRecording( uint64_t size )
+{
+	const uint64_t alignment = RECORDING_ALIGNMENT;
+	return ( size + alignment - 1 ) / alignment * alignment;
+}
+
+
+/*----- RecordingWriter -----*/
+
+RecordingWriter::RecordingWriter( size_t bufferSize, int maxBuffers )
+	: bufferSize( bufferSize ), maxBuffers( maxBuffers ), file( nullptr ), streams( 0 ), fileOffset( 0 ),
+	  depthCompression( false ), depthTemporal( true ), playerStats( false ), current( nullptr ), failed( false ), quit( false )
+{
+	std::memset( &statistics, 0, sizeof( statistics ) );
+}
+
+RecordingWriter::~RecordingWriter()
+{
+	close();
+	for( size_t i = 0; i < buffers.size(); i++ ){
+		alignedFree( buffers[i]->data );
+		delete buffers[i];
+	}
+}
+
+bool RecordingWriter::open( const char* path, int streams )
+{
+	close();
+	file = std::fopen( path, "wb" );
+	if( !file ){
+		return false;
+	}
+
+	// obt@ɋl߂Ă傫ȒPʂŏނ̂ŁAWCũobt@͎gȂ
+	std::setvbuf( file, nullptr, _IONBF, 0 );
+
+	this->streams = streams;
+	fileOffset = 0;
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		index[i].clear();
+	}
+	if( depthCompressor ){
+		depthCompressor->reset();
+	}
+	std::memset( &statistics, 0, sizeof( statistics ) );
+	statistics.buffersAllocated = static_cast<int>( buffers.size() );
+	failed = false;
+	quit = false;
+	if( !thread.start( &RecordingWriter::writerEntry, this ) ){
+		std::fclose( file );
+		file = nullptr;
+		return false;
+	}
+
+	RecordingFileHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	std::memcpy( header.magic, RECORDING_MAGIC, sizeof( header.magic ) );
+	header.version = RECORDING_VERSION;
+	header.streams = static_cast<uint32_t>( playerStats ? ( streams | RECORD_STREAM_FLAG_PLAYER_STATS ) : streams );
+	return append( &header, sizeof( header ) );
+}
+
+bool RecordingWriter::close()
+{
+	if( !file ){
+		return true;
+	}
+
+	// CfbNX(Xg[̃Ggɕׂ)ƁÄʒutb^[
+	RecordingFooter footer;
+	std::memset( &footer, 0, sizeof( footer ) );
+	std::memcpy( footer.magic, RECORDING_INDEX_MAGIC, sizeof( footer.magic ) );
+	footer.indexOffset = fileOffset;
+
+	RecordHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	header.stream = RECORD_STREAM_INDEX;
+	uint64_t indexSize = 0;
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		footer.counts[i] = static_cast<uint32_t>( index[i].size() );
+		indexSize += index[i].size() * sizeof( RecordIndexEntry );
+	}
+	header.size = static_cast<uint32_t>( indexSize );
+
+	bool result = reserve( static_cast<size_t>( sizeof( header ) + alignRecording( indexSize ) + sizeof( footer ) ) ) && append( &header, sizeof( header ) );
+	for( int i = 0; i < RECORD_STREAM_COUNT && result; i++ ){
+		result = index[i].empty() || append( &index[i][0], index[i].size() * sizeof( RecordIndexEntry ) );
+	}
+	if( result ){
+		static const uint8_t zeros[RECORDING_ALIGNMENT] = { 0 };
+		result = append( zeros, static_cast<size_t>( alignRecording( indexSize ) - indexSize ) ) && append( &footer, sizeof( footer ) );
+	}
+	submit();
+
+	// ݃Xbhc̃obt@łÎ҂
+	{
+		ScopedLock lock( mutex );
+		quit = true;
+		bufferPending.notifyAll();
+	}
+	thread.join();
+	result = result && !failed;
+	result = ( std::fclose( file ) == 0 ) && result;
+	file = nullptr;
+	return result;
+}
+
+void RecordingWriter::setDepthCompression( bool enable, bool temporal )
+{
+	depthCompression = enable;
+	depthTemporal = temporal;
+	if( depthCompressor ){
+		depthCompressor->setTemporal( depthTemporal );
+	}
+}
+
+RecordingWriter::Statistics RecordingWriter::getStatistics()
+{
+	ScopedLock lock( mutex );
+	return statistics;
+}
+
+bool RecordingWriter::write( FrameStream stream, const FrameInfo& info, const void* data, uint32_t size, const SkeletonVector* floorClipPlane )
+{
+	RecordHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	header.stream = static_cast<uint32_t>( stream );
+	header.size = size;
+	header.timestamp = info.timestamp;
+	header.frameNumber = info.frameNumber;
+	header.format = static_cast<uint32_t>( info.format );
+	header.width = static_cast<uint16_t>( info.width );
+	header.height = static_cast<uint16_t>( info.height );
+	if( floorClipPlane ){
+		header.floorClipPlane = *floorClipPlane;
+	}
+	const bool depth16 = ( stream == FRAME_STREAM_DEPTH ) && ( info.format == PIXEL_FORMAT_DEPTH16 ) && ( size == static_cast<uint32_t>( info.width * info.height ) * sizeof( uint16_t ) );
+	return ( depth16 && depthCompression ) ? writeCompressedDepth( header, static_cast<const uint16_t*>( data ) ) : writeRecord( header, data );
+}
+
+bool RecordingWriter::writeSkeleton( const SkeletonFrame& frame )
+{
+	RecordHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	header.stream = FRAME_STREAM_SKELETON;
+	header.size = sizeof( frame );
+	header.timestamp = frame.timestamp;
+	header.frameNumber = frame.frameNumber;
+	header.floorClipPlane = frame.floorClipPlane;
+	return writeRecord( header, &frame );
+}
+
+bool RecordingWriter::writePlayerStats( const FrameInfo& info, const PlayerStats* stats )
+{
+	RecordHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	header.stream = RECORD_STREAM_PLAYER_STATS;
+	header.size = sizeof( PlayerStats ) * ( KINECT_PLAYER_COUNT + 1 );
+	header.timestamp = info.timestamp;
+	header.frameNumber = info.frameNumber;
+	header.width = static_cast<uint16_t>( info.width );
+	header.height = static_cast<uint16_t>( info.height );
+	return writeRecord( header, stats );
+}
+
+bool RecordingWriter::writeAudio( int64_t timestamp, uint32_t sampleNumber, const int16_t* samples, uint32_t sampleCount )
+{
+	RecordHeader header;
+	std::memset( &header, 0, sizeof( header ) );
+	header.stream = RECORD_STREAM_AUDIO;
+	header.size = sampleCount * sizeof( int16_t );
+	header.timestamp = timestamp;
+	header.frameNumber = sampleNumber;
+	header.format = RECORDING_AUDIO_SAMPLES_PER_SECOND;
+	header.width = 1;
+	return writeRecord( header, samples );
+}
+
+bool RecordingWriter::write( const FrameSet& frames )
+{
+	const SkeletonVector* floorClipPlane = frames.skeleton ? &frames.skeleton->floorClipPlane : nullptr;
+	if( ( streams & FRAME_STREAM_FLAG_COLOR ) && frames.color.data ){
+		const FrameInfo& info = frames.color.info;
+		if( !write( FRAME_STREAM_COLOR, info, frames.color.data, info.width * info.height * getBytesPerPixel( info.format ), floorClipPlane ) ){
+			return false;
+		}
+	}
+	if( ( streams & FRAME_STREAM_FLAG_DEPTH ) && frames.depth.data ){
+		const FrameInfo& info = frames.depth.info;
+		if( !write( FRAME_STREAM_DEPTH, info, frames.depth.data, info.width * info.height * getBytesPerPixel( info.format ), floorClipPlane ) ){
+			return false;
+		}
+	}
+	if( ( streams & FRAME_STREAM_FLAG_SKELETON ) && frames.skeleton ){
+		if( !writeSkeleton( *frames.skeleton ) ){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool RecordingWriter::writeRecord( const RecordHeader& header, const void* data )
+{
+	if( !file || failed ){
+		return false;
+	}
+
+	// wb_[ƃf[^𓯂obt@ɑċl߂
+	const uint64_t padding = alignRecording( header.size ) - header.size;
+	if( !reserve( static_cast<size_t>( sizeof( header ) + header.size + padding ) ) ){
+		return false;
+	}
+
+	RecordIndexEntry entry;
+	entry.offset = fileOffset;
+	entry.timestamp = header.timestamp;
+	entry.frameNumber = header.frameNumber;
+	entry.size = header.size;
+	index[header.stream].push_back( entry );
+
+	static const uint8_t zeros[RECORDING_ALIGNMENT] = { 0 };
+	return append( &header, sizeof( header ) ) && append( data, header.size ) && append( zeros, static_cast<size_t>( padding ) );
+}
+
+bool RecordingWriter::writeCompressedDepth( RecordHeader& header, const uint16_t* data )
+{
+	if( !file || failed ){
+		return false;
+	}
+	if( !depthCompressor || depthCompressor->getMaxCompressedSize() != DepthCompressor::getMaxCompressedSize( header.width, header.height ) ){
+		depthCompressor.reset( new DepthCompressor( header.width, header.height ) );
+		depthCompressor->setTemporal( depthTemporal );
+	}
+
+	// k̑傫͕Ȃ̂ŁAő̑傫mۂăobt@ɒڈk
+	const size_t maxSize = depthCompressor->getMaxCompressedSize();
+	if( !reserve( static_cast<size_t>( sizeof( header ) + alignRecording( maxSize ) ) ) ){
+		return false;
+	}
+	uint8_t* record = current->data + current->size;
+	const size_t size = depthCompressor->compress( data, record + sizeof( header ) );
+	const size_t padding = static_cast<size_t>( alignRecording( size ) - size );
+	std::memset( record + sizeof( header ) + size, 0, padding );
+
+	header.size = static_cast<uint32_t>( size );
+	header.compression = RECORD_COMPRESSION_DEPTH;
+	std::memcpy( record, &header, sizeof( header ) );
+
+	RecordIndexEntry entry;
+	entry.offset = fileOffset;
+	entry.timestamp = header.timestamp;
+	entry.frameNumber = header.frameNumber;
+	entry.size = header.size;
+	index[header.stream].push_back( entry );
+
+	const size_t recordSize = sizeof( header ) + size + padding;
+	current->size += recordSize;
+	fileOffset += recordSize;
+	return true;
+}
+
+bool RecordingWriter::append( const void* data, size_t size )
+{
+	if( !reserve( size ) ){
+		return false;
+	}
+	std::memcpy( current->data + current->size, data, size );
+	current->size += size;
+	fileOffset += size;
+	return true;
+}
+
+bool RecordingWriter::reserve( size_t size )
+{
+	if( current && current->size + size <= current->capacity ){
+		return true;
+	}
+	submit();
+
+	ScopedLock lock( mutex );
+	while( !failed ){
+		// 󂢂Ăobt@g(ȂΑ傫Ȃ̂ɍ蒼)
+		if( !freeBuffers.empty() ){
+			current = freeBuffers.back();
+			freeBuffers.pop_back();
+			if( current->capacity < size ){
+				alignedFree( current->data );
+				current->capacity = size;
+				current->data = static_cast<uint8_t*>( alignedAlloc( size, 4096 ) );
+			}
+			current->size = 0;
+			return current->data != nullptr;
+		}
+
+		// ݂ǂĂȂƂ̓obt@𑝂₷
+		if( static_cast<int>( buffers.size() ) < maxBuffers ){
+			current = new Buffer();
+			current->capacity = ( size > bufferSize ) ? size : bufferSize;
+			current->data = static_cast<uint8_t*>( alignedAlloc( current->capacity, 4096 ) );
+			current->size = 0;
+			buffers.push_back( current );
+			statistics.buffersAllocated = static_cast<int>( buffers.size() );
+			return current->data != nullptr;
+		}
+
+		statistics.stalls++;
+		bufferFree.wait( mutex );
+	}
+	return false;
+}
+
+void RecordingWriter::submit()
+{
+	if( !current ){
+		return;
+	}
+	ScopedLock lock( mutex );
+	if( current->size > 0 ){
+		pending.push_back( current );
+		if( static_cast<int>( pending.size() ) > statistics.peakPendingBuffers ){
+			statistics.peakPendingBuffers = static_cast<int>( pending.size() );
+		}
+		bufferPending.notifyOne();
+	}
+	else{
+		freeBuffers.push_back( current );
+	}
+	current = nullptr;
+}
+
+void RecordingWriter::writerEntry( void* argument )
+{
+	static_cast<RecordingWriter*>( argument )->writerLoop();
+}
+
+void RecordingWriter::writerLoop()
+{
+	ScopedLock lock( mutex );
+	while( true ){
+		while( pending.empty() && !quit ){
+			bufferPending.wait( mutex );
+		}
+		if( pending.empty() ){
+			break;
+		}
+
+		// łԂobt@͏ݑ҂ƂĐ
+		Buffer* buffer = pending.front();
+		mutex.unlock();
+		const bool result = ( std::fwrite( buffer->data, 1, buffer->size, file ) == buffer->size );
+		mutex.lock();
+
+		pending.pop_front();
+		freeBuffers.push_back( buffer );
+		if( result ){
+			statistics.bytesWritten += buffer->size;
+		}
+		else{
+			failed = true;
+		}
+		bufferFree.notifyAll();
+	}
+}
+
+
+/*----- RecordingReader -----*/
+
+RecordingReader::RecordingReader()
+	: streams( 0 ), indexed( false )
+{
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		entries[i] = nullptr;
+		counts[i] = 0;
+	}
+}
+
+bool RecordingReader::open( const char* path )
+{
+	close();
+	if( !mappedFile.open( path ) ){
+		return false;
+	}
+
+	// o[W1̃t@C̓R[h̕тŁACfbNX
+	// o[W2ȑÕt@CRecordHeader::compression0Ȃ̂ŁÂ܂ܓǂ߂
+	// o[W3ȑÕt@C̓tb^[Player̓ṽR[h̐(\̗̈)0Ȃ̂ŁÂ܂ܓǂ߂
+	const uint8_t* data = mappedFile.getData();
+	const uint64_t size = mappedFile.getSize();
+	const RecordingFileHeader* header = reinterpret_cast<const RecordingFileHeader*>( data );
+	if( size < sizeof( RecordingFileHeader ) || std::memcmp( header->magic, RECORDING_MAGIC, sizeof( header->magic ) ) != 0 || header->version < 1 || header->version > RECORDING_VERSION ){
+		close();
+		return false;
+	}
+	streams = static_cast<int>( header->streams );
+
+	indexed = readIndex();
+	if( !indexed ){
+		scanRecords();
+	}
+	return true;
+}
+
+void RecordingReader::close()
+{
+	mappedFile.close();
+	streams = 0;
+	indexed = false;
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		entries[i] = nullptr;
+		counts[i] = 0;
+		scannedEntries[i].clear();
+	}
+}
+
+bool RecordingReader::readIndex()
+{
+	const uint8_t* data = mappedFile.getData();
+	const uint64_t size = mappedFile.getSize();
+	if( size < sizeof( RecordingFileHeader ) + sizeof( RecordingFooter ) ){
+		return false;
+	}
+	const RecordingFooter* footer = reinterpret_cast<const RecordingFooter*>( data + size - sizeof( RecordingFooter ) );
+	if( std::memcmp( footer->magic, RECORDING_INDEX_MAGIC, sizeof( footer->magic ) ) != 0 ){
+		return false;
+	}
+
+	// CfbNXƃR[h̓tb^[̑OŏI(ZŌӂꂵȂ悤ɁAc̑傫Ɣׂ)
+	const uint64_t limit = size - sizeof( RecordingFooter );
+	if( footer->indexOffset < sizeof( RecordingFileHeader ) || footer->indexOffset > limit || limit - footer->indexOffset < sizeof( RecordHeader ) ){
+		return false;
+	}
+	const uint64_t capacity = ( limit - footer->indexOffset - sizeof( RecordHeader ) ) / sizeof( RecordIndexEntry );
+	uint64_t total = 0;
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		total += footer->counts[i];
+	}
+	if( total > capacity ){
+		return false;
+	}
+	const RecordHeader* indexHeader = reinterpret_cast<const RecordHeader*>( data + footer->indexOffset );
+	if( indexHeader->stream != RECORD_STREAM_INDEX ){
+		return false;
+	}
+
+	// eGg̃R[hCfbNXOɎ܂AR[h̃wb_[ƈv邱Ƃm߂
+	// (1łȂƂ́ACfbNXg킸ɃR[hǂ)
+	const RecordIndexEntry* entry = reinterpret_cast<const RecordIndexEntry*>( indexHeader + 1 );
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		for( uint32_t j = 0; j < footer->counts[i]; j++, entry++ ){
+			if( entry->offset < sizeof( RecordingFileHeader ) || entry->offset % RECORDING_ALIGNMENT != 0 || entry->offset > footer->indexOffset
+			 || footer->indexOffset - entry->offset < sizeof( RecordHeader ) || footer->indexOffset - entry->offset - sizeof( RecordHeader ) < entry->size ){
+				return false;
+			}
+			const RecordHeader* record = reinterpret_cast<const RecordHeader*>( data + entry->offset );
+			if( record->stream != static_cast<uint32_t>( i ) || record->size != entry->size ){
+				return false;
+			}
+		}
+	}
+
+	// CfbNX̓}bv̈𒼐ڎg
+	entry = reinterpret_cast<const RecordIndexEntry*>( indexHeader + 1 );
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		entries[i] = entry;
+		counts[i] = static_cast<int>( footer->counts[i] );
+		entry += footer->counts[i];
+	}
+	return true;
+}
+
+void RecordingReader::scanRecords()
+{
+	// R[h擪珇ɂǂāAXg[̈ʒuL^
+	// ݂̓rŏIt@ĆAŌ̊SȃR[h܂łg
+	const uint8_t* data = mappedFile.getData();
+	const uint64_t size = mappedFile.getSize();
+	uint64_t offset = sizeof( RecordingFileHeader );
+	while( offset + sizeof( RecordHeader ) <= size ){
+		const RecordHeader* record = reinterpret_cast<const RecordHeader*>( data + offset );
+		if( record->stream >= static_cast<uint32_t>( RECORD_STREAM_COUNT ) || offset + sizeof( RecordHeader ) + record->size > size ){
+			break;
+		}
+		RecordIndexEntry entry;
+		entry.offset = offset;
+		entry.timestamp = record->timestamp;
+		entry.frameNumber = record->frameNumber;
+		entry.size = record->size;
+		scannedEntries[record->stream].push_back( entry );
+		offset += sizeof( RecordHeader ) + alignRecording( record->size );
+	}
+	for( int i = 0; i < RECORD_STREAM_COUNT; i++ ){
+		entries[i] = scannedEntries[i].empty() ? nullptr : &scannedEntries[i][0];
+		counts[i] = static_cast<int>( scannedEntries[i].size() );
+	}
+}
+
+const RecordHeader* RecordingReader::getRecord( int stream, int index ) const
+{
+	return reinterpret_cast<const RecordHeader*>( mappedFile.getData() + entries[stream][index].offset );
+}
+
+uint8_t* RecordingReader::getRecordData( int stream, int index ) const
+{
+	return mappedFile.getData() + entries[stream][index].offset + sizeof( RecordHeader );
+}
+
+int RecordingReader::findByTime( int stream, int64_t timestamp ) const
+{
+	const int count = counts[stream];
+	if( count == 0 ){
+		return 0;
+	}
+	const RecordIndexEntry* entry = entries[stream];
+	const int64_t first = entry[0].timestamp;
+	const int64_t last = entry[count - 1].timestamp;
+	if( timestamp <= first ){
+		return 0;
+	}
+	if( timestamp >= last ){
+		return count - 1;
+	}
+
+	// t[̊Ԋu͂قڈȂ̂ŁA擪Ɩ̃^CX^vʒuςAOɏǂ
+	int index = static_cast<int>( static_cast<double>( timestamp - first ) * ( count - 1 ) / static_cast<double>( last - first ) );
+	while( index + 1 < count && entry[index + 1].timestamp <= timestamp ){
+		index++;
+	}
+	while( index > 0 && entry[index].timestamp > timestamp ){
+		index--;
+	}
+	return index;
+}
+
+int RecordingReader::findByFrameNumber( int stream, uint32_t frameNumber ) const
+{
+	const int count = counts[stream];
+	if( count == 0 ){
+		return 0;
+	}
+	const RecordIndexEntry* entry = entries[stream];
+	if( frameNumber <= entry[0].frameNumber ){
+		return 0;
+	}
+	if( frameNumber > entry[count - 1].frameNumber ){
+		return count;
+	}
+
+	// t[̕t[ԍ͈ʒuɐiނ̂ŁAԍ̍猩ςʒu߂
+	const int64_t estimate = static_cast<int64_t>( frameNumber ) - entry[0].frameNumber;
+	int index = ( estimate < count - 1 ) ? static_cast<int>( estimate ) : count - 1;
+	while( index > 0 && entry[index - 1].frameNumber >= frameNumber ){
+		index--;
+	}
+	while( entry[index].frameNumber < frameNumber ){
+		index++;
+	}
+	return index;
+}
+
+const PlayerStats* RecordingReader::findPlayerStats( uint32_t frameNumber ) const
+{
+	const int index = findByFrameNumber( RECORD_STREAM_PLAYER_STATS, frameNumber );
+	if( index >= counts[RECORD_STREAM_PLAYER_STATS] || entries[RECORD_STREAM_PLAYER_STATS][index].frameNumber != frameNumber || entries[RECORD_STREAM_PLAYER_STATS][index].size < sizeof( PlayerStats ) * ( KINECT_PLAYER_COUNT + 1 ) ){
+		return nullptr;
+	}
+	return reinterpret_cast<const PlayerStats*>( getRecordData( RECORD_STREAM_PLAYER_STATS, index ) );
+}
+
+
+/*----- RecordingFrameSource -----*/
+
+RecordingFrameSource::RecordingFrameSource( FrameSource* source )
+	: source( source )
+{
+}
+
+RecordingFrameSource::~RecordingFrameSource()
+{
+	close();
+}
+
+bool RecordingFrameSource::close()
+{
+	const bool flushed = flushPlayerStats();
+	return writer.close() && flushed;
+}
+
+bool RecordingFrameSource::read( FrameSet& frames )
+{
+	if( !source->read( frames ) ){
+		return false;
+	}
+	const bool flushed = flushPlayerStats();
+	return writer.write( frames ) && flushed;
+}
+
+void RecordingFrameSource::writePlayerStats( const FrameInfo& info, const PlayerStats* stats )
+{
+	ScopedLock lock( statsMutex );
+	pendingStats.resize( pendingStats.size() + 1 );
+	pendingStats.back().info = info;
+	std::memcpy( pendingStats.back().stats, stats, sizeof( pendingStats.back().stats ) );
+}
+
+bool RecordingFrameSource::flushPlayerStats()
+{
+	{
+		ScopedLock lock( statsMutex );
+		pendingStats.swap( writingStats );
+	}
+	bool result = true;
+	for( size_t i = 0; i < writingStats.size(); i++ ){
+		result = ( !writer.isOpen() || writer.writePlayerStats( writingStats[i].info, writingStats[i].stats ) ) && result;
+	}
+	writingStats.clear();
+	return result;
+}
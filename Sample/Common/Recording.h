@@ -0,0 +1,278 @@
+// Recording.h : t[̋L^t@C̓ǂݏ
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "Platform.h"
+#include "FrameSource.h"
+#include "DepthCodec.h"
+#include "DepthDecoder.h"
+
+
+// L^t@C(*.kbr)̍\
+// t@Cwb_[̌ɁAeXg[̃t[擾ɃR[hƂĕׂ
+// ƂɁAXg[̃R[ḧʒuA^CX^vAt[ԍCfbNXƂĖɏ
+// wb_[ƃR[h͑SRECORDING_ALIGNMENToCgEɑ̂ŁA}bv̈̉ff[^̂܂܏ɓn
+// o[W3Depth̃R[hkł(RecordHeader::compression)
+// o[W4Depth̃t[Player̓ṽR[h߂(RECORD_STREAM_PLAYER_STATS)
+static const uint32_t RECORDING_VERSION   = 4;
+static const uint32_t RECORDING_ALIGNMENT = 64;
+
+// L^t@C̃Xg[(FrameStreamɉPlayer̓v)
+// Player̓ṽR[h́ADepth̃t[Ɠ^CX^vƃt[ԍŁAPlayerStatsKINECT_PLAYER_COUNT + 1ׂ
+static const int RECORD_STREAM_AUDIO        = FRAME_STREAM_COUNT;
+static const int RECORD_STREAM_PLAYER_STATS = FRAME_STREAM_COUNT + 1;
+static const int RECORD_STREAM_COUNT        = FRAME_STREAM_COUNT + 2;
+static const int RECORD_STREAM_FLAG_AUDIO        = 1 << RECORD_STREAM_AUDIO;
+static const int RECORD_STREAM_FLAG_PLAYER_STATS = 1 << RECORD_STREAM_PLAYER_STATS;
+
+// R[h̃f[^̈k
+static const uint32_t RECORD_COMPRESSION_NONE  = 0;
+static const uint32_t RECORD_COMPRESSION_DEPTH = 1; // DepthCompressorňkDepth&Player
+
+// ̃CfbNX̃R[h
+static const uint32_t RECORD_STREAM_INDEX = 0xffffffff;
+
+// (Kinect̃}CNAC̏óA16rbgAm)
+static const uint32_t RECORDING_AUDIO_SAMPLES_PER_SECOND = 16000;
+
+struct RecordingFileHeader
+{
+	char magic[4];     // "KBRC"
+	uint32_t version;  // RECORDING_VERSION
+	uint32_t streams;  // L^Xg[(FRAME_STREAM_FLAG_*ARECORD_STREAM_FLAG_AUDIȎg)
+	uint32_t reserved[13];
+};
+
+struct RecordHeader
+{
+	uint32_t stream;      // FrameStreamARECORD_STREAM_AUDIOARECORD_STREAM_PLAYER_STATSARECORD_STREAM_INDEX
+	uint32_t size;        // f[^̃oCg(pfBO܂܂Ȃ)
+	int64_t timestamp;    // ^CX^v[ms](liTimeStamp)
+	uint32_t frameNumber; // t[ԍ(dwFrameNumberAł͐擪̃Tv̔ԍ)
+	uint32_t format;      // PixelFormat(Skeletonł0Ał̓TvOg)
+	uint16_t width;
+	uint16_t height;
+	uint32_t compression; // RECORD_COMPRESSION_*(o[W2ȑO0)
+	SkeletonVector floorClipPlane; // gSkeletont[̏̕(0)
+	uint32_t reserved[4];
+};
+
+// CfbNX1R[h
+struct RecordIndexEntry
+{
+	uint64_t offset;      // RecordHeader̈ʒu
+	int64_t timestamp;
+	uint32_t frameNumber;
+	uint32_t size;
+};
+
+// t@C̖ɒuACfbNẌʒu
+struct RecordingFooter
+{
+	char magic[4];        // "KBRI"
+	uint32_t reserved0;
+	uint64_t indexOffset; // CfbNX̃R[ḧʒu
+	uint32_t counts[RECORD_STREAM_COUNT]; // Xg[̃R[h̐(o[W3ȑOPlayer̓v̕0)
+	uint32_t reserved[12 - RECORD_STREAM_COUNT];
+};
+
+// L^t@Cւ̏
+// R[h͑傫ȃobt@ɋl߂Ă珑݃Xbh֓n̂ŁAwrite()̓t@Cւ݂̏҂Ȃ
+// (݂ǂȂƂ̓obt@𑝂₵AmaxBuffers𒴂Ƃ󂭂̂҂)
+class RecordingWriter
+{
+public:
+	static const size_t DEFAULT_BUFFER_SIZE = 8 * 1024 * 1024;
+	static const int DEFAULT_MAX_BUFFERS = 32;
+
+	struct Statistics
+	{
+		uint64_t bytesWritten;  // t@C֏񂾃oCg
+		int buffersAllocated;   // mۂobt@̐
+		int peakPendingBuffers; // ݑ҂̃obt@̐̍ől
+		int stalls;             // obt@󂭂̂҂
+	};
+
+	RecordingWriter( size_t bufferSize = DEFAULT_BUFFER_SIZE, int maxBuffers = DEFAULT_MAX_BUFFERS );
+	~RecordingWriter();
+
+	bool open( const char* path, int streams );
+
+	// c̃obt@ƃCfbNXŕ
+	bool close();
+	bool isOpen() const { return file != nullptr; }
+
+	// truêƂDepth̃t[tkď(temporaltruêƂ͑Õt[Ƃ̍g)
+	// kwrite()ĂяoXbhŁAmۂobt@ɒڏ
+	void setDepthCompression( bool enable, bool temporal = true );
+
+	// truêƂPlayer̓ṽXg[L^邱Ƃt@C̃wb_[ɏ(open()̑Oɐݒ肷)
+	// vwritePlayerStats()ŏ݁Ả͂ł͋L^t@CDepthǂ܂RecordingReader::findPlayerStats()Ŏ擾ł
+	void setPlayerStats( bool enable ) { playerStats = enable; }
+
+	// 1t[
+	bool write( FrameStream stream, const FrameInfo& info, const void* data, uint32_t size, const SkeletonVector* floorClipPlane = nullptr );
+	bool writeSkeleton( const SkeletonFrame& frame );
+
+	// Player̓v(KINECT_PLAYER_COUNT + 1̔z)(info͓gDepth̃t[)
+	// v͌ĂяȍŃfR[ĥƂɈꏏɋ߂(ClippingPlayerł͈ʒu킹Depth&Player̓v)
+	bool writePlayerStats( const FrameInfo& info, const PlayerStats* stats );
+
+	// (sampleNumber͋L^n߂ẴTv̔ԍ)
+	bool writeAudio( int64_t timestamp, uint32_t sampleNumber, const int16_t* samples, uint32_t sampleCount );
+
+	// t[̑ĝAL^Xg[̃t[
+	bool write( const FrameSet& frames );
+
+	// (݃Xbh֓n̂܂)oCg
+	uint64_t getBytesWritten() const { return fileOffset; }
+
+	Statistics getStatistics();
+
+private:
+	struct Buffer
+	{
+		uint8_t* data;
+		size_t capacity;
+		size_t size;
+	};
+
+	bool writeRecord( const RecordHeader& header, const void* data );
+	bool writeCompressedDepth( RecordHeader& header, const uint16_t* data );
+	bool append( const void* data, size_t size );
+	bool reserve( size_t size );
+	void submit();
+
+	static void writerEntry( void* argument );
+	void writerLoop();
+
+	size_t bufferSize;
+	int maxBuffers;
+
+	FILE* file;
+	int streams;
+	uint64_t fileOffset;
+	std::vector<RecordIndexEntry> index[RECORD_STREAM_COUNT];
+	bool depthCompression;
+	bool depthTemporal;
+	std::unique_ptr<DepthCompressor> depthCompressor;
+	bool playerStats;
+
+	// currentȊÕobt@mutexŕی삷
+	Buffer* current;
+	Mutex mutex;
+	ConditionVariable bufferPending;
+	ConditionVariable bufferFree;
+	std::deque<Buffer*> pending;
+	std::vector<Buffer*> freeBuffers;
+	std::vector<Buffer*> buffers;
+	Statistics statistics;
+	bool failed;
+	bool quit;
+	Thread thread;
+
+	RecordingWriter( const RecordingWriter& );
+	RecordingWriter& operator=( const RecordingWriter& );
+};
+
+// L^t@C̓ǂݍ
+// t@CŜɃ}bvÃCfbNX𒼐ڎg
+// CfbNX̖t@C(݂̓rŏI)ACfbNXt@C̒Ɏ܂Ȃt@ĆAJƂɃR[hǂăCfbNX
+class RecordingReader
+{
+public:
+	RecordingReader();
+
+	bool open( const char* path );
+	void close();
+	bool isOpen() const { return mappedFile.isOpen(); }
+
+	int getStreams() const { return streams; }
+	uint64_t getSize() const { return mappedFile.getSize(); }
+
+	// ̃CfbNXgǂ
+	bool hasIndex() const { return indexed; }
+
+	// streamFrameStreamARECORD_STREAM_AUDIOARECORD_STREAM_PLAYER_STATS
+	int getFrameCount( int stream ) const { return counts[stream]; }
+	const RecordIndexEntry& getIndexEntry( int stream, int index ) const { return entries[stream][index]; }
+
+	// Xg[indexԖڂ̃R[h(f[^̓wb_[̒ɑ)
+	// kR[h(RecordHeader::compression0ȊO)̃f[^͈k܂ܕԂ
+	const RecordHeader* getRecord( int stream, int index ) const;
+	uint8_t* getRecordData( int stream, int index ) const;
+
+	// ^CX^vtimestampȑOōłVR[h(StimestampVƂ0)
+	int findByTime( int stream, int64_t timestamp ) const;
+
+	// t[ԍframeNumberȍ~ōłÂR[h(ƂgetFrameCount())
+	int findByFrameNumber( int stream, uint32_t frameNumber ) const;
+
+	// t[ԍframeNumberDepth̃t[Player̓v(KINECT_PLAYER_COUNT + 1̔zAƂnullptr)
+	const PlayerStats* findPlayerStats( uint32_t frameNumber ) const;
+
+private:
+	bool readIndex();
+	void scanRecords();
+
+	MappedFile mappedFile;
+	int streams;
+	bool indexed;
+	const RecordIndexEntry* entries[RECORD_STREAM_COUNT];
+	int counts[RECORD_STREAM_COUNT];
+	std::vector<RecordIndexEntry> scannedEntries[RECORD_STREAM_COUNT];
+
+	RecordingReader( const RecordingReader& );
+	RecordingReader& operator=( const RecordingReader& );
+};
+
+// ʂ̃t[\[X擾t[L^t@Cɏ݂Ȃn
+// ݂read()ĂяoXbhōs
+class RecordingFrameSource : public FrameSource
+{
+public:
+	// sourceRecordingFrameSourcej
+	explicit RecordingFrameSource( FrameSource* source );
+	~RecordingFrameSource();
+
+	bool open( const char* path ) { return writer.open( path, source->getStreams() ); }
+	void setDepthCompression( bool enable, bool temporal = true ) { writer.setDepthCompression( enable, temporal ); }
+	void setPlayerStats( bool enable ) { writer.setPlayerStats( enable ); }
+	bool close();
+
+	// ŋ߂Player̓v(KINECT_PLAYER_COUNT + 1̔z)AinfoDepth̃t[̓vƂď
+	// ǂ̃XbhłĂяo(vRs[ĂAread()close()ĂяoXbhŏ)
+	// Ȃt[(pCvCŎ̂Ă)̓v͖
+	void writePlayerStats( const FrameInfo& info, const PlayerStats* stats );
+
+	// L^Ăt[\[X
+	FrameSource* getSource() const { return source.get(); }
+
+	bool read( FrameSet& frames );
+	bool isFrameReady() { return source->isFrameReady(); }
+	int getStreams() const { return source->getStreams(); }
+	const FrameDropCounter& getDropCounter( FrameStream stream ) const { return source->getDropCounter( stream ); }
+
+private:
+	struct PendingPlayerStats
+	{
+		FrameInfo info;
+		PlayerStats stats[KINECT_PLAYER_COUNT + 1];
+	};
+
+	// ߂Ăv
+	bool flushPlayerStats();
+
+	std::unique_ptr<FrameSource> source;
+	RecordingWriter writer;
+	Mutex statsMutex;
+	std::vector<PendingPlayerStats> pendingStats; // statsMutexŕی삷
+	std::vector<PendingPlayerStats> writingStats;
+};
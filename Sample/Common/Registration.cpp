@@ -0,0 +1,525 @@
+// Registration.cpp : DepthColor̈ʒu킹(Registration)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Registration.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+
+/*----- CameraModel -----*/
+
+void CameraModel::setDefault()
+{
+	width = KINECT_IMAGE_WIDTH;
+	height = KINECT_IMAGE_HEIGHT;
+
+	// NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS(320x240) ~ 2
+	depth.fx = 571.26f;
+	depth.fy = 571.26f;
+	depth.cx = width / 2.0f;
+	depth.cy = height / 2.0f;
+
+	// NUI_CAMERA_COLOR_NOMINAL_FOCAL_LENGTH_IN_PIXELS(640x480)
+	color.fx = 531.15f;
+	color.fy = 531.15f;
+	color.cx = width / 2.0f;
+	color.cy = height / 2.0f;
+
+	// ColorJ͐ԊOJ̖25mmɂ
+	for( int i = 0; i < 9; i++ ){
+		rotation[i] = ( i % 4 == 0 ) ? 1.0f : 0.0f;
+	}
+	translation[0] = -25.0f;
+	translation[1] = 0.0f;
+	translation[2] = 0.0f;
+
+	disparityScale = 0.0f;
+	disparityOffset = 0.0f;
+}
+
+bool CameraModel::load( const char* path )
+{
+	std::ifstream ifs( path );
+	if( !ifs ){
+		return false;
+	}
+
+	setDefault();
+
+	// "L[ l..." ̌`̍sǂށA#n܂s̓Rg
+	std::string line;
+	while( std::getline( ifs, line ) ){
+		if( line.empty() || line[0] == '#' ){
+			continue;
+		}
+		std::istringstream iss( line );
+		std::string key;
+		iss >> key;
+		if( key == "size" ){
+			iss >> width >> height;
+		}
+		else if( key == "depth" ){
+			iss >> depth.fx >> depth.fy >> depth.cx >> depth.cy;
+		}
+		else if( key == "color" ){
+			iss >> color.fx >> color.fy >> color.cx >> color.cy;
+		}
+		else if( key == "rotation" ){
+			for( int i = 0; i < 9; i++ ){
+				iss >> rotation[i];
+			}
+		}
+		else if( key == "translation" ){
+			iss >> translation[0] >> translation[1] >> translation[2];
+		}
+		else if( key == "disparity" ){
+			iss >> disparityScale >> disparityOffset;
+		}
+		else{
+			continue;
+		}
+		if( iss.fail() ){
+			return false;
+		}
+	}
+	return ( width > 0 ) && ( height > 0 );
+}
+
+bool CameraModel::save( const char* path ) const
+{
+	std::ofstream ofs( path );
+	if( !ofs ){
+		return false;
+	}
+	ofs.precision( 9 );
+	ofs << "# Kinect camera model" << std::endl;
+	ofs << "size " << width << " " << height << std::endl;
+	ofs << "depth " << depth.fx << " " << depth.fy << " " << depth.cx << " " << depth.cy << std::endl;
+	ofs << "color " << color.fx << " " << color.fy << " " << color.cx << " " << color.cy << std::endl;
+	ofs << "rotation";
+	for( int i = 0; i < 9; i++ ){
+		ofs << " " << rotation[i];
+	}
+	ofs << std::endl;
+	ofs << "translation " << translation[0] << " " << translation[1] << " " << translation[2] << std::endl;
+	ofs << "disparity " << disparityScale << " " << disparityOffset << std::endl;
+	return ofs.good();
+}
+
+bool CameraModel::projectToColor( float depthX, float depthY, float depthMm, float* colorX, float* colorY ) const
+{
+	if( depthMm <= 0.0f ){
+		return false;
+	}
+
+	// DepthJWn֋te
+	const float x = ( depthX - depth.cx ) * depthMm / depth.fx;
+	const float y = ( depthY - depth.cy ) * depthMm / depth.fy;
+	const float z = depthMm;
+
+	// ColorJWn֕ϊ
+	const float cx = rotation[0] * x + rotation[1] * y + rotation[2] * z + translation[0];
+	const float cy = rotation[3] * x + rotation[4] * y + rotation[5] * z + translation[1];
+	const float cz = rotation[6] * x + rotation[7] * y + rotation[8] * z + translation[2];
+	if( cz <= 0.0f ){
+		return false;
+	}
+
+	// Color摜֓eÂ
+	*colorX = color.fx * cx / cz + color.cx + disparityScale / depthMm + disparityOffset;
+	*colorY = color.fy * cy / cz + color.cy;
+	return true;
+}
+
+
+/*----- RegistrationTable -----*/
+
+// e[ut@C̎ʎqƃo[W
+static const char REGISTRATION_TABLE_MAGIC[4] = { 'K', 'B', 'R', 'T' };
+static const uint32_t REGISTRATION_TABLE_VERSION = 1;
+
+RegistrationTable::RegistrationTable()
+	: width( 0 ), height( 0 ), knotCount( 0 )
+{
+}
+
+int RegistrationTable::knotDepthMm( int k ) const
+{
+	// (̋t)œԊuknotu
+	const double nearDisparity = 1.0 / KNOT_NEAR_MM;
+	const double farDisparity = 1.0 / KNOT_FAR_MM;
+	const double disparity = nearDisparity + ( farDisparity - nearDisparity ) * k / ( knotCount - 1 );
+	return static_cast<int>( 1.0 / disparity + 0.5 );
+}
+
+void RegistrationTable::allocate( int width, int height, int knotCount )
+{
+	if( knotCount < 2 ){
+		knotCount = 2;
+	}
+	this->width = width;
+	this->height = height;
+	this->knotCount = knotCount;
+	const int16_t invalid = INVALID_COORD;
+	coords.assign( static_cast<size_t>( width ) * height * knotCount * 2, invalid );
+
+	// [mm]ƂɁAǂknot̊Ԃɂ邩ƕԂ̏d݂߂Ă
+	knotTable.assign( KINECT_DEPTH_MM_COUNT, 0 );
+	const double nearDisparity = 1.0 / KNOT_NEAR_MM;
+	const double farDisparity = 1.0 / KNOT_FAR_MM;
+	for( int mm = 1; mm < KINECT_DEPTH_MM_COUNT; mm++ ){
+		double t = ( nearDisparity - 1.0 / mm ) / ( nearDisparity - farDisparity ) * ( knotCount - 1 );
+		if( t < 0.0 ){
+			t = 0.0;
+		}
+		if( t > knotCount - 1 ){
+			t = knotCount - 1;
+		}
+		int k = static_cast<int>( t );
+		if( k > knotCount - 2 ){
+			k = knotCount - 2;
+		}
+		const uint32_t weight = static_cast<uint32_t>( ( t - k ) * ( 1 << WEIGHT_FRACTION_BITS ) + 0.5 );
+		knotTable[mm] = static_cast<uint32_t>( k ) | ( weight << 16 );
+	}
+}
+
+void RegistrationTable::setKnot( int x, int y, int k, float colorX, float colorY )
+{
+	// Œ菬_ŕ\͈(}2047pixel)Ɏ߂
+	const float limit = 2047.0f;
+	if( colorX < -limit ) colorX = -limit;
+	if( colorX >  limit ) colorX =  limit;
+	if( colorY < -limit ) colorY = -limit;
+	if( colorY >  limit ) colorY =  limit;
+
+	int16_t* knot = &coords[( ( y * width + x ) * knotCount + k ) * 2];
+	knot[0] = static_cast<int16_t>( std::floor( colorX * ( 1 << COORD_FRACTION_BITS ) + 0.5f ) );
+	knot[1] = static_cast<int16_t>( std::floor( colorY * ( 1 << COORD_FRACTION_BITS ) + 0.5f ) );
+}
+
+void RegistrationTable::setKnotInvalid( int x, int y, int k )
+{
+	int16_t* knot = &coords[( ( y * width + x ) * knotCount + k ) * 2];
+	knot[0] = INVALID_COORD;
+	knot[1] = INVALID_COORD;
+}
+
+void RegistrationTable::build( const CameraModel& model, int knotCount )
+{
+	buildFromMapping( model.width, model.height, knotCount,
+		[&model]( int x, int y, int depthMm, float* colorX, float* colorY ){
+			return model.projectToColor( static_cast<float>( x ), static_cast<float>( y ), static_cast<float>( depthMm ), colorX, colorY );
+		}
+	);
+}
+
+bool RegistrationTable::mapPixel( int x, int y, uint16_t depthPlayer, int* colorX, int* colorY ) const
+{
+	const int depthMm = depthPlayer >> KINECT_PLAYER_INDEX_SHIFT;
+	if( depthMm == 0 ){
+		return false;
+	}
+
+	const int k = knotOfDepth( depthMm );
+	const int w = weightOfDepth( depthMm );
+	const int16_t* knot = &coords[( ( y * width + x ) * knotCount + k ) * 2];
+	if( ( knot[0] == INVALID_COORD ) || ( knot[2] == INVALID_COORD ) ){
+		return false;
+	}
+
+	// ׂ荇knot`ԂĎľܓ
+	const int shift = COORD_FRACTION_BITS + WEIGHT_FRACTION_BITS;
+	const int round = 1 << ( shift - 1 );
+	*colorX = ( knot[0] * ( 1 << WEIGHT_FRACTION_BITS ) + ( knot[2] - knot[0] ) * w + round ) >> shift;
+	*colorY = ( knot[1] * ( 1 << WEIGHT_FRACTION_BITS ) + ( knot[3] - knot[1] ) * w + round ) >> shift;
+	return true;
+}
+
+// O()̉fcďށA0͒lȂf
+// ޏԂɂ炸ʂɂȂ̂ŁAXJ[łSIMDł̌ʂv
+static inline void writeNearest( uint16_t* dst, int index, uint16_t value, int& first, int& last )
+{
+	if( index < first ){
+		first = index;
+	}
+	if( index > last ){
+		last = index;
+	}
+	const uint16_t current = dst[index];
+	if( ( current == 0 ) || ( value < current ) ){
+		dst[index] = value;
+	}
+}
+
+void RegistrationTable::registerFrame( const uint16_t* src, uint16_t* dst ) const
+{
+	registerFrame( src, dst, getSimdLevel() );
+}
+
+void RegistrationTable::registerFrame( const uint16_t* src, uint16_t* dst, SimdLevel level ) const
+{
+	std::memset( dst, 0, sizeof( uint16_t ) * width * height );
+
+	int first = 0;
+	int last = 0;
+	registerRange( src, dst, 0, width * height, level, &first, &last );
+}
+
+void RegistrationTable::registerRange( const uint16_t* src, uint16_t* dst, int begin, int end, SimdLevel level, int* first, int* last ) const
+{
+	*first = width * height;
+	*last = -1;
+
+	// CPUΉĂȂ߃Zbg͎gȂ
+	if( level > getSimdLevel() ){
+		level = getSimdLevel();
+	}
+#ifdef KINECT_SIMD_AVX2
+	if( level >= SIMD_AVX2 ){
+		registerRangeAvx2( src, dst, begin, end, *first, *last );
+		return;
+	}
+#endif
+#ifdef KINECT_SIMD_X86
+	if( level >= SIMD_SSE41 ){
+		registerRangeSse41( src, dst, begin, end, *first, *last );
+		return;
+	}
+#endif
+	registerRangeScalar( src, dst, begin, end, *first, *last );
+}
+
+void RegistrationTable::registerRangeScalar( const uint16_t* src, uint16_t* dst, int begin, int end, int& first, int& last ) const
+{
+	const int shift = COORD_FRACTION_BITS + WEIGHT_FRACTION_BITS;
+	const int round = 1 << ( shift - 1 );
+	const int stride = knotCount * 2;
+	const int16_t* knots = &coords[0] + begin * stride;
+	for( int i = begin; i < end; i++, knots += stride ){
+		const int depthMm = src[i] >> KINECT_PLAYER_INDEX_SHIFT;
+		if( depthMm == 0 ){
+			continue;
+		}
+		const int k = knotOfDepth( depthMm );
+		const int w = weightOfDepth( depthMm );
+		const int16_t* knot = knots + k * 2;
+		if( ( knot[0] == INVALID_COORD ) || ( knot[2] == INVALID_COORD ) ){
+			continue;
+		}
+		const int registX = ( knot[0] * ( 1 << WEIGHT_FRACTION_BITS ) + ( knot[2] - knot[0] ) * w + round ) >> shift;
+		const int registY = ( knot[1] * ( 1 << WEIGHT_FRACTION_BITS ) + ( knot[3] - knot[1] ) * w + round ) >> shift;
+		if( ( static_cast<unsigned int>( registX ) < static_cast<unsigned int>( width ) ) && ( static_cast<unsigned int>( registY ) < static_cast<unsigned int>( height ) ) ){
+			writeNearest( dst, registY * width + registX, src[i], first, last );
+		}
+	}
+}
+
+#ifdef KINECT_SIMD_X86
+
+// 4f̕ϊ̃CfbNX߂(ϊłȂf-1)
+// mm : [mm]Apair0/pair1 : ׂ荇knot̍W(16rbgxA16rbgy)Aweight : Ԃ̏d
+KINECT_TARGET_SSE41
+static inline __m128i registerTargetsSse41( __m128i mm, __m128i pair0, __m128i pair1, __m128i weight, int width, int height )
+{
+	const int shift = RegistrationTable::COORD_FRACTION_BITS + RegistrationTable::WEIGHT_FRACTION_BITS;
+	const __m128i round = _mm_set1_epi32( 1 << ( shift - 1 ) );
+	const __m128i invalid = _mm_set1_epi32( RegistrationTable::INVALID_COORD );
+	const __m128i minusOne = _mm_set1_epi32( -1 );
+	const __m128i widthV = _mm_set1_epi32( width );
+	const __m128i heightV = _mm_set1_epi32( height );
+
+	// t16rbg̍Wo
+	const __m128i x0 = _mm_srai_epi32( _mm_slli_epi32( pair0, 16 ), 16 );
+	const __m128i y0 = _mm_srai_epi32( pair0, 16 );
+	const __m128i x1 = _mm_srai_epi32( _mm_slli_epi32( pair1, 16 ), 16 );
+	const __m128i y1 = _mm_srai_epi32( pair1, 16 );
+
+	// ׂ荇knot`ԂĎľܓ
+	const __m128i registX = _mm_srai_epi32( _mm_add_epi32( _mm_add_epi32( _mm_slli_epi32( x0, RegistrationTable::WEIGHT_FRACTION_BITS ), _mm_mullo_epi32( _mm_sub_epi32( x1, x0 ), weight ) ), round ), shift );
+	const __m128i registY = _mm_srai_epi32( _mm_add_epi32( _mm_add_epi32( _mm_slli_epi32( y0, RegistrationTable::WEIGHT_FRACTION_BITS ), _mm_mullo_epi32( _mm_sub_epi32( y1, y0 ), weight ) ), round ), shift );
+
+	// 0̉fAϊłȂknotA摜̊Oɏof
+	const __m128i rejected = _mm_or_si128( _mm_cmpeq_epi32( mm, _mm_setzero_si128() ), _mm_or_si128( _mm_cmpeq_epi32( x0, invalid ), _mm_cmpeq_epi32( x1, invalid ) ) );
+	const __m128i inside = _mm_and_si128( _mm_and_si128( _mm_cmpgt_epi32( registX, minusOne ), _mm_cmpgt_epi32( widthV, registX ) ),
+	                                      _mm_and_si128( _mm_cmpgt_epi32( registY, minusOne ), _mm_cmpgt_epi32( heightV, registY ) ) );
+	const __m128i accepted = _mm_andnot_si128( rejected, inside );
+
+	const __m128i target = _mm_add_epi32( _mm_mullo_epi32( registY, widthV ), registX );
+	return _mm_blendv_epi8( minusOne, target, accepted );
+}
+
+// SSE4.1
+// SSE4.1ɂgather߂̂ŁA\knot̍W̓ǂݍ݂̓XJ[ōsAԂƔ͈͔4f
+KINECT_TARGET_SSE41
+void RegistrationTable::registerRangeSse41( const uint16_t* src, uint16_t* dst, int begin, int end, int& first, int& last ) const
+{
+	const int32_t* pairs = reinterpret_cast<const int32_t*>( &coords[0] );
+	const uint32_t* table = &knotTable[0];
+
+	int i = begin;
+	for( ; i + 8 <= end; i += 8 ){
+		const __m128i depthPlayer = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+
+		// lfΉȂ(wǐ摜̒[ő)
+		if( _mm_testz_si128( depthPlayer, depthPlayer ) ){
+			continue;
+		}
+
+		int32_t target[8];
+		for( int half = 0; half < 2; half++ ){
+			const __m128i value = _mm_cvtepu16_epi32( half == 0 ? depthPlayer : _mm_srli_si128( depthPlayer, 8 ) );
+			const __m128i mm = _mm_srli_epi32( value, KINECT_PLAYER_INDEX_SHIFT );
+
+			// \knot̍W̓ǂݍ
+			const int pixel = i + half * 4;
+			const uint32_t knot0 = table[_mm_extract_epi32( mm, 0 )];
+			const uint32_t knot1 = table[_mm_extract_epi32( mm, 1 )];
+			const uint32_t knot2 = table[_mm_extract_epi32( mm, 2 )];
+			const uint32_t knot3 = table[_mm_extract_epi32( mm, 3 )];
+			const int32_t* pair0 = pairs + ( pixel + 0 ) * knotCount + ( knot0 & 0xFFFF );
+			const int32_t* pair1 = pairs + ( pixel + 1 ) * knotCount + ( knot1 & 0xFFFF );
+			const int32_t* pair2 = pairs + ( pixel + 2 ) * knotCount + ( knot2 & 0xFFFF );
+			const int32_t* pair3 = pairs + ( pixel + 3 ) * knotCount + ( knot3 & 0xFFFF );
+			const __m128i knot = _mm_setr_epi32( knot0, knot1, knot2, knot3 );
+
+			const __m128i result = registerTargetsSse41( mm,
+				_mm_setr_epi32( pair0[0], pair1[0], pair2[0], pair3[0] ),
+				_mm_setr_epi32( pair0[1], pair1[1], pair2[1], pair3[1] ),
+				_mm_srli_epi32( knot, 16 ),
+				width, height );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( target + half * 4 ), result );
+		}
+
+		// ݐ悪΂΂Ȃ̂ŁAZobt@̍XV̓XJ[ōs
+		for( int j = 0; j < 8; j++ ){
+			if( target[j] >= 0 ){
+				writeNearest( dst, target[j], src[i + j], first, last );
+			}
+		}
+	}
+
+	registerRangeScalar( src, dst, i, end, first, last );
+}
+
+#endif
+
+#ifdef KINECT_SIMD_AVX2
+
+// 8f̕ϊ̃CfbNX߂(registerTargetsSse41()AVX2)
+KINECT_TARGET_AVX2
+static inline __m256i registerTargetsAvx2( __m256i mm, __m256i pair0, __m256i pair1, __m256i weight, int width, int height )
+{
+	const int shift = RegistrationTable::COORD_FRACTION_BITS + RegistrationTable::WEIGHT_FRACTION_BITS;
+	const __m256i round = _mm256_set1_epi32( 1 << ( shift - 1 ) );
+	const __m256i invalid = _mm256_set1_epi32( RegistrationTable::INVALID_COORD );
+	const __m256i minusOne = _mm256_set1_epi32( -1 );
+	const __m256i widthV = _mm256_set1_epi32( width );
+	const __m256i heightV = _mm256_set1_epi32( height );
+
+	const __m256i x0 = _mm256_srai_epi32( _mm256_slli_epi32( pair0, 16 ), 16 );
+	const __m256i y0 = _mm256_srai_epi32( pair0, 16 );
+	const __m256i x1 = _mm256_srai_epi32( _mm256_slli_epi32( pair1, 16 ), 16 );
+	const __m256i y1 = _mm256_srai_epi32( pair1, 16 );
+
+	const __m256i registX = _mm256_srai_epi32( _mm256_add_epi32( _mm256_add_epi32( _mm256_slli_epi32( x0, RegistrationTable::WEIGHT_FRACTION_BITS ), _mm256_mullo_epi32( _mm256_sub_epi32( x1, x0 ), weight ) ), round ), shift );
+	const __m256i registY = _mm256_srai_epi32( _mm256_add_epi32( _mm256_add_epi32( _mm256_slli_epi32( y0, RegistrationTable::WEIGHT_FRACTION_BITS ), _mm256_mullo_epi32( _mm256_sub_epi32( y1, y0 ), weight ) ), round ), shift );
+
+	const __m256i rejected = _mm256_or_si256( _mm256_cmpeq_epi32( mm, _mm256_setzero_si256() ), _mm256_or_si256( _mm256_cmpeq_epi32( x0, invalid ), _mm256_cmpeq_epi32( x1, invalid ) ) );
+	const __m256i inside = _mm256_and_si256( _mm256_and_si256( _mm256_cmpgt_epi32( registX, minusOne ), _mm256_cmpgt_epi32( widthV, registX ) ),
+	                                         _mm256_and_si256( _mm256_cmpgt_epi32( registY, minusOne ), _mm256_cmpgt_epi32( heightV, registY ) ) );
+	const __m256i accepted = _mm256_andnot_si256( rejected, inside );
+
+	const __m256i target = _mm256_add_epi32( _mm256_mullo_epi32( registY, widthV ), registX );
+	return _mm256_blendv_epi8( minusOne, target, accepted );
+}
+
+// AVX2
+// 16fǂݍ݁A\knot̍W̓ǂݍ݂gather߂8f
+KINECT_TARGET_AVX2
+void RegistrationTable::registerRangeAvx2( const uint16_t* src, uint16_t* dst, int begin, int end, int& first, int& last ) const
+{
+	const int* pairs = reinterpret_cast<const int*>( &coords[0] );
+	const int* table = reinterpret_cast<const int*>( &knotTable[0] );
+	const __m256i lane = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	const __m256i knotCountV = _mm256_set1_epi32( knotCount );
+	const __m256i lowMask = _mm256_set1_epi32( 0xFFFF );
+
+	int i = begin;
+	for( ; i + 16 <= end; i += 16 ){
+		const __m256i depthPlayer = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( src + i ) );
+		if( _mm256_testz_si256( depthPlayer, depthPlayer ) ){
+			continue;
+		}
+
+		int32_t target[16];
+		for( int half = 0; half < 2; half++ ){
+			const __m256i value = _mm256_cvtepu16_epi32( half == 0 ? _mm256_castsi256_si128( depthPlayer ) : _mm256_extracti128_si256( depthPlayer, 1 ) );
+			const __m256i mm = _mm256_srli_epi32( value, KINECT_PLAYER_INDEX_SHIFT );
+
+			// knotƏd݂\
+			const __m256i knot = _mm256_i32gather_epi32( table, mm, 4 );
+			const __m256i weight = _mm256_srli_epi32( knot, 16 );
+
+			// fƂknot̍Wǂݍ
+			const __m256i pixel = _mm256_add_epi32( _mm256_set1_epi32( i + half * 8 ), lane );
+			const __m256i index = _mm256_add_epi32( _mm256_mullo_epi32( pixel, knotCountV ), _mm256_and_si256( knot, lowMask ) );
+			const __m256i pair0 = _mm256_i32gather_epi32( pairs, index, 4 );
+			const __m256i pair1 = _mm256_i32gather_epi32( pairs + 1, index, 4 );
+
+			_mm256_storeu_si256( reinterpret_cast<__m256i*>( target + half * 8 ), registerTargetsAvx2( mm, pair0, pair1, weight, width, height ) );
+		}
+
+		for( int j = 0; j < 16; j++ ){
+			if( target[j] >= 0 ){
+				writeNearest( dst, target[j], src[i + j], first, last );
+			}
+		}
+	}
+
+	registerRangeScalar( src, dst, i, end, first, last );
+}
+
+#endif
+
+bool RegistrationTable::save( const char* path ) const
+{
+	std::ofstream ofs( path, std::ios::binary );
+	if( !ofs ){
+		return false;
+	}
+	const uint32_t header[4] = { REGISTRATION_TABLE_VERSION, static_cast<uint32_t>( width ), static_cast<uint32_t>( height ), static_cast<uint32_t>( knotCount ) };
+	ofs.write( REGISTRATION_TABLE_MAGIC, sizeof( REGISTRATION_TABLE_MAGIC ) );
+	ofs.write( reinterpret_cast<const char*>( header ), sizeof( header ) );
+	ofs.write( reinterpret_cast<const char*>( &coords[0] ), sizeof( int16_t ) * coords.size() );
+	return ofs.good();
+}
+
+bool RegistrationTable::load( const char* path )
+{
+	std::ifstream ifs( path, std::ios::binary );
+	if( !ifs ){
+		return false;
+	}
+	char magic[4];
+	uint32_t header[4];
+	ifs.read( magic, sizeof( magic ) );
+	ifs.read( reinterpret_cast<char*>( header ), sizeof( header ) );
+	if( !ifs || std::memcmp( magic, REGISTRATION_TABLE_MAGIC, sizeof( magic ) ) != 0 || header[0] != REGISTRATION_TABLE_VERSION ){
+		return false;
+	}
+	if( header[1] == 0 || header[2] == 0 || header[1] > 4096 || header[2] > 4096 || header[3] < 2 || header[3] > 256 ){
+		return false;
+	}
+	allocate( header[1], header[2], header[3] );
+	ifs.read( reinterpret_cast<char*>( &coords[0] ), sizeof( int16_t ) * coords.size() );
+	if( !ifs ){
+		coords.clear();
+		return false;
+	}
+	return true;
+}
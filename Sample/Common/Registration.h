@@ -0,0 +1,165 @@
+// Registration.h : DepthColor̈ʒu킹(Registration)
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "KinectTypes.h"
+#include "Simd.h"
+
+
+// J̓p[^[
+struct CameraIntrinsics
+{
+	float fx, fy; // œ_[pixel]
+	float cx, cy; // wS[pixel]
+};
+
+// DepthJColorJ̊֌W\Jf
+// Depth摜̓_(x, y, z)3ɋteAOp[^[ŕϊĂColor摜֓e
+// ɋɈˑ鎋̂ disparityScale / z + disparityOffset xɉ
+struct CameraModel
+{
+	// 摜TCY
+	int width;
+	int height;
+
+	// p[^[
+	CameraIntrinsics depth;
+	CameraIntrinsics color;
+
+	// Op[^[(DepthJWnColorJWn)
+	float rotation[9];    // ]s(sD)
+	float translation[3]; // i[mm]
+
+	// Ɉˑ鎋̂[pixel]
+	float disparityScale;  // [pixel*mm]
+	float disparityOffset; // [pixel]
+
+	// Kinecť̒l(NUI_CAMERA_*_NOMINAL_*)ŏ
+	void setDefault();
+
+	// eLXg`̃Lu[Vt@C̓ǂݏ
+	bool load( const char* path );
+	bool save( const char* path ) const;
+
+	// Depth摜̓_Color摜̓_ɕϊ
+	// ϊłȂƂ(J̌Ȃ)falseԂ
+	bool projectToColor( float depthX, float depthY, float depthMm, float* colorX, float* colorY ) const;
+};
+
+// ʒu킹̃bNAbve[u
+// fƂɁA̋t()œԊuɕׂknotCount̋ł̕ϊWێ
+// s͋knotƏd݂\Aׂ荇2knot`Ԃ邾ŕϊ悪܂
+// ̉fϊɏdȂƂ́AłO()̉fc(Zobt@)
+class RegistrationTable
+{
+public:
+	// knot̐̊l
+	static const int DEFAULT_KNOT_COUNT = 8;
+
+	// knotzu鋗͈̔[mm]
+	static const int KNOT_NEAR_MM = 400;
+	static const int KNOT_FAR_MM  = 8000;
+
+	// W̌Œ菬_̏̃rbg
+	static const int COORD_FRACTION_BITS = 4;
+
+	// ď݂Œ菬_̏̃rbg
+	static const int WEIGHT_FRACTION_BITS = 8;
+
+	// ϊłȂf\W̒l
+	static const int16_t INVALID_COORD = -32768;
+
+	RegistrationTable();
+
+	// Jfe[u쐬
+	void build( const CameraModel& model, int knotCount = DEFAULT_KNOT_COUNT );
+
+	// Cӂ̕ϊ֐e[u쐬
+	// mapToColor bool( int x, int y, int depthMm, float* colorX, float* colorY ) ̌`
+	// (Kinect SDK̕ϊ֐̂܂ܕ\ɏĂނƂɎg)
+	template<class MapFunc>
+	bool buildFromMapping( int width, int height, int knotCount, MapFunc mapToColor )
+	{
+		allocate( width, height, knotCount );
+		for( int y = 0; y < height; y++ ){
+			for( int x = 0; x < width; x++ ){
+				for( int k = 0; k < knotCount; k++ ){
+					float colorX = 0.0f;
+					float colorY = 0.0f;
+					if( mapToColor( x, y, knotDepthMm( k ), &colorX, &colorY ) ){
+						setKnot( x, y, k, colorX, colorY );
+					}
+					else{
+						setKnotInvalid( x, y, k );
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// 1t[̈ʒu킹s
+	// src : DepthJ_Depth(&Player)f[^
+	// dst : ColorJ_ɕϊDepth(&Player)f[^(lȂf0ɂȂ)
+	// CPUΉĂł߃Zbg̏g
+	void registerFrame( const uint16_t* src, uint16_t* dst ) const;
+
+	// ߃Zbgw肵Ĉʒu킹s(ǂ̖߃Zbgłʂ͓ɂȂ)
+	void registerFrame( const uint16_t* src, uint16_t* dst, SimdLevel level ) const;
+
+	// f[begin, end)ʒu킹(dst͍̏sȂ)
+	// ̃XbhŕSƂɎgA񂾉f̃CfbNX͈̔͂[*first, *last]ɕԂ(݂Ƃ*first > *last)
+	void registerRange( const uint16_t* src, uint16_t* dst, int begin, int end, SimdLevel level, int* first, int* last ) const;
+
+	// 1f̕ϊ߂
+	bool mapPixel( int x, int y, uint16_t depthPlayer, int* colorX, int* colorY ) const;
+
+	// oCi`ł̓ǂݏ
+	// Kinect SDK쐬e[uۑĂ΁AZT[̖łʒu킹ł
+	bool load( const char* path );
+	bool save( const char* path ) const;
+
+	bool empty() const { return coords.empty(); }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getKnotCount() const { return knotCount; }
+
+	// kԖڂknot̋[mm]
+	int knotDepthMm( int k ) const;
+
+	// [mm]ɑΉknotƏd
+	int knotOfDepth( int depthMm ) const { return knotTable[depthMm] & 0xFFFF; }
+	int weightOfDepth( int depthMm ) const { return knotTable[depthMm] >> 16; }
+
+	// f(x, y)knot̍W(x, y̏ɌŒ菬_knotCountg)
+	const int16_t* knotsOfPixel( int index ) const { return &coords[index * knotCount * 2]; }
+
+private:
+	void allocate( int width, int height, int knotCount );
+	void setKnot( int x, int y, int k, float colorX, float colorY );
+	void setKnotInvalid( int x, int y, int k );
+
+	// ߃Zbg̏
+	void registerRangeScalar( const uint16_t* src, uint16_t* dst, int begin, int end, int& first, int& last ) const;
+#ifdef KINECT_SIMD_X86
+	void registerRangeSse41( const uint16_t* src, uint16_t* dst, int begin, int end, int& first, int& last ) const;
+#endif
+#ifdef KINECT_SIMD_AVX2
+	void registerRangeAvx2( const uint16_t* src, uint16_t* dst, int begin, int end, int& first, int& last ) const;
+#endif
+
+	int width;
+	int height;
+	int knotCount;
+
+	// fƂknot̍W
+	// x, y̑g32rbgPʂł܂Ƃ߂ēǂ߂悤ɗׂ荇킹ĕׂ
+	std::vector<int16_t> coords;
+
+	// [mm]Ƃknot̃CfbNX(16rbg)Əd(16rbg)
+	std::vector<uint32_t> knotTable;
+};
@@ -0,0 +1,211 @@
+// ReplayFrameSource.cpp : L^t@CĐt[\[X
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "ReplayFrameSource.h"
+
+
+ReplayFrameSource::ReplayFrameSource()
+	: streams( 0 ), position( 0 ), realTime( false ), loop( false ), startTime( 0.0 ), startTimestamp( 0 ), decodedDepthIndex( -1 )
+{
+}
+
+bool ReplayFrameSource::open( const char* path, int streams )
+{
+	close();
+	if( !reader.open( path ) ){
+		return false;
+	}
+
+	// L^ĂȂXg[͎gȂ
+	const int requested = streams ? streams : reader.getStreams();
+	if( ( requested & reader.getStreams() ) != requested ){
+		close();
+		return false;
+	}
+	this->streams = requested;
+	if( getFrameCount() == 0 ){
+		close();
+		return false;
+	}
+	seek( 0 );
+	return true;
+}
+
+void ReplayFrameSource::close()
+{
+	reader.close();
+	streams = 0;
+	position = 0;
+	depthDecompressor.reset();
+	decodedDepthIndex = -1;
+}
+
+int ReplayFrameSource::getFrameCount() const
+{
+	int count = -1;
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( streams & ( 1 << i ) ){
+			const int streamCount = reader.getFrameCount( static_cast<FrameStream>( i ) );
+			count = ( count < 0 || streamCount < count ) ? streamCount : count;
+		}
+	}
+	return ( count < 0 ) ? 0 : count;
+}
+
+void ReplayFrameSource::seek( int index )
+{
+	position = index;
+	startTime = 0.0;
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		dropCounters[i].reset();
+	}
+}
+
+void ReplayFrameSource::seekToTime( int64_t timestamp )
+{
+	if( !reader.isOpen() ){
+		return;
+	}
+	seek( reader.findByTime( getMainStream(), timestamp ) );
+}
+
+FrameStream ReplayFrameSource::getMainStream() const
+{
+	if( streams & FRAME_STREAM_FLAG_DEPTH ){
+		return FRAME_STREAM_DEPTH;
+	}
+	return ( streams & FRAME_STREAM_FLAG_COLOR ) ? FRAME_STREAM_COLOR : FRAME_STREAM_SKELETON;
+}
+
+double ReplayFrameSource::getPlaybackTime() const
+{
+	return ( getTimeInSeconds() - startTime ) * 1000.0;
+}
+
+bool ReplayFrameSource::decompressDepth( int index )
+{
+	if( index == decodedDepthIndex ){
+		return true;
+	}
+
+	// čĐƂ͒Õt[gAV[NƂ̓L[t[܂Ŗ߂ēWJ
+	int start = index;
+	if( index != decodedDepthIndex + 1 || decodedDepthIndex < 0 ){
+		while( start > 0 && !DepthDecompressor::isKeyframe( reader.getRecordData( FRAME_STREAM_DEPTH, start ), reader.getRecord( FRAME_STREAM_DEPTH, start )->size ) ){
+			start--;
+		}
+	}
+
+	const RecordHeader* record = reader.getRecord( FRAME_STREAM_DEPTH, index );
+	if( record->width == 0 || record->height == 0 ){
+		decodedDepthIndex = -1;
+		return false;
+	}
+	depthBuffer.resize( static_cast<size_t>( record->width ) * record->height );
+	for( int i = start; i <= index; i++ ){
+		if( !depthDecompressor.decompress( reader.getRecordData( FRAME_STREAM_DEPTH, i ), reader.getRecord( FRAME_STREAM_DEPTH, i )->size, &depthBuffer[0], record->width, record->height ) ){
+			decodedDepthIndex = -1;
+			return false;
+		}
+	}
+	decodedDepthIndex = index;
+	return true;
+}
+
+bool ReplayFrameSource::setImageFrame( FrameStream stream, int index, ImageFrame& frame )
+{
+	const RecordHeader* record = reader.getRecord( stream, index );
+	if( record->format > PIXEL_FORMAT_BGRX32 || ( stream == FRAME_STREAM_DEPTH && record->format != PIXEL_FORMAT_DEPTH16 ) ){
+		return false;
+	}
+	const PixelFormat format = static_cast<PixelFormat>( record->format );
+	if( record->compression == RECORD_COMPRESSION_DEPTH && stream == FRAME_STREAM_DEPTH ){
+		if( !decompressDepth( index ) ){
+			return false;
+		}
+		frame.data = reinterpret_cast<uint8_t*>( &depthBuffer[0] );
+	}
+	else if( record->compression == RECORD_COMPRESSION_NONE && record->size == static_cast<uint64_t>( record->width ) * record->height * getBytesPerPixel( format ) ){
+		frame.data = reader.getRecordData( stream, index );
+	}
+	else{
+		return false;
+	}
+	frame.info.frameNumber = record->frameNumber;
+	frame.info.timestamp = record->timestamp;
+	frame.info.format = format;
+	frame.info.width = record->width;
+	frame.info.height = record->height;
+	return true;
+}
+
+bool ReplayFrameSource::isFrameReady()
+{
+	if( !reader.isOpen() ){
+		return false;
+	}
+	if( position >= getFrameCount() ){
+		return loop;
+	}
+	if( !realTime || startTime == 0.0 ){
+		return true;
+	}
+	return reader.getIndexEntry( getMainStream(), position ).timestamp - startTimestamp <= getPlaybackTime();
+}
+
+bool ReplayFrameSource::read( FrameSet& frames )
+{
+	frames.reset();
+	if( !reader.isOpen() ){
+		return false;
+	}
+	if( position >= getFrameCount() ){
+		if( !loop ){
+			return false;
+		}
+		seek( 0 );
+	}
+
+	// 傫̍ȂR[hꂽkf[^Ƃ́AōĐI
+	if( ( streams & FRAME_STREAM_FLAG_COLOR ) && !setImageFrame( FRAME_STREAM_COLOR, position, frames.color ) ){
+		frames.reset();
+		return false;
+	}
+	if( ( streams & FRAME_STREAM_FLAG_DEPTH ) && !setImageFrame( FRAME_STREAM_DEPTH, position, frames.depth ) ){
+		frames.reset();
+		return false;
+	}
+	if( streams & FRAME_STREAM_FLAG_SKELETON ){
+		if( reader.getRecord( FRAME_STREAM_SKELETON, position )->size != sizeof( SkeletonFrame ) ){
+			frames.reset();
+			return false;
+		}
+		frames.skeleton = reinterpret_cast<const SkeletonFrame*>( reader.getRecordData( FRAME_STREAM_SKELETON, position ) );
+	}
+	if( frames.color.data ){
+		dropCounters[FRAME_STREAM_COLOR].update( frames.color.info.frameNumber );
+	}
+	if( frames.depth.data ){
+		dropCounters[FRAME_STREAM_DEPTH].update( frames.depth.info.frameNumber );
+	}
+	if( frames.skeleton ){
+		dropCounters[FRAME_STREAM_SKELETON].update( frames.skeleton->frameNumber );
+	}
+
+	// ԂōĐƂ́A擪̃t[̃^CX^v̍Ԃo܂ő҂
+	const int64_t timestamp = frames.depth.data ? frames.depth.info.timestamp : ( frames.color.data ? frames.color.info.timestamp : frames.skeleton->timestamp );
+	if( realTime ){
+		if( startTime == 0.0 ){
+			startTime = getTimeInSeconds();
+			startTimestamp = timestamp;
+		}
+		const double wait = static_cast<double>( timestamp - startTimestamp ) - getPlaybackTime();
+		if( wait >= 1.0 ){
+			sleepMilliseconds( static_cast<int>( wait ) );
+		}
+	}
+
+	position++;
+	return true;
+}
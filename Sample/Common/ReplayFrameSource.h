@@ -0,0 +1,74 @@
+// ReplayFrameSource.h : L^t@CĐt[\[X
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include "FrameSource.h"
+#include "Recording.h"
+#include "DepthCodec.h"
+#include <vector>
+
+
+// L^t@CɃ}bvčĐ
+// t[̓Rs[ɁA}bv̈𒼐ڎwImageFrameƂēn
+// kDepth̃t[́AWJobt@w(read()܂ŗL)
+class ReplayFrameSource : public FrameSource
+{
+public:
+	ReplayFrameSource();
+
+	// streams͍ĐXg[(0̂Ƃ͋L^ĂSẴXg[)
+	bool open( const char* path, int streams = 0 );
+	void close();
+
+	// truêƂ̓^CX^v̊Ԋuɍ킹čĐAfalsêƂ͑҂ɎXƍĐ(lfalse)
+	void setRealTime( bool realTime ) { this->realTime = realTime; }
+
+	// truêƂ͍Ō܂ōĐ擪ɖ߂
+	void setLoop( bool loop ) { this->loop = loop; }
+
+	// 擪indexԖڂ̃t[̑gɈړ
+	void seek( int index );
+
+	// ^CX^v[ms]timestampȑOōłVt[̑gɈړ(L^t@C̃CfbNXg)
+	void seekToTime( int64_t timestamp );
+
+	// Đłt[̑g̐(gXg[̒ōłȂt[)
+	int getFrameCount() const;
+
+	// ĐĂL^t@C
+	const RecordingReader& getReader() const { return reader; }
+
+	bool read( FrameSet& frames );
+	bool isFrameReady();
+	int getStreams() const { return streams; }
+	const FrameDropCounter& getDropCounter( FrameStream stream ) const { return dropCounters[stream]; }
+
+private:
+	// R[h̑傫wb_[̉摜̑傫ƍȂƂ(ꂽL^t@C)falseԂ
+	bool setImageFrame( FrameStream stream, int index, ImageFrame& frame );
+
+	// kDepth̃t[WJ(Õt[gt[́AL[t[珇ɓWJ)
+	// WJt[̑傫̓R[h̃wb_[̕ƍŁAkf[^̑傫ƈႤƂfalseԂ
+	bool decompressDepth( int index );
+
+	// Đ̎̊ɂXg[(DepthAColorASkeleton̏Ɏg)
+	FrameStream getMainStream() const;
+
+	// Đ[ms](擪̃t[̌oߎ)
+	double getPlaybackTime() const;
+
+	RecordingReader reader;
+	int streams;
+	int position;
+	bool realTime;
+	bool loop;
+	double startTime;
+	int64_t startTimestamp;
+	FrameDropCounter dropCounters[FRAME_STREAM_COUNT];
+
+	DepthDecompressor depthDecompressor;
+	std::vector<uint16_t> depthBuffer;
+	int decodedDepthIndex; // depthBufferɓWJt[(Ƃ-1)
+};
@@ -0,0 +1,105 @@
+// Simd.h : SIMD߂̗pۂ̔
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+// x86/x64̂ƂSIMDł̏g
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#define KINECT_SIMD_X86 1
+#endif
+
+// AVX2̑gݍ݊֐Visual C++ 2013ȍ~(܂GCC/Clang)łgȂ
+// Visual C++ 2010łSSE4.1łƃXJ[łrh
+#if defined( KINECT_SIMD_X86 ) && ( ( defined( _MSC_VER ) && ( _MSC_VER >= 1800 ) ) || defined( __GNUC__ ) )
+#define KINECT_SIMD_AVX2 1
+#endif
+
+// GCC/Clangł͊֐PʂŖ߃ZbgLɂ(Visual C++ł͎w肵ȂĂg)
+#if defined( __GNUC__ )
+#define KINECT_TARGET_SSE41 __attribute__(( target( "sse4.1" ) ))
+#define KINECT_TARGET_AVX2  __attribute__(( target( "avx2" ) ))
+#else
+#define KINECT_TARGET_SSE41
+#define KINECT_TARGET_AVX2
+#endif
+
+#ifdef KINECT_SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+
+// gp閽߃Zbg
+enum SimdLevel
+{
+	SIMD_SCALAR = 0,
+	SIMD_SSE41,
+	SIMD_AVX2
+};
+
+// CPUΉĂ閽߃Zbg𒲂ׂ
+inline SimdLevel detectSimdLevel()
+{
+	SimdLevel level = SIMD_SCALAR;
+#ifdef KINECT_SIMD_X86
+	unsigned int info[4] = { 0 };
+#ifdef _MSC_VER
+	__cpuid( reinterpret_cast<int*>( info ), 0 );
+	const unsigned int maxId = info[0];
+	__cpuid( reinterpret_cast<int*>( info ), 1 );
+#else
+	__cpuid( 0, info[0], info[1], info[2], info[3] );
+	const unsigned int maxId = info[0];
+	__cpuid( 1, info[0], info[1], info[2], info[3] );
+#endif
+	if( info[2] & ( 1 << 19 ) ){
+		level = SIMD_SSE41;
+	}
+#ifdef KINECT_SIMD_AVX2
+	// AVX2OSYMMWX^ޔ(OSXSAVEXCR0)Ƃg
+	const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+	if( osxsave && ( maxId >= 7 ) ){
+#ifdef _MSC_VER
+		const unsigned long long xcr0 = _xgetbv( 0 );
+		__cpuidex( reinterpret_cast<int*>( info ), 7, 0 );
+#else
+		unsigned int xcr0Low = 0;
+		unsigned int xcr0High = 0;
+		__asm__( "xgetbv" : "=a"( xcr0Low ), "=d"( xcr0High ) : "c"( 0 ) );
+		const unsigned long long xcr0 = xcr0Low;
+		__cpuid_count( 7, 0, info[0], info[1], info[2], info[3] );
+#endif
+		if( ( ( xcr0 & 0x6 ) == 0x6 ) && ( info[1] & ( 1 << 5 ) ) && ( level == SIMD_SSE41 ) ){
+			level = SIMD_AVX2;
+		}
+	}
+#else
+	(void)maxId;
+#endif
+#endif
+	return level;
+}
+
+// sɎg߃Zbg(̌ĂяoŔ肵ʂg)
+inline SimdLevel getSimdLevel()
+{
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+inline const char* getSimdLevelName( SimdLevel level )
+{
+	switch( level ){
+		case SIMD_SSE41:
+			return "SSE4.1";
+		case SIMD_AVX2:
+			return "AVX2";
+		default:
+			return "scalar";
+	}
+}
@@ -0,0 +1,104 @@
+// SkeletonFrame.h : Kinect SDKɈˑSkeletonf[^߂̌^
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "KinectTypes.h"
+
+// Skeleton̐Ɗ֐߂̐(NUI_SKELETON_COUNTANUI_SKELETON_POSITION_COUNT)
+static const int KINECT_SKELETON_COUNT          = KINECT_PLAYER_COUNT;
+static const int KINECT_SKELETON_POSITION_COUNT = 20;
+
+// SkeletonWnDepth摜(320x240)ւ̓ěW(NUI_CAMERA_SKELETON_TO_DEPTH_IMAGE_MULTIPLIER_320x240)
+static const float KINECT_SKELETON_TO_DEPTH_MULTIPLIER_320x240 = 285.63f;
+
+// Skeleton̒ǐՏ(NUI_SKELETON_TRACKING_STATEƓl)
+enum SkeletonTrackingState
+{
+	SKELETON_NOT_TRACKED = 0,
+	SKELETON_POSITION_ONLY,
+	SKELETON_TRACKED
+};
+
+// ֐߂̒ǐՏ(NUI_SKELETON_POSITION_TRACKING_STATEƓl)
+enum SkeletonPositionTrackingState
+{
+	SKELETON_POSITION_NOT_TRACKED = 0,
+	SKELETON_POSITION_INFERRED,
+	SKELETON_POSITION_TRACKED
+};
+
+// ֐߂̔ԍ(NUI_SKELETON_POSITION_INDEXƓl)
+enum SkeletonPositionIndex
+{
+	SKELETON_POSITION_HIP_CENTER = 0,
+	SKELETON_POSITION_SPINE,
+	SKELETON_POSITION_SHOULDER_CENTER,
+	SKELETON_POSITION_HEAD,
+	SKELETON_POSITION_SHOULDER_LEFT,
+	SKELETON_POSITION_ELBOW_LEFT,
+	SKELETON_POSITION_WRIST_LEFT,
+	SKELETON_POSITION_HAND_LEFT,
+	SKELETON_POSITION_SHOULDER_RIGHT,
+	SKELETON_POSITION_ELBOW_RIGHT,
+	SKELETON_POSITION_WRIST_RIGHT,
+	SKELETON_POSITION_HAND_RIGHT,
+	SKELETON_POSITION_HIP_LEFT,
+	SKELETON_POSITION_KNEE_LEFT,
+	SKELETON_POSITION_ANKLE_LEFT,
+	SKELETON_POSITION_FOOT_LEFT,
+	SKELETON_POSITION_HIP_RIGHT,
+	SKELETON_POSITION_KNEE_RIGHT,
+	SKELETON_POSITION_ANKLE_RIGHT,
+	SKELETON_POSITION_FOOT_RIGHT
+};
+
+// 3̓_(Vector4ƓсAPʂ[m])
+struct SkeletonVector
+{
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+// 1lSkeleton(NUI_SKELETON_DATAƓ)
+struct SkeletonData
+{
+	int32_t trackingState; // SkeletonTrackingState
+	uint32_t trackingId;
+	uint32_t enrollmentIndex;
+	uint32_t userIndex;
+	SkeletonVector position;
+	SkeletonVector positions[KINECT_SKELETON_POSITION_COUNT];
+	int32_t positionTrackingStates[KINECT_SKELETON_POSITION_COUNT]; // SkeletonPositionTrackingState
+	uint32_t qualityFlags;
+};
+
+// Skeletont[(NUI_SKELETON_FRAMEƓ)
+// Kinect SDK̂łNUI_SKELETON_FRAMÊ܂܃Rs[łAL^t@Cɂ̌`̂܂ܕۑ
+struct SkeletonFrame
+{
+	int64_t timestamp;             // ^CX^v[ms](liTimeStamp)
+	uint32_t frameNumber;          // t[ԍ(dwFrameNumber)
+	uint32_t flags;
+	SkeletonVector floorClipPlane; // ̕(ax + by + cz + d = 0)
+	SkeletonVector normalToGravity;
+	SkeletonData skeletons[KINECT_SKELETON_COUNT];
+};
+
+// SkeletonWn̓_Depth摜̓_ɓe(NuiTransformSkeletonToDepthImage()ƓvZ)
+inline void projectSkeletonToDepth( const SkeletonVector& point, int width, int height, float* depthX, float* depthY )
+{
+	if( point.z > 1e-7f ){
+		const float scale = KINECT_SKELETON_TO_DEPTH_MULTIPLIER_320x240 / point.z;
+		*depthX = ( 0.5f + point.x * scale / 320.0f ) * width;
+		*depthY = ( 0.5f - point.y * scale / 240.0f ) * height;
+	}
+	else{
+		*depthX = 0.0f;
+		*depthY = 0.0f;
+	}
+}
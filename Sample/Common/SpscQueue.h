@@ -0,0 +1,234 @@
+// SpscQueue.h : 1̃Xbh1̃XbhoAbN̖Œ蒷̃L[
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Platform.h"
+
+
+// L[t̂Ƃ̈
+enum QueueDropPolicy
+{
+	QUEUE_BLOCK = 0,   // 󂭂܂ő҂
+	QUEUE_DROP_OLDEST, // łÂvf̂Ăē
+	QUEUE_DROP_NEWEST  // 悤Ƃvf̂Ă
+};
+
+// push()̌
+enum QueuePushResult
+{
+	QUEUE_PUSHED = 0,            // ꂽ
+	QUEUE_PUSHED_DROPPING_OLDEST, // łÂvf̂Ăēꂽ(̂ĂvfdroppedɕԂ)
+	QUEUE_DROPPED_NEWEST,        // tȂ̂œȂ
+	QUEUE_CLOSED                 // Ă̂œȂ
+};
+
+inline const char* getQueueDropPolicyName( QueueDropPolicy policy )
+{
+	switch( policy ){
+		case QUEUE_DROP_OLDEST:
+			return "drop oldest";
+		case QUEUE_DROP_NEWEST:
+			return "drop newest";
+		default:
+			return "block";
+	}
+}
+
+// P̐Y҂ƒP̏(Single-Producer/Single-Consumer)̃Oobt@
+// ʒu(tail)͐Y҂Aoʒu(head)͏҂i߂̂ŁAbNɎ󂯓n
+// QUEUE_DROP_OLDESTňt̂Ƃ͐Y҂łÂvfôŁAhead͔rŐi߂
+// vf̓Wu̔ԍ|C^[̂悤ȏȒlɂ(oƎ̂Ă鏈Ƃ͓ǂ񂾒l̂Ē)
+// ҂Ƃ(̂Ƃpop()AQUEUE_BLOCKňt̂Ƃpush())~[ebNXƏϐg
+template<class T>
+class SpscQueue
+{
+public:
+	// v(쒆ɓǂނƁAl͏Ă邱Ƃ)
+	struct Statistics
+	{
+		uint64_t pushed;        // ꂽvf̐
+		uint64_t popped;        // ovf̐
+		uint64_t droppedOldest; // t̂ƂɎ̂ĂłÂvf̐
+		uint64_t droppedNewest; // t̂ƂɓȂvf̐
+		uint64_t depthSum;      // ꂽ̗vf̐̍v
+		int maxDepth;           // ꂽ̗vf̐̍ől
+
+		double getMeanDepth() const { return pushed ? static_cast<double>( depthSum ) / static_cast<double>( pushed ) : 0.0; }
+	};
+
+	explicit SpscQueue( int capacity = 2, QueueDropPolicy policy = QUEUE_BLOCK )
+		: slots( capacity > 0 ? capacity : 1 ), policy( policy ), head( 0 ), tail( 0 ), closed( 0 ), waiters( 0 )
+	{
+		resetStatistics();
+	}
+
+	int getCapacity() const { return static_cast<int>( slots.size() ); }
+	QueueDropPolicy getPolicy() const { return policy; }
+
+	// ̗vf̐
+	int size() const
+	{
+		return static_cast<int>( static_cast<unsigned long>( atomicLoad( &tail ) ) - static_cast<unsigned long>( atomicLoad( &head ) ) );
+	}
+
+	// Y҂̃XbhĂяo
+	QueuePushResult push( const T& item, T* dropped = nullptr )
+	{
+		QueuePushResult result = QUEUE_PUSHED;
+		const unsigned long position = static_cast<unsigned long>( tail );
+		const unsigned long capacity = static_cast<unsigned long>( slots.size() );
+		for( ;; ){
+			if( atomicLoad( &closed ) ){
+				return QUEUE_CLOSED;
+			}
+			const long first = atomicLoad( &head );
+			if( position - static_cast<unsigned long>( first ) < capacity ){
+				break;
+			}
+
+			// t̂Ƃ
+			if( policy == QUEUE_DROP_NEWEST ){
+				statistics.droppedNewest++;
+				return QUEUE_DROPPED_NEWEST;
+			}
+			if( policy == QUEUE_DROP_OLDEST ){
+				const T oldest = slots[static_cast<unsigned long>( first ) % capacity];
+				if( atomicCompareExchange( &head, static_cast<long>( static_cast<unsigned long>( first ) + 1 ), first ) == first ){
+					if( dropped ){
+						*dropped = oldest;
+					}
+					statistics.droppedOldest++;
+					result = QUEUE_PUSHED_DROPPING_OLDEST;
+					notify();
+					break;
+				}
+				continue;
+			}
+			waitUntil( &SpscQueue::canPush );
+		}
+
+		slots[position % capacity] = item;
+		atomicStore( &tail, static_cast<long>( position + 1 ) );
+		notify();
+
+		const int depth = static_cast<int>( position + 1 - static_cast<unsigned long>( atomicLoad( &head ) ) );
+		statistics.pushed++;
+		statistics.depthSum += depth;
+		if( depth > statistics.maxDepth ){
+			statistics.maxDepth = depth;
+		}
+		return result;
+	}
+
+	// ҂̃XbhĂяo
+	// ̂Ƃ͓܂ő҂AĂċ̂ƂfalseԂ
+	bool pop( T& item )
+	{
+		for( ;; ){
+			if( tryPop( item ) ){
+				return true;
+			}
+			if( atomicLoad( &closed ) ){
+				// Oɓvf͎o
+				return tryPop( item );
+			}
+			waitUntil( &SpscQueue::canPop );
+		}
+	}
+
+	// ҂̃XbhĂяo(̂Ƃ͑҂falseԂ)
+	bool tryPop( T& item )
+	{
+		const unsigned long capacity = static_cast<unsigned long>( slots.size() );
+		for( ;; ){
+			const long first = atomicLoad( &head );
+			if( first == atomicLoad( &tail ) ){
+				return false;
+			}
+			const T value = slots[static_cast<unsigned long>( first ) % capacity];
+			if( atomicCompareExchange( &head, static_cast<long>( static_cast<unsigned long>( first ) + 1 ), first ) == first ){
+				item = value;
+				statistics.popped++;
+				notify();
+				return true;
+			}
+			// Y҂łÂvf̂Ă̂œǂݒ
+		}
+	}
+
+	// āA҂ĂXbhN(ȍ~push()͓Ȃ)
+	void close()
+	{
+		atomicStore( &closed, 1 );
+		ScopedLock lock( mutex );
+		condition.notifyAll();
+	}
+
+	bool isClosed() const { return atomicLoad( &closed ) != 0; }
+
+	// Y҂Ə҂~܂ĂƂɌĂяo
+	void reset()
+	{
+		head = 0;
+		tail = 0;
+		closed = 0;
+	}
+
+	Statistics getStatistics() const { return statistics; }
+	void resetStatistics() { statistics = Statistics(); }
+
+private:
+	bool canPush() const
+	{
+		return static_cast<unsigned long>( atomicLoad( &tail ) ) - static_cast<unsigned long>( atomicLoad( &head ) ) < slots.size();
+	}
+
+	bool canPop() const
+	{
+		return atomicLoad( &head ) != atomicLoad( &tail );
+	}
+
+	// 邩܂Ŗ
+	// ҂𑝂₵Ă𒲂ג̂ŁAnotify()Ƃ̊ԂŋN˂邱Ƃ͖
+	void waitUntil( bool ( SpscQueue::*ready )() const )
+	{
+		ScopedLock lock( mutex );
+		atomicAdd( &waiters, 1 );
+		if( !( this->*ready )() && !atomicLoad( &closed ) ){
+			condition.wait( mutex );
+		}
+		atomicAdd( &waiters, -1 );
+	}
+
+	// ҂ĂXbh΋N
+	void notify()
+	{
+		if( atomicLoad( &waiters ) > 0 ){
+			ScopedLock lock( mutex );
+			condition.notifyAll();
+		}
+	}
+
+	std::vector<T> slots;
+	QueueDropPolicy policy;
+
+	// Y҂Ə҂ʁXɏނ̂ŁALbVC𕪂
+	char padding0[64];
+	volatile long head;
+	char padding1[64];
+	volatile long tail;
+	char padding2[64];
+	volatile long closed;
+	volatile long waiters;
+
+	Mutex mutex;
+	ConditionVariable condition;
+	Statistics statistics;
+
+	SpscQueue( const SpscQueue& );
+	SpscQueue& operator=( const SpscQueue& );
+};
@@ -0,0 +1,211 @@
+// StagePipeline.cpp : t[̎擾AA\iɕĕʁX̃XbhŕsĎs
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "StagePipeline.h"
+#include <iomanip>
+#include "Trace.h"
+
+
+StagePipeline::StagePipeline( int jobCount )
+	: jobCount( jobCount > 0 ? jobCount : 1 ), stopping( 0 )
+{
+	freeJobs.reserve( this->jobCount );
+}
+
+StagePipeline::~StagePipeline()
+{
+	stop();
+	for( size_t i = 0; i < stages.size(); i++ ){
+		if( stages[i]->thread.joinable() ){
+			stages[i]->thread.join();
+		}
+	}
+}
+
+void StagePipeline::addStage( const char* name, const StageFunction& function, int queueCapacity, QueueDropPolicy policy )
+{
+	std::unique_ptr<Stage> stage( new Stage() );
+	stage->pipeline = this;
+	stage->index = static_cast<int>( stages.size() );
+	stage->name = name;
+	stage->function = function;
+	if( stage->index > 0 ){
+		stage->input.reset( new SpscQueue<int>( queueCapacity, policy ) );
+	}
+	stage->processed = 0;
+	stage->busySeconds = 0.0;
+	stage->startTime = 0.0;
+	stage->stopTime = 0.0;
+	stages.push_back( std::move( stage ) );
+}
+
+void StagePipeline::run()
+{
+	if( stages.empty() ){
+		return;
+	}
+
+	// SẴWu󂢂ĂԂɂ
+	atomicStore( &stopping, 0 );
+	freeJobs.clear();
+	for( int i = jobCount - 1; i >= 0; i-- ){
+		freeJobs.push_back( i );
+	}
+	for( size_t i = 0; i < stages.size(); i++ ){
+		Stage& stage = *stages[i];
+		if( stage.input ){
+			stage.input->reset();
+			stage.input->resetStatistics();
+		}
+		stage.processed = 0;
+		stage.busySeconds = 0.0;
+		stage.startTime = getTimeInSeconds();
+		stage.stopTime = 0.0;
+	}
+
+	// Ō̒iȊO͂ꂼ̃XbhŎs
+	for( size_t i = 0; i + 1 < stages.size(); i++ ){
+		stages[i]->thread.start( &StagePipeline::stageEntry, stages[i].get() );
+	}
+	runStage( *stages.back() );
+
+	stop();
+	for( size_t i = 0; i + 1 < stages.size(); i++ ){
+		stages[i]->thread.join();
+	}
+}
+
+void StagePipeline::stop()
+{
+	atomicStore( &stopping, 1 );
+	for( size_t i = 0; i < stages.size(); i++ ){
+		if( stages[i]->input ){
+			stages[i]->input->close();
+		}
+	}
+	ScopedLock lock( freeMutex );
+	freeCondition.notifyAll();
+}
+
+void StagePipeline::stageEntry( void* argument )
+{
+	Stage* stage = static_cast<Stage*>( argument );
+	stage->pipeline->runStage( *stage );
+}
+
+void StagePipeline::runStage( Stage& stage )
+{
+	const bool last = stage.index + 1 == static_cast<int>( stages.size() );
+	const char* traceName = internTraceName( stage.name.c_str() );
+	setTraceThreadName( traceName );
+	for( ;; ){
+		// ŏ̒i͋󂢂ĂWuAȊO̒i͑O̒inWuo
+		// O̒iIăL[ɂȂI
+		int job;
+		if( stage.index == 0 ){
+			if( !acquireJob( job ) ){
+				break;
+			}
+		}
+		else if( !stage.input->pop( job ) ){
+			break;
+		}
+		if( atomicLoad( &stopping ) ){
+			releaseJob( job );
+			break;
+		}
+
+		const double start = getTimeInSeconds();
+		const bool succeeded = stage.function( job );
+		const double end = getTimeInSeconds();
+		stage.busySeconds += end - start;
+		recordTraceEvent( traceName, start, end );
+		if( !succeeded ){
+			releaseJob( job );
+			if( stage.index > 0 ){
+				stop();
+			}
+			break;
+		}
+		stage.processed++;
+		forward( stage, job );
+	}
+	stage.stopTime = getTimeInSeconds();
+
+	// ̒iցAȏWuȂƂ`
+	if( !last ){
+		stages[stage.index + 1]->input->close();
+	}
+}
+
+void StagePipeline::forward( Stage& stage, int job )
+{
+	if( stage.index + 1 == static_cast<int>( stages.size() ) ){
+		releaseJob( job );
+		return;
+	}
+
+	int dropped = -1;
+	switch( stages[stage.index + 1]->input->push( job, &dropped ) ){
+		case QUEUE_PUSHED_DROPPING_OLDEST:
+			releaseJob( dropped );
+			break;
+		case QUEUE_DROPPED_NEWEST:
+		case QUEUE_CLOSED:
+			releaseJob( job );
+			break;
+		default:
+			break;
+	}
+}
+
+bool StagePipeline::acquireJob( int& job )
+{
+	ScopedLock lock( freeMutex );
+	while( freeJobs.empty() && !atomicLoad( &stopping ) ){
+		freeCondition.wait( freeMutex );
+	}
+	if( atomicLoad( &stopping ) ){
+		return false;
+	}
+	job = freeJobs.back();
+	freeJobs.pop_back();
+	return true;
+}
+
+void StagePipeline::releaseJob( int job )
+{
+	ScopedLock lock( freeMutex );
+	freeJobs.push_back( job );
+	freeCondition.notifyOne();
+}
+
+StagePipeline::StageStatistics StagePipeline::getStatistics( int index ) const
+{
+	const Stage& stage = *stages[index];
+	StageStatistics statistics;
+	statistics.name = stage.name;
+	statistics.processed = stage.processed;
+	statistics.busySeconds = stage.busySeconds;
+	statistics.elapsedSeconds = ( stage.stopTime > 0.0 ? stage.stopTime : getTimeInSeconds() ) - stage.startTime;
+	statistics.queueCapacity = stage.input ? stage.input->getCapacity() : 0;
+	statistics.queuePolicy = stage.input ? stage.input->getPolicy() : QUEUE_BLOCK;
+	statistics.queue = stage.input ? stage.input->getStatistics() : SpscQueue<int>::Statistics();
+	return statistics;
+}
+
+void StagePipeline::printStatistics( std::ostream& out ) const
+{
+	for( int i = 0; i < getStageCount(); i++ ){
+		const StageStatistics statistics = getStatistics( i );
+		out << std::left << std::setw( 10 ) << statistics.name << std::right << std::fixed << std::setprecision( 1 )
+			<< " : " << std::setw( 6 ) << statistics.getFps() << " fps, " << std::setprecision( 2 ) << statistics.getBusyMs() << " ms/frame";
+		if( statistics.queueCapacity > 0 ){
+			out << ", queue " << statistics.queueCapacity << " (" << getQueueDropPolicyName( statistics.queuePolicy ) << ")"
+				<< " depth mean " << statistics.queue.getMeanDepth() << " max " << statistics.queue.maxDepth
+				<< ", dropped " << statistics.queue.droppedOldest + statistics.queue.droppedNewest;
+		}
+		out << std::endl;
+	}
+}
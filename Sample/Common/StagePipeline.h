@@ -0,0 +1,105 @@
+// StagePipeline.h : t[̎擾AA\iɕĕʁX̃XbhŕsĎs
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Platform.h"
+#include "SpscQueue.h"
+
+
+// 1ȉ
+// Wu̔ԍ(0`Wu̐ - 1)󂯎A̒i֓nƂtrueԂ
+// falseԂƃpCvCŜ~߂(ŏ̒ił́A擾t[ȂƂ\)
+typedef std::function<bool( int job )> StageFunction;
+
+// i̊ԂSpscQueuełȂAt[̃f[^(Wu)Ɏ󂯓n
+// ei͕ʁX̃Xbhœ̂ŁAŜ̃t[[g͑SĂ̒ȉԂ̍vł͂ȂAłxiŌ܂
+// Wu͋NɌ߂g񂵁AŌ̒iI邩L[Ŏ̂Ăƍŏ̒i֖߂
+// (Wủ摜obt@͌ĂяoWu̔ԍőI)
+class StagePipeline
+{
+public:
+	// i̓v
+	struct StageStatistics
+	{
+		std::string name;
+		uint64_t processed;     // Wu̐
+		double busySeconds;     // ɂԂ̍v[s]
+		double elapsedSeconds;  // JnĂ~܂(܂͍)܂ł̎[s]
+
+		// O̒i󂯎L[(ŏ̒iɂ͖)
+		int queueCapacity;
+		QueueDropPolicy queuePolicy;
+		SpscQueue<int>::Statistics queue;
+
+		double getFps() const { return elapsedSeconds > 0.0 ? processed / elapsedSeconds : 0.0; }
+		double getBusyMs() const { return processed ? busySeconds * 1000.0 / processed : 0.0; }
+	};
+
+	explicit StagePipeline( int jobCount );
+	~StagePipeline();
+
+	// iǉ(ŏɒǉiWuiɂȂ)
+	// queueCapacitypolicýAO̒i炱̒i֓nL[̑傫ƈt̂Ƃ̈
+	void addStage( const char* name, const StageFunction& function, int queueCapacity = 2, QueueDropPolicy policy = QUEUE_BLOCK );
+
+	// Ō̒iȊOꂼ̃XbhŊJnAŌ̒iĂяoXbhŎs
+	// g[XLȂƂ́Ai̖OXbh̖OɂāAWȕCxgƂċL^
+	// (EBhEւ̕\̂悤ɁAĂяoXbhŎsKv鏈Ō̒iɂ)
+	// ŏ̒iIƎc̃WuĂ߂AȊO̒ifalseԂstop()ĂяoƂɖ߂
+	void run();
+
+	// SĂ̒i~߂(ǂ̃XbhłĂяo)
+	void stop();
+
+	int getJobCount() const { return jobCount; }
+	int getStageCount() const { return static_cast<int>( stages.size() ); }
+	StageStatistics getStatistics( int stage ) const;
+
+	// i̓v\
+	void printStatistics( std::ostream& out ) const;
+
+private:
+	struct Stage
+	{
+		StagePipeline* pipeline;
+		int index;
+		std::string name;
+		StageFunction function;
+		std::unique_ptr< SpscQueue<int> > input; // O̒i󂯎L[(ŏ̒inullptr)
+		Thread thread;
+		uint64_t processed;
+		double busySeconds;
+		double startTime;
+		double stopTime;
+	};
+
+	static void stageEntry( void* argument );
+	void runStage( Stage& stage );
+
+	// ̒i֓n(Ō̒ił͋󂢂ĂWuɖ߂)
+	void forward( Stage& stage, int job );
+
+	// 󂢂ĂWuo(~߂ƂfalseԂ)
+	bool acquireJob( int& job );
+	void releaseJob( int job );
+
+	int jobCount;
+	std::vector< std::unique_ptr<Stage> > stages;
+	volatile long stopping;
+
+	// 󂢂ĂWu(Ō̒iƃL[Ŏ̂ĂꂽWu߂)
+	std::vector<int> freeJobs;
+	Mutex freeMutex;
+	ConditionVariable freeCondition;
+
+	StagePipeline( const StagePipeline& );
+	StagePipeline& operator=( const StagePipeline& );
+};
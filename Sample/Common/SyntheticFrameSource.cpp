@@ -0,0 +1,536 @@
+// SyntheticFrameSource.cpp : V[̃t[𐶐t[\[X
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "SyntheticFrameSource.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+// ̑傫[m](ZT[̐ʂ̉̕ǂ܂ł̋ƁAE̕ǂ܂ł̋)
+static const float BACK_WALL_Z = 3.8f;
+static const float SIDE_WALL_X = 2.0f;
+
+// ̃[h(Near ModełȂ)̌v͈[mm]
+static const int DEPTH_MINIMUM_MM = 800;
+
+// eł鋗̍[mm]ƁAIRvWFN^[IRJ̊Ԋu[m]
+static const int SHADOW_EDGE_MM = 100;
+static const float PROJECTOR_BASELINE = 0.075f;
+
+// ʂ̎(labels̏ʃrbgA3rbgPlayer̃CfbNX)
+static const uint8_t LABEL_FLOOR     = 0 << 3;
+static const uint8_t LABEL_BACK_WALL = 1 << 3;
+static const uint8_t LABEL_SIDE_WALL = 2 << 3;
+static const uint8_t LABEL_BODY      = 0 << 3;
+static const uint8_t LABEL_LEGS      = 1 << 3;
+static const uint8_t LABEL_SKIN      = 2 << 3;
+
+// ̃e[ȗ傫(fɗɁAsɂ炵Ȃǂ)
+static const int NOISE_TABLE_SIZE = 1 << 16;
+
+// 1̑т̍s
+static const int BAND_ROWS = 16;
+
+// l̐̕F(BGR)
+static const uint8_t SHIRT_COLORS[KINECT_PLAYER_COUNT][3] = {
+	{  40,  40, 200 },
+	{ 200,  90,  30 },
+	{  40, 170,  40 },
+	{  30, 190, 220 },
+	{ 170,  40, 170 },
+	{ 200, 200,  40 }
+};
+static const uint8_t LEGS_COLOR[3] = { 120,  70,  40 };
+static const uint8_t SKIN_COLOR[3] = { 140, 170, 220 };
+
+// ̃nbV(sɁAAt[ԍAs̔ԍ痐̃e[üʒu߂̂ŁAт̕ɂ炸t[ɂȂ)
+static inline uint32_t hashPixel( uint32_t seed, uint32_t frameNumber, uint32_t position )
+{
+	uint32_t h = seed * 0x9E3779B1u ^ frameNumber * 0x85EBCA77u ^ position * 0xC2B2AE3Du;
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+static inline uint32_t xorshift( uint32_t x )
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+static inline SkeletonVector makeVector( float x, float y, float z )
+{
+	SkeletonVector vector = { x, y, z, 1.0f };
+	return vector;
+}
+
+// pointdirectioňlengthi񂾓_
+static inline SkeletonVector advance( const SkeletonVector& point, const SkeletonVector& direction, float length )
+{
+	return makeVector( point.x + direction.x * length, point.y + direction.y * length, point.z + direction.z * length );
+}
+
+static inline uint8_t clampByte( int value )
+{
+	return static_cast<uint8_t>( ( value < 0 ) ? 0 : ( ( value > 255 ) ? 255 : value ) );
+}
+
+static inline uint8_t saturate( float value )
+{
+	return static_cast<uint8_t>( ( std::max )( 0.0f, ( std::min )( 255.0f, value + 0.5f ) ) );
+}
+
+
+SyntheticFrameSource::SyntheticFrameSource( const SyntheticScene& scene, int streams, ThreadPool* pool )
+	: scene( scene ), streams( streams & FRAME_STREAM_FLAG_ALL ), pool( pool ),
+	  frameNumber( 0 ), realTime( false ), startTime( 0.0 ), startFrameNumber( 0 )
+{
+	this->scene.players = ( std::max )( 1, ( std::min )( KINECT_PLAYER_COUNT, scene.players ) );
+	if( !pool ){
+		ownedPool.reset( new ThreadPool() );
+		this->pool = ownedPool.get();
+	}
+
+	// projectSkeletonToDepth()Ɠe
+	focalX = KINECT_SKELETON_TO_DEPTH_MULTIPLIER_320x240 * scene.width / 320.0f;
+	focalY = KINECT_SKELETON_TO_DEPTH_MULTIPLIER_320x240 * scene.height / 240.0f;
+	bandCount = ( scene.height + BAND_ROWS - 1 ) / BAND_ROWS;
+
+	const size_t pixels = static_cast<size_t>( scene.width ) * scene.height;
+	depthBuffer.resize( pixels );
+	colorBuffer.resize( pixels * 4 );
+	sceneDepth.resize( pixels );
+	labels.resize( pixels );
+	joints.resize( this->scene.players * KINECT_SKELETON_POSITION_COUNT );
+	backgroundDepth.resize( pixels );
+	backgroundLabels.resize( pixels );
+	backgroundColor.resize( pixels * 4 );
+	renderBackground();
+
+	// ̃e[uƁA[mm]̃mCY̑傫(2ɔႷAOpz-255`255Ɋ|)
+	noiseTable.resize( NOISE_TABLE_SIZE );
+	uint32_t random = hashPixel( scene.seed, 0, 0 ) | 1;
+	for( int i = 0; i < NOISE_TABLE_SIZE; i++ ){
+		random = xorshift( random );
+		noiseTable[i] = random;
+	}
+	noiseAmplitude.resize( KINECT_DEPTH_MM_COUNT * 8 );
+	for( size_t i = 0; i < noiseAmplitude.size(); i++ ){
+		noiseAmplitude[i] = scene.noise * 1.5e-6f / 128.0f * static_cast<float>( i * i );
+	}
+}
+
+void SyntheticFrameSource::seek( uint32_t frameNumber )
+{
+	this->frameNumber = frameNumber;
+	startTime = 0.0;
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		dropCounters[i].reset();
+	}
+}
+
+void SyntheticFrameSource::updatePlayers( uint32_t frameNumber )
+{
+	const float time = static_cast<float>( frameNumber / scene.fps );
+	const float hipY = 0.96f - scene.cameraHeight;
+	capsules.clear();
+
+	// lɉsƑςāAEɉȂ
+	for( int player = 0; player < scene.players; player++ ){
+		const float z = 2.4f + 0.25f * player;
+		const float x = ( 1.2f - 0.12f * player ) * std::sin( ( 0.35f + 0.07f * player ) * time + 1.7f * player );
+		const float swing = 0.45f * std::sin( ( 4.0f + 0.3f * player ) * time );
+		const float bend = 0.3f * ( std::max )( 0.0f, std::sin( ( 4.0f + 0.3f * player ) * time ) );
+		const float raise = 0.2f + 0.6f * ( 1.0f + std::sin( 0.5f * time + player ) );
+
+		SkeletonVector* joint = &joints[player * KINECT_SKELETON_POSITION_COUNT];
+		joint[SKELETON_POSITION_HIP_CENTER]      = makeVector( x, hipY, z );
+		joint[SKELETON_POSITION_SPINE]           = makeVector( x, hipY + 0.25f, z );
+		joint[SKELETON_POSITION_SHOULDER_CENTER] = makeVector( x, hipY + 0.5f, z );
+		joint[SKELETON_POSITION_HEAD]            = makeVector( x, hipY + 0.7f, z );
+
+		// r(Er͉ɏグAOɐUƂ̓ZT[ɋ߂Â)
+		for( int side = 0; side < 2; side++ ){
+			const float sign = side ? 1.0f : -1.0f;
+			const float abduction = side ? raise : 0.2f;
+			const float armSwing = side ? swing : -swing;
+			const int shoulder = side ? SKELETON_POSITION_SHOULDER_RIGHT : SKELETON_POSITION_SHOULDER_LEFT;
+			const SkeletonVector upper = makeVector( sign * std::sin( abduction ), -std::cos( abduction ) * std::cos( armSwing ), -std::cos( abduction ) * std::sin( armSwing ) );
+			const SkeletonVector lower = makeVector( sign * std::sin( abduction ), -std::cos( abduction ) * std::cos( armSwing + 0.35f ), -std::cos( abduction ) * std::sin( armSwing + 0.35f ) );
+			joint[shoulder]     = makeVector( x + sign * 0.18f, hipY + 0.45f, z );
+			joint[shoulder + 1] = advance( joint[shoulder], upper, 0.28f );
+			joint[shoulder + 2] = advance( joint[shoulder + 1], lower, 0.25f );
+			joint[shoulder + 3] = advance( joint[shoulder + 2], lower, 0.08f );
+		}
+
+		// r(EŋtɐUAG͌ɋȂ)
+		for( int side = 0; side < 2; side++ ){
+			const float sign = side ? 1.0f : -1.0f;
+			const float legSwing = side ? -0.8f * swing : 0.8f * swing;
+			const int hip = side ? SKELETON_POSITION_HIP_RIGHT : SKELETON_POSITION_HIP_LEFT;
+			joint[hip]     = makeVector( x + sign * 0.1f, hipY - 0.05f, z );
+			joint[hip + 1] = advance( joint[hip], makeVector( 0.0f, -std::cos( legSwing ), -std::sin( legSwing ) ), 0.45f );
+			joint[hip + 2] = advance( joint[hip + 1], makeVector( 0.0f, -std::cos( legSwing - bend ), -std::sin( legSwing - bend ) ), 0.42f );
+			joint[hip + 3] = makeVector( joint[hip + 2].x, joint[hip + 2].y - 0.04f, joint[hip + 2].z - 0.12f );
+		}
+
+		// ̂̕(Player̃CfbNX1)
+		const uint8_t index = static_cast<uint8_t>( player + 1 );
+		addCapsule( joint[SKELETON_POSITION_HIP_CENTER], joint[SKELETON_POSITION_SHOULDER_CENTER], 0.15f, LABEL_BODY | index );
+		addCapsule( joint[SKELETON_POSITION_SHOULDER_LEFT], joint[SKELETON_POSITION_SHOULDER_RIGHT], 0.07f, LABEL_BODY | index );
+		addCapsule( joint[SKELETON_POSITION_HEAD], joint[SKELETON_POSITION_HEAD], 0.11f, LABEL_SKIN | index );
+		addCapsule( joint[SKELETON_POSITION_HIP_LEFT], joint[SKELETON_POSITION_HIP_RIGHT], 0.1f, LABEL_LEGS | index );
+		for( int side = 0; side < 2; side++ ){
+			const int shoulder = side ? SKELETON_POSITION_SHOULDER_RIGHT : SKELETON_POSITION_SHOULDER_LEFT;
+			const int hip = side ? SKELETON_POSITION_HIP_RIGHT : SKELETON_POSITION_HIP_LEFT;
+			addCapsule( joint[shoulder], joint[shoulder + 1], 0.05f, LABEL_BODY | index );
+			addCapsule( joint[shoulder + 1], joint[shoulder + 2], 0.045f, LABEL_BODY | index );
+			addCapsule( joint[shoulder + 2], joint[shoulder + 3], 0.05f, LABEL_SKIN | index );
+			addCapsule( joint[hip], joint[hip + 1], 0.08f, LABEL_LEGS | index );
+			addCapsule( joint[hip + 1], joint[hip + 2], 0.06f, LABEL_LEGS | index );
+			addCapsule( joint[hip + 2], joint[hip + 3], 0.05f, LABEL_LEGS | index );
+		}
+	}
+}
+
+void SyntheticFrameSource::addCapsule( const SkeletonVector& p0, const SkeletonVector& p1, float radius, uint8_t label )
+{
+	Capsule capsule;
+	projectSkeletonToDepth( p0, scene.width, scene.height, &capsule.x0, &capsule.y0 );
+	projectSkeletonToDepth( p1, scene.width, scene.height, &capsule.x1, &capsule.y1 );
+	capsule.z0 = p0.z;
+	capsule.z1 = p1.z;
+	capsule.radius = radius;
+	capsule.radius0 = radius * focalX / p0.z;
+	capsule.radius1 = radius * focalX / p1.z;
+	capsule.label = label;
+
+	const float margin = ( std::max )( capsule.radius0, capsule.radius1 ) + 1.0f;
+	capsule.left   = ( std::max )( 0, static_cast<int>( ( std::min )( capsule.x0, capsule.x1 ) - margin ) );
+	capsule.right  = ( std::min )( scene.width - 1, static_cast<int>( ( std::max )( capsule.x0, capsule.x1 ) + margin ) );
+	capsule.top    = ( std::max )( 0, static_cast<int>( ( std::min )( capsule.y0, capsule.y1 ) - margin ) );
+	capsule.bottom = ( std::min )( scene.height - 1, static_cast<int>( ( std::max )( capsule.y0, capsule.y1 ) + margin ) );
+	if( capsule.left <= capsule.right && capsule.top <= capsule.bottom ){
+		capsules.push_back( capsule );
+	}
+}
+
+void SyntheticFrameSource::fillSkeletonFrame( uint32_t frameNumber, SkeletonFrame& skeleton ) const
+{
+	std::memset( &skeleton, 0, sizeof( skeleton ) );
+	skeleton.timestamp = static_cast<int64_t>( frameNumber * 1000.0 / scene.fps + 0.5 );
+	skeleton.frameNumber = frameNumber;
+	skeleton.floorClipPlane = makeVector( 0.0f, 1.0f, 0.0f );
+	skeleton.floorClipPlane.w = scene.cameraHeight;
+	skeleton.normalToGravity = makeVector( 0.0f, 1.0f, 0.0f );
+	skeleton.normalToGravity.w = 0.0f;
+	for( int player = 0; player < scene.players; player++ ){
+		const SkeletonVector* joint = &joints[player * KINECT_SKELETON_POSITION_COUNT];
+		SkeletonData& data = skeleton.skeletons[player];
+		data.trackingId = player + 1;
+		data.position = joint[SKELETON_POSITION_SPINE];
+
+		// KinectƓASĂ̊֐߂ǐՂ̂trackedSkeletonsl܂
+		if( player >= scene.trackedSkeletons ){
+			data.trackingState = SKELETON_POSITION_ONLY;
+			continue;
+		}
+		data.trackingState = SKELETON_TRACKED;
+		for( int i = 0; i < KINECT_SKELETON_POSITION_COUNT; i++ ){
+			data.positions[i] = joint[i];
+			data.positionTrackingStates[i] = SKELETON_POSITION_TRACKED;
+		}
+	}
+}
+
+void SyntheticFrameSource::renderBackground()
+{
+	// ƕ(f̌̕ŏɓ)͓Ȃ̂ŁAŏ1x`Ă
+	const float centerX = scene.width * 0.5f;
+	const float centerY = scene.height * 0.5f;
+	for( int y = 0; y < scene.height; y++ ){
+		const float rayY = ( centerY - ( y + 0.5f ) ) / focalY;
+		const float floorZ = ( rayY < 0.0f ) ? scene.cameraHeight / -rayY : BACK_WALL_Z;
+		for( int x = 0; x < scene.width; x++ ){
+			const float rayX = ( x + 0.5f - centerX ) / focalX;
+			float z = BACK_WALL_Z;
+			uint8_t label = LABEL_BACK_WALL;
+			if( floorZ < z ){
+				z = floorZ;
+				label = LABEL_FLOOR;
+			}
+			if( std::fabs( rayX ) * z > SIDE_WALL_X ){
+				z = SIDE_WALL_X / std::fabs( rayX );
+				label = LABEL_SIDE_WALL;
+			}
+
+			// ʖ̖͗l
+			const float worldX = rayX * z;
+			const float worldY = rayY * z;
+			float b, g, r;
+			if( label == LABEL_FLOOR ){
+				// 50cmp̎s͗l
+				const bool dark = ( ( static_cast<int>( std::floor( worldX * 2.0f ) ) + static_cast<int>( z * 2.0f ) ) & 1 ) != 0;
+				b = dark ? 70.0f : 90.0f; g = dark ? 95.0f : 120.0f; r = dark ? 120.0f : 150.0f;
+			}
+			else if( label == LABEL_BACK_WALL ){
+				// K(12.5cm~25cmAiɔ炷)
+				const float rowPosition = ( worldY + 10.0f ) * 8.0f;
+				const int brickRow = static_cast<int>( rowPosition );
+				const float columnPosition = ( worldX + 10.0f ) * 4.0f + ( ( brickRow & 1 ) ? 0.5f : 0.0f );
+				if( rowPosition - brickRow < 0.1f || columnPosition - std::floor( columnPosition ) < 0.05f ){
+					b = 200.0f; g = 200.0f; r = 200.0f;
+				}
+				else{
+					const float shade = static_cast<float>( hashPixel( scene.seed, brickRow, static_cast<uint32_t>( columnPosition ) ) & 0x1f );
+					b = 50.0f + shade; g = 70.0f + shade; r = 150.0f + shade;
+				}
+			}
+			else{
+				// 20cm̏c
+				const bool dark = ( static_cast<int>( z * 5.0f ) & 1 ) != 0;
+				b = dark ? 150.0f : 170.0f; g = dark ? 170.0f : 190.0f; r = dark ? 180.0f : 200.0f;
+			}
+
+			const int i = y * scene.width + x;
+			const float light = 1.2f - 0.12f * z;
+			backgroundDepth[i] = static_cast<uint16_t>( z * 1000.0f + 0.5f );
+			backgroundLabels[i] = label;
+			backgroundColor[i * 4 + 0] = saturate( b * light );
+			backgroundColor[i * 4 + 1] = saturate( g * light );
+			backgroundColor[i * 4 + 2] = saturate( r * light );
+			backgroundColor[i * 4 + 3] = 0;
+		}
+	}
+}
+
+void SyntheticFrameSource::renderGeometry( int band )
+{
+	const int top = band * BAND_ROWS;
+	const int bottom = ( std::min )( top + BAND_ROWS, scene.height );
+	const size_t offset = static_cast<size_t>( top ) * scene.width;
+	const size_t size = static_cast<size_t>( bottom - top ) * scene.width;
+	std::memcpy( &sceneDepth[offset], &backgroundDepth[offset], size * sizeof( uint16_t ) );
+	std::memcpy( &labels[offset], &backgroundLabels[offset], size );
+
+	// l(̂̕̕\ʂʂŋߎAOɂ̂c)
+	for( size_t i = 0; i < capsules.size(); i++ ){
+		const Capsule& capsule = capsules[i];
+		const int y0 = ( std::max )( top, capsule.top );
+		const int y1 = ( std::min )( bottom - 1, capsule.bottom );
+		const float dx = capsule.x1 - capsule.x0;
+		const float dy = capsule.y1 - capsule.y0;
+		const float lengthSquared = dx * dx + dy * dy;
+		const float inverseLength = ( lengthSquared > 0.0f ) ? 1.0f / lengthSquared : 0.0f;
+		const float maxRadius = ( std::max )( capsule.radius0, capsule.radius1 );
+		for( int y = y0; y <= y1; y++ ){
+			uint16_t* depthRow = &sceneDepth[y * scene.width];
+			uint8_t* labelRow = &labels[y * scene.width];
+			const float py = y + 0.5f - capsule.y0;
+
+			// ̍sɊ|镔̍E͈̔(̂AsmaxRadiusȓɂ镔𑾂点)
+			float t0 = 0.0f;
+			float t1 = 1.0f;
+			if( dy != 0.0f ){
+				t0 = ( py - maxRadius ) / dy;
+				t1 = ( py + maxRadius ) / dy;
+				if( t0 > t1 ){
+					std::swap( t0, t1 );
+				}
+				t0 = ( std::max )( 0.0f, t0 );
+				t1 = ( std::min )( 1.0f, t1 );
+			}
+			const float segmentLeft = capsule.x0 + ( std::min )( t0 * dx, t1 * dx );
+			const float segmentRight = capsule.x0 + ( std::max )( t0 * dx, t1 * dx );
+			const int left = ( std::max )( capsule.left, static_cast<int>( segmentLeft - maxRadius ) );
+			const int right = ( std::min )( capsule.right, static_cast<int>( segmentRight + maxRadius ) + 1 );
+
+			for( int x = left; x <= right; x++ ){
+				const float px = x + 0.5f - capsule.x0;
+				const float t = ( std::max )( 0.0f, ( std::min )( 1.0f, ( px * dx + py * dy ) * inverseLength ) );
+				const float ex = px - t * dx;
+				const float ey = py - t * dy;
+				const float radius = capsule.radius0 + t * ( capsule.radius1 - capsule.radius0 );
+				const float radiusSquared = radius * radius;
+				const float distanceSquared = ex * ex + ey * ey;
+				if( distanceSquared >= radiusSquared ){
+					continue;
+				}
+				// S̋甼aĂOɂȂȂf͕\ʂ߂Ȃ
+				const float centerZ = capsule.z0 + t * ( capsule.z1 - capsule.z0 );
+				if( ( centerZ - capsule.radius ) * 1000.0f >= depthRow[x] ){
+					continue;
+				}
+				const float z = centerZ - capsule.radius * std::sqrt( 1.0f - distanceSquared / radiusSquared );
+				const uint16_t depthMm = static_cast<uint16_t>( z * 1000.0f + 0.5f );
+				if( depthMm < depthRow[x] ){
+					depthRow[x] = depthMm;
+					labelRow[x] = capsule.label;
+				}
+			}
+		}
+	}
+}
+
+void SyntheticFrameSource::renderOutput( int band, uint32_t frameNumber, uint16_t* depth, uint8_t* color )
+{
+	const int top = band * BAND_ROWS;
+	const int bottom = ( std::min )( top + BAND_ROWS, scene.height );
+	const uint32_t holeThreshold = static_cast<uint32_t>( scene.holeRate * 65536.0f );
+
+	for( int y = top; y < bottom; y++ ){
+		const uint16_t* depthRow = &sceneDepth[y * scene.width];
+		const uint8_t* labelRow = &labels[y * scene.width];
+
+		// Depth&Player
+		// Ô̍̕ɂ́AIRvWFN^[̌͂Ȃe(vłȂf)ł
+		if( depth ){
+			uint16_t* outputRow = depth + y * scene.width;
+			const uint32_t* random = &noiseTable[hashPixel( scene.seed, frameNumber, y ) % ( NOISE_TABLE_SIZE - scene.width )];
+			int shadow = 0;
+			int shadowDepthMm = 0;
+			for( int x = scene.width - 1; x >= 0; x-- ){
+				const int depthMm = depthRow[x];
+				if( x + 1 < scene.width && depthRow[x + 1] + SHADOW_EDGE_MM < depthMm ){
+					const int width = static_cast<int>( PROJECTOR_BASELINE * focalX * ( 1000.0f / depthRow[x + 1] - 1000.0f / depthMm ) ) + 1;
+					if( width > shadow ){
+						shadow = width;
+						shadowDepthMm = depthRow[x + 1];
+					}
+				}
+				if( shadow > 0 ){
+					shadow--;
+					if( depthMm > shadowDepthMm + SHADOW_EDGE_MM ){
+						outputRow[x] = 0;
+						continue;
+					}
+				}
+
+				// 2ɔႷmCY(Opz)ƃ_Ȍ
+				if( ( random[x] >> 16 ) < holeThreshold ){
+					outputRow[x] = 0;
+					continue;
+				}
+				const float noise = ( static_cast<int>( random[x] & 0xff ) + static_cast<int>( ( random[x] >> 8 ) & 0xff ) - 255 ) * noiseAmplitude[depthMm];
+				const int noisyMm = depthMm + static_cast<int>( noise + ( ( noise < 0.0f ) ? -0.5f : 0.5f ) );
+				if( noisyMm < DEPTH_MINIMUM_MM || noisyMm > KINECT_DEPTH_MAXIMUM_MM ){
+					outputRow[x] = 0;
+					continue;
+				}
+				outputRow[x] = static_cast<uint16_t>( ( noisyMm << KINECT_PLAYER_INDEX_SHIFT ) | ( labelRow[x] & KINECT_PLAYER_INDEX_MASK ) );
+			}
+		}
+
+		// Color(l͕̐Fɋɂ閾邳̕ωAȊO͏ƕǂ̉摜gAŜɏmCY)
+		if( color ){
+			uint8_t* outputRow = color + y * scene.width * 4;
+			const uint8_t* backgroundRow = &backgroundColor[y * scene.width * 4];
+			const uint32_t* random = &noiseTable[hashPixel( scene.seed ^ 0x5bd1e995u, frameNumber, y ) % ( NOISE_TABLE_SIZE - scene.width )];
+			for( int x = 0; x < scene.width; x++ ){
+				const int grain = static_cast<int>( random[x] & 7 ) - 4;
+				const uint8_t label = labelRow[x];
+				const int player = label & KINECT_PLAYER_INDEX_MASK;
+				if( !player ){
+					outputRow[x * 4 + 0] = clampByte( backgroundRow[x * 4 + 0] + grain );
+					outputRow[x * 4 + 1] = clampByte( backgroundRow[x * 4 + 1] + grain );
+					outputRow[x * 4 + 2] = clampByte( backgroundRow[x * 4 + 2] + grain );
+					outputRow[x * 4 + 3] = 0;
+					continue;
+				}
+				const uint8_t* rgb = SHIRT_COLORS[player - 1];
+				switch( label & ~KINECT_PLAYER_INDEX_MASK ){
+					case LABEL_LEGS:
+						rgb = LEGS_COLOR;
+						break;
+					case LABEL_SKIN:
+						rgb = SKIN_COLOR;
+						break;
+				}
+				const float light = 1.2f - 0.00012f * depthRow[x];
+				outputRow[x * 4 + 0] = saturate( rgb[0] * light + grain );
+				outputRow[x * 4 + 1] = saturate( rgb[1] * light + grain );
+				outputRow[x * 4 + 2] = saturate( rgb[2] * light + grain );
+				outputRow[x * 4 + 3] = 0;
+			}
+		}
+	}
+}
+
+void SyntheticFrameSource::render( uint32_t frameNumber, uint16_t* depth, uint8_t* color, SkeletonFrame* skeleton )
+{
+	updatePlayers( frameNumber );
+
+	// 1. іɃmCYŐƖʂ̎ނ߂
+	// 2. іɉeAmCYADepth&PlayerColor(e͓s̉fg)
+	if( depth || color ){
+		pool->run( bandCount, [&]( int band, int ){
+			renderGeometry( band );
+		} );
+		pool->run( bandCount, [&]( int band, int ){
+			renderOutput( band, frameNumber, depth, color );
+		} );
+	}
+	if( skeleton ){
+		fillSkeletonFrame( frameNumber, *skeleton );
+	}
+}
+
+bool SyntheticFrameSource::isFrameReady()
+{
+	if( !realTime || startTime == 0.0 ){
+		return true;
+	}
+	return getTimeInSeconds() - startTime >= ( frameNumber - startFrameNumber ) / scene.fps;
+}
+
+bool SyntheticFrameSource::read( FrameSet& frames )
+{
+	frames.reset();
+
+	// ԂŐƂ́Aŏ̃t[t[[g̊ԊuԂo܂ő҂
+	if( realTime ){
+		if( startTime == 0.0 ){
+			startTime = getTimeInSeconds();
+			startFrameNumber = frameNumber;
+		}
+		const double wait = ( frameNumber - startFrameNumber ) / scene.fps - ( getTimeInSeconds() - startTime );
+		if( wait * 1000.0 >= 1.0 ){
+			sleepMilliseconds( static_cast<int>( wait * 1000.0 ) );
+		}
+	}
+
+	render( frameNumber, ( streams & FRAME_STREAM_FLAG_DEPTH ) ? &depthBuffer[0] : nullptr, ( streams & FRAME_STREAM_FLAG_COLOR ) ? &colorBuffer[0] : nullptr,
+		( streams & FRAME_STREAM_FLAG_SKELETON ) ? &skeletonFrame : nullptr );
+
+	FrameInfo info;
+	info.frameNumber = frameNumber;
+	info.timestamp = static_cast<int64_t>( frameNumber * 1000.0 / scene.fps + 0.5 );
+	info.width = scene.width;
+	info.height = scene.height;
+	if( streams & FRAME_STREAM_FLAG_COLOR ){
+		frames.color.data = &colorBuffer[0];
+		frames.color.info = info;
+		frames.color.info.format = PIXEL_FORMAT_BGRX32;
+		dropCounters[FRAME_STREAM_COLOR].update( frameNumber );
+	}
+	if( streams & FRAME_STREAM_FLAG_DEPTH ){
+		frames.depth.data = reinterpret_cast<uint8_t*>( &depthBuffer[0] );
+		frames.depth.info = info;
+		frames.depth.info.format = PIXEL_FORMAT_DEPTH16;
+		dropCounters[FRAME_STREAM_DEPTH].update( frameNumber );
+	}
+	if( streams & FRAME_STREAM_FLAG_SKELETON ){
+		frames.skeleton = &skeletonFrame;
+		dropCounters[FRAME_STREAM_SKELETON].update( frameNumber );
+	}
+
+	frameNumber++;
+	return true;
+}
@@ -0,0 +1,121 @@
+// SyntheticFrameSource.h : V[̃t[𐶐t[\[X
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "FrameSource.h"
+#include "ThreadPool.h"
+
+
+// V[̐ݒ
+struct SyntheticScene
+{
+	int width;             // 摜TCY(ColorADepth&Player)
+	int height;
+	double fps;            // t[[g(^CX^v̊ԊuƁAԂŐƂ̊Ԋu)
+	int players;           // l̐(1`KINECT_PLAYER_COUNT)
+	int trackedSkeletons;  // SĂ̊֐߂ǐՂl̐(c͈ʒuAKinectł2l܂)
+	float cameraHeight;    // ̃ZT[̍[m]
+	float noise;           // ̃mCY̑傫(1.0ŃZT[ƓxA0.0ŃmCY)
+	float holeRate;        // vłȂf_Ɍ銄(̂̉eɂ錇Ƃ͕)
+	uint32_t seed;         // ̎(ƃt[ԍ͏ɓt[𐶐)
+
+	SyntheticScene()
+		: width( KINECT_IMAGE_WIDTH ), height( KINECT_IMAGE_HEIGHT ), fps( 30.0 ), players( 2 ), trackedSkeletons( 2 ),
+		  cameraHeight( 0.8f ), noise( 1.0f ), holeRate( 0.002f ), seed( 1 )
+	{
+	}
+};
+
+// ƕǂ̂镔̒lEɕV[AZT[g킸Ƀt[ƂĐ
+// Depth&PlayerɂPlayer̃CfbNXAɉmCYẨeƌv͈͊ǑA
+// SkeletonDepth摜̐lƓʒu(projectSkeletonToDepth()œeʒu)ɒu
+// ColorDepthJ̎_ŕ`eNX`[t̉摜(ʒu킹e[uŕϊƁA̕)
+// 1t[͍sPʂ̑тɕăXbhv[̃XbhŐ
+class SyntheticFrameSource : public FrameSource
+{
+public:
+	// streams͐Xg[(FRAME_STREAM_FLAG_*̑g)
+	// poolnullptr̂Ƃ͘_vZbT̐XbhgXbhv[
+	explicit SyntheticFrameSource( const SyntheticScene& scene = SyntheticScene(), int streams = FRAME_STREAM_FLAG_ALL, ThreadPool* pool = nullptr );
+
+	const SyntheticScene& getScene() const { return scene; }
+
+	// truêƂ̓t[[g̊ԊuŐAfalsêƂ͑҂ɎXƐ(lfalse)
+	void setRealTime( bool realTime ) { this->realTime = realTime; startTime = 0.0; }
+
+	// ɐt[̃t[ԍ
+	void seek( uint32_t frameNumber );
+
+	// frameNumberԖڂ̃t[nobt@ɐ(gȂ̂nullptr)
+	// depthwidth~heightfAcolorwidth~height~4oCg(BGRX)
+	void render( uint32_t frameNumber, uint16_t* depth, uint8_t* color, SkeletonFrame* skeleton );
+
+	bool read( FrameSet& frames );
+	bool isFrameReady();
+	int getStreams() const { return streams; }
+	const FrameDropCounter& getDropCounter( FrameStream stream ) const { return dropCounters[stream]; }
+
+private:
+	// l̑̂̕(Depth摜̉~̗[ŕ)
+	struct Capsule
+	{
+		float x0, y0, z0;  // [̒S(x, yDepth摜̈ʒu[pixel]Az͋[m])
+		float x1, y1, z1;
+		float radius;      // a[m]
+		float radius0;     // [ł̔a[pixel]
+		float radius1;
+		int top, bottom;   // Depth摜͈̔[pixel]
+		int left, right;
+		uint8_t label;
+	};
+
+	// frameNumberԖڂ̃t[ł̐l̊֐߂̈ʒu߁Âׂ̕
+	void updatePlayers( uint32_t frameNumber );
+	void addCapsule( const SkeletonVector& p0, const SkeletonVector& p1, float radius, uint8_t label );
+	void fillSkeletonFrame( uint32_t frameNumber, SkeletonFrame& skeleton ) const;
+	void renderBackground();
+	void renderGeometry( int band );
+	void renderOutput( int band, uint32_t frameNumber, uint16_t* depth, uint8_t* color );
+
+	SyntheticScene scene;
+	int streams;
+	ThreadPool* pool;
+	std::unique_ptr<ThreadPool> ownedPool;
+	int bandCount;
+	float focalX, focalY;
+
+	// t[ƃt[ԍ
+	uint32_t frameNumber;
+	bool realTime;
+	double startTime;
+	uint32_t startFrameNumber;
+	std::vector<uint16_t> depthBuffer;
+	std::vector<uint8_t> colorBuffer;
+	SkeletonFrame skeletonFrame;
+	FrameDropCounter dropCounters[FRAME_STREAM_COUNT];
+
+	// mCYŐ[mm]ƁAf̖ʂ̎(3rbgPlayer̃CfbNX)
+	std::vector<uint16_t> sceneDepth;
+	std::vector<uint8_t> labels;
+
+	// ƕǂ̋[mm]Aʂ̎ށAColor
+	std::vector<uint16_t> backgroundDepth;
+	std::vector<uint8_t> backgroundLabels;
+	std::vector<uint8_t> backgroundColor;
+
+	// ̃e[uƁA[mm]̃mCY̑傫
+	std::vector<uint32_t> noiseTable;
+	std::vector<float> noiseAmplitude;
+
+	// l̊֐߂̈ʒu(KINECT_SKELETON_POSITION_COUNT)Ƒ̂̕
+	std::vector<SkeletonVector> joints;
+	std::vector<Capsule> capsules;
+
+	SyntheticFrameSource( const SyntheticFrameSource& );
+	SyntheticFrameSource& operator=( const SyntheticFrameSource& );
+};
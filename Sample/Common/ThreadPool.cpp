@@ -0,0 +1,107 @@
+// ThreadPool.cpp : [J[Xbhŏ𕪒SĎs
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "ThreadPool.h"
+#include <cstddef>
+
+
+ThreadPool::ThreadPool( int threadCount )
+	: threadCount( threadCount ), task( nullptr ), taskCount( 0 ), nextTask( 0 ), remainingTasks( 0 ), generation( 0 ), quit( false )
+{
+	if( this->threadCount <= 0 ){
+		this->threadCount = getProcessorCount();
+	}
+
+	for( int i = 1; i < this->threadCount; i++ ){
+		Worker* worker = new Worker;
+		worker->pool = this;
+		worker->threadIndex = i;
+		if( !worker->thread.start( &ThreadPool::workerEntry, worker ) ){
+			delete worker;
+			break;
+		}
+		workers.push_back( worker );
+	}
+
+	// XbhȂ͎gȂ
+	this->threadCount = static_cast<int>( workers.size() ) + 1;
+}
+
+ThreadPool::~ThreadPool()
+{
+	mutex.lock();
+	quit = true;
+	taskReady.notifyAll();
+	mutex.unlock();
+
+	for( std::size_t i = 0; i < workers.size(); i++ ){
+		workers[i]->thread.join();
+		delete workers[i];
+	}
+}
+
+void ThreadPool::run( int taskCount, const std::function<void( int, int )>& task )
+{
+	if( taskCount <= 0 ){
+		return;
+	}
+
+	// [J[XbhƂA^XN1̂Ƃ͌ĂяoXbhŎs
+	if( workers.empty() || taskCount == 1 ){
+		for( int i = 0; i < taskCount; i++ ){
+			task( i, 0 );
+		}
+		return;
+	}
+
+	ScopedLock lock( mutex );
+	this->task = &task;
+	this->taskCount = taskCount;
+	nextTask = 0;
+	remainingTasks = taskCount;
+	generation++;
+	taskReady.notifyAll();
+
+	runTasks( 0 );
+	while( remainingTasks > 0 ){
+		taskDone.wait( mutex );
+	}
+	this->task = nullptr;
+}
+
+void ThreadPool::workerEntry( void* argument )
+{
+	Worker* worker = static_cast<Worker*>( argument );
+	worker->pool->workerLoop( worker->threadIndex );
+}
+
+void ThreadPool::workerLoop( int threadIndex )
+{
+	unsigned int seen = 0;
+	ScopedLock lock( mutex );
+	while( true ){
+		while( ( generation == seen ) && !quit ){
+			taskReady.wait( mutex );
+		}
+		if( quit ){
+			break;
+		}
+		seen = generation;
+		runTasks( threadIndex );
+	}
+}
+
+void ThreadPool::runTasks( int threadIndex )
+{
+	while( nextTask < taskCount ){
+		const int taskIndex = nextTask++;
+		const std::function<void( int, int )>& current = *task;
+		mutex.unlock();
+		current( taskIndex, threadIndex );
+		mutex.lock();
+		if( --remainingTasks == 0 ){
+			taskDone.notifyAll();
+		}
+	}
+}
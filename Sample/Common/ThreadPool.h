@@ -0,0 +1,57 @@
+// ThreadPool.h : [J[Xbhŏ𕪒SĎs
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "Platform.h"
+
+
+// NɃ[J[XbhĂAt[̏𕡐̃^XNɕĎs
+// run()ĂяoXbh^XN̂ŁAthreadCount - 1̃[J[Xbh
+class ThreadPool
+{
+public:
+	// threadCount0̂Ƃ͘_vZbT̐Xbhg
+	explicit ThreadPool( int threadCount = 0 );
+	~ThreadPool();
+
+	int getThreadCount() const { return threadCount; }
+
+	// task( taskIndex, threadIndex )taskCountsASďI܂ő҂
+	// threadIndex0`getThreadCount() - 1ŁAXbh̍Ɨ̈IԂ̂Ɏg
+	void run( int taskCount, const std::function<void( int, int )>& task );
+
+private:
+	struct Worker
+	{
+		ThreadPool* pool;
+		int threadIndex;
+		Thread thread;
+	};
+
+	static void workerEntry( void* argument );
+	void workerLoop( int threadIndex );
+
+	// cĂ^XNoĎs(mutexbNԂŌĂяo)
+	void runTasks( int threadIndex );
+
+	int threadCount;
+	std::vector<Worker*> workers;
+
+	Mutex mutex;
+	ConditionVariable taskReady;
+	ConditionVariable taskDone;
+
+	const std::function<void( int, int )>* task;
+	int taskCount;
+	int nextTask;
+	int remainingTasks;
+	unsigned int generation;
+	bool quit;
+
+	ThreadPool( const ThreadPool& );
+	ThreadPool& operator=( const ThreadPool& );
+};
@@ -0,0 +1,237 @@
+// Trace.cpp : ȉ̊JnƏIOobt@ɋL^AChromẽg[X`(JSON)ŏo
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#include "Trace.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <string>
+
+
+// 1̃Cxg(JnƏI܂Ƃ߂Chromẽg[X"X"Cxg)
+// JnƏIʁX̃CxgɂƁAOobt@㏑ƂɕЕc邱Ƃ
+// sequence͏łԂ0AIʂԍ + 1ɂ(ǂޑ͑Oœlǂ߂̂g)
+struct TraceEvent
+{
+	volatile long sequence;
+	int thread;
+	const char* name;
+	int64_t frame;
+	double start;
+	double end;
+};
+
+struct TraceState
+{
+	volatile long enabled;
+	volatile long next;        // ɏރCxg̒ʂԍ
+	volatile long threadCount; // ԍ蓖ĂXbh̐
+	TraceEvent* events;
+	int capacity;
+	std::string path;
+	double origin;             // g[X̎̌_[s]
+
+	// JnAoA~AXbhƕ̖O
+	Mutex mutex;
+	char threadNames[TRACE_MAX_THREADS][32];
+	std::list<std::string> names;
+
+	TraceState()
+		: enabled( 0 ), next( 0 ), threadCount( 0 ), events( nullptr ), capacity( 0 ), origin( 0.0 )
+	{
+		std::memset( threadNames, 0, sizeof( threadNames ) );
+	}
+
+	~TraceState()
+	{
+		stopTrace();
+	}
+
+private:
+	TraceState( const TraceState& );
+	TraceState& operator=( const TraceState& );
+};
+
+static TraceState g_traceState;
+
+// ݂̃Xbh̔ԍ(1A0͖蓖)ƏĂt[̔ԍ
+static PLATFORM_THREAD_LOCAL int t_traceThread = 0;
+static PLATFORM_THREAD_LOCAL int64_t t_traceFrame = -1;
+
+static int getTraceThread()
+{
+	if( t_traceThread == 0 ){
+		const long thread = atomicAdd( &g_traceState.threadCount, 1 );
+		t_traceThread = ( thread < TRACE_MAX_THREADS ) ? static_cast<int>( thread ) : TRACE_MAX_THREADS;
+	}
+	return t_traceThread;
+}
+
+bool startTrace( const char* path, int capacity )
+{
+	ScopedLock lock( g_traceState.mutex );
+	if( g_traceState.events || capacity <= 0 ){
+		return false;
+	}
+
+	// o邩ǂɊm߂
+	std::ofstream ofs( path );
+	if( !ofs ){
+		return false;
+	}
+
+	g_traceState.events = new TraceEvent[capacity];
+	for( int i = 0; i < capacity; i++ ){
+		g_traceState.events[i].sequence = 0;
+	}
+	g_traceState.capacity = capacity;
+	g_traceState.path = path;
+	g_traceState.origin = getTimeInSeconds();
+	atomicStore( &g_traceState.next, 0 );
+	atomicStore( &g_traceState.enabled, 1 );
+	return true;
+}
+
+bool isTraceEnabled()
+{
+	return g_traceState.enabled != 0;
+}
+
+void setTraceThreadName( const char* name )
+{
+	const int thread = getTraceThread();
+	ScopedLock lock( g_traceState.mutex );
+	std::strncpy( g_traceState.threadNames[thread - 1], name, sizeof( g_traceState.threadNames[0] ) - 1 );
+}
+
+void setTraceFrame( int64_t frame )
+{
+	t_traceFrame = frame;
+}
+
+void recordTraceEvent( const char* name, double startSeconds, double endSeconds )
+{
+	if( !isTraceEnabled() ){
+		return;
+	}
+	const long index = atomicAdd( &g_traceState.next, 1 ) - 1;
+	TraceEvent& event = g_traceState.events[index % g_traceState.capacity];
+	atomicStore( &event.sequence, 0 );
+	event.thread = getTraceThread();
+	event.name = name;
+	event.frame = t_traceFrame;
+	event.start = startSeconds;
+	event.end = endSeconds;
+	atomicStore( &event.sequence, index + 1 );
+}
+
+const char* internTraceName( const char* name )
+{
+	ScopedLock lock( g_traceState.mutex );
+	for( std::list<std::string>::const_iterator it = g_traceState.names.begin(); it != g_traceState.names.end(); ++it ){
+		if( *it == name ){
+			return it->c_str();
+		}
+	}
+	g_traceState.names.push_back( name );
+	return g_traceState.names.back().c_str();
+}
+
+// JSON̕Ƃďo(Oɂ͐䕶gȂ)
+static void writeQuoted( std::ostream& os, const char* text )
+{
+	os << '"';
+	for( ; *text; text++ ){
+		if( *text == '"' || *text == '\\' ){
+			os << '\\';
+		}
+		os << *text;
+	}
+	os << '"';
+}
+
+// ̌`JSON(̓g[XJnĂ[us])
+//   { "displayTimeUnit" : "ms", "traceEvents" : [
+//     { "name" : "thread_name", "ph" : "M", "pid" : 1, "tid" : 1, "args" : { "name" : "capture" } },
+//     { "name" : "register", "ph" : "X", "pid" : 1, "tid" : 2, "ts" : 1234.5, "dur" : 678.9, "args" : { "frame" : 42 } }, ... ] }
+static bool writeTraceLocked()
+{
+	if( !g_traceState.events ){
+		return false;
+	}
+	const std::string temporaryPath = g_traceState.path + ".tmp";
+	{
+		std::ofstream ofs( temporaryPath.c_str() );
+		if( !ofs ){
+			return false;
+		}
+		ofs << "{ \"displayTimeUnit\" : \"ms\", \"traceEvents\" : [" << std::endl;
+		long threadCount = atomicLoad( &g_traceState.threadCount );
+		if( threadCount > TRACE_MAX_THREADS ){
+			threadCount = TRACE_MAX_THREADS;
+		}
+		for( int i = 1; i <= threadCount; i++ ){
+			const char* threadName = g_traceState.threadNames[i - 1];
+			ofs << "  { \"name\" : \"thread_name\", \"ph\" : \"M\", \"pid\" : 1, \"tid\" : " << i << ", \"args\" : { \"name\" : ";
+			if( threadName[0] ){
+				writeQuoted( ofs, threadName );
+			}
+			else{
+				ofs << "\"thread " << i << "\"";
+			}
+			ofs << " } }," << std::endl;
+		}
+
+		// Oobt@ɎcĂ͈(㏑ꂽÂCxg͏)
+		const long next = atomicLoad( &g_traceState.next );
+		const long first = ( next > g_traceState.capacity ) ? next - g_traceState.capacity : 0;
+		ofs << std::fixed << std::setprecision( 3 );
+		bool separator = false;
+		for( long index = first; index < next; index++ ){
+			const TraceEvent& slot = g_traceState.events[index % g_traceState.capacity];
+			if( atomicLoad( &slot.sequence ) != index + 1 ){
+				continue;
+			}
+			const TraceEvent event = { 0, slot.thread, slot.name, slot.frame, slot.start, slot.end };
+			if( atomicLoad( &slot.sequence ) != index + 1 ){
+				continue;
+			}
+			ofs << ( separator ? ",\n" : "" ) << "  { \"name\" : ";
+			writeQuoted( ofs, event.name );
+			ofs << ", \"ph\" : \"X\", \"pid\" : 1, \"tid\" : " << event.thread
+				<< ", \"ts\" : " << ( event.start - g_traceState.origin ) * 1e6
+				<< ", \"dur\" : " << ( event.end - event.start ) * 1e6;
+			if( event.frame >= 0 ){
+				ofs << ", \"args\" : { \"frame\" : " << event.frame << " }";
+			}
+			ofs << " }";
+			separator = true;
+		}
+		ofs << std::endl << "] }" << std::endl;
+		if( !ofs ){
+			return false;
+		}
+	}
+	return replaceFile( temporaryPath.c_str(), g_traceState.path.c_str() );
+}
+
+bool writeTrace()
+{
+	ScopedLock lock( g_traceState.mutex );
+	return writeTraceLocked();
+}
+
+void stopTrace()
+{
+	ScopedLock lock( g_traceState.mutex );
+	if( !g_traceState.events ){
+		return;
+	}
+	atomicStore( &g_traceState.enabled, 0 );
+	writeTraceLocked();
+	delete[] g_traceState.events;
+	g_traceState.events = nullptr;
+	g_traceState.capacity = 0;
+}
@@ -0,0 +1,66 @@
+// Trace.h : ȉ̊JnƏIOobt@ɋL^AChromẽg[X`(JSON)ŏo
+// This source code is licensed under the MIT license. Please see the License in License.txt.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "Platform.h"
+
+
+// Oobt@ɓCxg̐̊l(30fps1t[20CxgȂ100b)
+static const int TRACE_DEFAULT_CAPACITY = 1 << 16;
+
+// OtXbh̐(Xbh͍Ō̔ԍɂ܂Ƃ߂)
+static const int TRACE_MAX_THREADS = 64;
+
+// g[XJn
+// capacity̃Cxg郊Oobt@mۂAtɂȂÂCxg㏑
+// ot@Cchrome://tracingPerfetto UI(https://ui.perfetto.dev/)ŊJ
+bool startTrace( const char* path, int capacity = TRACE_DEFAULT_CAPACITY );
+bool isTraceEnabled();
+
+// Oobt@ɎcĂCxgstartTrace()̃t@Cɏo(L^͎~߂Ȃ)
+// L^̃Xbhłr̃Cxg͏
+bool writeTrace();
+
+// oĂL^~߂ăOobt@(vȌIɂĂяo)
+// ̃XbhL^ĂȂƂ(Xbh~߂)ɌĂяo
+void stopTrace();
+
+// ݂̃Xbh̖O(g[X̃Xbh̍sɕ\)
+void setTraceThreadName( const char* name );
+
+// ݂̃XbhŏĂt[̔ԍ(ȍ~̃CxgɕtA-1̂Ƃ͕tȂ)
+void setTraceFrame( int64_t frame );
+
+// ̊JnƏI̎[s](getTimeInSeconds())CxgƂċL^
+// name͏o܂ŗLȕ(񃊃einternTraceName()̖߂l)
+void recordTraceEvent( const char* name, double startSeconds, double endSeconds );
+
+// O̕o܂ŕێ(Oɂ͓|C^Ԃ)
+const char* internTraceName( const char* name );
+
+// XR[v̏CxgƂċL^
+class TraceScope
+{
+public:
+	explicit TraceScope( const char* name )
+		: name( name ), start( isTraceEnabled() ? getTimeInSeconds() : -1.0 )
+	{
+	}
+
+	~TraceScope()
+	{
+		if( start >= 0.0 ){
+			recordTraceEvent( name, start, getTimeInSeconds() );
+		}
+	}
+
+private:
+	const char* name;
+	double start;
+
+	TraceScope( const TraceScope& );
+	TraceScope& operator=( const TraceScope& );
+};
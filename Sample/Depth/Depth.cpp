@@ -6,129 +6,105 @@
 #include <Windows.h>
 #include <NuiApi.h>
 #include <opencv2/opencv.hpp>
+#include "FrameBufferPool.h"
+#include "NuiFrameSource.h"
+#include "DepthPipeline.h"
+#include "DepthColorizer.h"
 
 
 int _tmain( int argc, _TCHAR* argv[] )
 {
 	cv::setUseOptimized( true );
 	
-	// Kinect̃CX^XA
-	INuiSensor* pSensor;
-	HRESULT hResult = S_OK;
-	hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	// t[\[X̍쐬
+	// Kinectg("-replay <file>"w肵Ƃ͋L^t@CĐA"-synthetic <l>"w肵Ƃ͍V[𐶐A"-record <file>"w肵Ƃ͋L^)
+	// ʒu킹e[u쐬(t[ɑSfNuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()ĂяoɁAN1x쐬)
+	std::unique_ptr<FrameSource> frameSource;
+	RegistrationTable registrationTable;
+	HRESULT hResult = createFrameSource( argc, argv, FRAME_STREAM_FLAG_COLOR | FRAME_STREAM_FLAG_DEPTH | NUI_FRAME_SOURCE_DEPTH_ONLY | NUI_FRAME_SOURCE_NEAR_MODE, frameSource, &registrationTable );
 	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		std::cerr << "Error : createFrameSource" << std::endl;
 		return -1;
 	}
 
-	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_DEPTH );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiInitialize" << std::endl;
-		return -1;
-	}
-
-	// ColorXg[
-	HANDLE hColorEvent = INVALID_HANDLE_VALUE;
-	HANDLE hColorHandle = INVALID_HANDLE_VALUE;
-	hColorEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hColorEvent, &hColorHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( COLOR )" << std::endl;
-		return -1;
-	}
+	// Deptḧʒu킹_vZbT̐̃XbhŕS
+	ThreadPool threadPool;
+	DepthPipeline depthPipeline( registrationTable, &threadPool );
 
-	// DepthXg[
-	HANDLE hDepthEvent = INVALID_HANDLE_VALUE;
-	HANDLE hDepthHandle = INVALID_HANDLE_VALUE;
-	hDepthEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_DEPTH, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hDepthEvent, &hDepthHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( DEPTH )" << std::endl;
-		return -1;
-	}
-
-	// Near Mode̐ݒ
-	hResult = pSensor->NuiImageStreamSetImageFrameFlags(hDepthHandle, NUI_IMAGE_STREAM_FLAG_ENABLE_NEAR_MODE );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamSetImageFrameFlags" << std::endl;
-		return -1;
-	}
+	// Depth̕\p̐Ft(̐F̃e[u1xɈAe[u͐F̕tςƂ蒼)
+	DepthColorizer depthColorizer;
+	depthColorizer.setRange( DEPTH_RANGE_NEAR );
 
-	HANDLE hEvents[2] = { hColorEvent, hDepthEvent };
+	// t[Ɏg摜obt@(t[mۂɎg)
+	FrameBufferPool framePool;
 
 	cv::namedWindow( "Color" );
 	cv::namedWindow( "Depth" );
 
+	// gbNo[̐
+	// colormap0 : O[XP[A1 : jetA2 : turboA3 : qXgO̕R
+	int colorMap = DEPTH_COLOR_MAP_GRAY;
+	cv::createTrackbar( "colormap", "Depth", &colorMap, DEPTH_COLOR_MAP_COUNT - 1 );
+
 	while( 1 ){
-		// t[̍XV҂
-		ResetEvent( hColorEvent );
-		ResetEvent( hDepthEvent );
-		WaitForMultipleObjects( ARRAYSIZE( hEvents ), hEvents, true, INFINITE );
-
-		// ColorJt[擾
-		NUI_IMAGE_FRAME pColorImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hColorHandle, 0, &pColorImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( COLOR )" << std::endl;
-			return -1;
+		// t[̎擾(SẴXg[̃t[܂ő҂AĐII)
+		FrameSet frames;
+		bool read;
+		{
+			TraceScope trace( "read" );
+			read = frameSource->read( frames );
 		}
-
-		// DepthZT[t[擾
-		NUI_IMAGE_FRAME pDepthImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hDepthHandle, 0, &pDepthImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( DEPTH )" << std::endl;
-			return -1;
+		if( !read ){
+			break;
 		}
-
-		// Color摜f[^̎擾
-		INuiFrameTexture* pColorFrameTexture = pColorImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sColorLockedRect;
-		pColorFrameTexture->LockRect( 0, &sColorLockedRect, nullptr, 0 );
-
-		// Depthf[^̎擾
-		INuiFrameTexture* pDepthFrameTexture = pDepthImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sDepthLockedRect;
-		pDepthFrameTexture->LockRect( 0, &sDepthLockedRect, nullptr, 0 );
+		setTraceFrame( frames.depth.info.frameNumber );
 
 		// \
-		cv::Mat colorMat( 480, 640, CV_8UC4, reinterpret_cast<uchar*>( sColorLockedRect.pBits ) );
-		LONG registX = 0;
-		LONG registY = 0;
-		ushort* pBuffer = reinterpret_cast<ushort*>( sDepthLockedRect.pBits );
-		cv::Mat bufferMat = cv::Mat::zeros( 480, 640, CV_16UC1 );
-		for( int y = 0; y < 480; y++ ){
-			for( int x = 0; x < 640; x++ ){
-				pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480, nullptr, x, y, *pBuffer, &registX, &registY );
-				if( ( registX >= 0 ) && ( registX < 640 ) && ( registY >= 0 ) && ( registY < 480 ) ){
-					bufferMat.at<ushort>( registY, registX ) = *pBuffer;
-				}
-				pBuffer++;
-			}
+		cv::Mat colorMat( 480, 640, CV_8UC4, frames.color.data );
+		PooledFrameBuffer registBuffer( framePool, PIXEL_FORMAT_DEPTH16, 640, 480 );
+		cv::Mat bufferMat( 480, 640, CV_16UC1, registBuffer.data() );
+		PooledFrameBuffer depthBuffer( framePool, PIXEL_FORMAT_BGRX32, 640, 480 );
+		cv::Mat depthMat( 480, 640, CV_8UC4, depthBuffer.data() );
+		DepthPipelineOutput depthOutput;
+		depthOutput.registered = reinterpret_cast<ushort*>( bufferMat.data );
+		{
+			ScopedMetric metric( METRIC_REGISTER );
+			depthPipeline.process( reinterpret_cast<ushort*>( frames.depth.data ), depthOutput );
+			depthColorizer.setColorMap( static_cast<DepthColorMap>( colorMap ) );
+			depthColorizer.colorize( reinterpret_cast<ushort*>( bufferMat.data ), depthMat.data, 640 * 480, 4 );
+		}
+		{
+			ScopedMetric metric( METRIC_DRAW );
+			cv::imshow( "Color", colorMat );
+			cv::imshow( "Depth", depthMat );
 		}
-		cv::Mat depthMat( 480, 640, CV_8UC1 );
-		bufferMat.convertTo( depthMat, CV_8UC1, -255.0f / NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE, 255.0f );
-		cv::imshow( "Color", colorMat );
-		cv::imshow( "Depth", depthMat );
+		recordFrameLatency( frames.depth.info.timestamp );
 		
-		// t[̉
-		pColorFrameTexture->UnlockRect( 0 );
-		pDepthFrameTexture->UnlockRect( 0 );
-		pSensor->NuiImageStreamReleaseFrame( hColorHandle, &pColorImageFrame );
-		pSensor->NuiImageStreamReleaseFrame( hDepthHandle, &pDepthImageFrame );
 
-
-		if( cv::waitKey( 30 ) == VK_ESCAPE ){
+		// [v̏I(EscL[)Ag[X̏o(tL[)
+		int key;
+		{
+			TraceScope trace( "wait" );
+			key = cv::waitKey( 30 );
+		}
+		if( key == 't' ){
+			writeTrace();
+		}
+		if( key == VK_ESCAPE ){
 			break;
 		}
 	}
 
-	// Kinect̏I
-	pSensor->NuiShutdown();
-	CloseHandle( hColorEvent );
-	CloseHandle( hDepthEvent );
-	CloseHandle( hColorHandle );
-	CloseHandle( hDepthHandle );
+	// t[̐
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( frameSource->getStreams() & ( 1 << i ) ){
+			const FrameDropCounter& dropCounter = frameSource->getDropCounter( static_cast<FrameStream>( i ) );
+			std::cout << getFrameStreamName( static_cast<FrameStream>( i ) ) << " : " << dropCounter.getDropped() << " frames dropped / " << dropCounter.getReceived() << " frames received" << std::endl;
+		}
+	}
+
+	// t[\[X̏I(Kinect̏I)
+	frameSource.reset();
 
 	cv::destroyAllWindows();
 
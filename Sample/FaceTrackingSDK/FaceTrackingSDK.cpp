@@ -7,6 +7,9 @@
 #include <NuiApi.h>
 #include <FaceTrackLib.h>
 #include <opencv2/opencv.hpp>
+#include "FrameBufferPool.h"
+#include "NuiFrameSource.h"
+#include "DepthColorizer.h"
 
 
 // Kinect for Windows Developer Toolkit v1.6 - Samples/C++/FaceTrackingVisualizationp(ꕔ)
@@ -110,57 +113,17 @@ int _tmain(int argc, _TCHAR* argv[])
 {
 	cv::setUseOptimized( true );
 
-	// Kinect̃CX^XA
-	INuiSensor* pSensor;
-	HRESULT hResult = S_OK;
-	hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	// t[\[X̍쐬
+	// Kinectg("-replay <file>"w肵Ƃ͋L^t@CĐA"-synthetic <l>"w肵Ƃ͍V[𐶐A"-record <file>"w肵Ƃ͋L^)
+	// ʒu킹e[u쐬(t[ɑSfNuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()ĂяoɁAN1x쐬)
+	std::unique_ptr<FrameSource> frameSource;
+	RegistrationTable registrationTable;
+	HRESULT hResult = createFrameSource( argc, argv, FRAME_STREAM_FLAG_ALL | NUI_FRAME_SOURCE_NEAR_MODE | NUI_FRAME_SOURCE_SEATED, frameSource, &registrationTable );
 	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		std::cerr << "Error : createFrameSource" << std::endl;
 		return -1;
 	}
 
-	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX | NUI_INITIALIZE_FLAG_USES_SKELETON );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiInitialize" << std::endl;
-		return -1;
-	}
-
-	// ColorXg[
-	HANDLE hColorEvent = INVALID_HANDLE_VALUE;
-	HANDLE hColorHandle = INVALID_HANDLE_VALUE;
-	hColorEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hColorEvent, &hColorHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen(camera)" << std::endl;
-		return -1;
-	}
-
-	// Depth&PlayerXg[
-	HANDLE hDepthPlayerEvent = INVALID_HANDLE_VALUE;
-	HANDLE hDepthPlayerHandle = INVALID_HANDLE_VALUE;
-	hDepthPlayerEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hDepthPlayerEvent, &hDepthPlayerHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( DEPTH&PLAYER )" << std::endl;
-		return -1;
-	}
-
-	// Near Mode̐ݒ
-	hResult = pSensor->NuiImageStreamSetImageFrameFlags( hDepthPlayerHandle, NUI_IMAGE_STREAM_FLAG_ENABLE_NEAR_MODE );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamSetImageFrameFlags" << std::endl;
-		return -1;
-	}
-
-	// SkeletonXg[
-	HANDLE hSkeletonEvent = INVALID_HANDLE_VALUE;
-	hSkeletonEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiSkeletonTrackingEnable( hSkeletonEvent, NUI_SKELETON_TRACKING_FLAG_SUPPRESS_NO_FRAME_DATA | NUI_SKELETON_TRACKING_FLAG_ENABLE_SEATED_SUPPORT );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiSkeletonTrackingEnable" << std::endl;
-		return -1;
-	}
- 
 	// Face Tracking
 	IFTFaceTracker* pFT = FTCreateFaceTracker();
 	if( !pFT ){
@@ -198,73 +161,49 @@ int _tmain(int argc, _TCHAR* argv[])
 	FT_VECTOR3D* hintPoint = nullptr;
 	bool lastTrack = false;
 
-	HANDLE hEvents[3] = { hColorEvent, hDepthPlayerEvent, hSkeletonEvent };
+	// Depth̕\p̐Ft(8rbgɂĂBGRɍLɁA̐F̃e[u1xBGR֕ϊ)
+	DepthColorizer depthColorizer;
+	depthColorizer.setRange( DEPTH_RANGE_NEAR );
+
+	// t[Ɏg摜obt@(t[mۂɎg)
+	FrameBufferPool framePool;
 
 	cv::namedWindow( "Face Tracking" );
 	cv::namedWindow( "Depth" );
 
 	while ( 1 ){
-		// t[̍XV҂
-		ResetEvent( hColorEvent );
-		ResetEvent( hDepthPlayerEvent );
-		ResetEvent( hSkeletonEvent );
-		WaitForMultipleObjects( ARRAYSIZE( hEvents ), hEvents, true, INFINITE );
-
-		// ColorJt[擾
-		NUI_IMAGE_FRAME sColorImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hColorHandle, 0, &sColorImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( COLOR )" << std::endl;
-			return -1;
+		// t[̎擾(SẴXg[̃t[܂ő҂AĐII)
+		FrameSet frames;
+		bool read;
+		{
+			TraceScope trace( "read" );
+			read = frameSource->read( frames );
 		}
-
-		// DepthZT[t[擾
-		NUI_IMAGE_FRAME sDepthPlayerImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hDepthPlayerHandle, 0, &sDepthPlayerImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( DEPTH&PLAYER )" << std::endl;
-			return -1;
+		if( !read ){
+			break;
 		}
+		setTraceFrame( frames.depth.info.frameNumber );
 
-		// Skeletont[擾
-		NUI_SKELETON_FRAME sSkeletonFrame = { 0 };
-		hResult = pSensor->NuiSkeletonGetNextFrame( 0, &sSkeletonFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiSkeletonGetNextFrame" << std::endl;
-			return -1;
-		}
+		// Skeletont[(NUI_SKELETON_FRAMEƓzu)
+		const NUI_SKELETON_FRAME& sSkeletonFrame = toNuiSkeletonFrame( *frames.skeleton );
 
 		// Color摜f[^̎擾
-		INuiFrameTexture* pColorTexture = sColorImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sColorLockedRect;
-		pColorTexture->LockRect( 0, &sColorLockedRect, nullptr, 0 );
-		cv::Mat colorMat( 480, 640, CV_8UC4, reinterpret_cast<uchar*>( sColorLockedRect.pBits ) );
+		cv::Mat colorMat( 480, 640, CV_8UC4, frames.color.data );
 
-		memcpy( pColorImage->GetBuffer(), PBYTE(sColorLockedRect.pBits), std::min( pColorImage->GetBufferSize(), UINT(pColorTexture->BufferLen()) ) ); // Face Trackinĝ߂̉摜փRs[
+		memcpy( pColorImage->GetBuffer(), frames.color.data, std::min( pColorImage->GetBufferSize(), UINT(640 * 480 * 4) ) ); // Face Trackinĝ߂̉摜փRs[
 
 		// Depthf[^̎擾
-		INuiFrameTexture* pDepthPlayerTexture = sDepthPlayerImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sDepthPlayerLockedRect;
-		pDepthPlayerTexture->LockRect( 0, &sDepthPlayerLockedRect, nullptr, 0 );
-		LONG registX = 0;
-		LONG registY = 0;
-		ushort* pBuffer = reinterpret_cast<ushort*>( sDepthPlayerLockedRect.pBits );
-		cv::Mat bufferMat16U = cv::Mat::zeros( 480, 640, CV_16UC1 );
-		for( int y = 0; y < 480; y++ ){
-			for( int x = 0; x < 640; x++ ){
-				pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480, nullptr, x, y, *pBuffer, &registX, &registY );
-				if( ( registX >= 0 ) && ( registX < 640 ) && ( registY >= 0 ) && ( registY < 480 ) ){
-					bufferMat16U.at<ushort>( registY, registX ) = *pBuffer & 0xFFF8;
-				}
-				pBuffer++;
-			}
+		PooledFrameBuffer registBuffer( framePool, PIXEL_FORMAT_DEPTH16, 640, 480 );
+		cv::Mat registMat( 480, 640, CV_16UC1, registBuffer.data() );
+		PooledFrameBuffer depthBuffer( framePool, PIXEL_FORMAT_BGR24, 640, 480 );
+		cv::Mat depthMat( 480, 640, CV_8UC3, depthBuffer.data() );
+		{
+			ScopedMetric metric( METRIC_REGISTER );
+			registrationTable.registerFrame( reinterpret_cast<ushort*>( frames.depth.data ), reinterpret_cast<ushort*>( registMat.data ) );
+			depthColorizer.colorize( reinterpret_cast<ushort*>( registMat.data ), depthMat.data, 640 * 480, 3 );
 		}
-		cv::Mat bufferMat8U( 480, 640, CV_8UC1 );
-		bufferMat16U.convertTo( bufferMat8U, CV_8UC1, -255.0f / NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE, 255.0f );
-		cv::Mat depthMat( 480, 640, CV_8UC3 );
-		cv::cvtColor( bufferMat8U, depthMat, CV_GRAY2BGR );
 
-		memcpy( pDepthImage->GetBuffer(), PBYTE(sDepthPlayerLockedRect.pBits), std::min( pDepthImage->GetBufferSize(), UINT(pDepthPlayerTexture->BufferLen()) ) ); // Face Trackinĝ߂̉摜փRs[
+		memcpy( pDepthImage->GetBuffer(), frames.depth.data, std::min( pDepthImage->GetBufferSize(), UINT(640 * 480 * 2) ) ); // Face Trackinĝ߂̉摜փRs[
 		
 		// Skeletonf[^(A)̎擾
 		bool skeletonTracked[NUI_SKELETON_COUNT];
@@ -339,65 +278,80 @@ int _tmain(int argc, _TCHAR* argv[])
 		sensorData.ViewOffset = viewOffset;
 
 		// FaceTrackinǧoEǐ 
-		if( lastTrack ){
-			// This method is faster than StartTracking() and is used only for tracking. But, If the face being tracked moves too far from the previous location, this method fails.
-			hResult = pFT->ContinueTracking( &sensorData, hintPoint, pFTResult );
-			if( FAILED( hResult ) || FAILED( pFTResult->GetStatus() ) ){
-				lastTrack = false;
-			}
-		}
-		else{
-			// This process is more expensive than simply tracking (done by calling ContinueTracking()), but more robust.
-			hResult = pFT->StartTracking( &sensorData, nullptr, hintPoint, pFTResult );
-			if( SUCCEEDED( hResult ) && SUCCEEDED( pFTResult->GetStatus() ) ){
-				lastTrack = true;
+		{
+			ScopedMetric metric( METRIC_TRACK );
+			if( lastTrack ){
+				// This method is faster than StartTracking() and is used only for tracking. But, If the face being tracked moves too far from the previous location, this method fails.
+				TraceScope trace( "ContinueTracking" );
+				hResult = pFT->ContinueTracking( &sensorData, hintPoint, pFTResult );
+				if( FAILED( hResult ) || FAILED( pFTResult->GetStatus() ) ){
+					lastTrack = false;
+				}
 			}
 			else{
-				lastTrack = false;
+				// This process is more expensive than simply tracking (done by calling ContinueTracking()), but more robust.
+				TraceScope trace( "StartTracking" );
+				hResult = pFT->StartTracking( &sensorData, nullptr, hintPoint, pFTResult );
+				if( SUCCEEDED( hResult ) && SUCCEEDED( pFTResult->GetStatus() ) ){
+					lastTrack = true;
+				}
+				else{
+					lastTrack = false;
+				}
 			}
 		}
 
 		// Face Trackingʕ`
-		if( lastTrack && SUCCEEDED( pFTResult->GetStatus() ) ){
-			// Candide-3 Face Model(http://www.icg.isy.liu.se/candide/)̕\
-			IFTModel* pFTModel;
-			hResult = pFT->GetFaceModel( &pFTModel );
-			if( SUCCEEDED( hResult ) ){
-				FLOAT* pSU = nullptr;
-				pFT->GetShapeUnits( nullptr, &pSU, nullptr, nullptr ); 
-				VisualizeFaceModel( pColorImage, pFTModel, &colorConfig, pSU, 1.0f, viewOffset, pFTResult, 0x00FF0000 ); // ARGB Red:0x00FF0000, Grean:0x0000FF00, Blue:0x000000FF, Yellow:0x00FFFF00
-				pFTModel->Release();
-				colorMat.data = reinterpret_cast<uchar*>( pColorImage->GetBuffer() );
+		{
+			ScopedMetric metric( METRIC_DRAW );
+			if( lastTrack && SUCCEEDED( pFTResult->GetStatus() ) ){
+				// Candide-3 Face Model(http://www.icg.isy.liu.se/candide/)̕\
+				IFTModel* pFTModel;
+				hResult = pFT->GetFaceModel( &pFTModel );
+				if( SUCCEEDED( hResult ) ){
+					FLOAT* pSU = nullptr;
+					pFT->GetShapeUnits( nullptr, &pSU, nullptr, nullptr ); 
+					VisualizeFaceModel( pColorImage, pFTModel, &colorConfig, pSU, 1.0f, viewOffset, pFTResult, 0x00FF0000 ); // ARGB Red:0x00FF0000, Grean:0x0000FF00, Blue:0x000000FF, Yellow:0x00FFFF00
+					pFTModel->Release();
+					colorMat.data = reinterpret_cast<uchar*>( pColorImage->GetBuffer() );
+				}
 			}
-		}
-
-		cv::imshow( "Face Tracking", colorMat );
-		cv::imshow( "Depth", depthMat );
 
-		// t[̉
-		pColorTexture->UnlockRect( 0 );
-		pDepthPlayerTexture->UnlockRect( 0 );
-		pSensor->NuiImageStreamReleaseFrame( hColorHandle, &sColorImageFrame );
-		pSensor->NuiImageStreamReleaseFrame( hDepthPlayerHandle, &sDepthPlayerImageFrame );
+			cv::imshow( "Face Tracking", colorMat );
+			cv::imshow( "Depth", depthMat );
+		}
+		recordFrameLatency( frames.depth.info.timestamp );
 
-		// [v̏I(EscL[)
-		if( cv::waitKey( 30 ) == VK_ESCAPE ){
+		// [v̏I(EscL[)Ag[X̏o(tL[)
+		int key;
+		{
+			TraceScope trace( "wait" );
+			key = cv::waitKey( 30 );
+		}
+		if( key == 't' ){
+			writeTrace();
+		}
+		if( key == VK_ESCAPE ){
 			break;
 		}
 	}
 
-	// Kinect̏I
+	// t[̐
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( frameSource->getStreams() & ( 1 << i ) ){
+			const FrameDropCounter& dropCounter = frameSource->getDropCounter( static_cast<FrameStream>( i ) );
+			std::cout << getFrameStreamName( static_cast<FrameStream>( i ) ) << " : " << dropCounter.getDropped() << " frames dropped / " << dropCounter.getReceived() << " frames received" << std::endl;
+		}
+	}
+
+	// Face Tracking̏I
 	pFT->Release();
 	pFTResult->Release();
 	pColorImage->Release();
 	pDepthImage->Release();
-	pSensor->NuiShutdown();
-	pSensor->NuiSkeletonTrackingDisable();
-	CloseHandle( hColorEvent );
-	CloseHandle( hDepthPlayerEvent );
-	CloseHandle( hSkeletonEvent );
-	CloseHandle( hColorHandle );
-	CloseHandle( hDepthPlayerHandle );
+
+	// t[\[X̏I(Kinect̏I)
+	frameSource.reset();
 
 	cv::destroyAllWindows();
 
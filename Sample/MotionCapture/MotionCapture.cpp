@@ -5,15 +5,19 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <tchar.h>
-#include <time.h>
 #include <sstream>
+#include <iomanip>
 #include <exception>
+#include <memory>
 
 #include <d3d9.h>
 #include <d3dx9.h>
 
 #include <objbase.h>
 #include <NuiApi.h>
+#include "NuiFrameSource.h"
+#include "BoneTransform.h"
+#include "FrameTiming.h"
 
 #pragma comment( lib, "d3d9.lib" )
 #pragma comment( lib, "d3dx9.lib" )
@@ -49,39 +53,24 @@ public:
 
 /*----- t[[gv -----*/
 
-static clock_t g_fpsClk = clock();
-static int g_fps = 0;
-static int g_fpsCur = 0;
-
-// t[[gvD1`悷閈1x̊֐ĂяoD1bƂɍXVC[͎ľܓ
-int updateFps()
-{
-	const clock_t current = clock();
-	const int diff = current - g_fpsClk;
-	if( diff >= CLOCKS_PER_SEC ) {
-		g_fps = static_cast<int>( ( static_cast<float>( g_fpsCur ) / ( diff / CLOCKS_PER_SEC ) + 0.5f ) );
-		g_fpsCur = 0;
-		g_fpsClk = ( current / CLOCKS_PER_SEC ) * CLOCKS_PER_SEC + diff % CLOCKS_PER_SEC;
-	}
-	g_fpsCur++;
-	return g_fps;
-}
+// `Ǝ擾̃t[[gC擾\܂ł̒x(1b̍ŏCρCőƎwړ)
+static FrameTiming g_frameTiming;
 
 /* ----- Kinect ----- */
 
-// Kinect̃CX^X
-static INuiSensor* g_sensor = nullptr;
-
-// RGB摜̃Xg[ƁC擾Ɠ邽߂̃nh
-static HANDLE g_rgbStream = INVALID_HANDLE_VALUE;
-static HANDLE g_rgbHandle = INVALID_HANDLE_VALUE;
+// t[\[X(KinectCR}hC"-replay <file>"Ŏw肵L^t@CC܂"-synthetic <l>"Ŏw肵V[)
+static std::unique_ptr<FrameSource> g_frameSource;
 
-// Skeleton̎擾Ɠ邽߂̃nh
-static HANDLE g_skeleHandle = INVALID_HANDLE_VALUE;
+// Kinect̃CX^X(KinectgȂƂnullptr)
+static INuiSensor* g_sensor = nullptr;
 
 // Skeletoñt[
 static NUI_SKELETON_FRAME g_skeleFrame;
 
+// ŌɎ擾RGB摜̃^CX^v[ms]ƁC܂\ĂȂ(x̋L^Ɏg)
+static int64_t g_frameTimestamp = 0;
+static bool g_framePending = false;
+
 // Kinect̃`g[^[̊px
 static float g_sensorTiltAngle = 0.0f;
 static float g_sensorTiltAnglePrev[ 10 ] = { 0.0f };
@@ -89,12 +78,8 @@ static float g_sensorTiltAnglePrev[ 10 ] = { 0.0f };
 // Kinect̃\[XJ
 void releaseKinect()
 {
-	if( g_sensor ) {
-		g_sensor->NuiSkeletonTrackingDisable();
-		g_sensor->NuiShutdown();
-	}
-	CloseHandle( g_rgbHandle );
-	CloseHandle( g_skeleHandle );
+	g_frameSource.reset();
+	g_sensor = nullptr;
 }
 
 // Kinect
@@ -102,41 +87,18 @@ void initKinect()
 {
 	HRESULT hResult;
 
-	// Kinect
-	hResult = NuiCreateSensorByIndex( 0, &g_sensor );
+	// t[\[X쐬(RGB摜Skeleton擾)
+	// RGB摜Skeleton̂ǂ炩XVꂽ擾(͑Õt[g)
+	hResult = createFrameSource( __argc, __targv, FRAME_STREAM_FLAG_COLOR | FRAME_STREAM_FLAG_SKELETON | NUI_FRAME_SOURCE_SYNC_ANY_STREAM, g_frameSource );
 	if( FAILED( hResult ) ) {
 		throw kinect_exception(
-			"Error : NuiCreateSensorByIndex\nKinectłĂȂCgpł" );
-	}
-
-	hResult = g_sensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_SKELETON );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : NuiInitialize" );
-	}
-
-	// KinectƓ邽߂̃Cxg쐬
-
-	g_skeleHandle = CreateEvent( nullptr, TRUE, FALSE, nullptr );
-	if( FAILED( g_skeleHandle ) ) {
-		throw win32_exception( "Error : CreateEvent" );
-	}
-
-	g_rgbHandle = CreateEvent( nullptr, TRUE, FALSE, nullptr );
-	if( FAILED( g_rgbHandle ) ) {
-		throw win32_exception( "Error : CreateEvent" );
-	}
-
-	// RGB摜擾邽߂̃Xg[J
-	hResult = g_sensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR,
-		NUI_IMAGE_RESOLUTION_640x480, 0, 2, g_rgbHandle, &g_rgbStream );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : NuiImageStreamOpen" );
+			"Error : createFrameSource\nKinectłĂȂCgpł" );
 	}
 
-	// Skeleton̒ǐՂL
-	hResult = g_sensor->NuiSkeletonTrackingEnable( g_skeleHandle, 0 );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : NuiSkeletonTrackingEnable" );
+	// KinectgȂƂ́C`g[^[̊px0xƂ
+	g_sensor = getNuiSensor( g_frameSource.get() );
+	if( !g_sensor ) {
+		return;
 	}
 
 	// `g[^[̊px擾
@@ -180,34 +142,6 @@ static const float BONE_LENGTH[ 20 ] = {
 // Bonẽ[gnʂ܂ł̋[cm]
 static const float BONE_ROOT_DISTANCE = 108.4f;
 
-// Bone̕\ɕKvȌvZʂi[邽߂̍\
-struct SkeleState
-{
-	// Joinẗʒu
-	D3DXVECTOR3 endJointPos[ NUI_SKELETON_POSITION_COUNT ];
-
-	// [Jϊs
-	D3DXMATRIX localTrans[ NUI_SKELETON_POSITION_COUNT ];
-
-	// gbLO
-	bool boneTracked[ NUI_SKELETON_POSITION_COUNT ];
-
-	// ]ʒuȂǂLۂ
-	bool isValid;
-
-	// o[ϐSď
-	void Reset()
-	{
-		for( int i = 0; i < NUI_SKELETON_POSITION_COUNT; i++ ) {
-			endJointPos[ i ].x = 0.0f;
-			endJointPos[ i ].y = 0.0f;
-			endJointPos[ i ].z = 0.0f;
-			D3DXMatrixIdentity( &localTrans[ i ] );
-			boneTracked[ i ] = false;
-			isValid = false;
-		}
-	}
-};
 static SkeleState g_skeleState[ NUI_SKELETON_COUNT ];
 
 // D3DIuWFNg
@@ -384,36 +318,24 @@ void initD3D()
 bool capture()
 {
 	HRESULT hResult;
-	DWORD dResult;
 
 	// Kinect̃f[^̎擾Ă邩ǂׂ
-	const HANDLE events[] = { g_rgbHandle, g_skeleHandle };
-	dResult = WaitForMultipleObjects( ARRAYSIZE( events ), events, true, 0 );
 	// ܂̂Ƃ͎擾Ȃ
-	if( dResult == WAIT_TIMEOUT ) {
+	if( !g_frameSource->isFrameReady() ) {
 		return false;
 	}
-	if( dResult == 0xFFFFFFFF ) {
-		throw win32_exception( "Error : MsgWaitForMultipleObjects" );
-	}
-
-	// RGB摜̐Vt[擾
-	NUI_IMAGE_FRAME rgbFrame;
-	INuiFrameTexture* rgbTexture;
-	NUI_LOCKED_RECT rgbKinectRect;
+	TraceScope trace( "capture" );
 
-	hResult = g_sensor->NuiImageStreamGetNextFrame( g_rgbStream, 0, &rgbFrame );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : NuiImageStreamGetNextFrame" );
+	// RGB摜Skeleton̐Vt[擾
+	// L^t@CŌ܂ōĐƂ͍XVȂ
+	FrameSet frames;
+	if( !g_frameSource->read( frames ) ) {
+		if( g_sensor ) {
+			throw kinect_exception( "Error : FrameSource#read" );
+		}
+		return false;
 	}
 
-	// Rs[RGB摜̓ǂݎJn
-	rgbTexture = rgbFrame.pFrameTexture;
-	hResult = rgbTexture->LockRect( 0, &rgbKinectRect, nullptr, 0 );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : INuiFrameTexture#LockRect" );
-	}
-	
 	// Rs[̃eNX`[݂̏Jn
 	D3DLOCKED_RECT rgbD3DRect;
 	hResult = g_kinectRgbTex->LockRect( 0, &rgbD3DRect, nullptr, D3DLOCK_DISCARD );
@@ -422,35 +344,32 @@ bool capture()
 	}
 
 	// 1sRs[JԂ
-	for( int row = 0; row < ( rgbKinectRect.size / rgbKinectRect.Pitch ); row++ ) {
+	const int rgbPitch = frames.color.info.width * 4;
+	for( int row = 0; row < frames.color.info.height; row++ ) {
 		// Rs[̃|C^
-		const byte *psrc = rgbKinectRect.pBits + row * rgbKinectRect.Pitch;
+		const byte *psrc = frames.color.data + row * rgbPitch;
 		// Rs[̃|C^
 		byte *pdest = reinterpret_cast< byte* >( rgbD3DRect.pBits ) + row * rgbD3DRect.Pitch;
-		memcpy( pdest, psrc, rgbKinectRect.Pitch );
+		memcpy( pdest, psrc, rgbPitch );
 	}
 
-	// eNX`[RGB摜̓]
+	// eNX`[ւRGB摜̓]
 	hResult = g_kinectRgbTex->UnlockRect( 0 );
 	if( FAILED( hResult ) ) {
 		throw d3d_exception( "Error : Error : IDirect3DTexture9#UnlockRect" );
 	}
 
-	hResult = rgbTexture->UnlockRect( 0 );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : INuiFrameTexture#UnlockRect" );
-	}
+	g_frameTimestamp = frames.color.info.timestamp;
+	g_framePending = true;
+	g_frameTiming.onCapture();
+	setTraceFrame( frames.color.info.frameNumber );
 
-	// RGB摜̃t[
-	hResult = g_sensor->NuiImageStreamReleaseFrame( g_rgbStream, &rgbFrame );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : NuiImageStreamReleaseFrame" );
-	}
+	// Skeletoñt[ۑ
+	memcpy( &g_skeleFrame, &toNuiSkeletonFrame( *frames.skeleton ), sizeof( g_skeleFrame ) );
 
-	// Skeleton̐Vt[擾
-	hResult = g_sensor->NuiSkeletonGetNextFrame( 0, &g_skeleFrame );
-	if( FAILED( hResult ) ) {
-		throw kinect_exception( "Error : NuiSkeletonGetNextFrame" );
+	// KinectgȂƂ́C擾Skeleton̂܂܎g
+	if( !g_sensor ) {
+		return true;
 	}
 
 	// SkeletoñX[WO
@@ -484,99 +403,37 @@ bool capture()
 
 	g_sensorTiltAngle = angle / ARRAYSIZE( g_sensorTiltAnglePrev );
 
-	// CxgVOiԂɖ߂
-	ResetEvent( g_rgbHandle );
-	ResetEvent( g_skeleHandle );
-
 	return true;
 }
 
-// Matrix4D3DXMATRIXɕϊ
-static void convertMat4ToD3DXMat( const Matrix4 &src, D3DXMATRIX &dest )
+// Kinect SDKD3DX̌^AтCommoň^Ƃēn
+static_assert( sizeof( SkeletonData ) == sizeof( NUI_SKELETON_DATA ), "SkeletonData must have the same layout as NUI_SKELETON_DATA" );
+static_assert( sizeof( BoneOrientation ) == sizeof( NUI_SKELETON_BONE_ORIENTATION ), "BoneOrientation must have the same layout as NUI_SKELETON_BONE_ORIENTATION" );
+static_assert( sizeof( BoneMatrix ) == sizeof( D3DXMATRIX ), "BoneMatrix must have the same layout as D3DXMATRIX" );
+
+static const SkeletonData& toSkeletonData( const NUI_SKELETON_DATA &skele )
 {
-	dest._11 = src.M11; dest._12 = src.M12; dest._13 = src.M13; dest._14 = src.M14;
-	dest._21 = src.M21; dest._22 = src.M22; dest._23 = src.M23; dest._24 = src.M24;
-	dest._31 = src.M31; dest._32 = src.M32; dest._33 = src.M33; dest._34 = src.M34;
-	dest._41 = src.M41; dest._42 = src.M42; dest._43 = src.M43; dest._44 = src.M44;
+	return reinterpret_cast<const SkeletonData&>( skele );
 }
 
-// WϊƃgbLOԂSkeleStateɊi[
-static void calcSkeleState(
-	const NUI_SKELETON_DATA *skele,
-	NUI_SKELETON_POSITION_INDEX start,
-	NUI_SKELETON_POSITION_INDEX end,
-	const D3DXVECTOR3 &jointStartPos,
-	const Matrix4 &rotate,
-	float boneLength,
-	SkeleState *state
-	)
+static const BoneOrientation* toBoneOrientations( const NUI_SKELETON_BONE_ORIENTATION *orient )
 {
-	D3DXMATRIX mat;
-	D3DXMATRIX matScale, matRotate, matTrans;
-	const D3DXVECTOR3 yVec( 0.0f, 1.0f, 0.0f ); // y1LтĂxNg
-	D3DXVECTOR3 ret;
-
-	// 3DfYɊg傷
-	D3DXMatrixScaling( &matScale, 1.0f, boneLength, 1.0f );
-
-	// ]
-	convertMat4ToD3DXMat( rotate, matRotate );
-	
-	// ړ
-	D3DXMatrixTranslation( &matTrans, jointStartPos.x, jointStartPos.y, jointStartPos.z );
-
-	// ϊs쐬
-	D3DXMatrixMultiply( &mat, &matScale, &matRotate );
-	D3DXMatrixMultiply( &state->localTrans[ end ], &mat, &matTrans );
-
-	// _Wϊ
-	D3DXVec3TransformCoord( &state->endJointPos[ end ], &yVec, &state->localTrans[ end ] );
-
-	// BonẽgbLOԂݒ肷
-	if( skele->eSkeletonPositionTrackingState[ start ] == NUI_SKELETON_POSITION_TRACKED
-		&& skele->eSkeletonPositionTrackingState[ end ] == NUI_SKELETON_POSITION_TRACKED ) {
-		state->boneTracked[ end ] = true;
-	}
-	else {
-		state->boneTracked[ end ] = false;
-	}
+	return reinterpret_cast<const BoneOrientation*>( orient );
 }
 
-// Bone Orientation\ɕKvȏ߂SkeleStateɊi[
-static void setSkeleStateFromOrient(
-	const NUI_SKELETON_DATA *skele,
-	const NUI_SKELETON_BONE_ORIENTATION *orient,
-	SkeleState *skeleState )
+static const D3DXMATRIX* toD3DXMatrix( const BoneMatrix &mat )
 {
-	NUI_SKELETON_POSITION_INDEX jointStart, jointEnd;
-
-	jointStart = NUI_SKELETON_POSITION_HIP_CENTER;
-	jointEnd   = NUI_SKELETON_POSITION_HIP_CENTER;
-
-	// Root͕\ł{[Ȃ̂ŁA[JϊšvZ͏ȗ
-
-	// gbLOԂ擾
-	skeleState->boneTracked[ jointEnd ] =
-		skele->eSkeletonPositionTrackingState[ jointEnd ] == NUI_SKELETON_POSITION_TRACKED;
-
-	// RootȊOBoneɑ΂calcSkeleState()Ăяo
-	for( int i = 1; i < NUI_SKELETON_POSITION_COUNT; i++ )
-	{
-		jointStart = orient[ i ].startJoint;
-		jointEnd   = orient[ i ].endJoint;
-
-		calcSkeleState( skele, jointStart, jointEnd, skeleState->endJointPos[ jointStart ],
-			orient[ jointEnd ].absoluteRotation.rotationMatrix, BONE_LENGTH[ jointEnd ], skeleState );
-	}
+	return reinterpret_cast<const D3DXMATRIX*>( &mat );
 }
 
 // Kinectf[^擾A]s̐Ȃǂ̌vZOɏĂ
 void preprocess()
 {
+	TraceScope trace( "preprocess" );
 	HRESULT hResult;
 	for( int i = 0; i < NUI_SKELETON_COUNT; i++ ) {
 		NUI_SKELETON_DATA *skele = &g_skeleFrame.SkeletonData[ i ];
-		g_skeleState[ i ].Reset();
+		g_skeleState[ i ].reset();
 
 		// ǐՉ\ȏԂɂ
 		if( skele->eTrackingState == NUI_SKELETON_TRACKED ) {
@@ -586,7 +443,8 @@ void preprocess()
 
 			// ]vZłƂ
 			if( hResult == S_OK ) {
-				setSkeleStateFromOrient( skele, orient, &g_skeleState[ i ] );
+				// ]ƕϊšvZBenchmarkłvł悤Common̊֐ōs
+				setSkeleStateFromOrient( toSkeletonData( *skele ), toBoneOrientations( orient ), BONE_LENGTH, &g_skeleState[ i ] );
 				g_skeleState[ i ].isValid = true;
 			}
 		}
@@ -615,7 +473,7 @@ static void drawSkeleton( NUI_SKELETON_DATA *skele, float floorHeight, float til
 		D3DXMATRIX matLocalWorld;
 
 		// ŏIIȕϊs߂
-		D3DXMatrixMultiply( &matLocalWorld, &skeleState->localTrans[ i ], &matWorld );
+		D3DXMatrixMultiply( &matLocalWorld, toD3DXMatrix( skeleState->localTrans[ i ] ), &matWorld );
 
 		// [hϊsݒ肷
 		g_d3ddev->SetTransform( D3DTS_WORLD, &matLocalWorld );
@@ -638,6 +496,7 @@ static void drawSkeleton( NUI_SKELETON_DATA *skele, float floorHeight, float til
 // `悷
 void draw()
 {
+	ScopedMetric metric( METRIC_DRAW );
 	HRESULT hResult;
 
 	D3DXVECTOR3 vecEye, vecAt, vecUp;
@@ -798,9 +657,16 @@ void draw()
 	g_d3ddev->SetViewport( &viewport );
 
 	// t[[g̎擾ƕ`
+	// ` : t[[g(Ԋu̍ŏ//ő)C擾 : t[[gCx : wړ(ŏ//ő)
+	const TimingSeries& render = g_frameTiming.getRenderInterval();
+	const TimingSeries& latency = g_frameTiming.getCaptureToPresent();
 	std::stringstream ssFps;
-	int fps = updateFps();
-	ssFps << "FPS : " << fps;
+	ssFps << std::fixed << std::setprecision( 1 )
+		<< "FPS : " << FrameTiming::toFps( render.getEwma() )
+		<< " (" << render.getMinimum() << "/" << render.getAverage() << "/" << render.getMaximum() << " ms)"
+		<< "  Capture : " << FrameTiming::toFps( g_frameTiming.getCaptureInterval().getEwma() )
+		<< "  Latency : " << latency.getEwma()
+		<< " (" << latency.getMinimum() << "/" << latency.getAverage() << "/" << latency.getMaximum() << " ms)";
 	textRect.top = 0;
 	g_font->DrawTextA( nullptr, ssFps.str().c_str(), -1, &textRect, 0, 0xFFFFFFFF );
 
@@ -814,6 +680,15 @@ void draw()
 	if( hResult != D3DERR_DEVICELOST && FAILED( hResult ) ) {
 		throw d3d_exception( "Error : IDirect3DDevice9#Present" );
 	}
+
+	// \L^
+	g_frameTiming.onPresent();
+
+	// Vt[\ƂCZT[\܂ł̒xL^
+	if( g_framePending ) {
+		recordFrameLatency( g_frameTimestamp );
+		g_framePending = false;
+	}
 }
 
 // EBhEvV[W
@@ -829,6 +704,11 @@ LRESULT CALLBACK WndProc( HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam
 			PostMessage( hWnd, WM_DESTROY, 0, 0 );
 			return 0;
 		}
+		// g[X̏o(R}hC"-trace <file>"w肵Ƃ)
+		if( wParam == 'T' ) {
+			writeTrace();
+			return 0;
+		}
 		break;
 
 	case WM_PAINT:
@@ -4,138 +4,150 @@
 
 #include "stdafx.h"
 #include <Windows.h>
+#include <sstream>
 #include <NuiApi.h>
 #include <opencv2/opencv.hpp>
+#include "NuiFrameSource.h"
+#include "FrameProcessor.h"
+#include "StagePipeline.h"
 
 
 int _tmain(int argc, _TCHAR* argv[])
 {
 	cv::setUseOptimized( true );
 
-	// Kinect̃CX^XA
-	INuiSensor* pSensor;
-	HRESULT hResult = S_OK;
-	hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	// t[\[X̍쐬
+	// Kinectg("-replay <file>"w肵Ƃ͋L^t@CĐA"-synthetic <l>"w肵Ƃ͍V[𐶐A"-record <file>"w肵Ƃ͋L^)
+	// ʒu킹e[u쐬(t[ɑSfNuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()ĂяoɁAN1x쐬)
+	std::unique_ptr<FrameSource> frameSource;
+	RegistrationTable registrationTable;
+	HRESULT hResult = createFrameSource( argc, argv, FRAME_STREAM_FLAG_COLOR | FRAME_STREAM_FLAG_DEPTH | NUI_FRAME_SOURCE_PLAYER_STATS, frameSource, &registrationTable );
 	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		std::cerr << "Error : createFrameSource" << std::endl;
 		return -1;
 	}
 
-	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiInitialize" << std::endl;
-		return -1;
-	}
-
-	// ColorXg[
-	HANDLE hColorEvent = INVALID_HANDLE_VALUE;
-	HANDLE hColorHandle = INVALID_HANDLE_VALUE;
-	hColorEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hColorEvent, &hColorHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( COLOR )" << std::endl;
-		return -1;
-	}
-
-	// Depth&PlayerXg[
-	HANDLE hDepthPlayerEvent = INVALID_HANDLE_VALUE;
-	HANDLE hDepthPlayerHandle = INVALID_HANDLE_VALUE;
-	hDepthPlayerEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hDepthPlayerEvent, &hDepthPlayerHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( DEPTH&PLAYER )" << std::endl;
-		return -1;
+	// ʒu킹A8rbgDepthPlayerɐFt摜ւ̃fR[h
+	// Depth̏͘_vZbT̐̃XbhŕS(Batchg)
+	ThreadPool threadPool;
+	PlayerProcessor playerProcessor( registrationTable, &threadPool );
+
+	// "-overlay"w肵Ƃ́APlayer̓v(fAdSAł߂/ADepth̃qXgO)fR[ĥƂɈꏏɋ߂āA
+	// PlayeȑdSɍł߂ƍł`
+	bool overlay = false;
+	for( int i = 1; i < argc; i++ ){
+		if( _tcscmp( argv[i], _T( "-overlay" ) ) == 0 ){
+			overlay = true;
+		}
 	}
-
-	HANDLE hEvents[2] = { hColorEvent, hDepthPlayerEvent };
-
-	// J[e[u
-	cv::Vec3b color[7];
-	color[0] = cv::Vec3b(   0,   0,   0 );
-	color[1] = cv::Vec3b( 255,   0,   0 );
-	color[2] = cv::Vec3b(   0, 255,   0 );
-	color[3] = cv::Vec3b(   0,   0, 255 );
-	color[4] = cv::Vec3b( 255, 255,   0 );
-	color[5] = cv::Vec3b( 255,   0, 255 );
-	color[6] = cv::Vec3b(   0, 255, 255 );
+	// "-record"̂Ƃ́A̓vL^t@Cɂ(Depth̃t[ǂݒɋ߂)
+	RecordingFrameSource* recording = dynamic_cast<RecordingFrameSource*>( frameSource.get() );
+	playerProcessor.setPlayerStats( overlay || recording );
 
 	cv::namedWindow( "Color" );
 	cv::namedWindow( "Depth" );
 	cv::namedWindow( "Player" );
 
-	while( 1 ){
-		// t[̍XV҂
-		ResetEvent( hColorEvent );
-		ResetEvent( hDepthPlayerEvent );
-		WaitForMultipleObjects( ARRAYSIZE( hEvents ), hEvents, true, INFINITE );
-
-		// ColorJt[擾
-		NUI_IMAGE_FRAME pColorImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hColorHandle, 0, &pColorImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( COLOR )" << std::endl;
-			return -1;
-		}
+	// t[̎擾AA\ꂼ̃Xbhŕsčs
+	// i̊Ԃ̃L[1t[ŁAt̂Ƃ͌Ât[̂Ă(xi͏ɍŐṼt[)
+	// Wủ摜͋NɊmۂĎg(3i + L[2̕)
+	struct PlayerJob
+	{
+		int64_t timestamp;     // Depth̃^CX^v[ms](x̋L^Ɏg)
+		uint32_t frameNumber;  // Depth̃t[ԍ(g[X̃Cxgɕt)
+		cv::Mat colorMat;
+		cv::Mat rawDepthMat;
+		cv::Mat depthMat;
+		cv::Mat playerMat;
+	};
+	StagePipeline pipeline( 5 );
+	std::vector<PlayerJob> jobs( pipeline.getJobCount() );
+	for( size_t i = 0; i < jobs.size(); i++ ){
+		jobs[i].colorMat.create( 480, 640, CV_8UC4 );
+		jobs[i].rawDepthMat.create( 480, 640, CV_16UC1 );
+		jobs[i].depthMat.create( 480, 640, CV_8UC1 );
+		jobs[i].playerMat.create( 480, 640, CV_8UC3 );
+	}
 
-		// DepthZT[t[擾
-		NUI_IMAGE_FRAME pDepthPlayerImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hDepthPlayerHandle, 0, &pDepthPlayerImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( DEPTH&PLAYER )" << std::endl;
-			return -1;
+	pipeline.addStage( "capture", [&]( int job ) -> bool {
+		// t[̎擾(^CX^vg҂AĐII)
+		FrameSet frames;
+		if( !frameSource->read( frames ) ){
+			return false;
+		}
+		jobs[job].timestamp = frames.depth.info.timestamp;
+		jobs[job].frameNumber = frames.depth.info.frameNumber;
+		setTraceFrame( frames.depth.info.frameNumber );
+
+		// ̃t[擾g悤ɁAWủ摜փRs[
+		std::memcpy( jobs[job].colorMat.data, frames.color.data, 640 * 480 * 4 );
+		std::memcpy( jobs[job].rawDepthMat.data, frames.depth.data, 640 * 480 * sizeof( ushort ) );
+		return true;
+	} );
+
+	pipeline.addStage( "process", [&]( int job ) -> bool {
+		setTraceFrame( jobs[job].frameNumber );
+
+		PlayerJob& playerJob = jobs[job];
+		playerProcessor.process( reinterpret_cast<ushort*>( playerJob.rawDepthMat.data ), playerJob.depthMat.data, playerJob.playerMat.data );
+		if( recording ){
+			const FrameInfo info = { playerJob.frameNumber, playerJob.timestamp, PIXEL_FORMAT_DEPTH16, 640, 480 };
+			recording->writePlayerStats( info, playerProcessor.getPlayerStats() );
 		}
 
-		// Color摜f[^̎擾
-		INuiFrameTexture* pColorFrameTexture = pColorImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sColorLockedRect;
-		pColorFrameTexture->LockRect( 0, &sColorLockedRect, nullptr, 0 );
-
-		// Depthf[^̎擾
-		INuiFrameTexture* pDepthPlayerFrameTexture = pDepthPlayerImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sDepthPlayerLockedRect;
-		pDepthPlayerFrameTexture->LockRect( 0, &sDepthPlayerLockedRect, nullptr, 0 );
-
-		// \
-		cv::Mat colorMat( 480, 640, CV_8UC4, reinterpret_cast<uchar*>( sColorLockedRect.pBits ) );
-		LONG registX = 0;
-		LONG registY = 0;
-		ushort* pBuffer = reinterpret_cast<ushort*>( sDepthPlayerLockedRect.pBits );
-		cv::Mat bufferMat = cv::Mat::zeros( 480, 640, CV_16UC1 );
-		cv::Mat playerMat = cv::Mat::zeros( 480, 640, CV_8UC3 );
-		for( int y = 0; y < 480; y++ ){
-			for( int x = 0; x < 640; x++ ){
-				pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480, nullptr, x, y, *pBuffer, &registX, &registY );
-				if( ( registX >= 0 ) && ( registX < 640 ) && ( registY >= 0 ) && ( registY < 480 ) ){
-					bufferMat.at<ushort>( registY, registX ) = *pBuffer & 0xFFF8;
-					playerMat.at<cv::Vec3b>( registY, registX ) = color[*pBuffer & 0x7];
+		// "-overlay"̂Ƃ́APlayeȑdSɍł߂ƍł`
+		if( overlay ){
+			const PlayerStats* stats = playerProcessor.getPlayerStats();
+			for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+				if( stats[player].pixels == 0 ){
+					continue;
 				}
-				pBuffer++;
+				const cv::Point centroid( static_cast<int>( stats[player].getCentroidX() ), static_cast<int>( stats[player].getCentroidY() ) );
+				std::ostringstream stream;
+				stream << stats[player].nearest << "-" << stats[player].farthest << "mm";
+				cv::putText( playerJob.playerMat, stream.str(), centroid, cv::FONT_HERSHEY_SIMPLEX, 0.5f, cv::Scalar( 255, 255, 255 ), 1, CV_AA );
 			}
 		}
-		cv::Mat depthMat( 480, 640, CV_8UC1 );
-		bufferMat.convertTo( depthMat, CV_8UC3, -255.0f / NUI_IMAGE_DEPTH_MAXIMUM, 255.0f );
-		cv::imshow( "Color", colorMat );
-		cv::imshow( "Depth", depthMat );
-		cv::imshow( "Player", playerMat );
-
-		// t[̉
-		pColorFrameTexture->UnlockRect( 0 );
-		pDepthPlayerFrameTexture->UnlockRect( 0 );
-		pSensor->NuiImageStreamReleaseFrame( hColorHandle, &pColorImageFrame );
-		pSensor->NuiImageStreamReleaseFrame( hDepthPlayerHandle, &pDepthPlayerImageFrame );
-
-		// [v̏I(EscL[)
-		if( cv::waitKey( 30 ) == VK_ESCAPE ){
-			break;
+		return true;
+	}, 1, QUEUE_DROP_OLDEST );
+
+	// \̓EBhẼXbhōs
+	pipeline.addStage( "present", [&]( int job ) -> bool {
+		setTraceFrame( jobs[job].frameNumber );
+
+		// \(EBhE̍XVwaitKey()ōŝŁA܂ł`̎Ԃɂ)
+		// [v̏I(EscL[)Ag[X̏o(tL[)
+		// \̊Ԋu̓t[̎擾Ō܂̂ŁAL[͂͑҂Ȃ
+		int key;
+		{
+			ScopedMetric metric( METRIC_DRAW );
+			cv::imshow( "Color", jobs[job].colorMat );
+			cv::imshow( "Depth", jobs[job].depthMat );
+			cv::imshow( "Player", jobs[job].playerMat );
+			key = cv::waitKey( 1 );
+		}
+		recordFrameLatency( jobs[job].timestamp );
+		if( key == 't' ){
+			writeTrace();
+		}
+		return key != VK_ESCAPE;
+	}, 1, QUEUE_DROP_OLDEST );
+
+	pipeline.run();
+
+	// ĩt[[gƃL[̏
+	pipeline.printStatistics( std::cout );
+
+	// t[̐
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( frameSource->getStreams() & ( 1 << i ) ){
+			const FrameDropCounter& dropCounter = frameSource->getDropCounter( static_cast<FrameStream>( i ) );
+			std::cout << getFrameStreamName( static_cast<FrameStream>( i ) ) << " : " << dropCounter.getDropped() << " frames dropped / " << dropCounter.getReceived() << " frames received" << std::endl;
 		}
 	}
 
-	// Kinect̏I
-	pSensor->NuiShutdown();
-	CloseHandle( hColorEvent );
-	CloseHandle( hDepthPlayerEvent );
-	CloseHandle( hColorHandle );
-	CloseHandle( hDepthPlayerHandle );
+	// t[\[X̏I(Kinect̏I)
+	frameSource.reset();
 
 	cv::destroyAllWindows();
 
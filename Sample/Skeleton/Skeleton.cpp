@@ -4,60 +4,29 @@
 
 #include "stdafx.h"
 #include <Windows.h>
+#include <sstream>
 #include <NuiApi.h>
 #include <opencv2/opencv.hpp>
+#include "FrameBufferPool.h"
+#include "NuiFrameSource.h"
+#include "DepthDecoder.h"
 
 
 int _tmain(int argc, _TCHAR* argv[])
 {
 	cv::setUseOptimized( true );
 
-	// Kinect̃CX^XA
-	INuiSensor* pSensor;
-	HRESULT hResult = S_OK;
-	hResult = NuiCreateSensorByIndex( 0, &pSensor );
+	// t[\[X̍쐬
+	// Kinectg("-replay <file>"w肵Ƃ͋L^t@CĐA"-synthetic <l>"w肵Ƃ͍V[𐶐A"-record <file>"w肵Ƃ͋L^)
+	// ʒu킹e[u쐬(t[ɑSfNuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution()ĂяoɁAN1x쐬)
+	std::unique_ptr<FrameSource> frameSource;
+	RegistrationTable registrationTable;
+	HRESULT hResult = createFrameSource( argc, argv, FRAME_STREAM_FLAG_ALL, frameSource, &registrationTable );
 	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiCreateSensorByIndex" << std::endl;
+		std::cerr << "Error : createFrameSource" << std::endl;
 		return -1;
 	}
 
-	hResult = pSensor->NuiInitialize( NUI_INITIALIZE_FLAG_USES_COLOR | NUI_INITIALIZE_FLAG_USES_DEPTH_AND_PLAYER_INDEX | NUI_INITIALIZE_FLAG_USES_SKELETON );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiInitialize" << std::endl;
-		return -1;
-	}
-
-	// ColorXg[
-	HANDLE hColorEvent = INVALID_HANDLE_VALUE;
-	HANDLE hColorHandle = INVALID_HANDLE_VALUE;
-	hColorEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_COLOR, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hColorEvent, &hColorHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( COLOR )" << std::endl;
-		return -1;
-	}
-
-	// Depth&PlayerXg[
-	HANDLE hDepthPlayerEvent = INVALID_HANDLE_VALUE;
-	HANDLE hDepthPlayerHandle = INVALID_HANDLE_VALUE;
-	hDepthPlayerEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiImageStreamOpen( NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX, NUI_IMAGE_RESOLUTION_640x480, 0, 2, hDepthPlayerEvent, &hDepthPlayerHandle );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiImageStreamOpen( DEPTH&PLAYER )" << std::endl;
-		return -1;
-	}
-
-	// SkeletonXg[
-	HANDLE hSkeletonEvent = INVALID_HANDLE_VALUE;
-	hSkeletonEvent = CreateEvent( nullptr, true, false, nullptr );
-	hResult = pSensor->NuiSkeletonTrackingEnable( hSkeletonEvent, 0 );
-	if( FAILED( hResult ) ){
-		std::cerr << "Error : NuiSkeletonTrackingEnable" << std::endl;
-		return -1;
-	}
-
-	HANDLE hEvents[3] = { hColorEvent, hDepthPlayerEvent, hSkeletonEvent };
-
 	// J[e[u
 	cv::Vec3b color[7];
 	color[0] = cv::Vec3b(   0,   0,   0 );
@@ -68,110 +37,117 @@ int _tmain(int argc, _TCHAR* argv[])
 	color[5] = cv::Vec3b( 255,   0, 255 );
 	color[6] = cv::Vec3b(   0, 255, 255 );
 
+	// Depth&Player̃fR[h(1x̑DepthPlayer̉摜)
+	DepthDecoder depthDecoder;
+	depthDecoder.setDepthScale( -255.0f / NUI_IMAGE_DEPTH_MAXIMUM, 255.0f );
+	depthDecoder.setPlayerColors( reinterpret_cast<uchar*>( color ) );
+
+	// "-overlay"w肵Ƃ́APlayer̓vfR[ĥƂɈꏏɋ߂āAPlayeȑdSDepth̕ς`
+	bool overlay = false;
+	for( int i = 1; i < argc; i++ ){
+		if( _tcscmp( argv[i], _T( "-overlay" ) ) == 0 ){
+			overlay = true;
+		}
+	}
+
+	// t[Ɏg摜obt@(t[mۂɎg)
+	FrameBufferPool framePool;
+
 	cv::namedWindow( "Color" );
 	cv::namedWindow( "Depth" );
 	cv::namedWindow( "Player" );
 	cv::namedWindow( "Skeleton" );
 
 	while( 1 ){
-		// t[̍XV҂
-		ResetEvent( hColorEvent );
-		ResetEvent( hDepthPlayerEvent );
-		ResetEvent( hSkeletonEvent );
-		WaitForMultipleObjects( ARRAYSIZE( hEvents ), hEvents, true, INFINITE );
-
-		// ColorJt[擾
-		NUI_IMAGE_FRAME pColorImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hColorHandle, 0, &pColorImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( COLOR )" << std::endl;
-			return -1;
+		// t[̎擾(SẴXg[̃t[܂ő҂AĐII)
+		FrameSet frames;
+		bool read;
+		{
+			TraceScope trace( "read" );
+			read = frameSource->read( frames );
 		}
-
-		// DepthZT[t[擾
-		NUI_IMAGE_FRAME pDepthPlayerImageFrame = { 0 };
-		hResult = pSensor->NuiImageStreamGetNextFrame( hDepthPlayerHandle, 0, &pDepthPlayerImageFrame );
-		if( FAILED( hResult ) ){
-			std::cerr << "Error : NuiImageStreamGetNextFrame( DEPTH&PLAYER )" << std::endl;
-			return -1;
+		if( !read ){
+			break;
 		}
+		setTraceFrame( frames.depth.info.frameNumber );
 
-		// Skeletont[擾
-		NUI_SKELETON_FRAME pSkeletonFrame = { 0 };
-		hResult = pSensor->NuiSkeletonGetNextFrame( 0, &pSkeletonFrame );
-		if( FAILED( hResult ) ){
-			std::cout << "Error : NuiSkeletonGetNextFrame" << std::endl;
-			return -1;
+		// \
+		cv::Mat colorMat( 480, 640, CV_8UC4, frames.color.data );
+
+		PooledFrameBuffer registBuffer( framePool, PIXEL_FORMAT_DEPTH16, 640, 480 );
+		cv::Mat registMat( 480, 640, CV_16UC1, registBuffer.data() );
+		PooledFrameBuffer depthBuffer( framePool, PIXEL_FORMAT_GRAY8, 640, 480 );
+		cv::Mat depthMat( 480, 640, CV_8UC1, depthBuffer.data() );
+		PooledFrameBuffer playerBuffer( framePool, PIXEL_FORMAT_BGR24, 640, 480 );
+		cv::Mat playerMat( 480, 640, CV_8UC3, playerBuffer.data() );
+		PlayerStats playerStats[KINECT_PLAYER_COUNT + 1];
+		DepthDecodeOutput depthOutput;
+		depthOutput.depth8 = depthMat.data;
+		depthOutput.player = playerMat.data;
+		depthOutput.stats = overlay ? playerStats : nullptr; // Player̓vfR[ĥƂɈꏏɋ߂
+		{
+			ScopedMetric metric( METRIC_REGISTER );
+			registrationTable.registerFrame( reinterpret_cast<ushort*>( frames.depth.data ), reinterpret_cast<ushort*>( registMat.data ) );
+			depthDecoder.decode( reinterpret_cast<ushort*>( registMat.data ), depthOutput, 0, 640 * 480 );
 		}
 
-		// Color摜f[^̎擾
-		INuiFrameTexture* pColorFrameTexture = pColorImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sColorLockedRect;
-		pColorFrameTexture->LockRect( 0, &sColorLockedRect, nullptr, 0 );
-
-		// Depthf[^̎擾
-		INuiFrameTexture* pDepthPlayerFrameTexture = pDepthPlayerImageFrame.pFrameTexture;
-		NUI_LOCKED_RECT sDepthPlayerLockedRect;
-		pDepthPlayerFrameTexture->LockRect( 0, &sDepthPlayerLockedRect, nullptr, 0 );
-
-		// \
-		cv::Mat colorMat( 480, 640, CV_8UC4, reinterpret_cast<uchar*>( sColorLockedRect.pBits ) );
-
-		LONG registX = 0;
-		LONG registY = 0;
-		ushort* pBuffer = reinterpret_cast<ushort*>( sDepthPlayerLockedRect.pBits );
-		cv::Mat bufferMat = cv::Mat::zeros( 480, 640, CV_16UC1 );
-		cv::Mat playerMat = cv::Mat::zeros( 480, 640, CV_8UC3 );
-		for( int y = 0; y < 480; y++ ){
-			for( int x = 0; x < 640; x++ ){
-				pSensor->NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution( NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480, nullptr, x, y, *pBuffer, &registX, &registY );
-				if( ( registX >= 0 ) && ( registX < 640 ) && ( registY >= 0 ) && ( registY < 480 ) ){
-					bufferMat.at<ushort>( registY, registX ) = *pBuffer & 0xFFF8;
-					playerMat.at<cv::Vec3b>( registY, registX ) = color[*pBuffer & 0x7];
+		PooledFrameBuffer skeletonBuffer( framePool, PIXEL_FORMAT_BGR24, 640, 480, true );
+		cv::Mat skeletonMat( 480, 640, CV_8UC3, skeletonBuffer.data() );
+		{
+			ScopedMetric metric( METRIC_DRAW );
+			cv::Point2f point;
+			for( int count = 0; count < KINECT_SKELETON_COUNT; count++ ){
+				const SkeletonData& skeleton = frames.skeleton->skeletons[count];
+				if( skeleton.trackingState == SKELETON_TRACKED ){
+					for( int position = 0; position < KINECT_SKELETON_POSITION_COUNT; position++ ){
+						projectSkeletonToDepth( skeleton.positions[position], 640, 480, &point.x, &point.y );
+						cv::circle( skeletonMat, point, 10, static_cast<cv::Scalar>( color[count + 1] ), -1, CV_AA );
+					}
 				}
-				pBuffer++;
 			}
-		}
-		cv::Mat depthMat( 480, 640, CV_8UC1 );
-		bufferMat.convertTo( depthMat, CV_8UC3, -255.0f / NUI_IMAGE_DEPTH_MAXIMUM, 255.0f );
-
-		cv::Mat skeletonMat = cv::Mat::zeros( 480, 640, CV_8UC3 );
-		cv::Point2f point;
-		for( int count = 0; count < NUI_SKELETON_COUNT; count++ ){
-			NUI_SKELETON_DATA skeleton = pSkeletonFrame.SkeletonData[count];
-			if( skeleton.eTrackingState == NUI_SKELETON_TRACKED ){
-				for( int position = 0; position < NUI_SKELETON_POSITION_COUNT; position++ ){
-					NuiTransformSkeletonToDepthImage( skeleton.SkeletonPositions[position], &point.x, &point.y, NUI_IMAGE_RESOLUTION_640x480 );
-					cv::circle( skeletonMat, point, 10, static_cast<cv::Scalar>( color[count + 1] ), -1, CV_AA );
+
+			// "-overlay"̂Ƃ́APlayeȑdSDepth̕ς`
+			if( overlay ){
+				for( int player = 1; player <= KINECT_PLAYER_COUNT; player++ ){
+					if( playerStats[player].pixels ){
+						std::ostringstream stream;
+						stream << static_cast<int>( playerStats[player].getMeanDepth() ) << "mm";
+						cv::putText( playerMat, stream.str(), cv::Point( static_cast<int>( playerStats[player].getCentroidX() ), static_cast<int>( playerStats[player].getCentroidY() ) ), cv::FONT_HERSHEY_SIMPLEX, 0.5f, cv::Scalar( 255, 255, 255 ), 1, CV_AA );
+					}
 				}
 			}
+
+			cv::imshow( "Color", colorMat );
+			cv::imshow( "Depth", depthMat );
+			cv::imshow( "Player", playerMat );
+			cv::imshow( "Skeleton", skeletonMat );
+		}
+		recordFrameLatency( frames.depth.info.timestamp );
+
+		// [v̏I(EscL[)Ag[X̏o(tL[)
+		int key;
+		{
+			TraceScope trace( "wait" );
+			key = cv::waitKey( 30 );
 		}
-		
-		cv::imshow( "Color", colorMat );
-		cv::imshow( "Depth", depthMat );
-		cv::imshow( "Player", playerMat );
-		cv::imshow( "Skeleton", skeletonMat );
-
-		// t[̉
-		pColorFrameTexture->UnlockRect( 0 );
-		pDepthPlayerFrameTexture->UnlockRect( 0 );
-		pSensor->NuiImageStreamReleaseFrame( hColorHandle, &pColorImageFrame );
-		pSensor->NuiImageStreamReleaseFrame( hDepthPlayerHandle, &pDepthPlayerImageFrame );
-
-		// [v̏I(EscL[)
-		if( cv::waitKey( 30 ) == VK_ESCAPE ){
+		if( key == 't' ){
+			writeTrace();
+		}
+		if( key == VK_ESCAPE ){
 			break;
 		}
 	}
 
-	// Kinect̏I
-	pSensor->NuiShutdown();
-	pSensor->NuiSkeletonTrackingDisable();
-	CloseHandle( hColorEvent );
-	CloseHandle( hDepthPlayerEvent );
-	CloseHandle( hSkeletonEvent );
-	CloseHandle( hColorHandle );
-	CloseHandle( hDepthPlayerHandle );
+	// t[̐
+	for( int i = 0; i < FRAME_STREAM_COUNT; i++ ){
+		if( frameSource->getStreams() & ( 1 << i ) ){
+			const FrameDropCounter& dropCounter = frameSource->getDropCounter( static_cast<FrameStream>( i ) );
+			std::cout << getFrameStreamName( static_cast<FrameStream>( i ) ) << " : " << dropCounter.getDropped() << " frames dropped / " << dropCounter.getReceived() << " frames received" << std::endl;
+		}
+	}
+
+	// t[\[X̏I(Kinect̏I)
+	frameSource.reset();
 
 	cv::destroyAllWindows();
 